@@ -0,0 +1,95 @@
+#include <benchmark/benchmark.h>
+
+#include "platform/linux/proc_event_tracker.hpp"
+#include "platform/linux/procfs_detector.hpp"
+
+#include <csignal>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace {
+
+// Forks a chain of `depth` processes, each the child of the previous one,
+// like a terminal -> shell -> tool -> ... stack. Killed on destruction.
+struct ProcessChain {
+    pid_t head = -1;
+
+    explicit ProcessChain(int depth) {
+        int ready[2];
+        if (::pipe(ready) != 0) return;
+
+        head = ::fork();
+        if (head == 0) {
+            ::setpgid(0, 0);
+            for (int i = 1; i < depth; ++i) {
+                pid_t next = ::fork();
+                if (next != 0) break;  // parent stays as this link
+            }
+            // Every link reports in, then waits to be killed.
+            char c = 1;
+            ::write(ready[1], &c, 1);
+            for (;;) ::pause();
+        }
+
+        ::close(ready[1]);
+        for (int i = 0; i < depth; ++i) {
+            char c;
+            if (::read(ready[0], &c, 1) != 1) break;
+        }
+        ::close(ready[0]);
+    }
+
+    ~ProcessChain() {
+        if (head <= 0) return;
+        ::kill(-head, SIGKILL);
+        ::waitpid(head, nullptr, 0);
+    }
+};
+
+// Worst case: no agent anywhere, so the whole tree is walked.
+void BM_ProcfsScanMiss(benchmark::State& state) {
+    ProcessChain chain(static_cast<int>(state.range(0)));
+    ProcfsDetector detector({"claude", "aider", "gh", "cursor"});
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(detector.scan(getpid()));
+    }
+    state.counters["depth"] = static_cast<double>(state.range(0));
+}
+BENCHMARK(BM_ProcfsScanMiss)->Arg(1)->Arg(8)->Arg(32)->Arg(64)->Unit(benchmark::kMicrosecond);
+
+// What start pays once the focus event has filled the cache.
+void BM_ProcfsDetectCached(benchmark::State& state) {
+    ProcessChain chain(static_cast<int>(state.range(0)));
+    ProcfsDetector detector({"claude", "aider", "gh", "cursor"});
+    detector.detect(getpid());
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(detector.detect(getpid()));
+    }
+    state.counters["depth"] = static_cast<double>(state.range(0));
+}
+BENCHMARK(BM_ProcfsDetectCached)->Arg(1)->Arg(64)->Unit(benchmark::kMicrosecond);
+
+// Walking the proc connector's in-memory tree instead of /proc.
+void BM_TrackerDetectMiss(benchmark::State& state) {
+    ProcEventTracker tracker;
+    if (!tracker.start()) {
+        state.SkipWithError("proc connector needs CAP_NET_ADMIN");
+        return;
+    }
+    ProcessChain chain(static_cast<int>(state.range(0)));
+    ProcfsDetector detector({"claude", "aider", "gh", "cursor"});
+    detector.use_tracker(&tracker);
+
+    for (auto _ : state) {
+        state.PauseTiming();
+        tracker.read_events();
+        state.ResumeTiming();
+        benchmark::DoNotOptimize(detector.detect(getpid()));
+    }
+    state.counters["depth"] = static_cast<double>(state.range(0));
+}
+BENCHMARK(BM_TrackerDetectMiss)->Arg(1)->Arg(8)->Arg(32)->Arg(64)->Unit(benchmark::kMicrosecond);
+
+} // namespace
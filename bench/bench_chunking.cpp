@@ -0,0 +1,56 @@
+#include <benchmark/benchmark.h>
+
+#include "whisper/chunking_backend.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// Ten minutes of "speech": a tone broken by a 400 ms pause every 7 seconds.
+std::vector<int16_t> meeting() {
+    std::vector<int16_t> audio(600 * 16000);
+    for (size_t i = 0; i < audio.size(); ++i) {
+        if (i % (7 * 16000) < 16000 * 4 / 10) continue;
+        audio[i] = static_cast<int16_t>(8000 * std::sin(2 * M_PI * 440 * static_cast<double>(i) / 16000));
+    }
+    return audio;
+}
+
+// A server that needs 1 ms per second of audio and runs requests side by side.
+struct SteadyBackend : WhisperBackend {
+    std::expected<TranscriptResult, std::string>
+    transcribe(std::span<const int16_t> audio, uint32_t sample_rate) override {
+        std::this_thread::sleep_for(std::chrono::microseconds(audio.size() * 1000 / sample_rate));
+        return TranscriptResult{.text = "words", .duration_s = static_cast<double>(audio.size()) / sample_rate};
+    }
+};
+
+// Finding the cuts: one VAD pass over the whole clip.
+void BM_PlanChunks(benchmark::State& state) {
+    auto audio = meeting();
+    for (auto _ : state) {
+        auto spans = chunking::plan(audio, 16000, {});
+        benchmark::DoNotOptimize(spans);
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * audio.size() * sizeof(int16_t)));
+}
+BENCHMARK(BM_PlanChunks)->Unit(benchmark::kMillisecond);
+
+// Wall time for the ten minutes with range(0) requests at once; 1 is the
+// clip cut up but sent one chunk after another.
+void BM_ChunkedTranscribe(benchmark::State& state) {
+    auto audio = meeting();
+    ChunkingBackend backend(std::make_unique<SteadyBackend>(), chunking::Options{
+        .concurrency = static_cast<uint32_t>(state.range(0)),
+    });
+    for (auto _ : state) {
+        auto r = backend.transcribe(audio, 16000, std::stop_token{});
+        benchmark::DoNotOptimize(r);
+    }
+}
+BENCHMARK(BM_ChunkedTranscribe)->Arg(1)->Arg(2)->Arg(4)->Arg(8)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+} // namespace
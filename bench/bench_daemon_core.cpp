@@ -0,0 +1,205 @@
+#include <benchmark/benchmark.h>
+
+#include "daemon_core.hpp"
+
+#include <condition_variable>
+#include <cstdlib>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <unistd.h>
+
+namespace {
+
+struct NullCapture : AudioCapture {
+    bool capturing = false;
+    bool start() override { return capturing = true; }
+    void stop() override { capturing = false; }
+    bool is_capturing() const override { return capturing; }
+};
+
+struct NullDetector : ProcessDetector {
+    DetectionResult detect(int) const override { return {}; }
+};
+
+// Keeps the last response instead of writing to a socket.
+struct CapturingIpc : IpcServer {
+    bool start(const std::string&) override { return true; }
+    void stop() override {}
+    int server_fd() const override { return -1; }
+    int accept_client() override { return -1; }
+    bool read_commands(int, std::vector<nlohmann::json>&) override { return false; }
+    bool send_response(int, const nlohmann::json& response) override {
+        last = response;
+        return true;
+    }
+    long send_some(int, std::string_view data) override { return static_cast<long>(data.size()); }
+    bool flush(int) override { return true; }
+    void close_client(int) override {}
+    uint32_t peer_uid(int) const override { return 0; }
+    void subscribe(int) override {}
+    size_t subscriber_count() const override { return 0; }
+    void publish(const nlohmann::json&, std::optional<uint32_t>) override {}
+
+    nlohmann::json last;
+};
+
+struct NullOutput : OutputMethod {
+    std::expected<void, std::string> deliver(const std::string&) override { return {}; }
+};
+
+// Answers immediately, so the daemon's own overhead is what gets measured.
+struct InstantBackend : WhisperBackend {
+    std::expected<TranscriptResult, std::string>
+    transcribe(std::span<const int16_t> audio, uint32_t sample_rate) override {
+        return TranscriptResult{
+            .text = "benchmark transcript",
+            .duration_s = static_cast<double>(audio.size()) / sample_rate,
+        };
+    }
+};
+
+// A model that takes float PCM, like the local backend. With float_input off
+// it gets int16 and converts the whole clip itself, as it did before the
+// daemon converted while recording.
+struct FloatModelBackend : WhisperBackend {
+    explicit FloatModelBackend(bool float_input) : float_input(float_input) {}
+
+    std::expected<TranscriptResult, std::string>
+    transcribe(std::span<const int16_t> audio, uint32_t sample_rate) override {
+        pcm.resize(audio.size());
+        audio::to_float(audio.data(), audio.size(), pcm.data());
+        return transcribe(std::span<const float>(pcm), sample_rate, std::stop_token{});
+    }
+
+    bool accepts_float() const override { return float_input; }
+    std::expected<TranscriptResult, std::string>
+    transcribe(std::span<const float> audio, uint32_t sample_rate, std::stop_token,
+               std::string_view = {}) override {
+        benchmark::DoNotOptimize(audio.data());
+        return TranscriptResult{
+            .text = "benchmark transcript",
+            .duration_s = static_cast<double>(audio.size()) / sample_rate,
+        };
+    }
+
+    bool float_input;
+    std::vector<float> pcm;
+};
+
+// Eventfd stand-in: the worker's notify wakes the benchmark thread.
+struct Notifier {
+    std::mutex mu;
+    std::condition_variable cv;
+    int pending = 0;
+
+    void notify() {
+        {
+            std::lock_guard lock(mu);
+            ++pending;
+        }
+        cv.notify_one();
+    }
+
+    void wait() {
+        std::unique_lock lock(mu);
+        cv.wait(lock, [this] { return pending > 0; });
+        --pending;
+    }
+};
+
+// stop -> transcription -> output -> history -> client response, for a
+// recording of range(0) seconds.
+void BM_DaemonStopToResponse(benchmark::State& state) {
+    // Keep the history database out of the user's data directory.
+    auto dir = std::filesystem::temp_directory_path() / ("sa_bench_" + std::to_string(getpid()));
+    ::setenv("XDG_DATA_HOME", dir.c_str(), 1);
+
+    Config config;
+    RingBuffer ring(config.audio.ring_buffer_bytes());
+    NullCapture capture;
+    NullDetector detector;
+    CapturingIpc ipc;
+    Notifier notifier;
+
+    DaemonCore core(config, false, ring, capture, detector, ipc,
+                    [](const OutputStrategy&) { return std::make_unique<NullOutput>(); },
+                    [&notifier] { notifier.notify(); });
+    core.set_backend(std::make_unique<InstantBackend>());
+    if (!core.init()) {
+        state.SkipWithError("init failed");
+        return;
+    }
+
+    std::vector<int16_t> audio(static_cast<size_t>(state.range(0)) * config.audio.sample_rate, 100);
+    auto empty = nlohmann::json::object();
+
+    for (auto _ : state) {
+        state.PauseTiming();
+        core.handle_command("start", empty);
+        ring.write(audio.data(), audio.size() * sizeof(int16_t));
+        state.ResumeTiming();
+
+        auto r = core.handle_command("stop", empty);
+        core.add_waiting_client(1, r.value("job_id", uint64_t{0}));
+        notifier.wait();
+        core.on_transcription_complete();
+        benchmark::DoNotOptimize(ipc.last);
+    }
+
+    core.shutdown();
+    std::filesystem::remove_all(dir);
+}
+BENCHMARK(BM_DaemonStopToResponse)->Arg(1)->Arg(10)->Arg(60)->Unit(benchmark::kMicrosecond)
+    ->UseRealTime();
+
+// Stop latency for a float model: range(1) = 0 converts the clip after stop,
+// 1 converts it in the audio ticks while recording (outside the timing).
+void BM_DaemonStopToResponseFloat(benchmark::State& state) {
+    auto dir = std::filesystem::temp_directory_path() / ("sa_bench_" + std::to_string(getpid()));
+    ::setenv("XDG_DATA_HOME", dir.c_str(), 1);
+
+    Config config;
+    RingBuffer ring(config.audio.ring_buffer_bytes());
+    NullCapture capture;
+    NullDetector detector;
+    CapturingIpc ipc;
+    Notifier notifier;
+
+    DaemonCore core(config, false, ring, capture, detector, ipc,
+                    [](const OutputStrategy&) { return std::make_unique<NullOutput>(); },
+                    [&notifier] { notifier.notify(); });
+    core.set_backend(std::make_unique<FloatModelBackend>(state.range(1) != 0));
+    if (!core.init()) {
+        state.SkipWithError("init failed");
+        return;
+    }
+
+    // Delivered in chunk_ms pieces with a tick after each, as while recording.
+    std::vector<int16_t> audio(static_cast<size_t>(state.range(0)) * config.audio.sample_rate, 100);
+    size_t chunk = config.audio.sample_rate * config.audio.chunk_ms / 1000;
+    auto empty = nlohmann::json::object();
+
+    for (auto _ : state) {
+        state.PauseTiming();
+        core.handle_command("start", empty);
+        for (size_t i = 0; i < audio.size(); i += chunk) {
+            ring.write(audio.data() + i, std::min(chunk, audio.size() - i) * sizeof(int16_t));
+            core.on_audio_tick();
+        }
+        state.ResumeTiming();
+
+        auto r = core.handle_command("stop", empty);
+        core.add_waiting_client(1, r.value("job_id", uint64_t{0}));
+        notifier.wait();
+        core.on_transcription_complete();
+        benchmark::DoNotOptimize(ipc.last);
+    }
+
+    core.shutdown();
+    std::filesystem::remove_all(dir);
+}
+BENCHMARK(BM_DaemonStopToResponseFloat)->ArgsProduct({{10, 60}, {0, 1}})
+    ->Unit(benchmark::kMicrosecond)->UseRealTime();
+
+} // namespace
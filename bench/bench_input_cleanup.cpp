@@ -0,0 +1,33 @@
+#include <benchmark/benchmark.h>
+
+#include "audio/input_cleanup.hpp"
+
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+namespace {
+
+// One second of 16 kHz mic audio cleaned up in 20 ms chunks, as the main
+// thread drains the ring buffer while recording. This is what the cleanup
+// adds to each audio tick; none of it is left for after stop.
+void BM_InputCleanup(benchmark::State& state) {
+    std::vector<int16_t> source(16000);
+    for (size_t i = 0; i < source.size(); ++i) {
+        double speech = (i / 4000) % 2 ? 6000.0 * std::sin(static_cast<double>(i) * 0.17) : 0.0;
+        source[i] = static_cast<int16_t>(speech + static_cast<double>((i * 7919) % 601) - 300.0);
+    }
+    InputCleanup cleanup(16000, {.denoise = true, .agc = true});
+    std::vector<int16_t> audio;
+    for (auto _ : state) {
+        audio = source;
+        for (size_t i = 0; i < audio.size(); i += 320) {
+            cleanup.process(std::span(audio).subspan(i, 320));
+        }
+        benchmark::DoNotOptimize(audio.data());
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * 16000);
+}
+BENCHMARK(BM_InputCleanup)->Unit(benchmark::kMicrosecond);
+
+} // namespace
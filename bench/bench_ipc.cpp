@@ -0,0 +1,80 @@
+#include <benchmark/benchmark.h>
+
+#include "platform/linux/unix_socket_server.hpp"
+
+#include <string>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+
+// A connected client of a real UnixSocketServer.
+struct Connection {
+    UnixSocketServer server;
+    int client = -1;
+    int server_side = -1;
+
+    Connection() {
+        std::string path = "/tmp/sa_bench_ipc_" + std::to_string(getpid()) + ".sock";
+        if (!server.start(path)) return;
+
+        client = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        sockaddr_un addr{};
+        addr.sun_family = AF_UNIX;
+        path.copy(addr.sun_path, sizeof(addr.sun_path) - 1);
+        if (::connect(client, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) return;
+        server_side = server.accept_client();
+    }
+
+    ~Connection() {
+        if (client >= 0) ::close(client);
+        server.stop();
+    }
+};
+
+void run_read_command(benchmark::State& state, const std::string& line) {
+    Connection conn;
+    if (conn.server_side < 0) {
+        state.SkipWithError("could not set up socket");
+        return;
+    }
+
+    nlohmann::json cmd;
+    for (auto _ : state) {
+        ::send(conn.client, line.data(), line.size(), 0);
+        if (!conn.server.read_command(conn.server_side, cmd)) {
+            state.SkipWithError("read_command failed");
+            return;
+        }
+        benchmark::DoNotOptimize(cmd);
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * line.size()));
+}
+
+// What the hotkey sends.
+void BM_ReadCommandToggle(benchmark::State& state) {
+    run_read_command(state, R"({"cmd":"toggle","output":"type"})" "\n");
+}
+BENCHMARK(BM_ReadCommandToggle);
+
+// A command carrying a payload of range(0) bytes.
+void BM_ReadCommandLarge(benchmark::State& state) {
+    std::string payload(static_cast<size_t>(state.range(0)), 'x');
+    run_read_command(state, R"({"cmd":"status","note":")" + payload + "\"}\n");
+}
+BENCHMARK(BM_ReadCommandLarge)->Arg(256)->Arg(3000);
+
+// The same commands as CBOR frames, as `sa` sends them.
+void BM_ReadCommandToggleCbor(benchmark::State& state) {
+    run_read_command(state, ipc::encode({{"cmd", "toggle"}, {"output", "type"}}, ipc::Encoding::Cbor));
+}
+BENCHMARK(BM_ReadCommandToggleCbor);
+
+void BM_ReadCommandLargeCbor(benchmark::State& state) {
+    std::string payload(static_cast<size_t>(state.range(0)), 'x');
+    run_read_command(state, ipc::encode({{"cmd", "status"}, {"note", payload}}, ipc::Encoding::Cbor));
+}
+BENCHMARK(BM_ReadCommandLargeCbor)->Arg(256)->Arg(3000);
+
+} // namespace
@@ -0,0 +1,72 @@
+#include <benchmark/benchmark.h>
+
+#include "text/replacer.hpp"
+
+#include <format>
+#include <string>
+#include <vector>
+
+namespace {
+
+// `count` made-up two-word phrases, one in ten of which occur in transcript().
+std::vector<Replacer::Rule> rules(size_t count) {
+    std::vector<Replacer::Rule> out;
+    for (size_t i = 0; i < count; ++i) {
+        out.push_back({std::format("term{} alias{}", i, i % 7), std::format("T{}", i)});
+    }
+    return out;
+}
+
+// About a minute of dictation.
+std::string transcript(size_t count) {
+    std::string text;
+    for (size_t i = 0; text.size() < 1000; ++i) {
+        text += "so then we run ";
+        if (count > 0 && i % 3 == 0) text += std::format("term{} alias{} ", i * 10 % count, i * 10 % count % 7);
+        text += "against the cluster and check the output, ";
+    }
+    return text;
+}
+
+// The old way: one search over the text per rule.
+void BM_ReplaceNaive(benchmark::State& state) {
+    auto r = rules(static_cast<size_t>(state.range(0)));
+    auto text = transcript(r.size());
+    for (auto _ : state) {
+        std::string out = text;
+        for (auto& rule : r) {
+            for (size_t pos = out.find(rule.from); pos != std::string::npos;
+                 pos = out.find(rule.from, pos + rule.to.size())) {
+                out.replace(pos, rule.from.size(), rule.to);
+            }
+        }
+        benchmark::DoNotOptimize(out);
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * text.size()));
+}
+BENCHMARK(BM_ReplaceNaive)->Arg(10)->Arg(1000)->Arg(10000);
+
+void BM_ReplacerApply(benchmark::State& state) {
+    auto r = rules(static_cast<size_t>(state.range(0)));
+    Replacer replacer(r);
+    auto text = transcript(r.size());
+    for (auto _ : state) {
+        auto out = replacer.apply(text);
+        benchmark::DoNotOptimize(out);
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * text.size()));
+    state.counters["states"] = static_cast<double>(replacer.state_count());
+}
+BENCHMARK(BM_ReplacerApply)->Arg(10)->Arg(1000)->Arg(10000);
+
+// Paid once per rule set, at startup.
+void BM_ReplacerCompile(benchmark::State& state) {
+    auto r = rules(static_cast<size_t>(state.range(0)));
+    for (auto _ : state) {
+        Replacer replacer(r);
+        benchmark::DoNotOptimize(replacer);
+    }
+}
+BENCHMARK(BM_ReplacerCompile)->Arg(1000)->Arg(10000);
+
+} // namespace
@@ -0,0 +1,39 @@
+#include <benchmark/benchmark.h>
+
+#include "audio/resampler.hpp"
+
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+namespace {
+
+// One second of native capture (range(0) Hz stereo float) converted to
+// 16 kHz mono int16, in 10 ms callbacks as the converter thread sees them.
+// With audio.native_format off this work happens in PipeWire's adapter
+// instead; compare against its CPU time in pw-top.
+void BM_ResampleToMono16k(benchmark::State& state) {
+    auto rate = static_cast<uint32_t>(state.range(0));
+    std::vector<float> in(static_cast<size_t>(rate) * 2);
+    for (size_t f = 0; f < rate; ++f) {
+        float s = 0.5f * static_cast<float>(std::sin(static_cast<double>(f) * 0.05));
+        in[2 * f] = s;
+        in[2 * f + 1] = -0.5f * s;
+    }
+    size_t period = static_cast<size_t>(rate) / 100 * 2;
+
+    Resampler resampler(rate, 16000, 2);
+    std::vector<int16_t> out;
+    out.reserve(16000);
+    for (auto _ : state) {
+        out.clear();
+        for (size_t i = 0; i < in.size(); i += period) {
+            resampler.process(std::span<const float>(in).subspan(i, std::min(period, in.size() - i)), out);
+        }
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * rate);
+}
+BENCHMARK(BM_ResampleToMono16k)->Arg(48000)->Arg(44100)->Unit(benchmark::kMicrosecond);
+
+} // namespace
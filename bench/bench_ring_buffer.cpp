@@ -0,0 +1,83 @@
+#include <benchmark/benchmark.h>
+
+#include "ring_buffer.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// Same capacity the daemon uses for 16 kHz mono and a 120 s cap.
+constexpr size_t CAPACITY = 16000 * 2 * 120;
+
+// Producer and consumer on one thread: the copy cost alone.
+void BM_RingBufferWriteRead(benchmark::State& state) {
+    auto chunk = static_cast<size_t>(state.range(0));
+    RingBuffer ring(CAPACITY);
+    std::vector<uint8_t> in(chunk, 0x55), out(chunk);
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(ring.write(in.data(), chunk));
+        benchmark::DoNotOptimize(ring.read(out.data(), chunk));
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * chunk));
+}
+BENCHMARK(BM_RingBufferWriteRead)->RangeMultiplier(4)->Range(64, 256 << 10);
+
+// A producer thread writing PipeWire-sized quanta while the benchmark thread
+// reads, so the atomics actually bounce between cores.
+void BM_RingBufferCrossThread(benchmark::State& state) {
+    auto chunk = static_cast<size_t>(state.range(0));
+    RingBuffer ring(CAPACITY);
+    std::atomic<bool> done{false};
+
+    std::jthread producer([&] {
+        std::vector<uint8_t> in(chunk, 0x55);
+        while (!done.load(std::memory_order_relaxed)) {
+            if (ring.write(in.data(), chunk) == 0) std::this_thread::yield();
+        }
+    });
+
+    std::vector<uint8_t> out(chunk);
+    size_t total = 0;
+    for (auto _ : state) {
+        size_t n;
+        while ((n = ring.read(out.data(), chunk)) == 0) {}
+        total += n;
+    }
+    done.store(true);
+    state.SetBytesProcessed(static_cast<int64_t>(total));
+}
+BENCHMARK(BM_RingBufferCrossThread)->RangeMultiplier(4)->Range(256, 64 << 10)->UseRealTime();
+
+// Stop: a whole recording of range(0) milliseconds comes out in one go.
+void BM_RingBufferDrainAll(benchmark::State& state) {
+    size_t bytes = static_cast<size_t>(state.range(0)) * 16 * 2;
+    RingBuffer ring(CAPACITY);
+    std::vector<uint8_t> in(bytes, 0x55);
+
+    for (auto _ : state) {
+        state.PauseTiming();
+        ring.reset();
+        ring.write(in.data(), bytes);
+        state.ResumeTiming();
+        benchmark::DoNotOptimize(ring.drain_all());
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * bytes));
+}
+BENCHMARK(BM_RingBufferDrainAll)->Arg(20)->Arg(1000)->Arg(10'000)->Arg(60'000)->Arg(120'000);
+
+// Daemon startup with a max_seconds of range(0): only the first chunk is
+// allocated, not the whole cap.
+void BM_RingBufferCreate(benchmark::State& state) {
+    size_t capacity = static_cast<size_t>(state.range(0)) * 16000 * 2;
+    for (auto _ : state) {
+        RingBuffer ring(capacity);
+        benchmark::DoNotOptimize(ring.available());
+    }
+}
+BENCHMARK(BM_RingBufferCreate)->Arg(120)->Arg(3600)->Unit(benchmark::kMicrosecond);
+
+} // namespace
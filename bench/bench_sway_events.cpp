@@ -0,0 +1,73 @@
+#include <benchmark/benchmark.h>
+
+#include "sway/focus_parser.hpp"
+
+#include <format>
+#include <nlohmann/json.hpp>
+#include <string>
+
+namespace {
+
+std::string container(int id, bool focused) {
+    return std::format(
+        R"({{"id": {0}, "type": "con", "orientation": "none", "percent": 0.5,)"
+        R"( "urgent": false, "marks": [], "focused": {1}, "layout": "none",)"
+        R"( "border": "pixel", "rect": {{"x": 0, "y": 0, "width": 960, "height": 1080}},)"
+        R"( "name": "user@host: ~/src/project-{0} - vim", "nodes": [], "floating_nodes": [],)"
+        R"( "pid": {2}, "app_id": "kitty", "visible": true, "shell": "xdg_shell",)"
+        R"( "idle_inhibitors": {{"user": "none", "application": "none"}}}})",
+        id, focused ? "true" : "false", 1000 + id);
+}
+
+// What a terminal sends on every prompt redraw.
+std::string title_event() {
+    return R"({"change": "title", "container": )" + container(1, true) + "}";
+}
+
+// A workspace of `windows` terminals, the last one focused.
+std::string tree(int windows) {
+    std::string nodes;
+    for (int i = 0; i < windows; ++i) {
+        if (i > 0) nodes += ", ";
+        nodes += container(i + 10, i == windows - 1);
+    }
+    return R"({"id": 1, "type": "root", "focused": false, "name": "root", "nodes": [)"
+           R"({"id": 2, "type": "workspace", "focused": false, "name": "1", "nodes": [)" +
+           nodes + R"(], "floating_nodes": []}]})";
+}
+
+// The old path: a DOM for every event, then a look at "change".
+void BM_SwayEventDom(benchmark::State& state) {
+    auto payload = title_event();
+    for (auto _ : state) {
+        auto j = nlohmann::json::parse(payload);
+        benchmark::DoNotOptimize(j.value("change", "") == "focus");
+    }
+}
+BENCHMARK(BM_SwayEventDom);
+
+void BM_SwayEventSax(benchmark::State& state) {
+    auto payload = title_event();
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(sway::parse_focus_event(payload));
+    }
+}
+BENCHMARK(BM_SwayEventSax);
+
+void BM_SwayTreeDom(benchmark::State& state) {
+    auto payload = tree(static_cast<int>(state.range(0)));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(nlohmann::json::parse(payload));
+    }
+}
+BENCHMARK(BM_SwayTreeDom)->Arg(4)->Arg(64)->Unit(benchmark::kMicrosecond);
+
+void BM_SwayTreeSax(benchmark::State& state) {
+    auto payload = tree(static_cast<int>(state.range(0)));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(sway::parse_focused_tree(payload));
+    }
+}
+BENCHMARK(BM_SwayTreeSax)->Arg(4)->Arg(64)->Unit(benchmark::kMicrosecond);
+
+} // namespace
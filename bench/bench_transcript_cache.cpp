@@ -0,0 +1,41 @@
+#include <benchmark/benchmark.h>
+
+#include "hash.hpp"
+#include "whisper/caching_backend.hpp"
+
+#include <vector>
+
+namespace {
+
+struct NullBackend : WhisperBackend {
+    std::expected<TranscriptResult, std::string>
+    transcribe(std::span<const int16_t>, uint32_t) override {
+        return TranscriptResult{.text = "benchmark transcript"};
+    }
+};
+
+// What a lookup costs on top of the request: hashing range(0) seconds of audio.
+void BM_HashAudio(benchmark::State& state) {
+    std::vector<int16_t> audio(static_cast<size_t>(state.range(0)) * 16000);
+    for (size_t i = 0; i < audio.size(); ++i) audio[i] = static_cast<int16_t>(i * 31);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(hash::xxh64(audio.data(), audio.size() * sizeof(int16_t)));
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * audio.size() * sizeof(int16_t)));
+}
+BENCHMARK(BM_HashAudio)->Arg(5)->Arg(120);
+
+// A repeated 5 s clip: hash, lookup and copy of the cached result.
+void BM_CacheHit(benchmark::State& state) {
+    CachingBackend backend(std::make_unique<NullBackend>(), std::make_unique<TranscriptCache>(256),
+                           "bench");
+    std::vector<int16_t> audio(5 * 16000, 3);
+    backend.transcribe(audio, 16000, std::stop_token{});
+    for (auto _ : state) {
+        auto r = backend.transcribe(audio, 16000, std::stop_token{});
+        benchmark::DoNotOptimize(r);
+    }
+}
+BENCHMARK(BM_CacheHit);
+
+} // namespace
@@ -0,0 +1,37 @@
+#include <benchmark/benchmark.h>
+
+#include "wav_encoder.hpp"
+
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+namespace {
+
+constexpr uint32_t RATE = 16000;
+
+// The legacy whole-clip encode; the LAN backend now streams a header plus the
+// PCM in place, so this is the cost that path avoids.
+void BM_WavEncode(benchmark::State& state) {
+    size_t samples = static_cast<size_t>(state.range(0)) * RATE;
+    std::vector<int16_t> pcm(samples);
+    for (size_t i = 0; i < samples; ++i) {
+        pcm[i] = static_cast<int16_t>(8000 * std::sin(static_cast<double>(i) * 0.05));
+    }
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(wav::encode(pcm, RATE));
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * samples * sizeof(int16_t)));
+}
+BENCHMARK(BM_WavEncode)->Arg(1)->Arg(5)->Arg(15)->Arg(30)->Arg(60)->Arg(120)
+    ->Unit(benchmark::kMicrosecond);
+
+void BM_WavHeader(benchmark::State& state) {
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(wav::header(120 * RATE, RATE));
+    }
+}
+BENCHMARK(BM_WavHeader);
+
+} // namespace
@@ -19,6 +19,7 @@ fi
 # Copy binaries
 echo "Installing binaries to $INSTALL_DIR..."
 install -m 755 "$BUILD_DIR/sa" "$INSTALL_DIR/sa"
+install -m 755 "$BUILD_DIR/sa-trigger" "$INSTALL_DIR/sa-trigger"
 install -m 755 "$BUILD_DIR/speak-anywhere" "$INSTALL_DIR/speak-anywhere"
 
 echo "Starting speak-anywhere.service..."
@@ -1,8 +1,13 @@
 #include "platform/linux/unix_socket_client.hpp"
 #include "platform/platform_paths.hpp"
 
+#include <cstdint>
+#include <cstdio>
 #include <cstdlib>
+#include <format>
+#include <fstream>
 #include <iostream>
+#include <iterator>
 #include <nlohmann/json.hpp>
 #include <print>
 #include <string>
@@ -13,11 +18,95 @@ using json = nlohmann::json;
 static void usage(const char* prog) {
     std::println(stderr, "Usage: {} <command> [options]", prog);
     std::println(stderr, "Commands:");
-    std::println(stderr, "  start [--output clipboard|type]   Start recording");
+    std::println(stderr, "  start [--output clipboard|type|none] [--auto-stop]");
+    std::println(stderr, "                                    Start recording (--auto-stop: end it on silence)");
     std::println(stderr, "  stop                              Stop recording and transcribe");
-    std::println(stderr, "  toggle [--output clipboard|type]  Toggle recording");
+    std::println(stderr, "  toggle [--output clipboard|type] [--auto-stop]");
+    std::println(stderr, "                                    Toggle recording");
+    std::println(stderr, "  cancel [--job N]                  Discard recording, abort pending transcriptions");
     std::println(stderr, "  status                            Show daemon status");
     std::println(stderr, "  history [--limit N]               Show transcription history");
+    std::println(stderr, "  search [filters] [--limit N] [--after CURSOR] WORDS...");
+    std::println(stderr, "                                    Search history (filters: --app ID, --agent NAME,");
+    std::println(stderr, "                                    --dir PATH, --since DATE, --before DATE)");
+    std::println(stderr, "  retranscribe ID [--fresh]         Transcribe the kept audio of history entry ID again");
+    std::println(stderr, "                                    (--fresh: bypass the transcript cache)");
+    std::println(stderr, "  metrics                           Show per-stage latency percentiles");
+    std::println(stderr, "  stats [--since DATE] [--before DATE]");
+    std::println(stderr, "                                    Words and audio per day, app and agent; speed per backend");
+    std::println(stderr, "  export [--format ndjson|csv]      Write the whole history to stdout, oldest first");
+    std::println(stderr, "  import FILE [--format ndjson|csv] Add an exported history (all of it or none)");
+    std::println(stderr, "  subscribe [--waybar]              Print live events as JSON lines (--waybar: as");
+    std::println(stderr, "                                    waybar custom module output)");
+}
+
+// Sends the file in chunks well under the daemon's message limit, each cut
+// after a newline so none splits a character. The daemon imports them
+// together once the last is in.
+static int import_file(IpcClient& client, const std::string& path, std::string format) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        std::println(stderr, "Cannot read {}", path);
+        return 1;
+    }
+    std::string data{std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+    if (format.empty()) format = path.ends_with(".csv") ? "csv" : "ndjson";
+
+    constexpr size_t CHUNK = 4u << 20;
+    size_t pos = 0;
+    json response;
+    do {
+        size_t end = data.size();
+        if (end - pos > CHUNK) {
+            end = data.rfind('\n', pos + CHUNK);
+            end = (end == std::string::npos || end < pos) ? pos + CHUNK : end + 1;
+        }
+        json cmd = {{"cmd", "import"}, {"format", format}, {"data", data.substr(pos, end - pos)}};
+        pos = end;
+        if (pos < data.size()) cmd["more"] = true;
+        // The last chunk waits for the whole import to commit.
+        if (!client.send(cmd) || !client.recv(response, 300000)) {
+            std::println(stderr, "No response from daemon (timeout)");
+            return 1;
+        }
+        if (response.value("status", "") != "ok") {
+            std::println(stderr, "Error: {}", response.value("message", "unknown error"));
+            return 1;
+        }
+    } while (pos < data.size());
+
+    std::println("Imported {} entries", response.value("imported", 0));
+    return 0;
+}
+
+// Turns a subscription event into a line for a waybar custom module with
+// "return-type": "json". Returns false for events that change nothing shown.
+static bool waybar_line(const json& event, json& bar, std::string& last_text) {
+    auto kind = event.value("event", "");
+    if (kind == "state") {
+        auto state = event.value("state", "idle");
+        bar["class"] = state;
+        if (state == "recording") {
+            bar["text"] = "\u25cf 0:00";
+            bar["tooltip"] = event.value("context", "");
+        } else if (state == "transcribing") {
+            bar["text"] = "\u2026";
+        } else {
+            bar["text"] = "";
+            bar["tooltip"] = last_text;
+        }
+    } else if (kind == "level") {
+        int secs = static_cast<int>(event.value("duration", 0.0));
+        bar["text"] = std::format("\u25cf {}:{:02}", secs / 60, secs % 60);
+    } else if (kind == "partial") {
+        bar["tooltip"] = event.value("text", "");
+    } else if (kind == "result") {
+        last_text = event.value("text", "");
+        bar["tooltip"] = last_text;
+    } else {
+        return false;
+    }
+    return true;
 }
 
 int main(int argc, char* argv[]) {
@@ -28,15 +117,47 @@ int main(int argc, char* argv[]) {
 
     std::string command = argv[1];
     std::string output_method;
+    std::string format;
+    bool auto_stop = false;
+    bool waybar = false;
+    bool fresh = false;
     int limit = 10;
+    uint64_t job_id = 0;
+    json search_args = json::object();
+    std::string query;
 
     // Parse optional args
     for (int i = 2; i < argc; i++) {
         std::string arg = argv[i];
         if (arg == "--output" && i + 1 < argc) {
             output_method = argv[++i];
+        } else if (arg == "--auto-stop") {
+            auto_stop = true;
+        } else if (arg == "--waybar") {
+            waybar = true;
+        } else if (arg == "--fresh") {
+            fresh = true;
+        } else if (arg == "--format" && i + 1 < argc) {
+            format = argv[++i];
         } else if (arg == "--limit" && i + 1 < argc) {
             limit = std::atoi(argv[++i]);
+        } else if (arg == "--job" && i + 1 < argc) {
+            job_id = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--app" && i + 1 < argc) {
+            search_args["app_id"] = argv[++i];
+        } else if (arg == "--agent" && i + 1 < argc) {
+            search_args["agent"] = argv[++i];
+        } else if (arg == "--dir" && i + 1 < argc) {
+            search_args["working_dir"] = argv[++i];
+        } else if (arg == "--since" && i + 1 < argc) {
+            search_args["since"] = argv[++i];
+        } else if (arg == "--before" && i + 1 < argc) {
+            search_args["before"] = argv[++i];
+        } else if (arg == "--after" && i + 1 < argc) {
+            search_args["after"] = argv[++i];
+        } else if (!arg.starts_with("--")) {
+            if (!query.empty()) query += ' ';
+            query += arg;
         }
     }
 
@@ -45,15 +166,43 @@ int main(int argc, char* argv[]) {
     if (command == "start") {
         cmd = {{"cmd", "start"}};
         if (!output_method.empty()) cmd["output"] = output_method;
+        if (auto_stop) cmd["auto_stop"] = true;
     } else if (command == "stop") {
         cmd = {{"cmd", "stop"}};
     } else if (command == "toggle") {
         cmd = {{"cmd", "toggle"}};
         if (!output_method.empty()) cmd["output"] = output_method;
+        if (auto_stop) cmd["auto_stop"] = true;
+    } else if (command == "cancel") {
+        cmd = {{"cmd", "cancel"}};
+        if (job_id != 0) cmd["job_id"] = job_id;
     } else if (command == "status") {
         cmd = {{"cmd", "status"}};
     } else if (command == "history") {
         cmd = {{"cmd", "history"}, {"limit", limit}};
+    } else if (command == "search") {
+        cmd = search_args;
+        cmd["cmd"] = "search";
+        cmd["query"] = query;
+        cmd["limit"] = limit;
+    } else if (command == "retranscribe") {
+        cmd = {{"cmd", "retranscribe"}, {"id", std::atoll(query.c_str())}};
+        if (fresh) cmd["fresh"] = true;
+    } else if (command == "metrics") {
+        cmd = {{"cmd", "metrics"}};
+    } else if (command == "subscribe") {
+        cmd = {{"cmd", "subscribe"}};
+    } else if (command == "stats") {
+        cmd = {{"cmd", "stats"}};
+        if (search_args.contains("since")) cmd["since"] = search_args["since"];
+        if (search_args.contains("before")) cmd["before"] = search_args["before"];
+    } else if (command == "export") {
+        cmd = {{"cmd", "export"}, {"format", format.empty() ? "ndjson" : format}};
+    } else if (command == "import") {
+        if (query.empty()) {
+            usage(argv[0]);
+            return 1;
+        }
     } else {
         std::println(stderr, "Unknown command: {}", command);
         usage(argv[0]);
@@ -61,7 +210,8 @@ int main(int argc, char* argv[]) {
     }
 
     // Connect and send
-    UnixSocketClient client;
+    // Binary frames: no JSON text to build or scan for the newline.
+    UnixSocketClient client(ipc::Encoding::Cbor);
     auto sock_path = platform::ipc_endpoint();
 
     if (!client.connect(sock_path)) {
@@ -70,6 +220,8 @@ int main(int argc, char* argv[]) {
         return 1;
     }
 
+    if (command == "import") return import_file(client, query, format);
+
     if (!client.send(cmd)) {
         std::println(stderr, "Failed to send command");
         return 1;
@@ -84,21 +236,133 @@ int main(int argc, char* argv[]) {
     // Display response
     auto status = response.value("status", "");
 
+    if (command == "subscribe" && status == "ok") {
+        // One event per line until the daemon goes away.
+        json event;
+        json bar = {{"text", ""}, {"class", "idle"}, {"tooltip", ""}};
+        std::string last_text;
+        while (client.recv(event, -1)) {
+            if (!waybar) {
+                std::println("{}", event.dump());
+            } else if (waybar_line(event, bar, last_text)) {
+                std::println("{}", bar.dump());
+            } else {
+                continue;
+            }
+            std::fflush(stdout);
+        }
+        return 0;
+    }
+
+    if (command == "export" && status == "ok") {
+        // The rows follow the response until the daemon hangs up.
+        std::string chunk;
+        while (client.recv_bytes(chunk)) std::fwrite(chunk.data(), 1, chunk.size(), stdout);
+        return 0;
+    }
+
     if (command == "status") {
         auto state = response.value("state", "unknown");
         std::println("State: {}", state);
         if (response.contains("duration")) {
             std::println("Recording duration: {:.1f}s", response["duration"].get<double>());
         }
+        if (auto level = response.value("level", json::object()); !level.empty()) {
+            std::println("Input level: {:.0f} dBFS, peak {:.1f} dBFS, {:.2f}% clipped",
+                         level.value("rms_db", -90.0), level.value("peak_db", -90.0),
+                         level.value("clipped_pct", 0.0));
+        }
+        if (response.value("pending_jobs", 0) > 0) {
+            std::println("Pending transcriptions: {}", response["pending_jobs"].get<int>());
+        }
+        auto capture = response.value("capture", json::object());
+        if (capture.value("callbacks", uint64_t{0}) > 0) {
+            std::println("Capture: {} frames/callback, callback {:.1f}us avg, {:.1f}us max",
+                         capture.value("quantum", 0u), capture.value("callback_avg_us", 0.0),
+                         capture.value("callback_max_us", 0.0));
+        }
+        if (capture.value("dropped_bytes", uint64_t{0}) > 0 || capture.value("underruns", uint64_t{0}) > 0) {
+            std::println("Capture problems: {} bytes dropped, {} underruns",
+                         capture.value("dropped_bytes", uint64_t{0}), capture.value("underruns", uint64_t{0}));
+        }
+        if (auto locked = capture.value("locked_bytes", uint64_t{0}); locked > 0) {
+            std::println("Capture buffers: {} KiB locked{}", locked >> 10,
+                         capture.value("hugepages", false) ? ", on hugepages" : "");
+        }
+        if (auto cpus = capture.value("cpus", std::vector<int>{}); !cpus.empty()) {
+            std::string list;
+            for (int cpu : cpus) {
+                if (!list.empty()) list += ",";
+                list += std::to_string(cpu);
+            }
+            std::println("Capture threads: on CPUs {}", list);
+        }
+        for (auto& server : response.value("servers", json::array())) {
+            auto state = server.value("state", "closed");
+            if (state == "closed") {
+                std::println("Server {}: up", server.value("name", ""));
+            } else {
+                std::println("Server {}: down ({}), {} requests skipped", server.value("name", ""),
+                             server.value("last_error", ""), server.value("rejected", uint64_t{0}));
+            }
+        }
     } else if (command == "history") {
         if (response.contains("entries")) {
             for (auto& entry : response["entries"]) {
-                std::println("[{}] {}", entry.value("timestamp", ""), entry.value("text", ""));
+                std::println("[{}] #{} {}", entry.value("timestamp", ""), entry.value("id", 0),
+                             entry.value("text", ""));
                 if (entry.contains("app_context") && !entry["app_context"].is_null()) {
                     std::println("  Context: {}", entry["app_context"].get<std::string>());
                 }
             }
         }
+    } else if (command == "search" && status == "ok") {
+        for (auto& hit : response["hits"]) {
+            std::println("[{}] #{} {}", hit.value("timestamp", ""), hit.value("id", 0),
+                         hit.value("snippet", ""));
+            if (auto ctx = hit.value("app_context", ""); !ctx.empty()) {
+                std::println("  Context: {}", ctx);
+            }
+        }
+        if (response.contains("next")) {
+            std::println("More results: --after {}", response["next"].get<std::string>());
+        }
+    } else if (command == "retranscribe" && status == "ok") {
+        std::println("{}", response.value("text", ""));
+        if (response.value("cached", false)) std::println(stderr, "(from cache; --fresh asks the backend)");
+        std::println(stderr, "Was: {}", response.value("original_text", ""));
+    } else if (command == "metrics" && status == "ok") {
+        std::println("Transcriptions: {}", response.value("transcriptions", 0));
+        std::println("{:<10} {:>6} {:>9} {:>9} {:>9} {:>9}", "stage", "count", "p50 ms", "p95 ms",
+                     "p99 ms", "max ms");
+        for (auto& [name, s] : response["stages"].items()) {
+            std::println("{:<10} {:>6} {:>9.1f} {:>9.1f} {:>9.1f} {:>9.1f}", name,
+                         s.value("count", 0), s.value("p50", 0.0) * 1000, s.value("p95", 0.0) * 1000,
+                         s.value("p99", 0.0) * 1000, s.value("max", 0.0) * 1000);
+        }
+        auto buf = response.value("audio_buffer", json::object());
+        if (buf.value("overflows", 0) > 0) {
+            std::println("Audio dropped: {} bytes in {} overflows", buf.value("overflow_bytes", 0),
+                         buf.value("overflows", 0));
+        }
+    } else if (command == "stats" && status == "ok") {
+        std::println("{} entries, {} words, {:.0f} s of audio", response.value("entries", 0),
+                     response.value("words", 0), response.value("audio_seconds", 0.0));
+        std::println("{:<10} {:<16} {:<10} {:>7} {:>7} {:>8}", "day", "app", "agent", "entries", "words",
+                     "audio s");
+        for (auto& d : response["days"]) {
+            std::println("{:<10} {:<16} {:<10} {:>7} {:>7} {:>8.0f}", d.value("day", ""), d.value("app", ""),
+                         d.value("agent", ""), d.value("entries", 0), d.value("words", 0),
+                         d.value("audio_seconds", 0.0));
+        }
+        std::println("{:<16} {:>7} {:>8} {:>6}", "backend", "entries", "audio s", "RTF");
+        for (auto& b : response["backends"]) {
+            std::println("{:<16} {:>7} {:>8.0f} {:>6.2f}", b.value("backend", ""), b.value("entries", 0),
+                         b.value("audio_seconds", 0.0), b.value("real_time_factor", 0.0));
+        }
+    } else if (command == "cancel" && status == "ok") {
+        if (response.value("discarded_recording", false)) std::println("Recording discarded");
+        std::println("Cancelled transcriptions: {}", response.value("cancelled_jobs", 0));
     } else if (status == "ok") {
         if (response.contains("text")) {
             std::println("{}", response["text"].get<std::string>());
@@ -9,5 +9,8 @@ public:
     virtual bool connect(const std::string& endpoint) = 0;
     virtual bool send(const nlohmann::json& cmd) = 0;
     virtual bool recv(nlohmann::json& response, int timeout_ms = 30000) = 0;
+    // Unframed bytes after the last response (an export's rows), whatever
+    // has arrived. False once the daemon has closed the connection.
+    virtual bool recv_bytes(std::string& out, int timeout_ms = 30000) = 0;
     virtual void close() = 0;
 };
@@ -1,5 +1,6 @@
 #include "platform/linux/unix_socket_client.hpp"
 
+#include <algorithm>
 #include <cerrno>
 #include <cstring>
 #include <poll.h>
@@ -7,7 +8,7 @@
 #include <sys/un.h>
 #include <unistd.h>
 
-UnixSocketClient::UnixSocketClient() = default;
+UnixSocketClient::UnixSocketClient(ipc::Encoding encoding) : encoding_(encoding) {}
 
 UnixSocketClient::~UnixSocketClient() {
     close();
@@ -31,7 +32,7 @@ bool UnixSocketClient::connect(const std::string& endpoint) {
 
 bool UnixSocketClient::send(const nlohmann::json& cmd) {
     if (fd_ < 0) return false;
-    std::string msg = cmd.dump() + "\n";
+    std::string msg = ipc::encode(cmd, encoding_);
     ssize_t sent = ::send(fd_, msg.data(), msg.size(), MSG_NOSIGNAL);
     return sent == static_cast<ssize_t>(msg.size());
 }
@@ -40,9 +41,17 @@ bool UnixSocketClient::recv(nlohmann::json& response, int timeout_ms) {
     if (fd_ < 0) return false;
 
     pollfd pfd{.fd = fd_, .events = POLLIN, .revents = 0};
-    std::string buf;
 
+    // A subscription sends lines back to back; whatever follows this one is
+    // kept for the next call.
     while (true) {
+        auto decoded = ipc::decode(buf_, response);
+        if (decoded.status == ipc::DecodeStatus::Invalid) return false;
+        if (decoded.status == ipc::DecodeStatus::Ok) {
+            buf_.erase(0, decoded.consumed);
+            return true;
+        }
+
         int ret = ::poll(&pfd, 1, timeout_ms);
         if (ret <= 0) return false;
 
@@ -50,17 +59,26 @@ bool UnixSocketClient::recv(nlohmann::json& response, int timeout_ms) {
         ssize_t n = ::recv(fd_, tmp, sizeof(tmp), 0);
         if (n <= 0) return false;
 
-        buf.append(tmp, static_cast<size_t>(n));
-        auto pos = buf.find('\n');
-        if (pos != std::string::npos) {
-            try {
-                response = nlohmann::json::parse(buf.substr(0, pos));
-                return true;
-            } catch (...) {
-                return false;
-            }
-        }
+        buf_.append(tmp, static_cast<size_t>(n));
+    }
+}
+
+bool UnixSocketClient::recv_bytes(std::string& out, int timeout_ms) {
+    if (fd_ < 0) return false;
+    // What came in with the response goes first.
+    if (!buf_.empty()) {
+        out = std::move(buf_);
+        buf_.clear();
+        return true;
     }
+
+    pollfd pfd{.fd = fd_, .events = POLLIN, .revents = 0};
+    if (::poll(&pfd, 1, timeout_ms) <= 0) return false;
+
+    out.resize(64 * 1024);
+    ssize_t n = ::recv(fd_, out.data(), out.size(), 0);
+    out.resize(static_cast<size_t>(std::max<ssize_t>(n, 0)));
+    return n > 0;
 }
 
 void UnixSocketClient::close() {
@@ -68,4 +86,5 @@ void UnixSocketClient::close() {
         ::close(fd_);
         fd_ = -1;
     }
+    buf_.clear();
 }
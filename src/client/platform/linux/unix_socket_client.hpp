@@ -1,10 +1,14 @@
 #pragma once
 
+#include "ipc_protocol.hpp"
 #include "platform/ipc_client.hpp"
 
+#include <string>
+
 class UnixSocketClient : public IpcClient {
 public:
-    UnixSocketClient();
+    // Commands go out in encoding; responses are read in whichever arrives.
+    explicit UnixSocketClient(ipc::Encoding encoding = ipc::Encoding::JsonLines);
     ~UnixSocketClient() override;
 
     UnixSocketClient(const UnixSocketClient&) = delete;
@@ -13,8 +17,11 @@ public:
     bool connect(const std::string& endpoint) override;
     bool send(const nlohmann::json& cmd) override;
     bool recv(nlohmann::json& response, int timeout_ms = 30000) override;
+    bool recv_bytes(std::string& out, int timeout_ms = 30000) override;
     void close() override;
 
 private:
     int fd_ = -1;
+    ipc::Encoding encoding_;
+    std::string buf_;  // received past the last line returned
 };
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "audio/vad.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+// Decides when a hands-free recording is over: after silence_ms of quiet
+// once speech has been heard, or, if none has been by no_speech_ms, that it
+// was started by mistake (0 waits for speech indefinitely).
+class AutoStop {
+public:
+    enum class Decision { Continue, Stop, Discard };
+
+    // Less speech than this (a click, a cough) doesn't arm the stop.
+    static constexpr uint32_t MIN_SPEECH_MS = 150;
+
+    AutoStop(uint32_t sample_rate, double threshold_db, uint32_t silence_ms, uint32_t no_speech_ms)
+        : vad_(sample_rate, threshold_db), sample_rate_(sample_rate),
+          silence_samples_(samples(silence_ms)), no_speech_samples_(samples(no_speech_ms)),
+          min_speech_samples_(samples(MIN_SPEECH_MS)) {}
+
+    Decision feed(std::span<const int16_t> audio) {
+        vad_.process(audio);
+        fed_ += audio.size();
+        return decide();
+    }
+
+    Decision decide() const {
+        if (heard()) {
+            return vad_.trailing_silence_samples() >= silence_samples_ ? Decision::Stop : Decision::Continue;
+        }
+        // Counted in samples fed, not whole VAD frames, so it isn't a frame late.
+        if (no_speech_samples_ > 0 && fed_ >= no_speech_samples_) {
+            return Decision::Discard;
+        }
+        return Decision::Continue;
+    }
+
+    // Audio still to come before the next decision could change, in ms.
+    uint32_t ms_until_decision() const {
+        size_t remaining;
+        if (heard()) {
+            remaining = silence_samples_ - std::min(silence_samples_, vad_.trailing_silence_samples());
+        } else if (no_speech_samples_ > 0) {
+            remaining = no_speech_samples_ - std::min(no_speech_samples_, fed_);
+        } else {
+            remaining = silence_samples_;
+        }
+        return static_cast<uint32_t>(remaining * 1000 / sample_rate_);
+    }
+
+    bool heard() const { return vad_.speech_samples() >= min_speech_samples_; }
+
+private:
+    size_t samples(uint32_t ms) const { return static_cast<size_t>(sample_rate_) * ms / 1000; }
+
+    Vad vad_;
+    uint32_t sample_rate_;
+    size_t silence_samples_;
+    size_t no_speech_samples_;
+    size_t min_speech_samples_;
+    size_t fed_ = 0;
+};
@@ -0,0 +1,121 @@
+#include "audio/file_capture.hpp"
+
+#include "audio/resampler.hpp"
+#include "wav_encoder.hpp"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+std::expected<std::vector<int16_t>, std::string> load(const fs::path& path, uint32_t sample_rate) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) return std::unexpected(path.string() + ": cannot read");
+    std::vector<uint8_t> file{std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+
+    auto clip = wav::decode(file);
+    if (!clip) return std::unexpected(path.string() + ": " + clip.error());
+    if (clip->channels == 1 && clip->sample_rate == sample_rate) return std::move(clip->samples);
+
+    std::vector<float> in_f(clip->samples.size());
+    std::ranges::transform(clip->samples, in_f.begin(), [](int16_t s) { return s / 32768.0f; });
+    std::vector<int16_t> out;
+    Resampler(clip->sample_rate, sample_rate, clip->channels).process(in_f, out);
+    return out;
+}
+
+} // namespace
+
+FileAudioCapture::FileAudioCapture(RingBuffer& ring_buf, uint32_t sample_rate)
+    : ring_buf_(ring_buf), sample_rate_(sample_rate) {}
+
+FileAudioCapture::~FileAudioCapture() {
+    stop();
+}
+
+std::expected<size_t, std::string> FileAudioCapture::open(const std::string& path) {
+    std::vector<fs::path> files;
+    std::error_code ec;
+    if (fs::is_directory(path, ec)) {
+        for (auto& entry : fs::directory_iterator(path, ec)) {
+            if (entry.path().extension() == ".wav") files.push_back(entry.path());
+        }
+        std::ranges::sort(files);
+        if (files.empty()) return std::unexpected(path + ": no .wav files");
+    } else {
+        files.emplace_back(path);
+    }
+
+    std::vector<std::vector<int16_t>> clips;
+    for (auto& file : files) {
+        auto clip = load(file, sample_rate_);
+        if (!clip) return std::unexpected(clip.error());
+        clips.push_back(std::move(*clip));
+    }
+    clips_ = std::move(clips);
+    next_clip_ = 0;
+    return clips_.size();
+}
+
+bool FileAudioCapture::start() {
+    if (capturing_.load(std::memory_order_relaxed)) return true;
+    if (clips_.empty()) return false;
+
+    ring_buf_.reset();
+    auto& clip = clips_[next_clip_];
+    next_clip_ = (next_clip_ + 1) % clips_.size();
+    capturing_.store(true, std::memory_order_release);
+    player_ = std::jthread([this, &clip](std::stop_token stop) { play(stop, clip); });
+    return true;
+}
+
+void FileAudioCapture::stop() {
+    if (!capturing_.load(std::memory_order_relaxed)) return;
+    player_ = {};  // requests stop and joins
+    capturing_.store(false, std::memory_order_release);
+}
+
+void FileAudioCapture::play(std::stop_token stop, const std::vector<int16_t>& clip) {
+    const size_t block = sample_rate_ * BLOCK_MS / 1000;
+    const std::vector<int16_t> silence(block);
+    auto next = std::chrono::steady_clock::now();
+    // Blocks go out on a fixed schedule: a late wakeup doesn't slow the clip.
+    for (size_t pos = 0; !stop.stop_requested(); pos += block) {
+        next += std::chrono::milliseconds(BLOCK_MS);
+        std::this_thread::sleep_until(next);
+
+        const int16_t* data = silence.data();
+        size_t n = block;
+        if (pos < clip.size()) {
+            data = clip.data() + pos;
+            n = std::min(block, clip.size() - pos);
+        }
+        size_t bytes = n * sizeof(int16_t);
+        size_t written = ring_buf_.write(data, bytes);
+        blocks_.store(blocks_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        bytes_.store(bytes_.load(std::memory_order_relaxed) + written, std::memory_order_relaxed);
+        if (written < bytes) {
+            dropped_bytes_.store(dropped_bytes_.load(std::memory_order_relaxed) + bytes - written,
+                                 std::memory_order_relaxed);
+        }
+    }
+}
+
+CaptureStats FileAudioCapture::stats() const {
+    return {
+        .callbacks = blocks_.load(std::memory_order_relaxed),
+        .bytes = bytes_.load(std::memory_order_relaxed),
+        .dropped_bytes = dropped_bytes_.load(std::memory_order_relaxed),
+        .quantum = sample_rate_ * BLOCK_MS / 1000,
+    };
+}
+
+std::vector<double> FileAudioCapture::clip_seconds() const {
+    std::vector<double> out;
+    for (auto& clip : clips_) out.push_back(static_cast<double>(clip.size()) / sample_rate_);
+    return out;
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "platform/audio_capture.hpp"
+#include "ring_buffer.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <expected>
+#include <stop_token>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Plays WAV files into the ring buffer in place of a microphone, for load
+// tests (speak-anywhere --replay, driven by sa-loadgen). Each start() takes
+// the next clip, round robin, and feeds it at real-time pace in BLOCK_MS
+// blocks; once the clip is over it feeds silence, as a quiet room would,
+// until stop().
+class FileAudioCapture : public AudioCapture {
+public:
+    static constexpr uint32_t BLOCK_MS = 20;
+
+    FileAudioCapture(RingBuffer& ring_buf, uint32_t sample_rate);
+    ~FileAudioCapture() override;
+
+    FileAudioCapture(const FileAudioCapture&) = delete;
+    FileAudioCapture& operator=(const FileAudioCapture&) = delete;
+
+    // A WAV file, or every .wav in a directory (in name order). 16-bit PCM
+    // at any rate and channel count: clips are converted to mono at
+    // sample_rate as they load. Returns the number of clips.
+    std::expected<size_t, std::string> open(const std::string& path);
+
+    bool start() override;
+    void stop() override;
+    bool is_capturing() const override { return capturing_.load(std::memory_order_relaxed); }
+    CaptureStats stats() const override;
+
+    // Seconds of each clip, in play order.
+    std::vector<double> clip_seconds() const;
+
+private:
+    void play(std::stop_token stop, const std::vector<int16_t>& clip);
+
+    RingBuffer& ring_buf_;
+    uint32_t sample_rate_;
+    std::vector<std::vector<int16_t>> clips_;
+    size_t next_clip_ = 0;
+    std::atomic<bool> capturing_{false};
+    std::jthread player_;
+
+    // Written by the player thread only.
+    std::atomic<uint64_t> blocks_{0};
+    std::atomic<uint64_t> bytes_{0};
+    std::atomic<uint64_t> dropped_bytes_{0};
+};
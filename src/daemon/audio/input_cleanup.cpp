@@ -0,0 +1,135 @@
+#include "audio/input_cleanup.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <numbers>
+
+namespace {
+
+constexpr double MIN_DB = -90.0;
+// Blocks count as speech above this and NOISE_MARGIN_DB over the floor.
+constexpr double MIN_SPEECH_DB = -55.0;
+constexpr double NOISE_MARGIN_DB = 10.0;
+// The floor follows quieter blocks at once, and rises towards the quietest
+// block of the last half to whole second: steady noise has no quieter gaps,
+// speech has them between syllables, so talking doesn't raise it.
+constexpr double FLOOR_RISE = 0.05;
+constexpr size_t HALF_WINDOW_BLOCKS = 50;
+// The expander is fully open this far over the floor, fully closed at it.
+constexpr double OPEN_DB = 6.0;
+// Weight of each speech block in the speech level AGC follows.
+constexpr double SPEECH_WEIGHT = 0.1;
+// AGC gain change per block: up slowly, so a pause doesn't pump the room
+// up, and down quickly, so a shout doesn't clip for long.
+constexpr double AGC_RISE_DB = 0.3;
+constexpr double AGC_FALL_DB = 2.0;
+// Filter state this small is flushed, so silence doesn't go denormal.
+constexpr double DENORMAL = 1e-15;
+
+double to_gain(double db) { return std::pow(10.0, db / 20.0); }
+
+int16_t saturate(double v) {
+    return static_cast<int16_t>(std::clamp(std::lrint(v), -32768L, 32767L));
+}
+
+} // namespace
+
+InputCleanup::InputCleanup(uint32_t sample_rate, const Options& options)
+    : options_(options),
+      block_len_(std::max<size_t>(1, static_cast<size_t>(sample_rate) * BLOCK_MS / 1000)),
+      release_db_(options.suppression_db * BLOCK_MS / RELEASE_MS),
+      floor_db_(MIN_DB), speech_db_(MIN_DB) {
+    if (options_.denoise) {
+        // Second-order Butterworth high-pass (Q = 1/sqrt 2).
+        double w0 = 2.0 * std::numbers::pi * HIGHPASS_HZ / std::max<uint32_t>(1, sample_rate);
+        double alpha = std::sin(w0) / std::numbers::sqrt2;
+        double cosw = std::cos(w0);
+        double a0 = 1.0 + alpha;
+        b0_ = (1.0 + cosw) / 2.0 / a0;
+        b1_ = -(1.0 + cosw) / a0;
+        b2_ = b0_;
+        a1_ = -2.0 * cosw / a0;
+        a2_ = (1.0 - alpha) / a0;
+    }
+}
+
+void InputCleanup::process(std::span<int16_t> samples) {
+    double step = (to_gain_ - from_gain_) / static_cast<double>(block_len_);
+    for (auto& s : samples) {
+        double x = s;
+        double y = x;
+        if (options_.denoise) {
+            y = b0_ * x + b1_ * x1_ + b2_ * x2_ - a1_ * y1_ - a2_ * y2_;
+            x2_ = x1_;
+            x1_ = x;
+            y2_ = y1_;
+            y1_ = y;
+        }
+        block_energy_ += y * y;
+        ++pos_;
+        s = saturate(y * (from_gain_ + step * static_cast<double>(pos_)));
+        if (pos_ == block_len_) {
+            end_block();
+            step = (to_gain_ - from_gain_) / static_cast<double>(block_len_);
+        }
+    }
+    samples_ += samples.size();
+}
+
+void InputCleanup::reset() {
+    x1_ = x2_ = y1_ = y2_ = 0;
+    samples_ = pos_ = blocks_ = 0;
+    block_energy_ = 0;
+    floor_db_ = speech_db_ = MIN_DB;
+    window_min_db_ = last_min_db_ = 0;
+    heard_speech_ = false;
+    gate_db_ = agc_db_ = 0;
+    from_gain_ = to_gain_ = 1;
+}
+
+void InputCleanup::end_block() {
+    double mean = block_energy_ / static_cast<double>(block_len_) / (32768.0 * 32768.0);
+    double level = mean > 0 ? std::max(MIN_DB, 10.0 * std::log10(mean)) : MIN_DB;
+    block_energy_ = 0;
+    pos_ = 0;
+
+    // Seeded from the first block, but never so high that speech from the
+    // first syllable would be taken for the background.
+    if (blocks_++ == 0) floor_db_ = std::min(level, MIN_SPEECH_DB);
+    bool speech = level > MIN_SPEECH_DB && level > floor_db_ + NOISE_MARGIN_DB;
+    window_min_db_ = std::min(window_min_db_, level);
+    double quietest = std::min(window_min_db_, last_min_db_);
+    if (blocks_ % HALF_WINDOW_BLOCKS == 0) {
+        last_min_db_ = window_min_db_;
+        window_min_db_ = 0;
+    }
+    if (level < floor_db_) {
+        floor_db_ = level;
+    } else if (quietest > floor_db_) {
+        floor_db_ += (quietest - floor_db_) * FLOOR_RISE;
+    }
+
+    if (options_.denoise) {
+        double closed = std::clamp((floor_db_ + OPEN_DB - level) / OPEN_DB, 0.0, 1.0);
+        double want = -options_.suppression_db * closed;
+        gate_db_ = want >= gate_db_ ? want : std::max(want, gate_db_ - release_db_);
+    }
+
+    if (options_.agc) {
+        if (speech) {
+            speech_db_ = heard_speech_ ? speech_db_ + (level - speech_db_) * SPEECH_WEIGHT : level;
+            heard_speech_ = true;
+        }
+        if (heard_speech_) {
+            double want = std::clamp(options_.target_db - speech_db_, -options_.max_gain_db, options_.max_gain_db);
+            agc_db_ = want > agc_db_ ? std::min(want, agc_db_ + AGC_RISE_DB)
+                                     : std::max(want, agc_db_ - AGC_FALL_DB);
+        }
+    }
+
+    from_gain_ = to_gain_;
+    to_gain_ = to_gain(gate_db_ + agc_db_);
+
+    if (std::abs(y1_) < DENORMAL) y1_ = 0;
+    if (std::abs(y2_) < DENORMAL) y2_ = 0;
+}
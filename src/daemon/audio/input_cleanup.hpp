@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+// Cleans the microphone signal up in place as the recording is drained
+// from the ring buffer, so what VAD, streaming and the encoder see has
+// less fan hum and keyboard between the words, and speech at a steady
+// level whatever the mic gain.
+//
+// Three stages, all in the time domain:
+//   - an 80 Hz high-pass (rumble, DC offset) when denoising;
+//   - a downward expander that pulls blocks near the noise floor (tracked
+//     from the quietest blocks of the last second) down by up to
+//     suppression_db, opening at once on speech and closing over RELEASE_MS;
+//   - AGC, which follows the level of the speech blocks and moves the gain
+//     towards target_db, capped at max_gain_db either way.
+// Gains are decided at the end of each BLOCK_MS block from the blocks
+// before and ramped across the next, so there is no lookahead: a chunk is
+// done when process() returns, and the output does not depend on how the
+// audio was split into chunks.
+class InputCleanup {
+public:
+    static constexpr uint32_t BLOCK_MS = 10;
+    static constexpr double HIGHPASS_HZ = 80.0;
+    static constexpr uint32_t RELEASE_MS = 100;
+
+    struct Options {
+        bool denoise = false;
+        double suppression_db = 18.0;
+        bool agc = false;
+        double target_db = -20.0;
+        double max_gain_db = 24.0;
+    };
+
+    InputCleanup(uint32_t sample_rate, const Options& options);
+
+    // Cleans samples in place; a trailing partial block carries over.
+    void process(std::span<int16_t> samples);
+    void reset();
+
+    // Samples processed so far, for catching up with a recording.
+    size_t samples() const { return samples_; }
+    double noise_floor_db() const { return floor_db_; }
+    // The gain the next block ramps to (expander and AGC), dB.
+    double gain_db() const { return gate_db_ + agc_db_; }
+
+private:
+    void end_block();
+
+    Options options_;
+    size_t block_len_;
+    double release_db_;  // per block
+
+    // High-pass biquad (direct form I) and its state.
+    double b0_ = 1, b1_ = 0, b2_ = 0, a1_ = 0, a2_ = 0;
+    double x1_ = 0, x2_ = 0, y1_ = 0, y2_ = 0;
+
+    size_t samples_ = 0;
+    size_t pos_ = 0;          // into the current block
+    double block_energy_ = 0;  // sum of squares of the filtered block
+    size_t blocks_ = 0;
+    double floor_db_;
+    double window_min_db_ = 0;  // quietest block of this half window
+    double last_min_db_ = 0;    // and of the one before
+    double speech_db_;  // tracked speech level, valid once heard_speech_
+    bool heard_speech_ = false;
+    double gate_db_ = 0;
+    double agc_db_ = 0;
+    double from_gain_ = 1;  // linear, at the start of the current block
+    double to_gain_ = 1;    // linear, at its end
+};
@@ -0,0 +1,90 @@
+#pragma once
+
+#include "audio/simd.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+// Input levels of the recording in progress, so a muted or overdriven mic
+// shows before a transcription is wasted on it. Fed each chunk as the main
+// thread drains the ring buffer (never on the audio thread); every sample
+// is looked at once, by the vectorized reductions in simd.hpp.
+class LevelMeter {
+public:
+    // At or beyond -0.1 dBFS counts as clipped.
+    static constexpr int16_t CLIP_LEVEL = 32393;
+    static constexpr double FLOOR_DB = -90.0;
+
+    struct Levels {
+        double rms_db = FLOOR_DB;
+        double peak_db = FLOOR_DB;
+        double clipped_pct = 0.0;  // of the samples, 0..100
+    };
+
+    // recent() covers the last window_samples (a meter's refresh interval).
+    explicit LevelMeter(size_t window_samples) : window_samples_(std::max<size_t>(1, window_samples)) {}
+
+    void feed(std::span<const int16_t> chunk) {
+        if (chunk.empty()) return;
+        Totals t{
+            .sum_squares = audio::sum_squares(chunk),
+            .peak = audio::peak_abs(chunk),
+            .clipped = audio::count_clipped(chunk, CLIP_LEVEL),
+            .samples = chunk.size(),
+        };
+        total_.add(t);
+        window_.add(t);
+        if (window_.samples >= window_samples_) {
+            last_window_ = window_;
+            window_ = {};
+        }
+    }
+
+    void reset() {
+        total_ = {};
+        window_ = {};
+        last_window_ = {};
+    }
+
+    size_t samples() const { return total_.samples; }
+    // Everything fed since reset().
+    Levels recording() const { return levels(total_); }
+    // The last full window, or what there is of the first one.
+    Levels recent() const { return levels(last_window_.samples > 0 ? last_window_ : window_); }
+
+private:
+    struct Totals {
+        uint64_t sum_squares = 0;
+        int32_t peak = 0;
+        size_t clipped = 0;
+        size_t samples = 0;
+
+        void add(const Totals& t) {
+            sum_squares += t.sum_squares;
+            peak = std::max(peak, t.peak);
+            clipped += t.clipped;
+            samples += t.samples;
+        }
+    };
+
+    static double to_db(double amplitude) {
+        return amplitude > 0.0 ? std::max(FLOOR_DB, 20.0 * std::log10(amplitude / 32768.0)) : FLOOR_DB;
+    }
+
+    static Levels levels(const Totals& t) {
+        if (t.samples == 0) return {};
+        return {
+            .rms_db = to_db(std::sqrt(static_cast<double>(t.sum_squares) / static_cast<double>(t.samples))),
+            .peak_db = to_db(t.peak),
+            .clipped_pct = 100.0 * static_cast<double>(t.clipped) / static_cast<double>(t.samples),
+        };
+    }
+
+    size_t window_samples_;
+    Totals total_;
+    Totals window_;
+    Totals last_window_;
+};
@@ -0,0 +1,86 @@
+#include "audio/resampler.hpp"
+
+#include "audio/simd.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <numbers>
+#include <numeric>
+
+namespace {
+
+// Pass band edge as a fraction of the lower Nyquist frequency; the Blackman
+// window's transition band sits above it.
+constexpr double CUTOFF = 0.85;
+
+} // namespace
+
+Resampler::Resampler(uint32_t in_rate, uint32_t out_rate, uint32_t channels, size_t taps_per_phase)
+    : in_rate_(in_rate), out_rate_(out_rate), channels_(std::max<uint32_t>(1, channels)),
+      taps_(std::max<size_t>(1, taps_per_phase)) {
+    size_t g = std::gcd(in_rate_, out_rate_);
+    up_ = out_rate_ / g;
+    down_ = in_rate_ / g;
+
+    // Prototype low-pass at in_rate * L, cut off below both Nyquist limits.
+    size_t n = up_ * taps_;
+    double fc = CUTOFF * 0.5 * std::min(in_rate_, out_rate_) / (static_cast<double>(in_rate_) * up_);
+    double center = static_cast<double>(n - 1) / 2;
+    std::vector<double> proto(n);
+    for (size_t k = 0; k < n; ++k) {
+        double x = static_cast<double>(k) - center;
+        double sinc = x == 0 ? 2 * fc : std::sin(2 * std::numbers::pi * fc * x) / (std::numbers::pi * x);
+        double w = n == 1 ? 1.0 : static_cast<double>(k) / static_cast<double>(n - 1);
+        double blackman = 0.42 - 0.5 * std::cos(2 * std::numbers::pi * w) + 0.08 * std::cos(4 * std::numbers::pi * w);
+        proto[k] = sinc * blackman;
+    }
+    // Zero stuffing divides the level by L; the branches put it back.
+    double sum = std::accumulate(proto.begin(), proto.end(), 0.0);
+    double gain = static_cast<double>(up_) / sum;
+
+    coeffs_.resize(n);
+    for (size_t p = 0; p < up_; ++p) {
+        for (size_t j = 0; j < taps_; ++j) {
+            coeffs_[p * taps_ + (taps_ - 1 - j)] = static_cast<float>(proto[p + j * up_] * gain);
+        }
+    }
+    reset();
+}
+
+void Resampler::reset() {
+    history_.assign(taps_ - 1, 0.0f);
+    next_ = (taps_ - 1) * up_;
+}
+
+void Resampler::filter(std::span<const float> interleaved, std::vector<float>& out) {
+    size_t frames = interleaved.size() / channels_;
+    size_t old = history_.size();
+    history_.resize(old + frames);
+    audio::downmix(interleaved.first(frames * channels_), channels_, history_.data() + old);
+
+    // Output y needs input positions [i - taps + 1, i] with i = next / L,
+    // through phase next % L.
+    while (next_ / up_ < history_.size()) {
+        size_t i = next_ / up_;
+        size_t phase = next_ % up_;
+        out.push_back(audio::dot(coeffs_.data() + phase * taps_, history_.data() + i + 1 - taps_, taps_));
+        next_ += down_;
+    }
+
+    // Keep just the lead-in the next output reaches back into.
+    size_t drop = std::min(history_.size(), next_ / up_ + 1 - taps_);
+    history_.erase(history_.begin(), history_.begin() + static_cast<std::ptrdiff_t>(drop));
+    next_ -= drop * up_;
+}
+
+void Resampler::process(std::span<const float> interleaved, std::vector<float>& out) {
+    filter(interleaved, out);
+}
+
+void Resampler::process(std::span<const float> interleaved, std::vector<int16_t>& out) {
+    scratch_.clear();
+    filter(interleaved, scratch_);
+    size_t old = out.size();
+    out.resize(old + scratch_.size());
+    audio::to_int16(scratch_.data(), scratch_.size(), out.data() + old);
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+// Streaming downmix and rational-ratio resampler for capture at the device's
+// native format (e.g. 48 kHz stereo float) down to the rate backends take.
+// The ratio out/in is reduced to L/M and a windowed-sinc low-pass is split
+// into L polyphase branches, so each output sample costs one dot product of
+// taps_per_phase input samples regardless of the ratio.
+class Resampler {
+public:
+    Resampler(uint32_t in_rate, uint32_t out_rate, uint32_t channels,
+              size_t taps_per_phase = DEFAULT_TAPS);
+
+    static constexpr size_t DEFAULT_TAPS = 96;
+
+    // Converts interleaved frames (a trailing partial frame is ignored) and
+    // appends the output. State carries over, so chunking doesn't change it.
+    void process(std::span<const float> interleaved, std::vector<float>& out);
+    void process(std::span<const float> interleaved, std::vector<int16_t>& out);
+    void reset();
+
+    uint32_t in_rate() const { return in_rate_; }
+    uint32_t out_rate() const { return out_rate_; }
+    uint32_t channels() const { return channels_; }
+
+private:
+    // Downmixes into history_ and appends the filtered samples to out.
+    void filter(std::span<const float> interleaved, std::vector<float>& out);
+
+    uint32_t in_rate_;
+    uint32_t out_rate_;
+    uint32_t channels_;
+    size_t up_;    // L
+    size_t down_;  // M
+    size_t taps_;
+    // Phase p's taps at [p * taps_, (p + 1) * taps_), reversed so they line
+    // up with the oldest-first history.
+    std::vector<float> coeffs_;
+    std::vector<float> history_;  // mono input, taps_ - 1 samples of lead-in
+    size_t next_ = 0;             // next output, in upsampled input positions
+    std::vector<float> scratch_;
+};
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "audio/simd.hpp"
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+// Finds the voiced part of a recording by scanning fixed frames inward from
+// both ends until one's RMS is above the threshold. A frame's peak is checked
+// first only to skip quiet frames cheaply: the RMS can't exceed the peak.
+namespace audio {
+
+struct TrimRange {
+    size_t begin = 0;
+    size_t end = 0;  // exclusive
+
+    size_t trimmed(size_t total) const { return total - (end - begin); }
+};
+
+inline TrimRange find_voiced_range(std::span<const int16_t> samples, uint32_t sample_rate,
+                                   double threshold_db, uint32_t padding_ms,
+                                   uint32_t frame_ms = 10) {
+    size_t n = samples.size();
+    size_t frame = std::max<size_t>(1, static_cast<size_t>(sample_rate) * frame_ms / 1000);
+    size_t pad = static_cast<size_t>(sample_rate) * padding_ms / 1000;
+
+    // Compare in the squared integer domain to avoid a sqrt/log per frame.
+    double amp = 32768.0 * std::pow(10.0, threshold_db / 20.0);
+    double amp_sq = amp * amp;
+
+    auto loud = [&](size_t pos) {
+        auto f = samples.subspan(pos, std::min(frame, n - pos));
+        if (audio::peak_abs(f) <= amp) return false;  // cheap reject
+        return static_cast<double>(audio::sum_squares(f)) > amp_sq * f.size();
+    };
+
+    size_t first = n;
+    for (size_t pos = 0; pos < n; pos += frame) {
+        if (loud(pos)) { first = pos; break; }
+    }
+    if (first == n) return {0, n};  // nothing above the threshold: leave it alone
+
+    size_t last = first;
+    size_t back = (n - 1) / frame * frame;
+    for (size_t pos = back + frame; pos > first; pos -= frame) {
+        if (loud(pos - frame)) { last = std::min(n, pos); break; }
+    }
+
+    return {
+        .begin = first > pad ? first - pad : 0,
+        .end = std::min(n, last + pad),
+    };
+}
+
+} // namespace audio
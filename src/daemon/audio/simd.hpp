@@ -0,0 +1,208 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cmath>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// Vectorized kernels over PCM. SSE2 is part of the x86-64 baseline, so no
+// runtime dispatch is needed; other targets use the scalar loops.
+namespace audio {
+
+// Sum of squared samples (exact, 64-bit).
+inline uint64_t sum_squares(std::span<const int16_t> samples) {
+    const int16_t* p = samples.data();
+    size_t n = samples.size();
+    size_t i = 0;
+    uint64_t total = 0;
+
+#if defined(__SSE2__)
+    const __m128i zero = _mm_setzero_si128();
+    __m128i acc_lo = zero;
+    __m128i acc_hi = zero;
+    for (; i + 8 <= n; i += 8) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+        // Each 32-bit lane is a*a + b*b <= 2^31, so it is exact as unsigned.
+        __m128i sq = _mm_madd_epi16(v, v);
+        acc_lo = _mm_add_epi64(acc_lo, _mm_unpacklo_epi32(sq, zero));
+        acc_hi = _mm_add_epi64(acc_hi, _mm_unpackhi_epi32(sq, zero));
+    }
+    alignas(16) uint64_t lanes[2];
+    _mm_store_si128(reinterpret_cast<__m128i*>(lanes), _mm_add_epi64(acc_lo, acc_hi));
+    total = lanes[0] + lanes[1];
+#endif
+
+    for (; i < n; ++i) {
+        total += static_cast<uint64_t>(static_cast<int32_t>(p[i]) * p[i]);
+    }
+    return total;
+}
+
+// Largest absolute sample value (0..32768).
+inline int32_t peak_abs(std::span<const int16_t> samples) {
+    const int16_t* p = samples.data();
+    size_t n = samples.size();
+    size_t i = 0;
+    int32_t hi = 0;
+    int32_t lo = 0;
+
+#if defined(__SSE2__)
+    if (n >= 8) {
+        __m128i vmax = _mm_setzero_si128();
+        __m128i vmin = _mm_setzero_si128();
+        for (; i + 8 <= n; i += 8) {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+            vmax = _mm_max_epi16(vmax, v);
+            vmin = _mm_min_epi16(vmin, v);
+        }
+        alignas(16) int16_t mx[8];
+        alignas(16) int16_t mn[8];
+        _mm_store_si128(reinterpret_cast<__m128i*>(mx), vmax);
+        _mm_store_si128(reinterpret_cast<__m128i*>(mn), vmin);
+        for (int k = 0; k < 8; ++k) {
+            hi = std::max<int32_t>(hi, mx[k]);
+            lo = std::min<int32_t>(lo, mn[k]);
+        }
+    }
+#endif
+
+    for (; i < n; ++i) {
+        hi = std::max<int32_t>(hi, p[i]);
+        lo = std::min<int32_t>(lo, p[i]);
+    }
+    return std::max(hi, -lo);
+}
+
+// Samples at or beyond +/-limit (0 < limit <= 32767): how much of the
+// signal sits at the rails when the input clips.
+inline size_t count_clipped(std::span<const int16_t> samples, int16_t limit) {
+    const int16_t* p = samples.data();
+    size_t n = samples.size();
+    size_t i = 0;
+    size_t count = 0;
+
+#if defined(__SSE2__)
+    const __m128i above = _mm_set1_epi16(static_cast<int16_t>(limit - 1));
+    const __m128i below = _mm_set1_epi16(static_cast<int16_t>(-limit + 1));
+    for (; i + 8 <= n; i += 8) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+        __m128i hit = _mm_or_si128(_mm_cmpgt_epi16(v, above), _mm_cmplt_epi16(v, below));
+        // Two mask bits per 16-bit lane.
+        count += static_cast<size_t>(std::popcount(static_cast<uint32_t>(_mm_movemask_epi8(hit)))) / 2;
+    }
+#endif
+
+    for (; i < n; ++i) {
+        if (p[i] >= limit || p[i] <= -limit) ++count;
+    }
+    return count;
+}
+
+// Sum of a[i] * b[i] over n floats.
+inline float dot(const float* a, const float* b, size_t n) {
+    size_t i = 0;
+    float total = 0;
+
+#if defined(__SSE2__)
+    // Two accumulators to hide the add latency.
+    __m128 acc0 = _mm_setzero_ps();
+    __m128 acc1 = _mm_setzero_ps();
+    for (; i + 8 <= n; i += 8) {
+        acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+        acc1 = _mm_add_ps(acc1, _mm_mul_ps(_mm_loadu_ps(a + i + 4), _mm_loadu_ps(b + i + 4)));
+    }
+    alignas(16) float lanes[4];
+    _mm_store_ps(lanes, _mm_add_ps(acc0, acc1));
+    total = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+#endif
+
+    for (; i < n; ++i) total += a[i] * b[i];
+    return total;
+}
+
+// Averages interleaved frames of `channels` floats into mono; out holds
+// in.size() / channels samples.
+inline void downmix(std::span<const float> in, uint32_t channels, float* out) {
+    size_t frames = in.size() / channels;
+    const float* p = in.data();
+    size_t f = 0;
+
+    if (channels == 1) {
+        std::copy_n(p, frames, out);
+        return;
+    }
+#if defined(__SSE2__)
+    if (channels == 2) {
+        const __m128 half = _mm_set1_ps(0.5f);
+        for (; f + 4 <= frames; f += 4) {
+            __m128 a = _mm_loadu_ps(p + 2 * f);      // L0 R0 L1 R1
+            __m128 b = _mm_loadu_ps(p + 2 * f + 4);  // L2 R2 L3 R3
+            __m128 left = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+            __m128 right = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+            _mm_storeu_ps(out + f, _mm_mul_ps(_mm_add_ps(left, right), half));
+        }
+    }
+#endif
+
+    float scale = 1.0f / static_cast<float>(channels);
+    for (; f < frames; ++f) {
+        float sum = 0;
+        for (uint32_t c = 0; c < channels; ++c) sum += p[f * channels + c];
+        out[f] = sum * scale;
+    }
+}
+
+// Float samples in [-1, 1) to int16, rounded and saturated.
+inline void to_int16(const float* in, size_t n, int16_t* out) {
+    size_t i = 0;
+
+#if defined(__SSE2__)
+    const __m128 scale = _mm_set1_ps(32768.0f);
+    for (; i + 8 <= n; i += 8) {
+        // cvtps rounds to nearest; packs saturates to the int16 range.
+        __m128i lo = _mm_cvtps_epi32(_mm_mul_ps(_mm_loadu_ps(in + i), scale));
+        __m128i hi = _mm_cvtps_epi32(_mm_mul_ps(_mm_loadu_ps(in + i + 4), scale));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_packs_epi32(lo, hi));
+    }
+#endif
+
+    for (; i < n; ++i) {
+        float v = std::nearbyint(in[i] * 32768.0f);
+        out[i] = static_cast<int16_t>(std::clamp(v, -32768.0f, 32767.0f));
+    }
+}
+
+// int16 samples to float in [-1, 1), the scale whisper models expect.
+inline void to_float(const int16_t* in, size_t n, float* out) {
+    size_t i = 0;
+
+#if defined(__SSE2__)
+    const __m128 scale = _mm_set1_ps(1.0f / 32768.0f);
+    for (; i + 8 <= n; i += 8) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+        // Sign-extend each half to 32 bits: duplicate into the high word, shift down.
+        __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+        __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16);
+        _mm_storeu_ps(out + i, _mm_mul_ps(_mm_cvtepi32_ps(lo), scale));
+        _mm_storeu_ps(out + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), scale));
+    }
+#endif
+
+    for (; i < n; ++i) out[i] = static_cast<float>(in[i]) / 32768.0f;
+}
+
+// Appends samples converted to float.
+inline void append_float(std::vector<float>& dst, std::span<const int16_t> samples) {
+    size_t old = dst.size();
+    dst.resize(old + samples.size());
+    to_float(samples.data(), samples.size(), dst.data() + old);
+}
+
+} // namespace audio
@@ -0,0 +1,80 @@
+#include "audio/vad.hpp"
+
+#include "audio/simd.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// Speech must rise this far above the background to count.
+constexpr double NOISE_MARGIN_DB = 10.0;
+// Floor used before any audio has been seen and as the lower clamp.
+constexpr double MIN_FLOOR_DB = -90.0;
+// Per-frame rise rate of the noise floor towards louder frames. Speech frames
+// pull it up very slowly so a long utterance does not become "background".
+constexpr double FLOOR_RISE_SILENCE = 0.05;
+constexpr double FLOOR_RISE_SPEECH = 0.001;
+
+} // namespace
+
+Vad::Vad(uint32_t sample_rate, double threshold_db, uint32_t frame_ms)
+    : frame_len_(std::max<size_t>(1, static_cast<size_t>(sample_rate) * frame_ms / 1000)),
+      threshold_db_(threshold_db), noise_floor_db_(MIN_FLOOR_DB) {}
+
+void Vad::process(std::span<const int16_t> samples) {
+    if (!partial_.empty()) {
+        size_t take = std::min(samples.size(), frame_len_ - partial_.size());
+        partial_.insert(partial_.end(), samples.begin(), samples.begin() + take);
+        samples = samples.subspan(take);
+        if (partial_.size() < frame_len_) return;
+        classify(partial_);
+        partial_.clear();
+    }
+
+    while (samples.size() >= frame_len_) {
+        classify(samples.first(frame_len_));
+        samples = samples.subspan(frame_len_);
+    }
+
+    partial_.assign(samples.begin(), samples.end());
+}
+
+void Vad::reset() {
+    noise_floor_db_ = MIN_FLOOR_DB;
+    frames_ = speech_frames_ = silent_run_ = 0;
+    partial_.clear();
+}
+
+double Vad::frame_level_db(std::span<const int16_t> frame) {
+    if (frame.empty()) return MIN_FLOOR_DB;
+    double sum = static_cast<double>(audio::sum_squares(frame));
+    double rms = std::sqrt(sum / frame.size()) / 32768.0;
+    return rms > 0.0 ? std::max(MIN_FLOOR_DB, 20.0 * std::log10(rms)) : MIN_FLOOR_DB;
+}
+
+void Vad::classify(std::span<const int16_t> frame) {
+    double level = frame_level_db(frame);
+
+    // Seed the floor from the first frame, but never above the threshold in
+    // case the recording starts mid-word.
+    if (frames_ == 0) noise_floor_db_ = std::min(level, threshold_db_);
+
+    bool speech = level > threshold_db_ && level > noise_floor_db_ + NOISE_MARGIN_DB;
+
+    // Track the background: drop immediately to quieter frames, creep up slowly.
+    if (level < noise_floor_db_) {
+        noise_floor_db_ = level;
+    } else {
+        double rise = speech ? FLOOR_RISE_SPEECH : FLOOR_RISE_SILENCE;
+        noise_floor_db_ += (level - noise_floor_db_) * rise;
+    }
+    frames_++;
+
+    if (speech) {
+        speech_frames_++;
+        silent_run_ = 0;
+    } else {
+        silent_run_++;
+    }
+}
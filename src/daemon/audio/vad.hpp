@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+// Energy-based voice activity detector.
+// Audio is classified in fixed frames; a frame counts as speech when its RMS
+// level is above both the absolute threshold and the tracked noise floor plus
+// a margin, so a noisy room does not read as one endless utterance.
+class Vad {
+public:
+    Vad(uint32_t sample_rate, double threshold_db = -45.0, uint32_t frame_ms = 30);
+
+    // Classifies complete frames; a trailing partial frame is kept for the next call.
+    void process(std::span<const int16_t> samples);
+    void reset();
+
+    bool speech_detected() const { return speech_frames_ > 0; }
+    size_t speech_samples() const { return speech_frames_ * frame_len_; }
+    bool in_speech() const { return speech_frames_ > 0 && silent_run_ == 0; }
+
+    // Samples classified so far (always a multiple of the frame length).
+    size_t samples_processed() const { return frames_ * frame_len_; }
+    // Silence since the last speech frame (or since the start if none yet).
+    size_t trailing_silence_samples() const { return silent_run_ * frame_len_; }
+    double noise_floor_db() const { return noise_floor_db_; }
+
+    static double frame_level_db(std::span<const int16_t> frame);
+
+private:
+    void classify(std::span<const int16_t> frame);
+
+    size_t frame_len_;
+    double threshold_db_;
+    double noise_floor_db_;
+    size_t frames_ = 0;
+    size_t speech_frames_ = 0;
+    size_t silent_run_ = 0;
+    std::vector<int16_t> partial_;
+};
@@ -0,0 +1,97 @@
+#include "audio_encoder.hpp"
+#include "flac_encoder.hpp"
+#include "wav_encoder.hpp"
+#include "platform/cpu_affinity.hpp"
+
+#ifdef SPEAK_ANYWHERE_HAVE_OPUS
+#include "opus_encoder.hpp"
+#endif
+
+namespace {
+
+class WavFileEncoder : public AudioEncoder {
+public:
+    explicit WavFileEncoder(uint32_t sample_rate) : sample_rate_(sample_rate) {}
+
+    void append(std::span<const int16_t> samples) override {
+        samples_.insert(samples_.end(), samples.begin(), samples.end());
+    }
+    std::vector<uint8_t> finish() override { return wav::encode(samples_, sample_rate_); }
+    const char* mime_type() const override { return "audio/wav"; }
+    const char* file_name() const override { return "audio.wav"; }
+
+private:
+    uint32_t sample_rate_;
+    std::vector<int16_t> samples_;
+};
+
+} // namespace
+
+std::unique_ptr<AudioEncoder> make_audio_encoder(const std::string& format, uint32_t sample_rate,
+                                                 [[maybe_unused]] uint32_t opus_bitrate) {
+    if (format == "wav") return std::make_unique<WavFileEncoder>(sample_rate);
+    if (format == "flac") return std::make_unique<FlacEncoder>(sample_rate);
+#ifdef SPEAK_ANYWHERE_HAVE_OPUS
+    if (format == "opus") {
+        auto enc = std::make_unique<OggOpusEncoder>(sample_rate, opus_bitrate);
+        if (enc->ok()) return enc;
+    }
+#endif
+    return nullptr;
+}
+
+BackgroundEncoder::BackgroundEncoder(std::unique_ptr<AudioEncoder> encoder, uint32_t sample_rate,
+                                     std::vector<int> cpus)
+    : encoder_(std::move(encoder)), sample_rate_(sample_rate), cpus_(std::move(cpus)),
+      thread_([this] { run(); }) {}
+
+BackgroundEncoder::~BackgroundEncoder() {
+    {
+        std::lock_guard lock(mu_);
+        done_ = true;
+    }
+    cv_.notify_one();
+    if (thread_.joinable()) thread_.join();
+}
+
+void BackgroundEncoder::push(std::span<const int16_t> samples) {
+    if (samples.empty()) return;
+    samples_pushed_ += samples.size();
+    {
+        std::lock_guard lock(mu_);
+        queue_.emplace_back(samples.begin(), samples.end());
+    }
+    cv_.notify_one();
+}
+
+void BackgroundEncoder::run() {
+    // Not being pinned only costs the placement: status reports the capture's.
+    (void)platform::pin_current_thread(cpus_);
+    std::vector<std::vector<int16_t>> batch;
+    for (;;) {
+        {
+            std::unique_lock lock(mu_);
+            cv_.wait(lock, [this] { return done_ || !queue_.empty(); });
+            if (queue_.empty() && done_) return;
+            batch.swap(queue_);
+        }
+        for (auto& chunk : batch) encoder_->append(chunk);
+        batch.clear();
+    }
+}
+
+EncodedAudio BackgroundEncoder::finish() {
+    {
+        std::lock_guard lock(mu_);
+        done_ = true;
+    }
+    cv_.notify_one();
+    if (thread_.joinable()) thread_.join();
+
+    return EncodedAudio{
+        .data = encoder_->finish(),
+        .mime_type = encoder_->mime_type(),
+        .file_name = encoder_->file_name(),
+        .duration_s = static_cast<double>(samples_pushed_) / sample_rate_,
+    };
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Compressed upload formats. Encoders are incremental: samples are appended
+// as they are captured and finish() returns the complete file.
+class AudioEncoder {
+public:
+    virtual ~AudioEncoder() = default;
+    virtual void append(std::span<const int16_t> samples) = 0;
+    virtual std::vector<uint8_t> finish() = 0;
+    virtual const char* mime_type() const = 0;
+    virtual const char* file_name() const = 0;
+};
+
+// format: "wav", "flac" or "opus". Returns nullptr for unknown formats and
+// for "opus" when built without libopus.
+std::unique_ptr<AudioEncoder> make_audio_encoder(const std::string& format, uint32_t sample_rate,
+                                                 uint32_t opus_bitrate = 24000);
+
+struct EncodedAudio {
+    std::vector<uint8_t> data;
+    std::string mime_type;
+    std::string file_name;
+    double duration_s = 0.0;
+};
+
+// Runs an AudioEncoder on its own thread so encoding overlaps recording.
+// push() is called from the main thread with each captured chunk.
+class BackgroundEncoder {
+public:
+    // cpus, when given, is where the encoder thread runs (audio.cpus).
+    BackgroundEncoder(std::unique_ptr<AudioEncoder> encoder, uint32_t sample_rate,
+                      std::vector<int> cpus = {});
+    ~BackgroundEncoder();
+
+    BackgroundEncoder(const BackgroundEncoder&) = delete;
+    BackgroundEncoder& operator=(const BackgroundEncoder&) = delete;
+
+    void push(std::span<const int16_t> samples);
+    // Waits for queued chunks to be encoded and returns the file.
+    EncodedAudio finish();
+
+    size_t samples_pushed() const { return samples_pushed_; }
+
+private:
+    void run();
+
+    std::unique_ptr<AudioEncoder> encoder_;
+    uint32_t sample_rate_;
+    size_t samples_pushed_ = 0;
+    std::vector<int> cpus_;
+
+    std::mutex mu_;
+    std::condition_variable cv_;
+    std::vector<std::vector<int16_t>> queue_;
+    bool done_ = false;
+    std::thread thread_;
+};
@@ -5,19 +5,17 @@
 #include <filesystem>
 #include <fstream>
 #include <nlohmann/json.hpp>
+#include <optional>
 #include <print>
 
 namespace fs = std::filesystem;
 using json = nlohmann::json;
 
-Config Config::load(const std::string& path) {
-    Config cfg;
-    std::ifstream f(path);
-    if (!f.is_open()) {
-        std::println(stderr, "config: could not open {}, using defaults", path);
-        return cfg;
-    }
+namespace {
 
+// Fills cfg in from the file's JSON. On an error, what was read before it is
+// kept and the error returned.
+std::optional<std::string> parse(std::istream& f, Config& cfg) {
     try {
         auto j = json::parse(f);
 
@@ -27,17 +25,169 @@ Config Config::load(const std::string& path) {
             if (b.contains("url")) cfg.backend.url = b["url"].get<std::string>();
             if (b.contains("api_format")) cfg.backend.api_format = b["api_format"].get<std::string>();
             if (b.contains("language")) cfg.backend.language = b["language"].get<std::string>();
+            if (b.contains("http2")) cfg.backend.http2 = b["http2"].get<bool>();
+            if (b.contains("audio_format")) cfg.backend.audio_format = b["audio_format"].get<std::string>();
+            if (b.contains("opus_bitrate")) cfg.backend.opus_bitrate = b["opus_bitrate"].get<uint32_t>();
+            if (b.contains("endpoints")) {
+                cfg.backend.endpoints.clear();
+                for (auto& e : b["endpoints"]) {
+                    if (e.is_string()) {
+                        cfg.backend.endpoints.push_back({.url = e.get<std::string>()});
+                    } else {
+                        cfg.backend.endpoints.push_back({
+                            .url = e.value("url", ""),
+                            .api_format = e.value("api_format", ""),
+                        });
+                    }
+                }
+            }
+            if (b.contains("pool_mode")) cfg.backend.pool_mode = b["pool_mode"].get<std::string>();
+            if (b.contains("health")) {
+                auto& h = b["health"];
+                if (h.contains("probe_seconds")) cfg.backend.health.probe_seconds = h["probe_seconds"].get<uint32_t>();
+                if (h.contains("failures")) cfg.backend.health.failures = h["failures"].get<uint32_t>();
+                if (h.contains("retry_seconds")) cfg.backend.health.retry_seconds = h["retry_seconds"].get<uint32_t>();
+            }
+            if (b.contains("local_fallback")) cfg.backend.local_fallback = b["local_fallback"].get<bool>();
+            if (b.contains("local")) {
+                auto& l = b["local"];
+                if (l.contains("model_path")) cfg.backend.local.model_path = l["model_path"].get<std::string>();
+                if (l.contains("threads")) cfg.backend.local.threads = l["threads"].get<int>();
+                if (l.contains("use_gpu")) cfg.backend.local.use_gpu = l["use_gpu"].get<bool>();
+                if (l.contains("lazy_load")) cfg.backend.local.lazy_load = l["lazy_load"].get<bool>();
+            }
         }
 
         if (j.contains("output")) {
             auto& o = j["output"];
             if (o.contains("default")) cfg.output.default_method = o["default"].get<std::string>();
+            if (o.contains("native_wayland")) cfg.output.native_wayland = o["native_wayland"].get<bool>();
+            if (o.contains("incremental")) cfg.output.incremental = o["incremental"].get<bool>();
+            if (o.contains("apps")) {
+                for (auto& a : o["apps"]) {
+                    cfg.output.apps.push_back({
+                        .app_id = a.value("app_id", ""),
+                        .method = a.value("method", "paste"),
+                        .paste_keys = a.value("paste_keys", "ctrl+v"),
+                    });
+                }
+            }
+            if (o.contains("fallback")) cfg.output.fallback = o["fallback"].get<std::string>();
         }
 
         if (j.contains("audio")) {
             auto& a = j["audio"];
             if (a.contains("sample_rate")) cfg.audio.sample_rate = a["sample_rate"].get<uint32_t>();
             if (a.contains("max_seconds")) cfg.audio.max_seconds = a["max_seconds"].get<uint32_t>();
+            if (a.contains("chunk_ms")) cfg.audio.chunk_ms = a["chunk_ms"].get<uint32_t>();
+            if (a.contains("armed")) cfg.audio.armed = a["armed"].get<bool>();
+            if (a.contains("preroll_ms")) cfg.audio.preroll_ms = a["preroll_ms"].get<uint32_t>();
+            if (a.contains("quantum")) cfg.audio.quantum = a["quantum"].get<uint32_t>();
+            if (a.contains("native_format")) cfg.audio.native_format = a["native_format"].get<bool>();
+            if (a.contains("lock_memory")) cfg.audio.lock_memory = a["lock_memory"].get<bool>();
+            if (a.contains("hugepages")) cfg.audio.hugepages = a["hugepages"].get<bool>();
+            if (a.contains("cpus")) cfg.audio.cpus = a["cpus"].get<std::vector<int>>();
+        }
+
+        if (j.contains("streaming")) {
+            auto& s = j["streaming"];
+            if (s.contains("enabled")) cfg.streaming.enabled = s["enabled"].get<bool>();
+            if (s.contains("segment_seconds")) cfg.streaming.segment_seconds = s["segment_seconds"].get<uint32_t>();
+        }
+
+        if (j.contains("preview")) {
+            auto& p = j["preview"];
+            if (p.contains("enabled")) cfg.preview.enabled = p["enabled"].get<bool>();
+            if (p.contains("interval_ms")) cfg.preview.interval_ms = p["interval_ms"].get<uint32_t>();
+            if (p.contains("window_seconds")) cfg.preview.window_seconds = p["window_seconds"].get<uint32_t>();
+        }
+
+        if (j.contains("prompt")) {
+            auto& p = j["prompt"];
+            if (p.contains("enabled")) cfg.prompt.enabled = p["enabled"].get<bool>();
+            if (p.contains("max_terms")) cfg.prompt.max_terms = p["max_terms"].get<uint32_t>();
+            if (p.contains("max_files")) cfg.prompt.max_files = p["max_files"].get<uint32_t>();
+        }
+
+        if (j.contains("vad")) {
+            auto& v = j["vad"];
+            if (v.contains("enabled")) cfg.vad.enabled = v["enabled"].get<bool>();
+            if (v.contains("threshold_db")) cfg.vad.threshold_db = v["threshold_db"].get<double>();
+            if (v.contains("silence_ms")) cfg.vad.silence_ms = v["silence_ms"].get<uint32_t>();
+            if (v.contains("min_segment_seconds")) cfg.vad.min_segment_seconds = v["min_segment_seconds"].get<uint32_t>();
+            if (v.contains("auto_stop_ms")) cfg.vad.auto_stop_ms = v["auto_stop_ms"].get<uint32_t>();
+            if (v.contains("no_speech_ms")) cfg.vad.no_speech_ms = v["no_speech_ms"].get<uint32_t>();
+        }
+
+        if (j.contains("trim")) {
+            auto& t = j["trim"];
+            if (t.contains("enabled")) cfg.trim.enabled = t["enabled"].get<bool>();
+            if (t.contains("threshold_db")) cfg.trim.threshold_db = t["threshold_db"].get<double>();
+            if (t.contains("padding_ms")) cfg.trim.padding_ms = t["padding_ms"].get<uint32_t>();
+        }
+        if (j.contains("cleanup")) {
+            auto& c = j["cleanup"];
+            if (c.contains("denoise")) cfg.cleanup.denoise = c["denoise"].get<bool>();
+            if (c.contains("suppression_db")) cfg.cleanup.suppression_db = c["suppression_db"].get<double>();
+            if (c.contains("agc")) cfg.cleanup.agc = c["agc"].get<bool>();
+            if (c.contains("target_db")) cfg.cleanup.target_db = c["target_db"].get<double>();
+            if (c.contains("max_gain_db")) cfg.cleanup.max_gain_db = c["max_gain_db"].get<double>();
+        }
+
+        if (j.contains("queue")) {
+            auto& q = j["queue"];
+            if (q.contains("max_jobs")) cfg.queue.max_jobs = q["max_jobs"].get<uint32_t>();
+            if (q.contains("cancel_on_start")) cfg.queue.cancel_on_start = q["cancel_on_start"].get<bool>();
+        }
+
+        if (j.contains("archive")) {
+            auto& a = j["archive"];
+            if (a.contains("enabled")) cfg.archive.enabled = a["enabled"].get<bool>();
+            if (a.contains("max_mb")) cfg.archive.max_mb = a["max_mb"].get<uint32_t>();
+            if (a.contains("segment_mb")) cfg.archive.segment_mb = a["segment_mb"].get<uint32_t>();
+        }
+
+        if (j.contains("cache")) {
+            auto& c = j["cache"];
+            if (c.contains("enabled")) cfg.cache.enabled = c["enabled"].get<bool>();
+            if (c.contains("max_entries")) cfg.cache.max_entries = c["max_entries"].get<uint32_t>();
+            if (c.contains("persist")) cfg.cache.persist = c["persist"].get<bool>();
+        }
+
+        if (j.contains("chunking")) {
+            auto& c = j["chunking"];
+            if (c.contains("enabled")) cfg.chunking.enabled = c["enabled"].get<bool>();
+            if (c.contains("max_chunk_seconds")) cfg.chunking.max_chunk_seconds = c["max_chunk_seconds"].get<uint32_t>();
+            if (c.contains("concurrency")) cfg.chunking.concurrency = c["concurrency"].get<uint32_t>();
+            if (c.contains("overlap_ms")) cfg.chunking.overlap_ms = c["overlap_ms"].get<uint32_t>();
+        }
+
+        if (j.contains("daemon")) {
+            auto& d = j["daemon"];
+            if (d.contains("idle_exit_minutes")) cfg.daemon.idle_exit_minutes = d["idle_exit_minutes"].get<uint32_t>();
+            if (d.contains("multi_user")) cfg.daemon.multi_user = d["multi_user"].get<bool>();
+            if (d.contains("socket_group")) cfg.daemon.socket_group = d["socket_group"].get<std::string>();
+        }
+
+        if (j.contains("postprocess")) {
+            auto& p = j["postprocess"];
+            auto replacements = [](const json& r) {
+                Config::PostProcess::Replacements out;
+                for (auto& [from, to] : r.items()) out.emplace_back(from, to.get<std::string>());
+                return out;
+            };
+            if (p.contains("voice_commands")) cfg.postprocess.voice_commands = p["voice_commands"].get<bool>();
+            if (p.contains("replace")) cfg.postprocess.replace = replacements(p["replace"]);
+            if (p.contains("apps")) {
+                for (auto& a : p["apps"]) {
+                    cfg.postprocess.apps.push_back({
+                        .app_id = a.value("app_id", ""),
+                        .agent = a.value("agent", ""),
+                        .replace = a.contains("replace") ? replacements(a["replace"])
+                                                         : Config::PostProcess::Replacements{},
+                    });
+                }
+            }
         }
 
         if (j.contains("agents")) {
@@ -45,19 +195,45 @@ Config Config::load(const std::string& path) {
         }
 
     } catch (const json::exception& e) {
-        std::println(stderr, "config: parse error: {}", e.what());
+        return e.what();
+    }
+
+    return std::nullopt;
+}
+
+} // namespace
+
+Config Config::load(const std::string& path) {
+    Config cfg;
+    std::ifstream f(path);
+    if (!f.is_open()) {
+        std::println(stderr, "config: could not open {}, using defaults", path);
+        return cfg;
+    }
+    if (auto error = parse(f, cfg)) {
+        std::println(stderr, "config: parse error: {}", *error);
     }
+    return cfg;
+}
 
+std::expected<Config, std::string> Config::read(const std::string& path) {
+    Config cfg;
+    std::ifstream f(path);
+    if (!f.is_open()) return std::unexpected("could not open " + path);
+    if (auto error = parse(f, cfg)) return std::unexpected("parse error: " + *error);
     return cfg;
 }
 
-Config Config::load_default() {
+std::string Config::default_path() {
     auto dir = platform::config_dir();
-    if (dir.empty()) return Config{};
+    if (dir.empty()) return {};
+    return (fs::path(dir) / "config.json").string();
+}
 
-    auto config_path = fs::path(dir) / "config.json";
-    if (fs::exists(config_path)) {
-        return load(config_path.string());
+Config Config::load_default() {
+    auto path = default_path();
+    if (!path.empty() && fs::exists(path)) {
+        return load(path);
     }
     return Config{};
 }
@@ -1,33 +1,217 @@
 #pragma once
 
 #include <cstdint>
+#include <expected>
 #include <string>
+#include <utility>
 #include <vector>
 
 struct Config {
     struct Backend {
-        std::string type = "lan";
+        std::string type = "lan";  // "lan" or "local"
         std::string url = "http://localhost:8080";
         std::string api_format = "whisper.cpp"; // "whisper.cpp" or "openai"
         std::string language = "en";
+        bool http2 = false;  // negotiate HTTP/2 over TLS when the server offers it
+        std::string audio_format = "wav";  // "wav", "flac" or "opus"
+        uint32_t opus_bitrate = 24000;
+
+        // Several servers behind one backend; when set, url is ignored.
+        struct Endpoint {
+            std::string url;
+            std::string api_format;  // empty: same as backend.api_format
+            bool operator==(const Endpoint&) const = default;
+        };
+        std::vector<Endpoint> endpoints;
+        std::string pool_mode = "latency";  // "failover", "latency" or "race"
+
+        // Servers that can't be reached are skipped for a while instead of
+        // each request waiting out the connect timeout.
+        struct Health {
+            uint32_t probe_seconds = 10;  // connect to each server this often (0: never)
+            uint32_t failures = 2;        // connection failures in a row before it is skipped
+            uint32_t retry_seconds = 30;  // then this long before a request tries it again
+            bool operator==(const Health&) const = default;
+        } health;
+        // With type "lan": transcribe with the local model when no server can be reached.
+        bool local_fallback = false;
+
+        // In-process whisper.cpp (type "local")
+        struct Local {
+            std::string model_path;
+            int threads = 0;  // 0: all cores
+            bool use_gpu = true;
+            bool lazy_load = false;  // load on first recording, not at startup
+            bool operator==(const Local&) const = default;
+        } local;
+        bool operator==(const Backend&) const = default;
     } backend;
 
     struct Output {
         std::string default_method = "clipboard";
+        bool native_wayland = true;  // in-process clipboard/keys instead of wl-copy/wtype
+        bool incremental = false;    // streaming: type each segment once it is transcribed
+
+        // How text asked to be typed gets into each app; the first rule whose
+        // app_id occurs in the window's app_id (or X11 class) wins, then the
+        // built-in terminal rules, then fallback.
+        struct Rule {
+            std::string app_id;
+            std::string method = "paste";       // "type", "paste", "clipboard" or "auto"
+            std::string paste_keys = "ctrl+v";  // or "ctrl+shift+v"
+            bool operator==(const Rule&) const = default;
+        };
+        std::vector<Rule> apps;
+        std::string fallback = "paste";  // "auto": the fastest method that works, as measured
+        bool operator==(const Output&) const = default;
     } output;
 
     struct Audio {
         uint32_t sample_rate = 16000;
         uint32_t max_seconds = 120;
+        uint32_t chunk_ms = 100;  // consumer poll interval while recording
+        bool armed = false;         // keep the microphone open between recordings
+        uint32_t preroll_ms = 500;  // armed: audio from before start that is kept
+        uint32_t quantum = 0;       // frames per capture callback (0 = server default)
+        bool native_format = false; // capture the device's rate/channels, convert in-process
+        bool lock_memory = false;   // allocate the capture buffers up front, locked into RAM
+        bool hugepages = false;     // lock_memory: back them with transparent hugepages
+        std::vector<int> cpus;      // pin the capture and encoder threads to these CPUs
 
         // Computed from max_seconds and sample_rate (no independent config key).
         size_t ring_buffer_bytes() const {
             return static_cast<size_t>(max_seconds) * sample_rate * sizeof(int16_t);
         }
+        bool operator==(const Audio&) const = default;
     } audio;
 
+    struct Streaming {
+        bool enabled = false;
+        uint32_t segment_seconds = 10;  // audio per request (upper limit with VAD)
+        bool operator==(const Streaming&) const = default;
+    } streaming;
+
+    // Speculative transcriptions while recording, pushed to subscribed clients.
+    struct Preview {
+        bool enabled = false;
+        uint32_t interval_ms = 1000;  // at most one request this often
+        uint32_t window_seconds = 20; // most recent audio sent per request
+        bool operator==(const Preview&) const = default;
+    } preview;
+
+    // Vocabulary from the agent's working directory (and the last transcript
+    // made there), sent as the whisper prompt.
+    struct Prompt {
+        bool enabled = false;
+        uint32_t max_terms = 40;
+        uint32_t max_files = 2000;  // files read per directory scan
+        bool operator==(const Prompt&) const = default;
+    } prompt;
+
+    struct Vad {
+        bool enabled = false;
+        double threshold_db = -45.0;       // minimum speech level, dBFS
+        uint32_t silence_ms = 500;         // pause length that ends a segment
+        uint32_t min_segment_seconds = 2;
+        // start --auto-stop: trailing silence that ends the recording, and
+        // how long to wait for any speech before discarding it (0 = forever).
+        uint32_t auto_stop_ms = 800;
+        uint32_t no_speech_ms = 8000;
+        bool operator==(const Vad&) const = default;
+    } vad;
+
+    struct Trim {
+        bool enabled = false;
+        double threshold_db = -50.0;  // frames below this are silence, dBFS
+        uint32_t padding_ms = 200;    // kept around the voiced range
+        bool operator==(const Trim&) const = default;
+    } trim;
+
+    // Cleans the microphone signal up as it is recorded, before VAD,
+    // streaming and the encoder see it.
+    struct Cleanup {
+        bool denoise = false;          // high-pass, and pull the background down between words
+        double suppression_db = 18.0;  // how far the background is pulled down
+        bool agc = false;              // bring speech up (or down) to target_db
+        double target_db = -20.0;      // speech level aimed for, dBFS
+        double max_gain_db = 24.0;     // the most AGC amplifies
+        bool operator==(const Cleanup&) const = default;
+    } cleanup;
+
+    struct Queue {
+        uint32_t max_jobs = 4;  // transcriptions in flight at once (0 = unlimited)
+        bool cancel_on_start = false;  // a new recording aborts pending transcriptions
+        bool operator==(const Queue&) const = default;
+    } queue;
+
+    // Keeps the audio of each transcription for `sa retranscribe`.
+    struct Archive {
+        bool enabled = false;
+        uint32_t max_mb = 1024;     // oldest segments are deleted past this
+        uint32_t segment_mb = 64;   // unit of retention
+        bool operator==(const Archive&) const = default;
+    } archive;
+
+    // Replacements applied to each transcript before it is typed out.
+    struct PostProcess {
+        using Replacements = std::vector<std::pair<std::string, std::string>>;  // phrase, replacement
+
+        bool voice_commands = false;  // "new line", "comma", "full stop", ...
+        Replacements replace;         // everywhere
+        // Extra replacements for one app and/or agent; the first match wins.
+        struct RuleSet {
+            std::string app_id;  // app_id, or X11 class
+            std::string agent;
+            Replacements replace;
+            bool operator==(const RuleSet&) const = default;
+        };
+        std::vector<RuleSet> apps;
+        bool operator==(const PostProcess&) const = default;
+    } postprocess;
+
+    // Backend results by audio content, so the same audio is only sent once.
+    struct Cache {
+        bool enabled = false;
+        uint32_t max_entries = 256;
+        bool persist = true;  // keep entries in the history database across restarts
+        bool operator==(const Cache&) const = default;
+    } cache;
+
+    // Long clips (retranscribe, recordings without streaming) are split at
+    // pauses and the pieces sent to the backend side by side.
+    struct Chunking {
+        bool enabled = false;
+        uint32_t max_chunk_seconds = 30;
+        uint32_t concurrency = 4;
+        uint32_t overlap_ms = 1000;  // shared by both sides of a cut that found no pause
+        bool operator==(const Chunking&) const = default;
+    } chunking;
+
+    struct Daemon {
+        // Exit after this long with nothing recording or transcribing and no
+        // subscribers (0 = never). Only under socket activation, which starts
+        // the daemon again on the next command.
+        uint32_t idle_exit_minutes = 0;
+        // One daemon for every user of the machine: clients are told apart by
+        // uid, each with their own history and share of the queue. Otherwise
+        // only the daemon's own user (and root) may connect.
+        bool multi_user = false;
+        // With multi_user, the group whose members may connect: the socket is
+        // made 0660 and given to it. Required, so the socket is never open to
+        // everyone.
+        std::string socket_group;
+        bool operator==(const Daemon&) const = default;
+    } daemon;
+
     std::vector<std::string> agents = {"claude", "aider", "gh", "cursor"};
 
+    bool operator==(const Config&) const = default;
+
     static Config load(const std::string& path);
     static Config load_default();
+    // Like load(), but a file that can't be opened or parsed is an error
+    // rather than defaults: for reloading a running daemon's config.
+    static std::expected<Config, std::string> read(const std::string& path);
+    // Where load_default() looks; empty without a config directory.
+    static std::string default_path();
 };
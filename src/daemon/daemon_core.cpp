@@ -1,12 +1,52 @@
 #include "daemon_core.hpp"
 
+#include "audio/silence_trim.hpp"
 #include "platform/platform_paths.hpp"
+#include "whisper/backend_pool.hpp"
+#include "whisper/curl_multi.hpp"
 #include "whisper/lan_backend.hpp"
 
+#ifdef SPEAK_ANYWHERE_HAVE_WHISPER
+#include "whisper/local_backend.hpp"
+#endif
+
 #include <algorithm>
 #include <cctype>
 #include <format>
 #include <print>
+#include <utility>
+
+namespace {
+
+// Seconds per stage; stages the transcription didn't go through are left out.
+nlohmann::json timings_json(const StageTimings& timings) {
+    nlohmann::json j = nlohmann::json::object();
+    for (auto& stage : STAGES) {
+        if (auto& v = timings.*stage.value) j[stage.name] = *v;
+    }
+    return j;
+}
+
+// What besides the audio decides the text, for the transcript cache key.
+// A server that swaps its model behind the same URL isn't noticed.
+std::string backend_identity(const Config::Backend& b) {
+    auto id = std::format("{}|{}|{}|{}|{}", b.type, b.api_format, b.language, b.audio_format,
+                          b.local.model_path);
+    if (b.endpoints.empty()) id += "|" + b.url;
+    for (auto& e : b.endpoints) id += "|" + e.url + "|" + e.api_format;
+    return id;
+}
+
+nlohmann::json chunks_json(const std::vector<ChunkTiming>& chunks) {
+    nlohmann::json j = nlohmann::json::array();
+    for (auto& c : chunks) {
+        j.push_back({{"start", c.start_s}, {"duration", c.duration_s},
+                     {"queued", c.queued_s}, {"processing", c.processing_s}});
+    }
+    return j;
+}
+
+} // namespace
 
 DaemonCore::DaemonCore(Config config, bool verbose,
                        RingBuffer& ring_buf, AudioCapture& audio,
@@ -15,50 +55,329 @@ DaemonCore::DaemonCore(Config config, bool verbose,
     : config_(std::move(config)), verbose_(verbose),
       ring_buf_(ring_buf), audio_(audio),
       detector_(detector), ipc_(ipc),
-      output_factory_(std::move(output_factory)),
+      outputs_(config_.output, std::move(output_factory)),
       notify_(std::move(notify)),
-      session_(ring_buf_, audio_, config_.audio.sample_rate) {}
+      session_(ring_buf_, audio_, config_.audio.sample_rate, config_.audio.max_seconds),
+      post_(std::make_shared<const PostProcessor>(config_.postprocess)),
+      meter_(config_.audio.sample_rate / 4) {}
 
 DaemonCore::~DaemonCore() = default;
 
 bool DaemonCore::init() {
-    // Create backend
-    if (config_.backend.type == "lan") {
-        backend_ = std::make_unique<LanBackend>(
-            config_.backend.url, config_.backend.api_format, config_.backend.language);
-    } else {
-        std::println(stderr, "Unknown backend type: {}", config_.backend.type);
-        return false;
-    }
+    backend_pinned_ = pinned_backend_ != nullptr;
+    auto model = backend_pinned_ ? std::move(pinned_backend_) : create_backend(config_);
+    if (!model) return false;
 
     // Open history DB
-    auto data = platform::data_dir();
-    std::string db_path;
-    if (!data.empty()) {
-        db_path = data + "/history.db";
-    } else {
-        db_path = "/tmp/speak-anywhere/history.db";
+    data_dir_ = platform::data_dir();
+    if (data_dir_.empty()) data_dir_ = "/tmp/speak-anywhere";
+    std::string db_path = data_dir_ + "/history.db";
+    backends_ = wrap_backend(std::move(model), config_);
+
+    // Nothing needs the history until the first transcription is delivered,
+    // so creating or migrating it doesn't hold up the first command. The
+    // transcript cache shares the file and opens after it, so that only one
+    // connection ever upgrades the schema.
+    history_opener_ = std::jthread([this, db_path, backends = backends_, persist = config_.cache.persist] {
+        auto start = StageSpan::Clock::now();
+        if (!history_db_.open(db_path)) {
+            std::println(stderr, "Warning: history DB failed to open, history disabled");
+        } else if (!history_writer_.open(db_path)) {
+            std::println(stderr, "Warning: history writer failed to start, writing on the main thread");
+        }
+        log(std::format("startup: history opened in {:.1f} ms",
+                        StageSpan::seconds_since(start) * 1000));
+        if (persist) open_cache(*backends, db_path);
+    });
+
+    if (config_.preview.enabled) {
+        partial_ = std::make_unique<PartialTranscriber>(*backends_->model, config_.audio.sample_rate,
+                                                        config_.preview.interval_ms, notify_);
+    }
+
+    if (config_.prompt.enabled) {
+        prompts_ = std::make_unique<PromptBuilder>(PromptBuilder::Options{
+            .max_terms = config_.prompt.max_terms,
+            .max_files = config_.prompt.max_files,
+        });
     }
-    if (!history_db_.open(db_path)) {
-        std::println(stderr, "Warning: history DB failed to open, history disabled");
+
+    if (config_.audio.armed && !session_.arm(config_.audio.preroll_ms)) {
+        std::println(stderr, "Warning: could not keep capture armed, starting it per recording");
     }
 
     return true;
 }
 
+std::shared_ptr<DaemonCore::Backends> DaemonCore::wrap_backend(std::unique_ptr<WhisperBackend> model,
+                                                              const Config& config) {
+    auto out = std::make_shared<Backends>();
+    // Previews of a growing recording never repeat and are never long; they
+    // bypass both wrappers.
+    out->model = model.get();
+    out->backend = std::move(model);
+    auto identity = backend_identity(config.backend);
+    if (config.chunking.enabled) {
+        auto& c = config.chunking;
+        auto chunking = std::make_unique<ChunkingBackend>(std::move(out->backend), chunking::Options{
+            .max_chunk_seconds = c.max_chunk_seconds,
+            .concurrency = c.concurrency,
+            .overlap_ms = c.overlap_ms,
+            .threshold_db = config.vad.threshold_db,
+        });
+        out->chunker = chunking.get();
+        out->backend = std::move(chunking);
+        // Where a clip is cut changes its text a little.
+        identity += std::format("|chunks {}/{}", c.max_chunk_seconds, c.overlap_ms);
+    }
+    if (config.cache.enabled) {
+        auto cache = std::make_unique<TranscriptCache>(config.cache.max_entries);
+        auto caching = std::make_unique<CachingBackend>(std::move(out->backend), std::move(cache),
+                                                        std::move(identity));
+        out->cache = caching.get();
+        out->backend = std::move(caching);
+    }
+    return out;
+}
+
+void DaemonCore::reload(Config next) {
+    // Sized or opened at startup: these keep their running values.
+    std::string restart;
+    auto keep = [&restart](auto& wanted, const auto& running, std::string_view name) {
+        if (wanted == running) return;
+        wanted = running;
+        if (!restart.empty()) restart += ", ";
+        restart += name;
+    };
+    keep(next.audio, config_.audio, "audio");
+    keep(next.daemon, config_.daemon, "daemon");
+    keep(next.archive, config_.archive, "archive");
+    keep(next.output.native_wayland, config_.output.native_wayland, "output.native_wayland");
+    if (!restart.empty()) log("Config: " + restart + " changed, which takes a restart");
+
+    bool rebuild = !backend_pinned_ &&
+        (next.backend != config_.backend || next.cache != config_.cache || next.chunking != config_.chunking ||
+         (next.chunking.enabled && next.vad.threshold_db != config_.vad.threshold_db));
+    if (rebuild) {
+        if (auto model = create_backend(next)) {
+            // Previews use the model directly; they move to the new one below.
+            partial_.reset();
+            // Jobs and the recording in progress keep the old one alive.
+            backends_ = wrap_backend(std::move(model), next);
+            if (next.cache.persist) {
+                await_history();
+                open_cache(*backends_, data_dir_ + "/history.db");
+            }
+        } else {
+            log("Config: backend unchanged");
+            next.backend = config_.backend;
+            next.cache = config_.cache;
+            next.chunking = config_.chunking;
+            rebuild = false;
+        }
+    }
+    if (rebuild || next.preview != config_.preview) {
+        partial_.reset();
+        if (next.preview.enabled) {
+            partial_ = std::make_unique<PartialTranscriber>(*backends_->model, next.audio.sample_rate,
+                                                            next.preview.interval_ms, notify_);
+        }
+    }
+    if (next.prompt != config_.prompt) {
+        prompts_.reset();
+        if (next.prompt.enabled) {
+            prompts_ = std::make_unique<PromptBuilder>(PromptBuilder::Options{
+                .max_terms = next.prompt.max_terms,
+                .max_files = next.prompt.max_files,
+            });
+        }
+    }
+    // Live outputs hold on to the rules they started with.
+    if (next.postprocess != config_.postprocess) {
+        post_ = std::make_shared<const PostProcessor>(next.postprocess);
+    }
+    if (next.output != config_.output) outputs_.configure(next.output);
+    if (next.agents != config_.agents) detector_.set_agents(next.agents);
+
+    std::string changed;
+    auto note = [&changed](bool differs, std::string_view name) {
+        if (!differs) return;
+        if (!changed.empty()) changed += ", ";
+        changed += name;
+    };
+    note(next.backend != config_.backend, "backend");
+    note(next.output != config_.output, "output");
+    note(next.streaming != config_.streaming, "streaming");
+    note(next.preview != config_.preview, "preview");
+    note(next.prompt != config_.prompt, "prompt");
+    note(next.vad != config_.vad, "vad");
+    note(next.trim != config_.trim, "trim");
+    note(next.cleanup != config_.cleanup, "cleanup");
+    note(next.queue != config_.queue, "queue");
+    note(next.postprocess != config_.postprocess, "postprocess");
+    note(next.cache != config_.cache, "cache");
+    note(next.chunking != config_.chunking, "chunking");
+    note(next.agents != config_.agents, "agents");
+    // Everything else is read per recording, from here on.
+    config_ = std::move(next);
+    log(changed.empty() ? "Config reloaded, nothing to apply" : "Config reloaded: " + changed);
+}
+
+void DaemonCore::open_cache(Backends& backends, const std::string& db_path) {
+    if (backends.cache && !backends.cache->cache().open(db_path)) {
+        std::println(stderr, "Warning: transcript cache not persisted, keeping it in memory");
+    }
+}
+
+void DaemonCore::await_history() {
+    if (history_opener_.joinable()) history_opener_.join();
+}
+
+DaemonCore::History DaemonCore::history(uint32_t uid) {
+    await_history();
+    if (!config_.daemon.multi_user) return {history_db_, history_writer_};
+
+    auto& user = user_histories_[uid];
+    if (!user) {
+        user = std::make_unique<UserHistory>();
+        auto path = std::format("{}/users/{}/history.db", data_dir_, uid);
+        if (!user->db.open(path)) {
+            log(std::format("History of uid {} failed to open", uid));
+        } else if (!user->writer.open(path)) {
+            log(std::format("History writer of uid {} failed to start, writing on the main thread", uid));
+        }
+    }
+    return {user->db, user->writer};
+}
+
+std::optional<uint32_t> DaemonCore::audience(uint32_t uid) const {
+    if (!config_.daemon.multi_user) return std::nullopt;
+    return uid;
+}
+
+std::unique_ptr<WhisperBackend> DaemonCore::create_backend(const Config& config) {
+    auto& b = config.backend;
+    CircuitBreaker::Options health{
+        .failures = b.health.failures,
+        .retry = std::chrono::seconds(b.health.retry_seconds),
+    };
+    auto make_lan = [&b, &health](const std::string& url, const std::string& api_format) {
+        return std::make_unique<LanBackend>(url, api_format, b.language, b.http2,
+                                            b.audio_format, b.opus_bitrate, health);
+    };
+    auto make_local = [&b]() -> std::unique_ptr<WhisperBackend> {
+#ifdef SPEAK_ANYWHERE_HAVE_WHISPER
+        auto local = std::make_unique<LocalWhisperBackend>(LocalWhisperBackend::Options{
+            .model_path = b.local.model_path,
+            .language = b.language,
+            .threads = b.local.threads,
+            .use_gpu = b.local.use_gpu,
+            .lazy_load = b.local.lazy_load,
+        });
+        if (!b.local.lazy_load) {
+            if (auto loaded = local->load(); !loaded) {
+                std::println(stderr, "{}", loaded.error());
+                return nullptr;
+            }
+        }
+        return local;
+#else
+        std::println(stderr, "Backend type local needs a build with whisper.cpp");
+        return nullptr;
+#endif
+    };
+
+    if (b.type == "lan") {
+        auto mode = BackendPool::parse_mode(b.pool_mode);
+        if (!mode) {
+            std::println(stderr, "Unknown backend pool mode: {}", b.pool_mode);
+            return nullptr;
+        }
+        std::unique_ptr<WhisperBackend> fallback;
+        if (b.local_fallback && !(fallback = make_local())) {
+            std::println(stderr, "Warning: no local fallback, transcribing with the server only");
+        }
+        if (b.endpoints.empty() && !fallback) return make_lan(b.url, b.api_format);
+
+        // A single server with a fallback is a pool of one.
+        auto pool = std::make_unique<BackendPool>(b.endpoints.empty() ? BackendPool::Mode::Failover : *mode);
+        if (b.endpoints.empty()) pool->add(b.url, make_lan(b.url, b.api_format));
+        for (auto& ep : b.endpoints) {
+            pool->add(ep.url, make_lan(ep.url, ep.api_format.empty() ? b.api_format : ep.api_format));
+        }
+        if (fallback) pool->add_fallback("local", std::move(fallback));
+        return pool;
+    } else if (b.type == "local") {
+        return make_local();
+    } else {
+        std::println(stderr, "Unknown backend type: {}", b.type);
+        return nullptr;
+    }
+}
+
+uint32_t DaemonCore::probe_ms() const {
+    if (config_.backend.type != "lan") return 0;
+    return config_.backend.health.probe_seconds * 1000;
+}
+
+void DaemonCore::probe_backends() {
+    if (transfers_ && backends_) backends_->model->probe(*transfers_);
+}
+
 nlohmann::json DaemonCore::handle_command(const std::string& cmd_str,
-                                          const nlohmann::json& cmd) {
-    if (cmd_str == "start") return handle_start(cmd);
-    if (cmd_str == "stop") return handle_stop(cmd);
-    if (cmd_str == "toggle") return handle_toggle(cmd);
-    if (cmd_str == "status") return handle_status(cmd);
-    if (cmd_str == "history") return handle_history(cmd);
-    return {{"status", "error"}, {"message", "unknown command"}};
+                                          const nlohmann::json& cmd, uint32_t uid, int client_fd) {
+    caller_uid_ = uid;
+    caller_fd_ = client_fd;
+    // One microphone, one recording: whoever started it is the only one
+    // who can end it.
+    if (config_.daemon.multi_user && session_.state() == SessionState::Recording &&
+        uid != recording_uid_ && (cmd_str == "stop" || cmd_str == "toggle")) {
+        return {{"status", "error"}, {"message", "recording in progress for another user"}};
+    }
+
+    nlohmann::json resp;
+    // The handlers read their fields with value(), which throws on one of
+    // the wrong type ({"limit": "x"}). That fails the command, not the daemon.
+    try {
+        if (cmd_str == "start") resp = handle_start(cmd);
+        else if (cmd_str == "stop") resp = handle_stop(cmd);
+        else if (cmd_str == "toggle") resp = handle_toggle(cmd);
+        else if (cmd_str == "status") return handle_status(cmd);
+        else if (cmd_str == "history") return handle_history(cmd);
+        else if (cmd_str == "search") return handle_search(cmd);
+        else if (cmd_str == "retranscribe") resp = handle_retranscribe(cmd);
+        else if (cmd_str == "cancel") resp = handle_cancel(cmd);
+        else if (cmd_str == "metrics") return handle_metrics(cmd);
+        else if (cmd_str == "stats") return handle_stats(cmd);
+        else if (cmd_str == "export") return handle_export(cmd);
+        else if (cmd_str == "import") return handle_import(cmd);
+        else if (cmd_str == "subscribe") return {{"status", "ok"}, {"message", "subscribed"}};
+        else return {{"status", "error"}, {"message", "unknown command"}};
+    } catch (const nlohmann::json::exception& e) {
+        log(std::format("Rejected a malformed {} command: {}", cmd_str, e.what()));
+        return {{"status", "error"}, {"message", std::format("invalid {} command: {}", cmd_str, e.what())}};
+    }
+
+    publish_state();
+    return resp;
 }
 
 nlohmann::json DaemonCore::handle_start(const nlohmann::json& cmd) {
     if (session_.state() != SessionState::Idle) {
-        return {{"status", "error"}, {"message", "already recording or transcribing"}};
+        return {{"status", "error"}, {"message", "already recording"}};
+    }
+    if (config_.queue.cancel_on_start) {
+        if (size_t n = cancel_jobs(); n > 0) {
+            log(std::format("Cancelled {} pending transcription(s) for new recording", n));
+        }
+    }
+    // Cancelled jobs are only waiting for their abort to land; they don't
+    // count. Users kept apart each get max_jobs of their own.
+    auto pending = std::ranges::count_if(jobs_, [this](auto& job) {
+        return !job->cancelled && (!config_.daemon.multi_user || job->uid == caller_uid_);
+    });
+    if (config_.queue.max_jobs > 0 && static_cast<size_t>(pending) >= config_.queue.max_jobs) {
+        return {{"status", "error"}, {"message", "too many transcriptions pending"}};
     }
 
     pending_output_method_ = cmd.value("output", config_.output.default_method);
@@ -68,8 +387,82 @@ nlohmann::json DaemonCore::handle_start(const nlohmann::json& cmd) {
         return {{"status", "error"}, {"message", "failed to start recording"}};
     }
 
-    log("Recording started" + (window.context.empty() ? "" : " (" + window.context + ")"));
-    return {{"status", "ok"}, {"message", "recording"}};
+    // This recording finishes with the backend it starts with, reloads or not.
+    recording_backends_ = backends_;
+    auto& backend = *backends_->backend;
+    // Get the connection open while the user is still talking.
+    backend.warm_up();
+    // And the vocabulary scanned, if focus didn't already.
+    if (prompts_ && !window.working_dir.empty()) {
+        if (agent_dirs_.size() >= 64 && !agent_dirs_.contains(window.pid)) agent_dirs_.clear();
+        agent_dirs_[window.pid] = window.working_dir;
+        prompts_->prefetch(window.working_dir);
+    }
+
+    if (config_.streaming.enabled) {
+        std::optional<StreamingTranscriber::VadCuts> vad;
+        if (config_.vad.enabled) {
+            vad = StreamingTranscriber::VadCuts{
+                .threshold_db = config_.vad.threshold_db,
+                .silence_ms = config_.vad.silence_ms,
+                .min_segment_seconds = config_.vad.min_segment_seconds,
+            };
+        }
+        // Segments can go out as they are transcribed if the method shows
+        // text piecemeal; the final result then only adds the tail.
+        if (config_.output.incremental) {
+            auto strategy = outputs_.choose(pending_output_method_, window);
+            auto* output = outputs_.output(strategy);
+            if (output && output->incremental()) {
+                if (auto res = output->begin(); !res) {
+                    log("Output delivery failed: " + res.error());
+                }
+                live_ = LiveOutput{.output = output, .strategy = strategy,
+                                   .rules = &post_->select(window), .post = post_};
+            }
+        }
+        stream_ = std::make_unique<StreamingTranscriber>(
+            backend, config_.audio.sample_rate, config_.streaming.segment_seconds, vad,
+            live_ ? notify_ : NotifyCallback{});
+        // Segments go out while recording: whatever the cache has now.
+        if (prompts_) stream_->set_prompt(prompts_->prompt(window.working_dir));
+    } else if (!config_.trim.enabled && backend.upload_format() != "wav") {
+        // Compress while recording so stop only has to flush the last block.
+        // Trimming needs the whole clip first, so it encodes at upload instead.
+        if (auto enc = make_audio_encoder(backend.upload_format(), config_.audio.sample_rate,
+                                          config_.backend.opus_bitrate)) {
+            encoder_ = std::make_unique<BackgroundEncoder>(std::move(enc), config_.audio.sample_rate,
+                                                           config_.audio.cpus);
+        }
+    } else if (backend.accepts_float()) {
+        // The model takes float: convert each chunk as it arrives, into the
+        // last recording's buffer so its pages don't have to be faulted in
+        // (and freed) again.
+        float_pcm_.emplace(std::move(spare_pcm_));
+        float_pcm_->clear();
+    }
+
+    if (cmd.value("auto_stop", false)) {
+        auto_stop_.emplace(config_.audio.sample_rate, config_.vad.threshold_db,
+                           config_.vad.auto_stop_ms, config_.vad.no_speech_ms);
+    }
+
+    cleanup_.reset();
+    if (config_.cleanup.denoise || config_.cleanup.agc) {
+        cleanup_.emplace(config_.audio.sample_rate, InputCleanup::Options{
+            .denoise = config_.cleanup.denoise,
+            .suppression_db = config_.cleanup.suppression_db,
+            .agc = config_.cleanup.agc,
+            .target_db = config_.cleanup.target_db,
+            .max_gain_db = config_.cleanup.max_gain_db,
+        });
+    }
+    meter_.reset();
+    overflow_at_start_ = ring_buf_.overflow_bytes();
+    recording_uid_ = caller_uid_;
+    log("Recording started" + (window.context.empty() ? "" : " (" + window.context + ")") +
+        (auto_stop_ ? ", stops on silence" : ""));
+    return {{"status", "ok"}, {"message", auto_stop_ ? "recording (auto-stop)" : "recording"}};
 }
 
 nlohmann::json DaemonCore::handle_stop(const nlohmann::json& /*cmd*/) {
@@ -77,18 +470,74 @@ nlohmann::json DaemonCore::handle_stop(const nlohmann::json& /*cmd*/) {
         return {{"status", "error"}, {"message", "not recording"}};
     }
 
+    auto stopped_at = StageSpan::Clock::now();
+    auto_stop_.reset();
+    // The final pass gets the backend to itself.
+    if (partial_) partial_->cancel();
     auto audio = session_.stop_recording();
+    auto stream = std::move(stream_);
+    auto encoder = std::move(encoder_);
+    auto pcm = std::exchange(float_pcm_, std::nullopt);
+    auto cleanup = std::exchange(cleanup_, std::nullopt);
+    auto live = std::exchange(live_, std::nullopt);
     if (audio.empty()) {
+        if (live) end_live(*live);
+        recording_backends_.reset();
         session_.set_idle();
         return {{"status", "error"}, {"message", "no audio captured"}};
     }
 
+    meter_.feed(std::span<const int16_t>(audio).subspan(meter_.samples()));
+    if (cleanup) cleanup->process(std::span<int16_t>(audio).subspan(cleanup->samples()));
+    if (stream) {
+        stream->feed(std::span<const int16_t>(audio).subspan(stream->samples_fed()));
+    }
+    if (encoder) {
+        encoder->push(std::span<const int16_t>(audio).subspan(encoder->samples_pushed()));
+    }
+    if (pcm) {
+        audio::append_float(*pcm, std::span<const int16_t>(audio).subspan(pcm->size()));
+    }
+
+    // Streamed segments are already on their way; only whole clips are trimmed.
+    size_t trimmed = 0;
+    if (!stream && config_.trim.enabled) {
+        auto range = audio::find_voiced_range(audio, config_.audio.sample_rate,
+                                              config_.trim.threshold_db, config_.trim.padding_ms);
+        trimmed = range.trimmed(audio.size());
+        audio.resize(range.end);
+        audio.erase(audio.begin(), audio.begin() + static_cast<ptrdiff_t>(range.begin));
+        if (pcm) {
+            pcm->resize(range.end);
+            pcm->erase(pcm->begin(), pcm->begin() + static_cast<ptrdiff_t>(range.begin));
+        }
+    }
+
+    std::optional<double> drain_s = StageSpan::seconds_since(stopped_at);
     double duration = static_cast<double>(audio.size()) / config_.audio.sample_rate;
-    log(std::format("Recording stopped, {:.1f}s audio, transcribing...", duration));
+    log(std::format("Recording stopped, {:.1f}s audio ({} samples trimmed), transcribing...",
+                    duration, trimmed));
+    if (uint64_t lost = ring_buf_.overflow_bytes() - overflow_at_start_; lost > 0) {
+        log(std::format("Audio buffer overflowed, {} bytes dropped", lost));
+    }
+    // Before the trim, so a quiet mic isn't hidden by cutting the silence.
+    if (auto levels = meter_.recording(); levels.clipped_pct >= 0.1) {
+        log(std::format("Input clipped ({:.1f}% of samples at full scale), lower the mic gain",
+                        levels.clipped_pct));
+    } else if (levels.peak_db <= config_.vad.threshold_db) {
+        log(std::format("Input peaked at {:.0f} dBFS, is the mic muted?", levels.peak_db));
+    }
 
-    start_transcription(std::move(audio), session_.window_context(), pending_output_method_);
+    uint64_t job_id = start_transcription(std::move(audio), session_.window_context(),
+                                          pending_output_method_, std::move(stream),
+                                          std::move(encoder), pcm ? std::move(*pcm) : std::vector<float>{},
+                                          trimmed, stopped_at, drain_s);
+    jobs_.back()->live = std::move(live);
+    // The job owns the audio now; the next recording can start right away.
+    session_.set_idle();
 
-    return {{"status", "transcribing"}, {"duration", duration}};
+    return {{"status", "transcribing"}, {"job_id", job_id}, {"duration", duration},
+            {"trimmed_samples", trimmed}};
 }
 
 nlohmann::json DaemonCore::handle_toggle(const nlohmann::json& cmd) {
@@ -98,26 +547,57 @@ nlohmann::json DaemonCore::handle_toggle(const nlohmann::json& cmd) {
     return handle_start(cmd);
 }
 
-nlohmann::json DaemonCore::handle_status(const nlohmann::json& /*cmd*/) {
-    nlohmann::json resp = {{"status", "ok"}};
+const char* DaemonCore::state_name() const {
     switch (session_.state()) {
         case SessionState::Idle:
-            resp["state"] = "idle";
-            break;
+            return jobs_.empty() ? "idle" : "transcribing";
         case SessionState::Recording:
-            resp["state"] = "recording";
-            resp["duration"] = session_.recording_duration();
-            break;
+            return "recording";
         case SessionState::Transcribing:
-            resp["state"] = "transcribing";
-            break;
+            return "transcribing";
+    }
+    return "idle";
+}
+
+nlohmann::json DaemonCore::handle_status(const nlohmann::json& /*cmd*/) {
+    nlohmann::json resp = {{"status", "ok"}, {"pending_jobs", jobs_.size()}, {"state", state_name()}};
+    if (session_.state() == SessionState::Recording) {
+        resp["duration"] = session_.recording_duration();
+        auto recent = meter_.recent();
+        auto total = meter_.recording();
+        resp["level"] = {
+            {"rms_db", recent.rms_db},
+            {"peak_db", total.peak_db},
+            {"clipped_pct", total.clipped_pct},
+        };
+    }
+
+    auto capture = audio_.stats();
+    resp["capture"] = {
+        {"callbacks", capture.callbacks},
+        {"bytes", capture.bytes},
+        {"dropped_bytes", capture.dropped_bytes},
+        {"underruns", capture.underruns},
+        {"quantum", capture.quantum},
+        {"callback_avg_us", capture.callback_avg_us},
+        {"callback_max_us", capture.callback_max_us},
+        {"locked_bytes", capture.locked_bytes},
+        {"hugepages", capture.hugepages},
+        {"cpus", capture.cpus},
+    };
+
+    nlohmann::json servers = nlohmann::json::array();
+    for (auto& h : backends_ ? backends_->model->health() : std::vector<EndpointHealth>{}) {
+        servers.push_back({{"name", h.name}, {"state", h.state}, {"consecutive_failures", h.consecutive_failures},
+                           {"rejected", h.rejected}, {"last_error", h.last_error}});
     }
+    resp["servers"] = std::move(servers);
     return resp;
 }
 
 nlohmann::json DaemonCore::handle_history(const nlohmann::json& cmd) {
     int limit = cmd.value("limit", 10);
-    auto entries = history_db_.recent(limit);
+    auto entries = history(caller_uid_).db.recent(limit);
 
     nlohmann::json resp = {{"status", "ok"}, {"entries", nlohmann::json::array()}};
     for (auto& e : entries) {
@@ -128,104 +608,742 @@ nlohmann::json DaemonCore::handle_history(const nlohmann::json& cmd) {
             {"audio_duration", e.audio_duration},
             {"processing_time", e.processing_time},
             {"app_context", e.app_context},
+            {"timings", timings_json(e.timings)},
         });
     }
     return resp;
 }
 
-void DaemonCore::start_transcription(std::vector<int16_t> audio, WindowInfo context,
-                                     const std::string& output_method) {
-    worker_result_ = {};
+nlohmann::json DaemonCore::handle_stats(const nlohmann::json& cmd) {
+    // The rollups are by day: a full timestamp counts from its date.
+    auto day = [&cmd](const char* key) { return cmd.value(key, std::string{}).substr(0, 10); };
+    auto stats = history(caller_uid_).db.stats(day("since"), day("before"));
+    if (!stats) return {{"status", "error"}, {"message", stats.error()}};
+
+    nlohmann::json days = nlohmann::json::array();
+    int64_t entries = 0, words = 0;
+    double audio = 0;
+    for (auto& d : stats->days) {
+        days.push_back({{"day", d.day}, {"app", d.app}, {"agent", d.agent}, {"entries", d.entries},
+                        {"words", d.words}, {"audio_seconds", d.audio_seconds}});
+        entries += d.entries;
+        words += d.words;
+        audio += d.audio_seconds;
+    }
+    nlohmann::json backends = nlohmann::json::array();
+    for (auto& b : stats->backends) {
+        backends.push_back({{"backend", b.backend}, {"entries", b.entries}, {"audio_seconds", b.audio_seconds},
+                            {"processing_seconds", b.processing_seconds},
+                            {"real_time_factor", b.real_time_factor()}});
+    }
+    return {{"status", "ok"}, {"entries", entries}, {"words", words}, {"audio_seconds", audio},
+            {"days", std::move(days)}, {"backends", std::move(backends)}};
+}
+
+nlohmann::json DaemonCore::handle_export(const nlohmann::json& cmd) {
+    auto name = cmd.value("format", "ndjson");
+    if (!history_io::parse_format(name)) return {{"status", "error"}, {"message", "unknown format: " + name}};
+    // The rows follow once start_export() has the connection.
+    return {{"status", "ok"}, {"format", name}};
+}
+
+nlohmann::json DaemonCore::handle_import(const nlohmann::json& cmd) {
+    // A file larger than one message arrives in chunks, "more" on all but
+    // the last, and is imported as a whole once the last one is in.
+    constexpr size_t MAX_IMPORT_BYTES = 256u << 20;
+    auto name = cmd.value("format", "ndjson");
+    auto format = history_io::parse_format(name);
+    if (!format) {
+        imports_.erase(caller_fd_);
+        return {{"status", "error"}, {"message", "unknown format: " + name}};
+    }
+    auto& data = imports_[caller_fd_];
+    if (auto it = cmd.find("data"); it != cmd.end() && it->is_string()) {
+        data += it->get_ref<const std::string&>();
+    }
+    if (data.size() > MAX_IMPORT_BYTES) {
+        imports_.erase(caller_fd_);
+        return {{"status", "error"}, {"message", "import too large"}};
+    }
+    if (cmd.value("more", false)) return {{"status", "ok"}, {"message", "buffered"}};
+
+    auto records = history_io::parse(data, *format);
+    imports_.erase(caller_fd_);
+    if (!records) return {{"status", "error"}, {"message", records.error()}};
+
+    auto h = history(caller_uid_);
+    // Transcriptions queued before the import keep their place ahead of it.
+    h.writer.flush();
+    if (!h.db.import(*records)) {
+        return {{"status", "error"}, {"message", "import failed, nothing was added"}};
+    }
+    log(std::format("Imported {} history entries", records->size()));
+    return {{"status", "ok"}, {"imported", records->size()}};
+}
+
+nlohmann::json DaemonCore::handle_search(const nlohmann::json& cmd) {
+    constexpr int MAX_PAGE = 100;
+    int limit = std::clamp(cmd.value("limit", 20), 1, MAX_PAGE);
+
+    HistoryFilter filter{
+        .app_id = cmd.value("app_id", ""),
+        .agent = cmd.value("agent", ""),
+        .working_dir = cmd.value("working_dir", ""),
+        .since = cmd.value("since", ""),
+        .before = cmd.value("before", ""),
+    };
+
+    std::optional<SearchCursor> after;
+    if (auto cursor = cmd.value("after", ""); !cursor.empty()) {
+        after = SearchCursor::parse(cursor);
+        if (!after) return {{"status", "error"}, {"message", "invalid cursor"}};
+    }
+
+    auto page = history(caller_uid_).db.search(cmd.value("query", ""), filter, after, limit);
+    if (!page) return {{"status", "error"}, {"message", page.error()}};
 
-    worker_ = std::jthread([this, audio = std::move(audio), context = std::move(context),
-                            output_method, sample_rate = config_.audio.sample_rate]
-                           (std::stop_token) mutable {
-        auto result = backend_->transcribe(audio, sample_rate);
-        worker_result_ = WorkerResult{
-            .result = std::move(result),
-            .context = std::move(context),
-            .output_method = output_method,
+    nlohmann::json resp = {{"status", "ok"}, {"hits", nlohmann::json::array()}};
+    for (auto& hit : page->hits) {
+        auto& e = hit.entry;
+        resp["hits"].push_back({
+            {"id", e.id},
+            {"timestamp", e.timestamp},
+            {"text", e.text},
+            {"snippet", hit.snippet},
+            {"rank", hit.rank},
+            {"app_context", e.app_context},
+            {"app_id", e.app_id},
+            {"agent", e.agent},
+            {"working_dir", e.working_dir},
+        });
+    }
+    if (page->next) resp["next"] = page->next->encode();
+    return resp;
+}
+
+nlohmann::json DaemonCore::handle_retranscribe(const nlohmann::json& cmd) {
+    if (!archive_) return {{"status", "error"}, {"message", "audio archive disabled"}};
+
+    auto entry = history(caller_uid_).db.get(cmd.value("id", int64_t{0}));
+    if (!entry) return {{"status", "error"}, {"message", "no such history entry"}};
+    if (entry->audio_id == 0) return {{"status", "error"}, {"message", "no audio kept for this entry"}};
+
+    auto clip = archive_->clip(entry->audio_id);
+    if (!clip) return {{"status", "error"}, {"message", "audio no longer in the archive"}};
+
+    double duration = static_cast<double>(clip->samples.size()) / clip->sample_rate;
+    uint64_t job_id = start_replay(std::move(*clip), std::move(*entry), cmd.value("fresh", false));
+    return {{"status", "transcribing"}, {"job_id", job_id}, {"duration", duration}};
+}
+
+nlohmann::json DaemonCore::handle_metrics(const nlohmann::json& /*cmd*/) {
+    nlohmann::json stages = nlohmann::json::object();
+    for (size_t i = 0; i < STAGES.size(); ++i) {
+        auto& h = metrics_.stage(i);
+        if (h.count() == 0) continue;
+        stages[STAGES[i].name] = {
+            {"count", h.count()},
+            {"mean", h.mean()},
+            {"p50", h.percentile(0.50)},
+            {"p95", h.percentile(0.95)},
+            {"p99", h.percentile(0.99)},
+            {"max", h.max()},
+        };
+    }
+    // Audio the capture thread couldn't queue because the buffer was full.
+    nlohmann::json buffer = {
+        {"allocated_bytes", ring_buf_.allocated_bytes()},
+        {"capacity_bytes", ring_buf_.capacity()},
+        {"overflow_bytes", ring_buf_.overflow_bytes()},
+        {"overflows", ring_buf_.overflows()},
+    };
+    nlohmann::json resp = {{"status", "ok"}, {"transcriptions", metrics_.transcriptions()},
+                           {"stages", stages}, {"audio_buffer", buffer}};
+    if (auto* cache = backends_->cache) {
+        resp["cache"] = {
+            {"entries", cache->cache().size()},
+            {"hits", cache->cache().hits()},
+            {"misses", cache->cache().misses()},
         };
+    }
+    return resp;
+}
+
+void DaemonCore::discard_recording() {
+    session_.stop_recording();
+    stream_.reset();
+    encoder_.reset();
+    float_pcm_.reset();
+    cleanup_.reset();
+    auto_stop_.reset();
+    if (partial_) partial_->cancel();
+    if (live_) end_live(*live_);
+    live_.reset();
+    recording_backends_.reset();
+    session_.set_idle();
+}
+
+nlohmann::json DaemonCore::handle_cancel(const nlohmann::json& cmd) {
+    uint64_t job_id = cmd.value("job_id", uint64_t{0});
+
+    // A recording in progress is dropped without being transcribed.
+    bool discarded = false;
+    bool own = !config_.daemon.multi_user || recording_uid_ == caller_uid_;
+    if (job_id == 0 && session_.state() == SessionState::Recording && own) {
+        discard_recording();
+        discarded = true;
+        log("Recording discarded");
+    }
+
+    size_t cancelled = cancel_jobs(job_id);
+    if (!discarded && cancelled == 0) {
+        return {{"status", "error"},
+                {"message", job_id == 0 ? "nothing to cancel" : "no such job"}};
+    }
+    return {{"status", "ok"}, {"message", "cancelled"},
+            {"discarded_recording", discarded}, {"cancelled_jobs", cancelled}};
+}
+
+size_t DaemonCore::cancel_jobs(uint64_t job_id) {
+    size_t n = 0;
+    for (auto& job : jobs_) {
+        if (job->cancelled || (job_id != 0 && job->id != job_id)) continue;
+        if (config_.daemon.multi_user && job->uid != caller_uid_) continue;
+        // The worker's stop token aborts the HTTP transfer or whisper_full;
+        // the job still completes (with an error) and is delivered in order.
+        job->cancelled = true;
+        job->worker.request_stop();
+        if (job->transfer) transfers_->cancel(job->transfer);
+        ++n;
+    }
+    return n;
+}
+
+uint64_t DaemonCore::start_transcription(std::vector<int16_t> audio, WindowInfo context,
+                                         const std::string& output_method,
+                                         std::unique_ptr<StreamingTranscriber> stream,
+                                         std::unique_ptr<BackgroundEncoder> encoder,
+                                         std::vector<float> pcm,
+                                         size_t trimmed_samples,
+                                         StageSpan::Clock::time_point stopped_at,
+                                         std::optional<double> drain_s) {
+    auto job = std::make_unique<Job>();
+    job->id = next_job_id_++;
+    job->uid = recording_uid_;
+    job->context = std::move(context);
+    job->backends = std::exchange(recording_backends_, nullptr);
+    job->output_method = output_method;
+    job->trimmed_samples = trimmed_samples;
+    job->stopped_at = stopped_at;
+    job->drain_s = drain_s;
+    job->stream = std::move(stream);
+    job->pcm = std::move(pcm);
+    // Only a cache lookup: the scan happened while the user was talking.
+    if (prompts_) job->prompt = prompts_->prompt(job->context.working_dir);
+
+    if (transfers_ && !job->stream && !encoder && job->pcm.empty()) {
+        job->audio = std::move(audio);
+        job->transfer = job->backends->backend->start_transcribe(
+            *transfers_, job->audio, config_.audio.sample_rate, job->prompt,
+            [this, j = job.get(), sample_rate = config_.audio.sample_rate](auto result) {
+                j->result = std::move(result);
+                j->transfer = 0;
+                if (archive_ && j->result && !j->cancelled) {
+                    j->audio_id = archive_->append(j->audio, sample_rate);
+                }
+                j->done.store(true, std::memory_order_release);
+                on_transcription_complete();
+            });
+        if (job->transfer) {
+            uint64_t id = job->id;
+            jobs_.push_back(std::move(job));
+            return id;
+        }
+        // The backend can only block: it gets a worker after all.
+        audio = std::move(job->audio);
+    }
+
+    job->worker = std::jthread([this, j = job.get(), audio = std::move(audio),
+                                encoder = std::move(encoder),
+                                sample_rate = config_.audio.sample_rate]
+                               (std::stop_token stop) mutable {
+        if (j->stream) {
+            j->result = j->stream->finish(stop);
+        } else if (auto* chunker = j->backends->chunker;
+                   encoder && !(chunker && chunker->splits(audio.size(), sample_rate))) {
+            // (A clip long enough to be split goes out as PCM chunks instead:
+            // the encoded file can't be cut.)
+            // Most of the file was encoded while recording; this is the last block.
+            std::optional<double> encode_s;
+            EncodedAudio encoded;
+            {
+                StageSpan span(encode_s);
+                encoded = encoder->finish();
+            }
+            j->result = j->backends->backend->transcribe_encoded(encoded, stop, j->prompt);
+            if (j->result) j->result->timings.encode_s = encode_s;
+        } else if (!j->pcm.empty()) {
+            j->result = j->backends->backend->transcribe(std::span<const float>(j->pcm), sample_rate,
+                                                         stop, j->prompt);
+        } else {
+            j->result = j->backends->backend->transcribe(audio, sample_rate, stop, j->prompt);
+        }
+        // Stored once the request is done so it doesn't hold up the upload.
+        if (archive_ && j->result && !stop.stop_requested()) {
+            j->audio_id = archive_->append(audio, sample_rate);
+        }
+        j->done.store(true, std::memory_order_release);
+
+        notify_();
+    });
+
+    uint64_t id = job->id;
+    jobs_.push_back(std::move(job));
+    return id;
+}
+
+uint64_t DaemonCore::start_replay(AudioClip clip, HistoryEntry original, bool fresh) {
+    auto job = std::make_unique<Job>();
+    job->id = next_job_id_++;
+    job->uid = caller_uid_;
+    job->stopped_at = StageSpan::Clock::now();
+    job->replay_of = std::move(original);
+    job->backends = backends_;
+
+    // The samples go to the backend straight from the archive's mapping.
+    job->worker = std::jthread([this, j = job.get(), clip = std::move(clip), fresh]
+                               (std::stop_token stop) {
+        if (fresh && j->backends->cache) {
+            j->result = j->backends->cache->refresh(clip.samples, clip.sample_rate, stop);
+        } else {
+            j->result = j->backends->backend->transcribe(clip.samples, clip.sample_rate, stop);
+        }
+        j->done.store(true, std::memory_order_release);
 
         notify_();
     });
+
+    uint64_t id = job->id;
+    jobs_.push_back(std::move(job));
+    return id;
 }
 
 void DaemonCore::on_transcription_complete() {
-    if (worker_.joinable()) {
-        worker_.join();
+    // With users kept apart the order only holds per user, so one user's
+    // long transcription doesn't hold up everyone else's.
+    std::vector<uint32_t> behind;  // uids with an unfinished job further up
+    for (auto it = jobs_.begin(); it != jobs_.end();) {
+        uint32_t uid = config_.daemon.multi_user ? (*it)->uid : 0;
+        bool waits = std::ranges::find(behind, uid) != behind.end();
+        if (waits || !(*it)->done.load(std::memory_order_acquire)) {
+            if (!config_.daemon.multi_user) break;
+            if (!waits) behind.push_back(uid);
+            ++it;
+            continue;
+        }
+        auto job = std::move(*it);
+        it = jobs_.erase(it);
+        if (job->worker.joinable()) {
+            job->worker.join();
+        }
+        deliver(*job);
+        if (job->pcm.capacity() > spare_pcm_.capacity()) spare_pcm_ = std::move(job->pcm);
     }
+    feed_live_output();
+    if (partial_) publish_partial();
+    publish_state();
+}
+
+void DaemonCore::feed_live_output() {
+    // Only the oldest transcription may show text: anything newer would land
+    // ahead of text that is still to come.
+    if (!jobs_.empty()) {
+        auto& job = *jobs_.front();
+        if (job.live && !job.cancelled) append_live(*job.live, job.stream->take_finished());
+        return;
+    }
+    if (live_ && stream_) append_live(*live_, stream_->take_finished());
+}
+
+void DaemonCore::append_live(LiveOutput& live, const std::vector<std::string>& segments) {
+    for (auto& segment : segments) {
+        if (segment.empty()) continue;
+        // Joined the way StreamingTranscriber::finish() joins the full text.
+        std::string piece = live.raw.empty() ? segment : " " + segment;
+        live.raw += piece;
+        if (live.rules) piece = live.rules->apply_next(live.text, piece);
+        auto start = StageSpan::Clock::now();
+        auto res = live.output->append(piece);
+        live.spent_s += StageSpan::seconds_since(start);
+        if (!res) {
+            log("Output delivery failed: " + res.error());
+        }
+        live.text += piece;
+    }
+}
 
-    auto& wr = worker_result_;
+void DaemonCore::end_live(LiveOutput& live) {
+    // What it showed stays; only the session ends.
+    if (auto res = live.output->commit(); !res) {
+        log("Output delivery failed: " + res.error());
+    }
+}
+
+void DaemonCore::deliver(Job& job) {
     nlohmann::json response;
 
-    if (wr.result.has_value()) {
-        auto& tr = wr.result.value();
-        log(std::format("Transcription complete: {:.1f}s processing, {} chars",
-                        tr.processing_s, tr.text.size()));
+    if (job.cancelled) {
+        // Even if the result made it back before the abort landed, a cancelled
+        // transcription is neither typed out nor stored.
+        log(std::format("Transcription {} cancelled", job.id));
+        response = {{"status", "error"}, {"job_id", job.id}, {"message", "cancelled"}};
+    } else if (job.replay_of && job.result.has_value()) {
+        auto& tr = job.result.value();
+        log(std::format("Retranscription of entry {} complete: {:.1f}s processing",
+                        job.replay_of->id, tr.processing_s));
+        response = {
+            {"status", "ok"},
+            {"job_id", job.id},
+            {"id", job.replay_of->id},
+            {"text", tr.text},
+            {"original_text", job.replay_of->text},
+            {"duration", tr.duration_s},
+            {"processing_time", tr.processing_s},
+        };
+        if (tr.cached) response["cached"] = true;
+        if (!tr.chunks.empty()) response["chunks"] = chunks_json(tr.chunks);
+    } else if (job.result.has_value()) {
+        auto& tr = job.result.value();
+        log(std::format("Transcription {} complete: {:.1f}s processing, {} chars",
+                        job.id, tr.processing_s, tr.text.size()));
+        // What is typed out is also what history and the response get.
+        // A live job keeps the rules its segments went out with, and the
+        // text they showed: only the part of the result not shown yet is
+        // rewritten, continuing from it as append_live() does.
+        auto& post = job.live ? *job.live->post : *post_;
+        if (job.live && std::string_view(tr.text).starts_with(job.live->raw)) {
+            auto& live = *job.live;
+            auto tail = std::string_view(tr.text).substr(live.raw.size());
+            tr.text = live.text + (live.rules ? live.rules->apply_next(live.text, tail) : std::string(tail));
+        } else if (!post.empty()) {
+            tr.text = post.apply(tr.text, job.context);
+        }
+        if (prompts_) prompts_->remember(job.context.working_dir, tr.text);
 
-        // Determine if focused app is a terminal
-        std::string app = !wr.context.app_id.empty() ? wr.context.app_id : wr.context.window_class;
-        std::transform(app.begin(), app.end(), app.begin(), ::tolower);
+        auto timings = tr.timings;
+        timings.drain_s = job.drain_s;
 
-        bool is_terminal = !app.empty() &&
-            (app.find("kitty") != std::string::npos ||
-             app.find("alacritty") != std::string::npos ||
-             app.find("foot") != std::string::npos ||
-             app.find("wezterm") != std::string::npos);
+        if (job.live) {
+            // Segments already went out as they came in; add the rest. Typed
+            // text can't be taken back, so if the result doesn't continue it
+            // nothing more goes out.
+            std::string_view rest = tr.text;
+            if (rest.starts_with(job.live->text)) {
+                rest.remove_prefix(job.live->text.size());
+            } else {
+                auto diverged = std::ranges::mismatch(rest, job.live->text).in1 - rest.begin();
+                log(std::format("Transcription {} differs from its live output after {} chars, "
+                                "not typing the rest", job.id, diverged));
+                rest = {};
+            }
 
-        auto output = output_factory_(wr.output_method, is_terminal);
-        if (output && !tr.text.empty()) {
-            auto res = output->deliver(tr.text);
+            std::expected<void, std::string> res;
+            {
+                StageSpan span(timings.output_s);
+                if (!rest.empty()) res = job.live->output->append(std::string(rest));
+                if (res) res = job.live->output->commit();
+            }
             if (!res) {
                 log("Output delivery failed: " + res.error());
             }
+            outputs_.record(job.context, job.live->strategy, job.live->spent_s + timings.output_s.value_or(0),
+                            res.has_value());
+        } else if (auto strategy = outputs_.choose(job.output_method, job.context);
+                   auto* output = !tr.text.empty() ? outputs_.output(strategy) : nullptr) {
+            std::expected<void, std::string> res;
+            {
+                StageSpan span(timings.output_s);
+                res = output->deliver(tr.text);
+            }
+            if (!res) {
+                log("Output delivery failed: " + res.error());
+            }
+            outputs_.record(job.context, strategy, timings.output_s.value_or(0), res.has_value());
         }
+        timings.total_s = StageSpan::seconds_since(job.stopped_at);
 
-        history_db_.insert(tr.text, tr.duration_s, tr.processing_s, wr.context, config_.backend.type);
+        {
+            // Only queued: the response goes out before the row is committed.
+            StageSpan span(timings.history_s);
+            HistoryRecord record{
+                .text = tr.text,
+                .audio_duration = tr.duration_s,
+                .processing_time = tr.processing_s,
+                .context = job.context,
+                .backend = config_.backend.type,
+                .timings = timings,
+                .audio_id = job.audio_id,
+            };
+            auto h = history(job.uid);
+            if (h.writer.active()) {
+                h.writer.submit(std::move(record));
+            } else {
+                h.db.insert(record);
+            }
+        }
+        metrics_.record(timings);
 
         response = {
             {"status", "ok"},
+            {"job_id", job.id},
             {"text", tr.text},
             {"duration", tr.duration_s},
             {"processing_time", tr.processing_s},
+            {"trimmed_samples", job.trimmed_samples},
+            {"timings", timings_json(timings)},
         };
+        if (tr.cached) response["cached"] = true;
+        if (!tr.chunks.empty()) response["chunks"] = chunks_json(tr.chunks);
     } else {
-        log("Transcription failed: " + wr.result.error());
-        response = {{"status", "error"}, {"message", wr.result.error()}};
+        log("Transcription failed: " + job.result.error());
+        response = {{"status", "error"}, {"job_id", job.id}, {"message", job.result.error()}};
+    }
+    // A cancelled or failed job's live output keeps the segments it showed.
+    if (job.live && (job.cancelled || !job.result)) end_live(*job.live);
+
+    if (job.result && !job.cancelled) {
+        auto& chunks = job.result->chunks;
+        for (size_t i = 0; i < chunks.size(); ++i) {
+            log(std::format("  chunk {}: {:.1f}s at {:.1f}s, queued {:.2f}s, {:.2f}s processing",
+                            i + 1, chunks[i].duration_s, chunks[i].start_s, chunks[i].queued_s,
+                            chunks[i].processing_s));
+        }
     }
 
-    for (int fd : waiting_clients_) {
+    for (int fd : job.waiting_clients) {
         ipc_.send_response(fd, response);
     }
-    waiting_clients_.clear();
+    if (!job.replay_of) {
+        auto event = std::move(response);
+        event.erase("status");
+        event["event"] = event.contains("text") ? "result" : "error";
+        ipc_.publish(event, audience(job.uid));
+    }
+}
 
-    session_.set_idle();
+uint32_t DaemonCore::audio_tick_ms() const {
+    if (session_.state() == SessionState::Recording) return config_.audio.chunk_ms;
+    // Often enough that the ring buffer never fills between recordings.
+    if (session_.armed()) return std::min<uint32_t>(250, config_.audio.max_seconds * 250);
+    return 0;
 }
 
-void DaemonCore::add_waiting_client(int fd) {
-    waiting_clients_.push_back(fd);
+void DaemonCore::on_audio_tick() {
+    if (session_.state() != SessionState::Recording) {
+        session_.discard_stale();
+        return;
+    }
+
+    auto chunk = session_.pump();
+    if (!chunk.empty()) {
+        // The meter shows the mic as it is; everything after it gets the cleaned-up signal.
+        meter_.feed(chunk);
+        if (cleanup_) cleanup_->process(chunk);
+        if (stream_) stream_->feed(chunk);
+        if (encoder_) encoder_->push(chunk);
+        if (float_pcm_) audio::append_float(*float_pcm_, chunk);
+    }
+    if (ipc_.subscriber_count() > 0) publish_level(chunk);
+    if (partial_) schedule_partial();
+    if (auto_stop_) {
+        check_auto_stop(chunk);
+        publish_state();
+    }
+}
+
+void DaemonCore::schedule_partial() {
+    if (ipc_.subscriber_count() == 0) return;
+    if (!partial_->due(std::chrono::steady_clock::now())) return;
+    // Finished recordings come first: previews wait until they are through.
+    if (std::ranges::any_of(jobs_, [](auto& job) { return !job->cancelled; })) return;
+
+    // Streamed segments are final already; only the audio after them is guessed at.
+    auto audio = session_.samples();
+    size_t from = stream_ ? stream_->samples_dispatched() : 0;
+    size_t window = static_cast<size_t>(config_.preview.window_seconds) * config_.audio.sample_rate;
+    if (audio.size() > from + window) from = audio.size() - window;
+    if (audio.size() - from < config_.audio.sample_rate / 2) return;
+
+    partial_->start(audio.subspan(from), stream_ ? stream_->finished_text() : std::string{});
+}
+
+void DaemonCore::publish_partial() {
+    auto h = partial_->take();
+    if (!h || session_.state() != SessionState::Recording) return;
+    ipc_.publish({
+        {"event", "partial"},
+        {"text", h->text},
+        {"stable", h->stable},
+        {"audio_duration", h->audio_s},
+        {"processing_time", h->processing_s},
+    }, audience(recording_uid_));
+}
+
+uint32_t DaemonCore::auto_stop_ms() const {
+    if (!auto_stop_ || session_.state() != SessionState::Recording) return 0;
+    return std::max<uint32_t>(1, auto_stop_->ms_until_decision());
+}
+
+bool DaemonCore::idle() const {
+    return session_.state() == SessionState::Idle && jobs_.empty() && ipc_.subscriber_count() == 0 &&
+           exports_.empty() && imports_.empty();
+}
+
+void DaemonCore::check_auto_stop(std::span<const int16_t> chunk) {
+    switch (auto_stop_->feed(chunk)) {
+        case AutoStop::Decision::Continue:
+            return;
+        case AutoStop::Decision::Stop: {
+            log(std::format("Silence for {}ms, stopping", config_.vad.auto_stop_ms));
+            // Nobody asked for this stop, so nobody waits on its response;
+            // the text goes out through the output method as usual.
+            auto resp = handle_stop(nlohmann::json::object());
+            if (resp.value("status", "") == "error") log("Auto-stop: " + resp.value("message", ""));
+            return;
+        }
+        case AutoStop::Decision::Discard:
+            discard_recording();
+            log(std::format("No speech in {}ms, recording discarded", config_.vad.no_speech_ms));
+            return;
+    }
+}
+
+void DaemonCore::add_waiting_client(int fd, uint64_t job_id) {
+    for (auto it = jobs_.rbegin(); it != jobs_.rend(); ++it) {
+        if (job_id == 0 || (*it)->id == job_id) {
+            (*it)->waiting_clients.push_back(fd);
+            return;
+        }
+    }
 }
 
 void DaemonCore::remove_waiting_client(int fd) {
-    std::erase(waiting_clients_, fd);
+    for (auto& job : jobs_) {
+        std::erase(job->waiting_clients, fd);
+    }
+}
+
+void DaemonCore::remove_client(int fd) {
+    remove_waiting_client(fd);
+    exports_.erase(fd);
+    imports_.erase(fd);
+}
+
+void DaemonCore::start_export(int fd, const nlohmann::json& cmd) {
+    auto format = history_io::parse_format(cmd.value("format", "ndjson"));
+    if (!format) return;
+    exports_.try_emplace(fd, Export{.rows = HistoryExport(history(ipc_.peer_uid(fd)).db, *format)});
+}
+
+bool DaemonCore::pump_export(int fd) {
+    // Enough per wakeup to keep a fast reader busy, few enough that audio
+    // ticks and other clients don't wait on the export.
+    constexpr int MAX_PAGES = 16;
+    auto it = exports_.find(fd);
+    if (it == exports_.end()) return false;
+    auto& ex = it->second;
+
+    for (int pages = 0;;) {
+        if (ex.sent == ex.pending.size()) {
+            if (pages++ == MAX_PAGES) return true;
+            ex.pending = ex.rows.next();
+            ex.sent = 0;
+            if (ex.pending.empty()) {
+                log(std::format("Exported {} history entries", ex.rows.rows()));
+                exports_.erase(it);
+                return false;
+            }
+        }
+        long n = ipc_.send_some(fd, std::string_view(ex.pending).substr(ex.sent));
+        if (n < 0) {
+            log(std::format("Export cut short after {} entries: client went away", ex.rows.rows()));
+            exports_.erase(it);
+            return false;
+        }
+        if (n == 0) return true;
+        ex.sent += static_cast<size_t>(n);
+    }
+}
+
+void DaemonCore::add_subscriber(int fd) {
+    ipc_.subscribe(fd);
+    ipc_.send_response(fd, state_event());
+}
+
+nlohmann::json DaemonCore::state_event() const {
+    nlohmann::json event = {{"event", "state"}, {"state", state_name()}, {"pending_jobs", jobs_.size()}};
+    if (session_.state() == SessionState::Recording) {
+        event["duration"] = session_.recording_duration();
+        // Which window someone is dictating into is theirs to know.
+        if (!config_.daemon.multi_user) event["context"] = session_.window_context().context;
+    }
+    return event;
+}
+
+void DaemonCore::publish_state() {
+    std::string state = state_name();
+    if (state == published_state_ && jobs_.size() == published_jobs_) return;
+    published_state_ = std::move(state);
+    published_jobs_ = jobs_.size();
+    ipc_.publish(state_event());
+}
+
+void DaemonCore::publish_level(std::span<const int16_t> chunk) {
+    // Enough for a meter; a bar redraws no faster anyway.
+    constexpr auto LEVEL_INTERVAL = std::chrono::milliseconds(250);
+    auto now = std::chrono::steady_clock::now();
+    if (chunk.empty() || now - level_published_at_ < LEVEL_INTERVAL) return;
+    level_published_at_ = now;
+    // level_db and peak_db over the last window, clipped_pct since the start.
+    auto recent = meter_.recent();
+    ipc_.publish({
+        {"event", "level"},
+        {"duration", session_.recording_duration()},
+        {"level_db", recent.rms_db},
+        {"peak_db", recent.peak_db},
+        {"clipped_pct", meter_.recording().clipped_pct},
+    }, audience(recording_uid_));
 }
 
 void DaemonCore::set_focused_window(const WindowInfo& info) {
     focused_window_ = info;
+    // Get agent detection off the hotkey path: start only does a lookup.
+    if (info.pid > 0) detector_.prefetch(info.pid);
+    if (prompts_) {
+        if (auto it = agent_dirs_.find(info.pid); it != agent_dirs_.end()) prompts_->prefetch(it->second);
+    }
 }
 
 void DaemonCore::shutdown() {
-    if (session_.state() == SessionState::Recording) {
+    if (partial_) partial_->cancel();
+    if (session_.state() == SessionState::Recording || session_.armed()) {
         audio_.stop();
     }
 
-    if (session_.state() == SessionState::Transcribing) {
-        log("Waiting for pending transcription to complete...");
+    if (!jobs_.empty()) {
+        log(std::format("Waiting for {} pending transcription(s) to complete...", jobs_.size()));
+        // The event loop is gone; transfers are driven here until they finish.
+        if (transfers_) transfers_->run_until_idle();
+        for (auto& job : jobs_) {
+            if (job->worker.joinable()) job->worker.join();
+        }
         on_transcription_complete();
-    } else if (worker_.joinable()) {
-        worker_.join();
     }
+
+    // Everything delivered is in the queue by now; commit it before exiting.
+    await_history();
+    history_writer_.close();
+    for (auto& [uid, user] : user_histories_) user->writer.close();
 }
 
 WindowInfo DaemonCore::enrich_window_info(WindowInfo info) {
@@ -1,29 +1,48 @@
 #pragma once
 
+#include "audio/auto_stop.hpp"
+#include "audio/input_cleanup.hpp"
+#include "audio/level_meter.hpp"
+#include "audio_encoder.hpp"
 #include "config.hpp"
+#include "metrics.hpp"
 #include "output/output.hpp"
+#include "output/output_router.hpp"
+#include "platform/audio_archive.hpp"
 #include "platform/audio_capture.hpp"
 #include "platform/ipc_server.hpp"
 #include "platform/process_detector.hpp"
 #include "ring_buffer.hpp"
 #include "session.hpp"
 #include "storage/history_db.hpp"
+#include "storage/history_export.hpp"
+#include "storage/history_writer.hpp"
 #include "sway/window_info.hpp"
+#include "text/post_processor.hpp"
+#include "text/prompt_builder.hpp"
 #include "whisper/backend.hpp"
+#include "whisper/caching_backend.hpp"
+#include "whisper/chunking_backend.hpp"
+#include "whisper/partial_transcriber.hpp"
+#include "whisper/streaming_transcriber.hpp"
 
 #include <atomic>
+#include <chrono>
 #include <cstdint>
+#include <deque>
 #include <expected>
 #include <functional>
 #include <memory>
+#include <optional>
 #include <nlohmann/json.hpp>
 #include <string>
 #include <thread>
+#include <unordered_map>
 #include <vector>
 
 class DaemonCore {
 public:
-    using OutputFactory = std::function<std::unique_ptr<OutputMethod>(const std::string&, bool)>;
+    using OutputFactory = OutputRouter::Factory;
     using NotifyCallback = std::function<void()>;
 
     DaemonCore(Config config, bool verbose,
@@ -37,12 +56,73 @@ public:
 
     bool init();
 
-    nlohmann::json handle_command(const std::string& cmd_str, const nlohmann::json& cmd);
+    // Uses backend instead of the one described by the config, also across
+    // reloads. Call before init(). For tests and benchmarks that need a
+    // backend without a server.
+    void set_backend(std::unique_ptr<WhisperBackend> backend) { pinned_backend_ = std::move(backend); }
 
+    // Applies a changed config file: the backend (with its cache and
+    // chunking), previews, prompts, post-processing, output rules, agents
+    // and everything read per recording. A recording in progress, and the
+    // jobs already queued, finish with the backend and rules they started
+    // with. Settings that need a restart (audio, daemon, archive,
+    // output.native_wayland) keep their running values and are logged.
+    void reload(Config next);
+
+    // Keeps each transcription's audio in archive, which must outlive the
+    // core, so retranscribe can replay it.
+    void set_audio_archive(AudioArchive* archive) { archive_ = archive; }
+    // Requests for whole recordings then run on the event loop's transfers
+    // rather than on a thread each, where the backend supports it. Their
+    // completion calls straight into the core, on the loop's thread.
+    void set_transfers(CurlMulti* transfers) { transfers_ = transfers; }
+
+    // uid is the client's; it only matters with daemon.multi_user. client_fd
+    // ties the chunks of an import together.
+    nlohmann::json handle_command(const std::string& cmd_str, const nlohmann::json& cmd,
+                                  uint32_t uid = 0, int client_fd = -1);
+
+    // A transcription job (or a streamed segment) finished: delivers every
+    // finished job at the head of the queue, so results always come out in
+    // recording order.
     void on_transcription_complete();
 
-    void add_waiting_client(int fd);
+    // Periodic consumer tick while recording: pulls captured audio out of the
+    // ring buffer and feeds the streaming transcriber or upload encoder.
+    // With armed capture it also runs between recordings to age out audio
+    // older than the pre-roll.
+    void on_audio_tick();
+    // Tick interval the event loop should use; 0 for no ticks.
+    uint32_t audio_tick_ms() const;
+    // Hands-free recording (start with auto_stop): ms until it could end by
+    // itself, when the event loop should tick once more. 0 otherwise.
+    uint32_t auto_stop_ms() const;
+    // Nothing recording or transcribing, nobody subscribed and no export or
+    // import under way: the daemon could exit without anyone noticing. Armed capture doesn't count.
+    bool idle() const;
+
+    // fd gets the final response of job_id (0: the newest job).
+    void add_waiting_client(int fd, uint64_t job_id = 0);
     void remove_waiting_client(int fd);
+    // fd stays connected and gets events pushed to it: state changes, levels
+    // while recording, preview and final text. It is sent the current state first.
+    void add_subscriber(int fd);
+    // After an ok "export" response: fd is sent its user's history, one
+    // NDJSON or CSV line per entry, as fast as it reads, and then closed.
+    void start_export(int fd, const nlohmann::json& cmd);
+    bool exporting(int fd) const { return exports_.contains(fd); }
+    // Sends fd more of its export, until the socket is full or a few pages
+    // have gone out; the event loop calls again once fd is writable. False
+    // when the export is over (done, or the client is gone): close fd.
+    bool pump_export(int fd);
+
+    // How often the loop should call probe_backends() (0: never).
+    uint32_t probe_ms() const;
+    // Checks that the transcription servers are still there (see CircuitBreaker).
+    void probe_backends();
+
+    // fd disconnected: whatever it waited for, exported or imported is dropped.
+    void remove_client(int fd);
 
     void set_focused_window(const WindowInfo& info);
 
@@ -51,14 +131,95 @@ public:
     void shutdown();
 
 private:
+    // The backend config describes, and the wrappers it asks for around it.
+    // Null (with the reason printed) if it can't be made.
+    std::unique_ptr<WhisperBackend> create_backend(const Config& config);
+    struct Backends;
+    std::shared_ptr<Backends> wrap_backend(std::unique_ptr<WhisperBackend> model, const Config& config);
+    // Keeps the backends' transcript cache, if any, in the history database.
+    // Only once that database is open, so that one connection upgrades it.
+    void open_cache(Backends& backends, const std::string& db_path);
+    // Waits for init()'s background open of the history, on first use.
+    void await_history();
+    // The history of uid: the daemon's own, or with daemon.multi_user one
+    // database per uid, opened when first needed.
+    struct History {
+        HistoryDb& db;
+        HistoryWriter& writer;
+    };
+    History history(uint32_t uid);
+    // Who gets an event about uid's recording or job: everyone, unless
+    // users are kept apart.
+    std::optional<uint32_t> audience(uint32_t uid) const;
+
     nlohmann::json handle_start(const nlohmann::json& cmd);
     nlohmann::json handle_stop(const nlohmann::json& cmd);
     nlohmann::json handle_toggle(const nlohmann::json& cmd);
     nlohmann::json handle_status(const nlohmann::json& cmd);
     nlohmann::json handle_history(const nlohmann::json& cmd);
+    nlohmann::json handle_search(const nlohmann::json& cmd);
+    nlohmann::json handle_retranscribe(const nlohmann::json& cmd);
+    nlohmann::json handle_cancel(const nlohmann::json& cmd);
+    nlohmann::json handle_metrics(const nlohmann::json& cmd);
+    nlohmann::json handle_stats(const nlohmann::json& cmd);
+    nlohmann::json handle_export(const nlohmann::json& cmd);
+    nlohmann::json handle_import(const nlohmann::json& cmd);
+
+    // "idle", "recording" or "transcribing", as status reports it.
+    const char* state_name() const;
+    nlohmann::json state_event() const;
+    // Publishes state_event() if the state or the number of pending jobs
+    // changed since the last one.
+    void publish_state();
+    void publish_level(std::span<const int16_t> chunk);
+
+    // Queues a job and starts its worker. Returns the job id.
+    // pcm, when not empty, is the same audio as float for the backend.
+    uint64_t start_transcription(std::vector<int16_t> audio, WindowInfo context,
+                                 const std::string& output_method,
+                                 std::unique_ptr<StreamingTranscriber> stream,
+                                 std::unique_ptr<BackgroundEncoder> encoder,
+                                 std::vector<float> pcm,
+                                 size_t trimmed_samples,
+                                 StageSpan::Clock::time_point stopped_at,
+                                 std::optional<double> drain_s);
+    // Queues a transcription of archived audio that is only reported back:
+    // nothing is typed out or stored.
+    // fresh skips the transcript cache (the result still goes into it).
+    uint64_t start_replay(AudioClip clip, HistoryEntry original, bool fresh);
+
+    // An incremental output that shows a streamed transcription's segments
+    // while the rest is still being transcribed.
+    struct LiveOutput {
+        OutputMethod* output;  // one of outputs_'
+        OutputStrategy strategy;
+        std::string raw;   // the segments it was given, joined like the final result
+        std::string text;  // raw after the rules: what was appended so far
+        const Replacer* rules = nullptr;  // post-processing for its window
+        std::shared_ptr<const PostProcessor> post;  // which rules belongs to
+        double spent_s = 0;  // in append() so far
+    };
 
-    void start_transcription(std::vector<int16_t> audio, WindowInfo context,
-                             const std::string& output_method);
+    // Sends the recording's most recent audio off for a preview transcription
+    // when one is due and the backend has nothing more important to do.
+    void schedule_partial();
+    void publish_partial();
+
+    // Ends or drops a hands-free recording once the silence says so.
+    void check_auto_stop(std::span<const int16_t> chunk);
+    // Drops the recording in progress without transcribing it.
+    void discard_recording();
+
+    struct Job;
+    void deliver(Job& job);
+    // Passes newly transcribed segments to the live output of the oldest
+    // transcription (or of the recording, when nothing is queued).
+    void feed_live_output();
+    void append_live(LiveOutput& live, const std::vector<std::string>& segments);
+    // Commits a live output that gets no final result.
+    void end_live(LiveOutput& live);
+    // Aborts job_id, or every pending job when 0. Returns how many were cancelled.
+    size_t cancel_jobs(uint64_t job_id = 0);
 
     WindowInfo enrich_window_info(WindowInfo info);
 
@@ -72,22 +233,95 @@ private:
     ProcessDetector& detector_;
     IpcServer& ipc_;
 
-    OutputFactory output_factory_;
+    OutputRouter outputs_;
     NotifyCallback notify_;
 
     Session session_;
-    HistoryDb history_db_;
-    std::unique_ptr<WhisperBackend> backend_;
+    HistoryDb history_db_;          // reads on the main thread
+    HistoryWriter history_writer_;  // inserts, off it
+    std::jthread history_opener_;   // opens both; joined by await_history()
+    struct UserHistory {
+        HistoryDb db;
+        HistoryWriter writer;
+    };
+    std::unordered_map<uint32_t, std::unique_ptr<UserHistory>> user_histories_;  // daemon.multi_user
+    std::string data_dir_;  // history and per-user databases live here
+    Metrics metrics_;
+    std::shared_ptr<const PostProcessor> post_;  // replaced whole on reload
+
+    // A backend with its wrappers. Replaced whole on reload; the recording in
+    // progress and each job hold on to the one they started with.
+    struct Backends {
+        std::unique_ptr<WhisperBackend> backend;  // what transcriptions go to
+        WhisperBackend* model = nullptr;     // innermost; previews skip the wrappers
+        CachingBackend* cache = nullptr;     // backend itself, when cache.enabled
+        ChunkingBackend* chunker = nullptr;  // inside cache, when chunking.enabled
+    };
+    std::shared_ptr<Backends> backends_;
+    std::shared_ptr<Backends> recording_backends_;  // backends_ when the recording started
+    std::unique_ptr<WhisperBackend> pinned_backend_;  // set_backend(), until init()
+    bool backend_pinned_ = false;
+    AudioArchive* archive_ = nullptr;
+    CurlMulti* transfers_ = nullptr;
+    std::unique_ptr<StreamingTranscriber> stream_;
+    std::unique_ptr<BackgroundEncoder> encoder_;
+    std::optional<std::vector<float>> float_pcm_;  // converted while recording
+    std::vector<float> spare_pcm_;  // a finished job's buffer, reused by the next
+    std::optional<AutoStop> auto_stop_;  // recording started with auto_stop
+    std::optional<InputCleanup> cleanup_;  // cleanup.denoise or cleanup.agc
+    LevelMeter meter_;  // the recording in progress
+    std::unique_ptr<PartialTranscriber> partial_;  // preview.enabled
+    std::unique_ptr<PromptBuilder> prompts_;       // prompt.enabled
+    std::optional<LiveOutput> live_;
 
     WindowInfo focused_window_;
+    // Working dirs found by agent detection, by window pid, so focusing a
+    // window can get its scan going before detection runs again at start.
+    std::unordered_map<int, std::string> agent_dirs_;
     std::string pending_output_method_;
-    std::vector<int> waiting_clients_;
+    uint64_t overflow_at_start_ = 0;  // ring buffer overflow_bytes() at start
+    uint32_t caller_uid_ = 0;     // client of the command being handled
+    int caller_fd_ = -1;          // and its connection
+    uint32_t recording_uid_ = 0;  // whoever started the recording in progress
 
-    struct WorkerResult {
-        std::expected<TranscriptResult, std::string> result;
+    std::string published_state_;
+    size_t published_jobs_ = 0;
+    std::chrono::steady_clock::time_point level_published_at_{};
+
+    struct Export {
+        HistoryExport rows;
+        std::string pending;  // the page being sent
+        size_t sent = 0;      // of pending, taken by the socket
+    };
+    std::unordered_map<int, Export> exports_;       // by client fd
+    std::unordered_map<int, std::string> imports_;  // chunks so far, by client fd
+
+    // One recording on its way through transcription. The worker fills in
+    // result and then sets done; the main thread reads them after that.
+    struct Job {
+        uint64_t id = 0;
+        uint32_t uid = 0;  // whose recording (or replay) it is
+        std::shared_ptr<Backends> backends;  // outlives stream and worker
         WindowInfo context;
         std::string output_method;
+        size_t trimmed_samples = 0;
+        std::vector<int> waiting_clients;
+        bool cancelled = false;  // main thread only
+        StageSpan::Clock::time_point stopped_at;
+        std::optional<double> drain_s;
+        std::unique_ptr<StreamingTranscriber> stream;  // read by the worker
+        std::optional<LiveOutput> live;                // main thread only
+        std::optional<HistoryEntry> replay_of;         // set for retranscribe
+        std::vector<float> pcm;                        // float audio, read by the worker
+        std::string prompt;                            // read by the worker
+        uint64_t audio_id = 0;                         // archived by the worker
+        std::vector<int16_t> audio;                    // sent in place by a transfer
+        uint64_t transfer = 0;                         // on transfers_ instead of a worker
+
+        std::expected<TranscriptResult, std::string> result;
+        std::atomic<bool> done{false};
+        std::jthread worker;
     };
-    WorkerResult worker_result_;
-    std::jthread worker_;
+    std::deque<std::unique_ptr<Job>> jobs_;
+    uint64_t next_job_id_ = 1;
 };
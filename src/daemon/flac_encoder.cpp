@@ -0,0 +1,288 @@
+#include "flac_encoder.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <utility>
+
+namespace {
+
+constexpr size_t STREAMINFO_OFFSET = 8;  // "fLaC" + metadata block header
+constexpr uint32_t MAX_RICE_PARAM = 14;
+constexpr uint32_t MAX_PARTITION_ORDER = 4;
+constexpr uint32_t MAX_FIXED_ORDER = 4;
+
+class BitWriter {
+public:
+    explicit BitWriter(std::vector<uint8_t>& out) : out_(out) {}
+
+    void put(uint64_t value, unsigned bits) {
+        while (bits > 0) {
+            unsigned n = std::min(bits, 32u);
+            bits -= n;
+            uint64_t chunk = (value >> bits) & ((uint64_t{1} << n) - 1);
+            acc_ = (acc_ << n) | chunk;
+            nbits_ += n;
+            while (nbits_ >= 8) {
+                nbits_ -= 8;
+                out_.push_back(static_cast<uint8_t>(acc_ >> nbits_));
+            }
+        }
+    }
+
+    // Unary-coded quotient (q zeros then a one) followed by k low bits.
+    void put_rice(uint32_t u, unsigned k) {
+        uint32_t q = u >> k;
+        while (q >= 32) {
+            put(0, 32);
+            q -= 32;
+        }
+        put(1, q + 1);
+        if (k) put(u & ((1u << k) - 1), k);
+    }
+
+    void align() {
+        if (nbits_ > 0) put(0, 8 - nbits_);
+    }
+
+private:
+    std::vector<uint8_t>& out_;
+    uint64_t acc_ = 0;
+    unsigned nbits_ = 0;
+};
+
+uint8_t crc8(std::span<const uint8_t> data) {
+    uint8_t crc = 0;
+    for (uint8_t b : data) {
+        crc ^= b;
+        for (int i = 0; i < 8; ++i)
+            crc = (crc & 0x80) ? static_cast<uint8_t>((crc << 1) ^ 0x07) : static_cast<uint8_t>(crc << 1);
+    }
+    return crc;
+}
+
+uint16_t crc16(std::span<const uint8_t> data) {
+    uint16_t crc = 0;
+    for (uint8_t b : data) {
+        crc ^= static_cast<uint16_t>(b) << 8;
+        for (int i = 0; i < 8; ++i)
+            crc = (crc & 0x8000) ? static_cast<uint16_t>((crc << 1) ^ 0x8005) : static_cast<uint16_t>(crc << 1);
+    }
+    return crc;
+}
+
+uint32_t zigzag(int32_t r) {
+    return (static_cast<uint32_t>(r) << 1) ^ static_cast<uint32_t>(r >> 31);
+}
+
+// Residual of FLAC's fixed predictor of the given order for samples[order..].
+void fixed_residual(std::span<const int16_t> s, uint32_t order, std::vector<uint32_t>& out) {
+    out.clear();
+    for (size_t i = order; i < s.size(); ++i) {
+        int32_t r;
+        switch (order) {
+        case 0: r = s[i]; break;
+        case 1: r = s[i] - s[i - 1]; break;
+        case 2: r = s[i] - 2 * s[i - 1] + s[i - 2]; break;
+        case 3: r = s[i] - 3 * s[i - 1] + 3 * s[i - 2] - s[i - 3]; break;
+        default: r = s[i] - 4 * s[i - 1] + 6 * s[i - 2] - 4 * s[i - 3] + s[i - 4]; break;
+        }
+        out.push_back(zigzag(r));
+    }
+}
+
+uint64_t rice_bits(std::span<const uint32_t> u, unsigned k) {
+    uint64_t bits = static_cast<uint64_t>(u.size()) * (k + 1);
+    for (uint32_t v : u) bits += v >> k;
+    return bits;
+}
+
+// Best Rice parameter for one partition: estimate from the mean, then check
+// the neighbours exactly.
+std::pair<unsigned, uint64_t> best_rice(std::span<const uint32_t> u) {
+    if (u.empty()) return {0, 0};
+    uint64_t sum = 0;
+    for (uint32_t v : u) sum += v;
+    uint64_t mean = sum / u.size();
+    unsigned guess = mean > 0 ? static_cast<unsigned>(std::bit_width(mean)) - 1 : 0;
+    guess = std::min(guess, MAX_RICE_PARAM);
+
+    unsigned best_k = guess;
+    uint64_t best = rice_bits(u, guess);
+    for (unsigned k : {guess - 1, guess + 1}) {
+        if (k > MAX_RICE_PARAM) continue;  // also catches guess - 1 wrapping
+        uint64_t bits = rice_bits(u, k);
+        if (bits < best) {
+            best = bits;
+            best_k = k;
+        }
+    }
+    return {best_k, best};
+}
+
+struct ResidualPlan {
+    uint32_t partition_order = 0;
+    std::array<unsigned, 1u << MAX_PARTITION_ORDER> params{};
+    uint64_t bits = UINT64_MAX;
+};
+
+// residual holds block_size - order values; partition 0 is short by `order`.
+ResidualPlan plan_residual(std::span<const uint32_t> residual, size_t block_size, uint32_t order) {
+    ResidualPlan best;
+    for (uint32_t p = 0; p <= MAX_PARTITION_ORDER; ++p) {
+        size_t parts = size_t{1} << p;
+        if (block_size % parts != 0 || (block_size >> p) <= order) break;
+
+        ResidualPlan plan;
+        plan.partition_order = p;
+        plan.bits = 2 + 4;  // coding method + partition order
+        size_t pos = 0;
+        for (size_t i = 0; i < parts; ++i) {
+            size_t len = (block_size >> p) - (i == 0 ? order : 0);
+            auto [k, bits] = best_rice(residual.subspan(pos, len));
+            plan.params[i] = k;
+            plan.bits += 4 + bits;
+            pos += len;
+        }
+        if (plan.bits < best.bits) best = plan;
+    }
+    return best;
+}
+
+void put_utf8(BitWriter& bw, uint32_t v) {
+    if (v < 0x80) {
+        bw.put(v, 8);
+        return;
+    }
+    int extra = v < 0x800 ? 1 : v < 0x10000 ? 2 : v < 0x200000 ? 3 : v < 0x4000000 ? 4 : 5;
+    uint32_t lead_mask = (0xFF00u >> (extra + 1)) & 0xFF;
+    bw.put(lead_mask | (v >> (6 * extra)), 8);
+    for (int i = extra - 1; i >= 0; --i)
+        bw.put(0x80 | ((v >> (6 * i)) & 0x3F), 8);
+}
+
+void put_streaminfo_tail(std::vector<uint8_t>& out, uint32_t sample_rate, uint64_t total_samples) {
+    BitWriter bw(out);
+    bw.put(sample_rate, 20);
+    bw.put(0, 3);   // channels - 1
+    bw.put(15, 5);  // bits per sample - 1
+    bw.put(total_samples, 36);
+}
+
+} // namespace
+
+FlacEncoder::FlacEncoder(uint32_t sample_rate) : sample_rate_(sample_rate) {
+    out_ = {'f', 'L', 'a', 'C'};
+    BitWriter bw(out_);
+    bw.put(1, 1);  // last metadata block
+    bw.put(0, 7);  // STREAMINFO
+    bw.put(34, 24);
+    bw.put(BLOCK_SIZE, 16);
+    bw.put(BLOCK_SIZE, 16);
+    bw.put(0, 24);  // min/max frame size unknown
+    bw.put(0, 24);
+    put_streaminfo_tail(out_, sample_rate_, 0);  // total patched in finish()
+    out_.resize(out_.size() + 16, 0);             // MD5 not computed
+    pending_.reserve(BLOCK_SIZE);
+}
+
+void FlacEncoder::append(std::span<const int16_t> samples) {
+    total_samples_ += samples.size();
+    while (!samples.empty()) {
+        size_t take = std::min(samples.size(), BLOCK_SIZE - pending_.size());
+        if (pending_.empty() && take == BLOCK_SIZE) {
+            encode_frame(samples.first(take));
+        } else {
+            pending_.insert(pending_.end(), samples.begin(), samples.begin() + take);
+            if (pending_.size() == BLOCK_SIZE) {
+                encode_frame(pending_);
+                pending_.clear();
+            }
+        }
+        samples = samples.subspan(take);
+    }
+}
+
+std::vector<uint8_t> FlacEncoder::finish() {
+    if (!pending_.empty()) {
+        encode_frame(pending_);
+        pending_.clear();
+    }
+
+    std::vector<uint8_t> tail;
+    put_streaminfo_tail(tail, sample_rate_, total_samples_);
+    std::copy(tail.begin(), tail.end(), out_.begin() + STREAMINFO_OFFSET + 10);
+
+    return std::move(out_);
+}
+
+void FlacEncoder::encode_frame(std::span<const int16_t> block) {
+    size_t frame_start = out_.size();
+    size_t n = block.size();
+    BitWriter bw(out_);
+
+    // Frame header
+    bw.put(0x3FFE, 14);  // sync
+    bw.put(0, 1);        // reserved
+    bw.put(0, 1);        // fixed block size
+    bw.put(n == BLOCK_SIZE ? 12 : 7, 4);  // 12: 256 * 2^4, 7: 16-bit size at end of header
+    bw.put(0, 4);        // sample rate from STREAMINFO
+    bw.put(0, 4);        // mono
+    bw.put(4, 3);        // 16 bits per sample
+    bw.put(0, 1);        // reserved
+    put_utf8(bw, frame_number_++);
+    if (n != BLOCK_SIZE) bw.put(n - 1, 16);
+    bw.put(crc8(std::span(out_).subspan(frame_start)), 8);
+
+    // Subframe
+    bool constant = std::all_of(block.begin(), block.end(), [&](int16_t s) { return s == block[0]; });
+    if (constant) {
+        bw.put(0, 8);  // padding bit, CONSTANT, no wasted bits
+        bw.put(static_cast<uint16_t>(block[0]), 16);
+    } else {
+        std::vector<uint32_t> residual;
+        std::vector<uint32_t> best_residual;
+        ResidualPlan best_plan;
+        uint32_t best_order = 0;
+        uint64_t best_bits = UINT64_MAX;
+        for (uint32_t order = 0; order <= MAX_FIXED_ORDER && order < n; ++order) {
+            fixed_residual(block, order, residual);
+            auto plan = plan_residual(residual, n, order);
+            if (plan.bits == UINT64_MAX) continue;
+            uint64_t bits = plan.bits + 16ull * order;
+            if (bits < best_bits) {
+                best_bits = bits;
+                best_plan = plan;
+                best_order = order;
+                best_residual.swap(residual);
+            }
+        }
+
+        if (best_bits >= 16ull * n) {
+            bw.put(0b00000010, 8);  // VERBATIM
+            for (int16_t s : block) bw.put(static_cast<uint16_t>(s), 16);
+        } else {
+            bw.put(0, 1);
+            bw.put(0b001000 | best_order, 6);  // FIXED
+            bw.put(0, 1);
+            for (uint32_t i = 0; i < best_order; ++i) bw.put(static_cast<uint16_t>(block[i]), 16);
+
+            bw.put(0, 2);  // Rice, 4-bit parameters
+            bw.put(best_plan.partition_order, 4);
+            size_t parts = size_t{1} << best_plan.partition_order;
+            size_t pos = 0;
+            for (size_t i = 0; i < parts; ++i) {
+                size_t len = (n >> best_plan.partition_order) - (i == 0 ? best_order : 0);
+                unsigned k = best_plan.params[i];
+                bw.put(k, 4);
+                for (size_t j = pos; j < pos + len; ++j) bw.put_rice(best_residual[j], k);
+                pos += len;
+            }
+        }
+    }
+
+    bw.align();
+    uint16_t crc = crc16(std::span(out_).subspan(frame_start));
+    out_.push_back(static_cast<uint8_t>(crc >> 8));
+    out_.push_back(static_cast<uint8_t>(crc & 0xFF));
+}
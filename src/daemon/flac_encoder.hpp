@@ -0,0 +1,32 @@
+#pragma once
+
+#include "audio_encoder.hpp"
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+// Minimal lossless FLAC encoder for mono 16-bit PCM.
+// Uses fixed-length 4096-sample blocks, FLAC's fixed polynomial predictors
+// (order 0-4, best per block) and partitioned Rice coding of the residual.
+// Speech typically compresses to 50-60% of the WAV size.
+class FlacEncoder : public AudioEncoder {
+public:
+    explicit FlacEncoder(uint32_t sample_rate);
+
+    void append(std::span<const int16_t> samples) override;
+    std::vector<uint8_t> finish() override;
+    const char* mime_type() const override { return "audio/flac"; }
+    const char* file_name() const override { return "audio.flac"; }
+
+    static constexpr size_t BLOCK_SIZE = 4096;
+
+private:
+    void encode_frame(std::span<const int16_t> block);
+
+    uint32_t sample_rate_;
+    uint64_t total_samples_ = 0;
+    uint32_t frame_number_ = 0;
+    std::vector<int16_t> pending_;
+    std::vector<uint8_t> out_;
+};
@@ -0,0 +1,15 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Binary frame layout of the IPC wire format (see ipc_protocol.hpp), on its
+// own so sa-trigger can write frames without pulling in nlohmann::json.
+namespace ipc {
+
+constexpr uint8_t FRAME_MAGIC = 0xA5;
+constexpr size_t FRAME_HEADER = 6;
+// Bigger frames are rejected rather than buffered.
+constexpr uint32_t MAX_FRAME = 16u << 20;
+
+} // namespace ipc
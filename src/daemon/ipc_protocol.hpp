@@ -0,0 +1,101 @@
+#pragma once
+
+#include "ipc_frame.hpp"
+
+#include <cstdint>
+#include <cstring>
+#include <nlohmann/json.hpp>
+#include <span>
+#include <string>
+#include <vector>
+
+// Wire format shared by the daemon and `sa`.
+//
+// Two encodings can share a socket. Newline-delimited JSON is what scripts
+// and socat speak. A binary frame is a 6-byte header — FRAME_MAGIC, the
+// encoding ('C' CBOR, 'M' MessagePack) and the payload length as a
+// little-endian uint32 — followed by the payload. JSON text never starts with
+// FRAME_MAGIC, so the first byte of each message says which one it is, and the
+// daemon answers a client in the encoding of its last command.
+namespace ipc {
+
+enum class Encoding : uint8_t { JsonLines, Cbor, MsgPack };
+
+inline char encoding_tag(Encoding enc) {
+    return enc == Encoding::MsgPack ? 'M' : 'C';
+}
+
+// Appends msg to out in the given encoding.
+inline void encode(const nlohmann::json& msg, Encoding enc, std::string& out) {
+    if (enc == Encoding::JsonLines) {
+        out += msg.dump();
+        out += '\n';
+        return;
+    }
+    // The library's public overloads write bytes to a vector; it is kept
+    // per thread so that every event doesn't allocate one.
+    thread_local std::vector<std::uint8_t> payload;
+    payload.clear();
+    if (enc == Encoding::Cbor) {
+        nlohmann::json::to_cbor(msg, payload);
+    } else {
+        nlohmann::json::to_msgpack(msg, payload);
+    }
+    size_t start = out.size();
+    out.resize(start + FRAME_HEADER);
+    out.append(reinterpret_cast<const char*>(payload.data()), payload.size());
+    uint32_t len = static_cast<uint32_t>(payload.size());
+    out[start] = static_cast<char>(FRAME_MAGIC);
+    out[start + 1] = encoding_tag(enc);
+    for (int i = 0; i < 4; ++i) out[start + 2 + i] = static_cast<char>((len >> (8 * i)) & 0xFF);
+}
+
+inline std::string encode(const nlohmann::json& msg, Encoding enc) {
+    std::string out;
+    encode(msg, enc, out);
+    return out;
+}
+
+enum class DecodeStatus { Ok, Incomplete, Invalid };
+
+struct Decoded {
+    DecodeStatus status = DecodeStatus::Incomplete;
+    size_t consumed = 0;  // bytes of buf the message took up (Ok only)
+    Encoding encoding = Encoding::JsonLines;
+};
+
+// Parses the first message in buf in place, without copying it out.
+inline Decoded decode(std::span<const char> buf, nlohmann::json& msg) {
+    if (buf.empty()) return {};
+
+    if (static_cast<uint8_t>(buf[0]) != FRAME_MAGIC) {
+        const char* nl = static_cast<const char*>(std::memchr(buf.data(), '\n', buf.size()));
+        if (!nl) {
+            return {buf.size() > MAX_FRAME ? DecodeStatus::Invalid : DecodeStatus::Incomplete};
+        }
+        msg = nlohmann::json::parse(buf.data(), nl, nullptr, false);
+        if (msg.is_discarded()) return {DecodeStatus::Invalid};
+        return {DecodeStatus::Ok, static_cast<size_t>(nl - buf.data()) + 1, Encoding::JsonLines};
+    }
+
+    if (buf.size() < FRAME_HEADER) return {};
+    Encoding enc;
+    switch (buf[1]) {
+        case 'C': enc = Encoding::Cbor; break;
+        case 'M': enc = Encoding::MsgPack; break;
+        default: return {DecodeStatus::Invalid};
+    }
+    uint32_t len = 0;
+    for (int i = 0; i < 4; ++i) len |= uint32_t{static_cast<uint8_t>(buf[2 + i])} << (8 * i);
+    if (len > MAX_FRAME) return {DecodeStatus::Invalid};
+    if (buf.size() < FRAME_HEADER + len) return {};
+
+    auto* begin = reinterpret_cast<const uint8_t*>(buf.data()) + FRAME_HEADER;
+    msg = enc == Encoding::Cbor
+        ? nlohmann::json::from_cbor(begin, begin + len, true, false)
+        : nlohmann::json::from_msgpack(begin, begin + len, true, false);
+    if (msg.is_discarded()) return {DecodeStatus::Invalid};
+    return {DecodeStatus::Ok, FRAME_HEADER + len, enc};
+}
+
+} // namespace ipc
@@ -9,6 +9,7 @@ int main(int argc, char* argv[]) {
     bool foreground = false;
     bool verbose = false;
     std::string config_path;
+    std::string replay;
 
     for (int i = 1; i < argc; i++) {
         std::string arg = argv[i];
@@ -18,12 +19,16 @@ int main(int argc, char* argv[]) {
             verbose = true;
         } else if (arg == "--config" || arg == "-c") {
             if (i + 1 < argc) config_path = argv[++i];
+        } else if (arg == "--replay") {
+            if (i + 1 < argc) replay = argv[++i];
         } else if (arg == "--help" || arg == "-h") {
             std::println("Usage: speak-anywhere [options]");
             std::println("Options:");
             std::println("  -f, --foreground    Run in foreground (don't daemonize)");
             std::println("  -v, --verbose       Enable verbose logging");
             std::println("  -c, --config PATH   Config file path");
+            std::println("      --replay PATH   Record from a WAV file, or a directory of them, instead");
+            std::println("                      of the microphone (load tests, see sa-loadgen)");
             std::println("  -h, --help          Show this help");
             return 0;
         }
@@ -35,8 +40,13 @@ int main(int argc, char* argv[]) {
         config = Config::load(config_path);
     } else {
         config = Config::load_default();
+        config_path = Config::default_path();
     }
 
+    // Each recording replays the next clip from its start: an open
+    // microphone between recordings would run through them unheard.
+    if (!replay.empty()) config.audio.armed = false;
+
     if (!foreground) {
         platform::daemonize();
     }
@@ -46,7 +56,7 @@ int main(int argc, char* argv[]) {
                      config.backend.type, config.backend.url);
     }
 
-    LinuxEventLoop loop(std::move(config), verbose);
+    LinuxEventLoop loop(std::move(config), verbose, config_path, replay);
     if (!loop.init()) {
         std::println(stderr, "Failed to initialize event loop");
         return 1;
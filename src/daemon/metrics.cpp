@@ -0,0 +1,48 @@
+#include "metrics.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+void LatencyHistogram::add(double seconds) {
+    seconds = std::max(seconds, 0.0);
+
+    size_t index = 0;
+    if (seconds > MIN_S) {
+        double b = std::floor(std::log2(seconds / MIN_S) * BUCKETS_PER_DOUBLING);
+        index = static_cast<size_t>(std::clamp(b, 0.0, static_cast<double>(BUCKETS - 1)));
+    }
+    ++buckets_[index];
+
+    if (count_ == 0 || seconds < min_) min_ = seconds;
+    if (seconds > max_) max_ = seconds;
+    ++count_;
+    sum_ += seconds;
+}
+
+double LatencyHistogram::percentile(double p) const {
+    if (count_ == 0) return 0.0;
+
+    auto rank = static_cast<uint64_t>(std::ceil(std::clamp(p, 0.0, 1.0) * static_cast<double>(count_)));
+    rank = std::max<uint64_t>(rank, 1);
+
+    uint64_t seen = 0;
+    size_t index = 0;
+    for (; index < BUCKETS; ++index) {
+        seen += buckets_[index];
+        if (seen >= rank) break;
+    }
+
+    // The top bucket has no upper edge.
+    if (index == BUCKETS - 1) return max_;
+
+    // Middle of the bucket on the log scale, but never outside what was seen.
+    double mid = MIN_S * std::exp2((static_cast<double>(index) + 0.5) / BUCKETS_PER_DOUBLING);
+    return std::clamp(mid, min_, max_);
+}
+
+void Metrics::record(const StageTimings& timings) {
+    ++transcriptions_;
+    for (size_t i = 0; i < STAGES.size(); ++i) {
+        if (auto& v = timings.*STAGES[i].value) stages_[i].add(*v);
+    }
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+
+// Where the time goes between "stop" and the text landing in the window.
+// Stages a transcription didn't go through (no connect on a reused
+// connection is still a measured 0; no upload for the local backend is
+// nullopt) stay unset, so they don't pull the percentiles down.
+struct StageTimings {
+    std::optional<double> drain_s;      // stop: read the ring buffer, trim silence
+    std::optional<double> encode_s;     // WAV header / FLAC / Opus, or the encoder's last block
+    std::optional<double> connect_s;    // DNS + TCP (+ TLS) to the server
+    std::optional<double> upload_s;     // request body on the wire
+    std::optional<double> inference_s;  // server (or local whisper) until the first response byte
+    std::optional<double> parse_s;      // response JSON
+    std::optional<double> output_s;     // OutputMethod::deliver
+    std::optional<double> history_s;    // HistoryDb::insert
+    std::optional<double> total_s;      // stop received until the output was delivered
+};
+
+struct StageField {
+    const char* name;
+    std::optional<double> StageTimings::* value;
+};
+
+inline constexpr std::array<StageField, 9> STAGES = {{
+    {"drain", &StageTimings::drain_s},
+    {"encode", &StageTimings::encode_s},
+    {"connect", &StageTimings::connect_s},
+    {"upload", &StageTimings::upload_s},
+    {"inference", &StageTimings::inference_s},
+    {"parse", &StageTimings::parse_s},
+    {"output", &StageTimings::output_s},
+    {"history", &StageTimings::history_s},
+    {"total", &StageTimings::total_s},
+}};
+
+// Times a scope into one stage.
+class StageSpan {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit StageSpan(std::optional<double>& out) : out_(out), start_(Clock::now()) {}
+    ~StageSpan() { out_ = seconds_since(start_); }
+
+    StageSpan(const StageSpan&) = delete;
+    StageSpan& operator=(const StageSpan&) = delete;
+
+    static double seconds_since(Clock::time_point t) {
+        return std::chrono::duration<double>(Clock::now() - t).count();
+    }
+
+private:
+    std::optional<double>& out_;
+    Clock::time_point start_;
+};
+
+// Fixed-size latency histogram with logarithmic buckets, eight per doubling
+// (about 9% wide), from 10us up to several minutes. Percentiles are read off
+// the bucket they fall in, so they are accurate to within half a bucket.
+class LatencyHistogram {
+public:
+    static constexpr double MIN_S = 1e-5;
+    static constexpr int BUCKETS_PER_DOUBLING = 8;
+    static constexpr size_t BUCKETS = 200;
+
+    void add(double seconds);
+
+    uint64_t count() const { return count_; }
+    double mean() const { return count_ ? sum_ / static_cast<double>(count_) : 0.0; }
+    double max() const { return max_; }
+    // p in [0, 1]; 0 when empty.
+    double percentile(double p) const;
+
+private:
+    std::array<uint64_t, BUCKETS> buckets_{};
+    uint64_t count_ = 0;
+    double sum_ = 0.0;
+    double min_ = 0.0;
+    double max_ = 0.0;
+};
+
+// Per-stage histograms over every transcription since the daemon started.
+// Main thread only.
+class Metrics {
+public:
+    void record(const StageTimings& timings);
+
+    const LatencyHistogram& stage(size_t index) const { return stages_[index]; }
+    uint64_t transcriptions() const { return transcriptions_; }
+
+private:
+    std::array<LatencyHistogram, STAGES.size()> stages_;
+    uint64_t transcriptions_ = 0;
+};
@@ -0,0 +1,140 @@
+#include "opus_encoder.hpp"
+
+#include <opus.h>
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+namespace {
+
+constexpr size_t MAX_PACKET = 1275;
+constexpr size_t PAGE_LACING = 64;  // ~1 s of 24 kbit/s packets per Ogg page; 255 max
+
+uint32_t ogg_crc(std::span<const uint8_t> data) {
+    static const auto table = [] {
+        std::array<uint32_t, 256> t{};
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t r = i << 24;
+            for (int j = 0; j < 8; ++j) r = (r & 0x80000000u) ? (r << 1) ^ 0x04C11DB7u : r << 1;
+            t[i] = r;
+        }
+        return t;
+    }();
+    uint32_t crc = 0;
+    for (uint8_t b : data) crc = (crc << 8) ^ table[((crc >> 24) ^ b) & 0xFF];
+    return crc;
+}
+
+void put_le(std::vector<uint8_t>& out, uint64_t v, int bytes) {
+    for (int i = 0; i < bytes; ++i) out.push_back(static_cast<uint8_t>(v >> (8 * i)));
+}
+
+} // namespace
+
+OggOpusEncoder::OggOpusEncoder(uint32_t sample_rate, uint32_t bitrate)
+    : sample_rate_(sample_rate), frame_samples_(sample_rate / 50) {
+    int err = 0;
+    enc_ = opus_encoder_create(static_cast<opus_int32>(sample_rate), 1, OPUS_APPLICATION_VOIP, &err);
+    if (err != OPUS_OK) {
+        enc_ = nullptr;
+        return;
+    }
+    opus_encoder_ctl(enc_, OPUS_SET_BITRATE(static_cast<opus_int32>(bitrate)));
+    opus_encoder_ctl(enc_, OPUS_SET_SIGNAL(OPUS_SIGNAL_VOICE));
+    opus_int32 lookahead = 0;
+    opus_encoder_ctl(enc_, OPUS_GET_LOOKAHEAD(&lookahead));
+    pre_skip_ = static_cast<uint32_t>(lookahead) * (48000 / sample_rate);
+
+    // Identification header (RFC 7845 section 5.1)
+    std::vector<uint8_t> head = {'O', 'p', 'u', 's', 'H', 'e', 'a', 'd', 1, 1};
+    put_le(head, pre_skip_, 2);
+    put_le(head, sample_rate, 4);
+    put_le(head, 0, 2);  // output gain
+    head.push_back(0);   // mapping family
+    add_packet(head);
+    flush_page(false);
+
+    // Comment header
+    static constexpr char vendor[] = "speak-anywhere";
+    std::vector<uint8_t> tags = {'O', 'p', 'u', 's', 'T', 'a', 'g', 's'};
+    put_le(tags, sizeof(vendor) - 1, 4);
+    tags.insert(tags.end(), vendor, vendor + sizeof(vendor) - 1);
+    put_le(tags, 0, 4);  // no user comments
+    add_packet(tags);
+    flush_page(false);
+
+    granule_ = pre_skip_;
+    pending_.reserve(frame_samples_);
+}
+
+OggOpusEncoder::~OggOpusEncoder() {
+    if (enc_) opus_encoder_destroy(enc_);
+}
+
+void OggOpusEncoder::append(std::span<const int16_t> samples) {
+    if (!enc_) return;
+    input_samples_ += samples.size();
+    while (!samples.empty()) {
+        size_t take = std::min(samples.size(), frame_samples_ - pending_.size());
+        pending_.insert(pending_.end(), samples.begin(), samples.begin() + take);
+        samples = samples.subspan(take);
+        if (pending_.size() == frame_samples_) {
+            encode_frame(pending_);
+            pending_.clear();
+        }
+    }
+}
+
+std::vector<uint8_t> OggOpusEncoder::finish() {
+    if (!enc_) return {};
+    if (!pending_.empty()) {
+        pending_.resize(frame_samples_, 0);
+        encode_frame(pending_);
+        pending_.clear();
+    }
+    // End trimming: the last granule marks the real end of the input.
+    granule_ = pre_skip_ + input_samples_ * (48000 / sample_rate_);
+    flush_page(true);
+    return std::move(out_);
+}
+
+void OggOpusEncoder::encode_frame(std::span<const int16_t> frame) {
+    std::array<uint8_t, MAX_PACKET> packet;
+    opus_int32 len = opus_encode(enc_, frame.data(), static_cast<int>(frame.size()),
+                                 packet.data(), static_cast<opus_int32>(packet.size()));
+    if (len < 0) return;
+    if (page_lacing_.size() + static_cast<size_t>(len) / 255 + 1 > PAGE_LACING) flush_page(false);
+    granule_ += frame.size() * (48000 / sample_rate_);
+    add_packet(std::span(packet).first(static_cast<size_t>(len)));
+}
+
+void OggOpusEncoder::add_packet(std::span<const uint8_t> packet) {
+    size_t len = packet.size();
+    for (; len >= 255; len -= 255) page_lacing_.push_back(255);
+    page_lacing_.push_back(static_cast<uint8_t>(len));
+    page_body_.insert(page_body_.end(), packet.begin(), packet.end());
+}
+
+void OggOpusEncoder::flush_page(bool last) {
+    uint8_t flags = 0;
+    if (page_seq_ == 0) flags |= 0x02;  // beginning of stream
+    if (last) flags |= 0x04;            // end of stream
+    uint64_t granule = page_seq_ < 2 ? 0 : granule_;
+
+    size_t start = out_.size();
+    out_.insert(out_.end(), {'O', 'g', 'g', 'S', 0, flags});
+    put_le(out_, granule, 8);
+    put_le(out_, serial_, 4);
+    put_le(out_, page_seq_++, 4);
+    put_le(out_, 0, 4);  // CRC, filled below
+    out_.push_back(static_cast<uint8_t>(page_lacing_.size()));
+    out_.insert(out_.end(), page_lacing_.begin(), page_lacing_.end());
+    out_.insert(out_.end(), page_body_.begin(), page_body_.end());
+
+    uint32_t crc = ogg_crc(std::span(out_).subspan(start));
+    for (int i = 0; i < 4; ++i) out_[start + 22 + i] = static_cast<uint8_t>(crc >> (8 * i));
+
+    page_lacing_.clear();
+    page_body_.clear();
+}
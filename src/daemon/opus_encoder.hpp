@@ -0,0 +1,48 @@
+#pragma once
+
+#include "audio_encoder.hpp"
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+struct OpusEncoder;
+
+// Lossy Opus (VOIP mode) in an Ogg container, for slow links where FLAC is
+// still too large. ~24 kbit/s keeps Whisper accuracy close to the raw PCM.
+// Only built when libopus is found (SPEAK_ANYWHERE_HAVE_OPUS).
+class OggOpusEncoder : public AudioEncoder {
+public:
+    OggOpusEncoder(uint32_t sample_rate, uint32_t bitrate);
+    ~OggOpusEncoder() override;
+
+    OggOpusEncoder(const OggOpusEncoder&) = delete;
+    OggOpusEncoder& operator=(const OggOpusEncoder&) = delete;
+
+    // False if libopus rejected the sample rate or bitrate.
+    bool ok() const { return enc_ != nullptr; }
+
+    void append(std::span<const int16_t> samples) override;
+    std::vector<uint8_t> finish() override;
+    const char* mime_type() const override { return "audio/ogg"; }
+    const char* file_name() const override { return "audio.ogg"; }
+
+private:
+    void encode_frame(std::span<const int16_t> frame);
+    void add_packet(std::span<const uint8_t> packet);
+    void flush_page(bool last);
+
+    OpusEncoder* enc_ = nullptr;
+    uint32_t sample_rate_;
+    size_t frame_samples_;  // 20 ms
+    uint32_t pre_skip_ = 0;  // at 48 kHz
+    uint32_t serial_ = 0x5341;
+    uint32_t page_seq_ = 0;
+    uint64_t granule_ = 0;  // 48 kHz samples encoded so far
+    uint64_t input_samples_ = 0;
+
+    std::vector<int16_t> pending_;
+    std::vector<uint8_t> page_body_;
+    std::vector<uint8_t> page_lacing_;
+    std::vector<uint8_t> out_;
+};
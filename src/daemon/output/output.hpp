@@ -2,9 +2,45 @@
 
 #include <expected>
 #include <string>
+#include <utility>
+
+// How text gets into the focused window.
+enum class Delivery {
+    Type,       // key by key through the virtual keyboard
+    Paste,      // onto the clipboard, then the paste keys
+    Clipboard,  // onto the clipboard only; the user pastes
+    None,       // nowhere: the text is only stored and returned (load tests)
+};
+
+struct OutputStrategy {
+    Delivery delivery = Delivery::Paste;
+    bool shift = false;  // Paste: Ctrl+Shift+V (terminals) rather than Ctrl+V
+
+    bool operator==(const OutputStrategy&) const = default;
+};
 
 class OutputMethod {
 public:
     virtual ~OutputMethod() = default;
     virtual std::expected<void, std::string> deliver(const std::string& text) = 0;
+
+    // Incremental delivery for streamed transcriptions: begin(), append() for
+    // each finalized segment as it is transcribed (with its separating space),
+    // then commit() once the whole result is in. Methods that can't show text
+    // piecemeal keep these defaults, which collect it for one deliver().
+    virtual bool incremental() const { return false; }
+    virtual std::expected<void, std::string> begin() {
+        pending_.clear();
+        return {};
+    }
+    virtual std::expected<void, std::string> append(const std::string& text) {
+        pending_ += text;
+        return {};
+    }
+    virtual std::expected<void, std::string> commit() {
+        return deliver(std::exchange(pending_, {}));
+    }
+
+private:
+    std::string pending_;
 };
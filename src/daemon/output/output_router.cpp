@@ -0,0 +1,111 @@
+#include "output/output_router.hpp"
+
+#include <algorithm>
+#include <cctype>
+
+namespace {
+
+// Terminals paste with Ctrl+Shift+V and mustn't be typed into key by key.
+constexpr const char* TERMINALS[] = {"kitty", "alacritty", "foot", "wezterm"};
+
+std::string lowercase(std::string s) {
+    std::transform(s.begin(), s.end(), s.begin(), ::tolower);
+    return s;
+}
+
+size_t slot(const OutputStrategy& s) {
+    switch (s.delivery) {
+    case Delivery::Type: return 0;
+    case Delivery::Paste: return s.shift ? 2 : 1;
+    case Delivery::Clipboard: return 3;
+    case Delivery::None: break;
+    }
+    return 1;
+}
+
+} // namespace
+
+OutputRouter::OutputRouter(const Config::Output& config, Factory factory)
+    : factory_(std::move(factory)) {
+    configure(config);
+}
+
+void OutputRouter::configure(const Config::Output& config) {
+    apps_.clear();  // they point into rules_
+    rules_.clear();
+    auto compile = [](const std::string& app_id, const std::string& method, const std::string& keys) {
+        Rule rule{.app_id = lowercase(app_id)};
+        if (method == "type") rule.strategy.delivery = Delivery::Type;
+        else if (method == "clipboard") rule.strategy.delivery = Delivery::Clipboard;
+        else rule.automatic = method == "auto";
+        // Kept for "auto" too, which may settle on pasting.
+        rule.strategy.shift = rule.strategy.delivery == Delivery::Paste && lowercase(keys) == "ctrl+shift+v";
+        return rule;
+    };
+
+    for (auto& r : config.apps) {
+        if (!r.app_id.empty()) rules_.push_back(compile(r.app_id, r.method, r.paste_keys));
+    }
+    for (auto* terminal : TERMINALS) rules_.push_back(compile(terminal, "paste", "ctrl+shift+v"));
+    fallback_ = compile("", config.fallback, "ctrl+v");
+}
+
+OutputRouter::App& OutputRouter::app(const WindowInfo& window) {
+    const std::string& id = !window.app_id.empty() ? window.app_id : window.window_class;
+    if (auto it = apps_.find(id); it != apps_.end()) return it->second;
+
+    if (apps_.size() >= MAX_APPS) apps_.clear();
+    const Rule* rule = &fallback_;
+    if (!id.empty()) {
+        std::string lower = lowercase(id);
+        auto it = std::ranges::find_if(rules_, [&lower](const Rule& r) {
+            return lower.find(r.app_id) != std::string::npos;
+        });
+        if (it != rules_.end()) rule = &*it;
+    }
+    return apps_.emplace(id, App{.rule = rule}).first->second;
+}
+
+OutputStrategy OutputRouter::choose(const std::string& method, const WindowInfo& window) {
+    if (method == "clipboard") return {.delivery = Delivery::Clipboard};
+    if (method == "none") return {.delivery = Delivery::None};
+
+    auto& a = app(window);
+    if (!a.rule->automatic) return a.rule->strategy;
+
+    // Each candidate gets one try, pasting first; then the fastest of those
+    // that have kept working.
+    OutputStrategy paste{.delivery = Delivery::Paste, .shift = a.rule->strategy.shift};
+    OutputStrategy type{.delivery = Delivery::Type};
+    const OutputStrategy* best = nullptr;
+    for (auto* candidate : {&paste, &type}) {
+        auto& s = a.stats[static_cast<size_t>(candidate->delivery)];
+        if (s.deliveries == 0) return *candidate;
+        if (!s.reliable()) continue;
+        if (!best || s.latency_s < a.stats[static_cast<size_t>(best->delivery)].latency_s) best = candidate;
+    }
+    return best ? *best : paste;
+}
+
+OutputMethod* OutputRouter::output(const OutputStrategy& strategy) {
+    if (strategy.delivery == Delivery::None) return nullptr;
+    auto& out = outputs_[slot(strategy)];
+    if (!out && factory_) out = factory_(strategy);
+    return out.get();
+}
+
+void OutputRouter::record(const WindowInfo& window, const OutputStrategy& strategy, double seconds, bool ok) {
+    auto& s = app(window).stats[static_cast<size_t>(strategy.delivery)];
+    if (!ok) {
+        ++s.failures;
+    } else if (s.deliveries == s.failures) {
+        s.latency_s = seconds;
+    } else {
+        s.latency_s += LATENCY_WEIGHT * (seconds - s.latency_s);
+    }
+    ++s.deliveries;
+}
+
+const OutputRouter::Stats& OutputRouter::stats(const WindowInfo& window, Delivery delivery) {
+    return app(window).stats[static_cast<size_t>(delivery)];
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include "config.hpp"
+#include "output/output.hpp"
+#include "sway/window_info.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Decides how a transcript gets into the window it is meant for, and hands
+// out the output that does it.
+//
+// The rules from output.apps, then the built-in terminal ones, are compiled
+// once (lowercased, methods parsed); each app's decision is kept, so a window
+// seen before costs one hash lookup. Outputs are made once per strategy and
+// reused. How long each delivery took, and whether it failed, is recorded
+// per app, and apps whose rule says "auto" get the fastest method that has
+// been reliable for them, after trying each once.
+class OutputRouter {
+public:
+    using Factory = std::function<std::unique_ptr<OutputMethod>(const OutputStrategy&)>;
+
+    // Latency is a moving average of successful deliveries.
+    static constexpr double LATENCY_WEIGHT = 0.25;
+    // A method failing more than this share of its deliveries is not picked.
+    static constexpr double MAX_FAILURE_RATE = 0.25;
+    // Decisions kept before the cache starts over.
+    static constexpr size_t MAX_APPS = 1024;
+
+    struct Stats {
+        double latency_s = 0;
+        uint32_t deliveries = 0;
+        uint32_t failures = 0;
+
+        bool reliable() const { return failures <= MAX_FAILURE_RATE * deliveries; }
+    };
+
+    OutputRouter(const Config::Output& config, Factory factory);
+
+    // Takes new rules (config reload). Decisions and measurements start over;
+    // the outputs already made are kept.
+    void configure(const Config::Output& config);
+
+    // The strategy for text sent with `method` to window: "clipboard" always
+    // means the clipboard and "none" no output, anything else goes by the
+    // app's rule.
+    OutputStrategy choose(const std::string& method, const WindowInfo& window);
+
+    // The output for strategy, made on first use. Null for Delivery::None,
+    // and if the factory has none. Outputs are shared: a live (incremental) one must keep no state
+    // of its own between begin() and commit().
+    OutputMethod* output(const OutputStrategy& strategy);
+
+    // A delivery to window through strategy that took seconds.
+    void record(const WindowInfo& window, const OutputStrategy& strategy, double seconds, bool ok);
+
+    // What has been measured for window's app so far.
+    const Stats& stats(const WindowInfo& window, Delivery delivery);
+
+private:
+    struct Rule {
+        std::string app_id;  // lowercased
+        bool automatic = false;
+        OutputStrategy strategy;
+    };
+
+    struct App {
+        const Rule* rule;
+        std::array<Stats, 4> stats{};  // by Delivery
+    };
+
+    std::vector<Rule> rules_;
+    Rule fallback_;
+    Factory factory_;
+    std::array<std::unique_ptr<OutputMethod>, 4> outputs_;  // by delivery and shift
+    std::unordered_map<std::string, App> apps_;             // by app_id as given
+
+    App& app(const WindowInfo& window);
+};
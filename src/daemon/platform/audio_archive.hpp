@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <span>
+
+// A stored recording, read in place from the archive's storage, which stays
+// mapped for as long as a copy of the clip is alive.
+struct AudioClip {
+    std::span<const int16_t> samples;
+    uint32_t sample_rate = 0;
+    std::shared_ptr<const void> storage;
+};
+
+// Keeps the audio of past transcriptions so they can be replayed. Both
+// calls may come from any thread.
+class AudioArchive {
+public:
+    virtual ~AudioArchive() = default;
+
+    // Returns the clip's id, or 0 when it couldn't be stored.
+    virtual uint64_t append(std::span<const int16_t> samples, uint32_t sample_rate) = 0;
+    // Empty once retention has dropped the clip.
+    virtual std::optional<AudioClip> clip(uint64_t id) = 0;
+};
@@ -1,9 +1,30 @@
 #pragma once
 
+#include <cstdint>
+#include <vector>
+
+// Counters kept by the capture thread since the capture was created.
+struct CaptureStats {
+    uint64_t callbacks = 0;      // process callbacks that delivered audio
+    uint64_t bytes = 0;          // audio queued into the ring buffer
+    uint64_t dropped_bytes = 0;  // audio the ring buffer had no room for
+    uint64_t underruns = 0;      // callbacks that came without audio
+    uint32_t quantum = 0;        // frames in the most recent callback
+    double callback_avg_us = 0;
+    double callback_max_us = 0;
+
+    // Where the capture path lives (audio.lock_memory, audio.cpus).
+    uint64_t locked_bytes = 0;  // buffer memory locked into RAM
+    bool hugepages = false;     // that memory is on transparent hugepages
+    std::vector<int> cpus;      // the capture threads were pinned to these
+};
+
 class AudioCapture {
 public:
     virtual ~AudioCapture() = default;
     virtual bool start() = 0;
     virtual void stop() = 0;
     virtual bool is_capturing() const = 0;
+    // Safe to call from any thread while capture runs.
+    virtual CaptureStats stats() const { return {}; }
 };
@@ -0,0 +1,13 @@
+#pragma once
+
+#include <expected>
+#include <string>
+#include <vector>
+
+namespace platform {
+
+// Keeps the calling thread on these CPUs from now on (audio.cpus). Nothing
+// to do for an empty list. Threads it starts afterwards inherit the set.
+std::expected<void, std::string> pin_current_thread(const std::vector<int>& cpus);
+
+} // namespace platform
@@ -1,7 +1,12 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
 #include <nlohmann/json.hpp>
+#include <optional>
 #include <string>
+#include <string_view>
+#include <vector>
 
 class IpcServer {
 public:
@@ -10,7 +15,30 @@ public:
     virtual void stop() = 0;
     virtual int server_fd() const = 0;
     virtual int accept_client() = 0;
-    virtual bool read_command(int client_fd, nlohmann::json& cmd) = 0;
+    // Reads everything the client has sent and appends each complete command
+    // to cmds, in order; a trailing partial one stays buffered for next time.
+    // False once the client has disconnected or sent garbage (cmds may still
+    // hold what came before).
+    virtual bool read_commands(int client_fd, std::vector<nlohmann::json>& cmds) = 0;
+    // Never blocks: what the socket doesn't take now is queued for flush().
+    // False if the client is gone, or so far behind that it was cut off.
     virtual bool send_response(int client_fd, const nlohmann::json& response) = 0;
+    // Writes as much of data as the socket takes right now, unframed and
+    // after anything queued: the bytes written (0 until it drains), or -1
+    // once the client is gone.
+    virtual long send_some(int client_fd, std::string_view data) = 0;
+    // The client's socket has room again: sends what is queued for it.
+    // False once the client is gone.
+    virtual bool flush(int client_fd) = 0;
     virtual void close_client(int client_fd) = 0;
+    // The uid of the process at the other end, as the kernel reported it
+    // when the client connected.
+    virtual uint32_t peer_uid(int client_fd) const = 0;
+
+    // Subscribed clients stay connected and get every published event as a
+    // line of its own, until they disconnect.
+    virtual void subscribe(int client_fd) = 0;
+    virtual size_t subscriber_count() const = 0;
+    // Only to the subscribers of one uid, when given.
+    virtual void publish(const nlohmann::json& event, std::optional<uint32_t> uid = std::nullopt) = 0;
 };
@@ -0,0 +1,25 @@
+#include "platform/cpu_affinity.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <sched.h>
+
+namespace platform {
+
+std::expected<void, std::string> pin_current_thread(const std::vector<int>& cpus) {
+    if (cpus.empty()) return {};
+
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu : cpus) {
+        if (cpu < 0 || cpu >= CPU_SETSIZE) return std::unexpected("no CPU " + std::to_string(cpu));
+        CPU_SET(cpu, &set);
+    }
+    // 0 is the calling thread, not the process.
+    if (::sched_setaffinity(0, sizeof(set), &set) != 0) {
+        return std::unexpected(std::string("sched_setaffinity() failed: ") + std::strerror(errno));
+    }
+    return {};
+}
+
+} // namespace platform
@@ -4,57 +4,229 @@
 #include "platform/linux/wayland_type_output.hpp"
 #include "platform/platform_paths.hpp"
 
+#include <algorithm>
 #include <cerrno>
 #include <cstring>
+#include <filesystem>
+#include <format>
+#include <grp.h>
+#include <optional>
 #include <print>
+#include <pwd.h>
 #include <signal.h>
 #include <sys/epoll.h>
 #include <sys/eventfd.h>
+#include <sys/inotify.h>
 #include <sys/signalfd.h>
+#include <sys/stat.h>
+#include <sys/timerfd.h>
+#include <thread>
 #include <unistd.h>
+#include <vector>
 
-LinuxEventLoop::LinuxEventLoop(Config config, bool verbose)
-    : config_(std::move(config)), verbose_(verbose),
-      ring_buf_(config_.audio.ring_buffer_bytes()),
-      audio_capture_(ring_buf_, config_.audio.sample_rate),
+namespace fs = std::filesystem;
+
+namespace {
+
+// With audio.lock_memory every chunk of the capture queues exists from the
+// start, in one locked region: the main ring first, then native mode's raw
+// queue.
+size_t capture_memory_bytes(const Config::Audio& audio) {
+    if (!audio.lock_memory) return 0;
+    size_t bytes = RingBuffer::storage_bytes(audio.ring_buffer_bytes());
+    if (audio.native_format) bytes += RingBuffer::storage_bytes(PipeWireCapture::RAW_RING_BYTES);
+    return bytes;
+}
+
+// The part of region from offset on, if it is all there (an empty region
+// means the buffers allocate for themselves).
+std::span<uint8_t> carve(std::span<uint8_t> region, size_t offset, size_t bytes) {
+    if (region.size() < offset + bytes) return {};
+    return region.subspan(offset, bytes);
+}
+
+std::optional<gid_t> find_group(const std::string& name) {
+    if (name.empty()) return std::nullopt;
+    std::vector<char> buf(16384);
+    group grp{};
+    group* found = nullptr;
+    if (::getgrnam_r(name.c_str(), &grp, buf.data(), buf.size(), &found) != 0 || !found) return std::nullopt;
+    return grp.gr_gid;
+}
+
+// Whether the user uid is in group gid, as their primary group or another.
+bool in_group(uint32_t uid, gid_t gid) {
+    std::vector<char> buf(16384);
+    passwd pw{};
+    passwd* found = nullptr;
+    if (::getpwuid_r(uid, &pw, buf.data(), buf.size(), &found) != 0 || !found) return false;
+    if (pw.pw_gid == gid) return true;
+    std::vector<gid_t> groups(32);
+    int n = static_cast<int>(groups.size());
+    while (::getgrouplist(pw.pw_name, pw.pw_gid, groups.data(), &n) < 0) {
+        // n is now the number needed.
+        if (static_cast<size_t>(n) <= groups.size()) return false;
+        groups.resize(static_cast<size_t>(n));
+    }
+    return std::ranges::find(groups.begin(), groups.begin() + n, gid) != groups.begin() + n;
+}
+
+} // namespace
+
+LinuxEventLoop::LinuxEventLoop(Config config, bool verbose, std::string config_path, std::string replay)
+    : config_(std::move(config)), verbose_(verbose), config_path_(std::move(config_path)),
+      replay_(std::move(replay)),
+      capture_memory_(capture_memory_bytes(config_.audio), config_.audio.hugepages),
+      ring_buf_(config_.audio.ring_buffer_bytes(), RingBuffer::DEFAULT_CHUNK_BYTES,
+                carve(capture_memory_.data(), 0, RingBuffer::storage_bytes(config_.audio.ring_buffer_bytes()))),
+      audio_capture_(ring_buf_, config_.audio.sample_rate, config_.audio.quantum,
+                     config_.audio.native_format,
+                     {.memory = &capture_memory_,
+                      .raw_storage = carve(capture_memory_.data(),
+                                           RingBuffer::storage_bytes(config_.audio.ring_buffer_bytes()),
+                                           RingBuffer::storage_bytes(PipeWireCapture::RAW_RING_BYTES)),
+                      .cpus = config_.audio.cpus}),
+      file_capture_(ring_buf_, config_.audio.sample_rate),
       detector_(config_.agents),
-      core_(config_, verbose_, ring_buf_, audio_capture_,
+      core_(config_, verbose_, ring_buf_,
+            replay_.empty() ? static_cast<AudioCapture&>(audio_capture_) : file_capture_,
             detector_, ipc_server_,
             // OutputFactory
-            [](const std::string& method, bool is_terminal) -> std::unique_ptr<OutputMethod> {
-                if (method == "type") return std::make_unique<WaylandTypeOutput>(is_terminal);
-                return std::make_unique<WaylandClipboardOutput>();
+            [this](const OutputStrategy& strategy) -> std::unique_ptr<OutputMethod> {
+                if (strategy.delivery == Delivery::Clipboard) {
+                    return std::make_unique<WaylandClipboardOutput>(wayland_session());
+                }
+                return std::make_unique<WaylandTypeOutput>(strategy, wayland_session());
             },
             // NotifyCallback
             [this]() {
                 uint64_t val = 1;
                 ::write(worker_event_fd_, &val, sizeof(val));
-            }) {}
+            }),
+      transfers_([this](int fd, uint32_t events) { watch_transfer(fd, events); },
+                 [this](long ms) { arm_transfer_timer(ms); }) {}
 
 LinuxEventLoop::~LinuxEventLoop() {
     if (epoll_fd_ >= 0) ::close(epoll_fd_);
     if (signal_fd_ >= 0) ::close(signal_fd_);
     if (worker_event_fd_ >= 0) ::close(worker_event_fd_);
+    if (audio_timer_fd_ >= 0) ::close(audio_timer_fd_);
+    if (auto_stop_timer_fd_ >= 0) ::close(auto_stop_timer_fd_);
+    if (curl_timer_fd_ >= 0) ::close(curl_timer_fd_);
+    if (probe_timer_fd_ >= 0) ::close(probe_timer_fd_);
+    if (idle_timer_fd_ >= 0) ::close(idle_timer_fd_);
+    if (config_watch_fd_ >= 0) ::close(config_watch_fd_);
 }
 
 bool LinuxEventLoop::init() {
-    // IPC socket
+    // With --verbose, what each step of startup cost.
+    auto lap = StageSpan::Clock::now();
+    auto started = lap;
+    auto step = [this, &lap](std::string_view what) {
+        log(std::format("startup: {} in {:.1f} ms", what, StageSpan::seconds_since(lap) * 1000));
+        lap = StageSpan::Clock::now();
+    };
+
+    // IPC socket. Clients can connect from here on; their commands wait in
+    // the socket until run() starts.
     auto ipc_path = platform::ipc_endpoint();
     if (!ipc_server_.start(ipc_path)) return false;
     log("IPC listening on " + ipc_path);
-
-    // Window manager (optional)
-    if (window_mgr_.connect()) {
-        core_.set_focused_window(window_mgr_.get_focused_window());
-        if (window_mgr_.subscribe_focus_events()) {
-            log("Sway IPC connected");
+    // Every user's clients connect to one socket, and only the members of
+    // daemon.socket_group may. (systemd's socket gets its group and mode
+    // from the unit; the check at accept applies to both.)
+    if (config_.daemon.multi_user) {
+        auto gid = find_group(config_.daemon.socket_group);
+        if (!gid) {
+            std::println(stderr, "daemon.multi_user needs daemon.socket_group, an existing group "
+                                 "of the users allowed to connect");
+            return false;
         }
+        socket_gid_ = *gid;
+        if (!ipc_server_.socket_activated() &&
+            (::chown(ipc_path.c_str(), static_cast<uid_t>(-1), *gid) != 0 || ::chmod(ipc_path.c_str(), 0660) != 0)) {
+            std::println(stderr, "Failed to give {} to group {}: {}", ipc_path, config_.daemon.socket_group,
+                         std::strerror(errno));
+            return false;
+        }
+    }
+    step(ipc_server_.socket_activated() ? "IPC socket (from systemd)" : "IPC socket");
+
+    // Window manager (optional). Connecting, GET_TREE and SUBSCRIBE are a
+    // round trip each; they run alongside the rest of startup.
+    std::optional<WindowInfo> focused;
+    bool subscribed = false;
+    std::optional<double> sway_s;
+    std::jthread sway([this, &focused, &subscribed, &sway_s] {
+        StageSpan span(sway_s);
+        if (!window_mgr_.connect()) return;
+        focused = window_mgr_.get_focused_window();
+        subscribed = window_mgr_.subscribe_focus_events();
+    });
+
+#ifdef SPEAK_ANYWHERE_HAVE_WAYLAND
+    // Native clipboard and keystrokes (optional; outputs fall back to wl-copy/wtype)
+    if (config_.output.native_wayland && wayland_.connect()) {
+        log(std::format("Wayland connected (clipboard: {}, virtual keyboard: {})",
+                        wayland_.has_clipboard() ? "yes" : "no",
+                        wayland_.has_keyboard() ? "yes" : "no"));
+    } else if (config_.output.native_wayland) {
+        log("Wayland protocols not available (using wl-copy/wtype)");
+    }
+    step("Wayland");
+#endif
+
+    // Process tree from fork/exec/exit events (optional; needs CAP_NET_ADMIN)
+    if (proc_events_.start()) {
+        detector_.use_tracker(&proc_events_);
+        log(std::format("Proc connector subscribed ({} processes)", proc_events_.process_count()));
     } else {
-        log("Sway IPC not available (window context disabled)");
+        log("Proc connector not available (agent detection reads /proc)");
+    }
+    step("proc connector");
+
+    if (!replay_.empty()) {
+        auto clips = file_capture_.open(replay_);
+        if (!clips) {
+            std::println(stderr, "replay: {}", clips.error());
+            return false;
+        }
+        log(std::format("Replaying {} clip(s) from {} instead of the microphone", *clips, replay_));
+    }
+
+    // Capture buffers (already mapped by the constructor)
+    if (config_.audio.lock_memory) {
+        if (!capture_memory_.locked()) {
+            std::println(stderr, "audio: capture buffers not locked: {} (raise the memlock limit)",
+                         capture_memory_.error());
+        } else {
+            log(std::format("Capture buffers locked ({} KiB{})", capture_memory_.data().size() >> 10,
+                            capture_memory_.hugepages() ? ", hugepages" : ""));
+        }
+        if (config_.audio.hugepages && !capture_memory_.hugepages()) {
+            std::println(stderr, "audio: transparent hugepages are not available");
+        }
+    }
+
+    // Audio archive (optional)
+    if (config_.archive.enabled) {
+        auto data = platform::data_dir();
+        auto dir = (data.empty() ? std::string("/tmp/speak-anywhere") : data) + "/audio";
+        if (audio_archive_.open({.dir = dir,
+                                 .max_bytes = uint64_t{config_.archive.max_mb} << 20,
+                                 .segment_bytes = uint64_t{config_.archive.segment_mb} << 20})) {
+            core_.set_audio_archive(&audio_archive_);
+            log(std::format("Audio archive at {} ({} MiB kept)", dir, audio_archive_.size_bytes() >> 20));
+        } else {
+            log("Audio archive not available");
+        }
     }
 
-    // Core init (backend, history db)
+    step("audio archive");
+
+    // Core init (backend; the history db opens in the background)
     if (!core_.init()) return false;
+    step("core");
 
     // epoll setup
     epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
@@ -68,8 +240,12 @@ bool LinuxEventLoop::init() {
     sigemptyset(&mask);
     sigaddset(&mask, SIGINT);
     sigaddset(&mask, SIGTERM);
+    sigaddset(&mask, SIGHUP);
     sigprocmask(SIG_BLOCK, &mask, nullptr);
 
+    // Clipboard data is written to pipes of pasting clients, which may close early.
+    ::signal(SIGPIPE, SIG_IGN);
+
     signal_fd_ = signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC);
     if (signal_fd_ < 0) {
         std::println(stderr, "signalfd failed: {}", std::strerror(errno));
@@ -83,6 +259,73 @@ bool LinuxEventLoop::init() {
         return false;
     }
 
+    // Audio consumer tick (armed only while recording)
+    audio_timer_fd_ = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (audio_timer_fd_ < 0) {
+        std::println(stderr, "timerfd_create failed: {}", std::strerror(errno));
+        return false;
+    }
+
+    // Hands-free stop: fires when the silence could be long enough, rather
+    // than waiting for the next audio tick
+    auto_stop_timer_fd_ = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (auto_stop_timer_fd_ < 0) {
+        std::println(stderr, "timerfd_create failed: {}", std::strerror(errno));
+        return false;
+    }
+
+    // Transcription uploads: libcurl's timeouts for the transfers run here
+    curl_timer_fd_ = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (curl_timer_fd_ < 0) {
+        std::println(stderr, "timerfd_create failed: {}", std::strerror(errno));
+        return false;
+    }
+
+    // Health probes of the transcription servers, on the transfers above
+    probe_timer_fd_ = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (probe_timer_fd_ < 0) {
+        std::println(stderr, "timerfd_create failed: {}", std::strerror(errno));
+        return false;
+    }
+
+    // Idle exit: only when systemd holds the socket and starts us again.
+    if (config_.daemon.idle_exit_minutes > 0 && ipc_server_.socket_activated()) {
+        idle_timer_fd_ = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+        if (idle_timer_fd_ < 0) {
+            std::println(stderr, "timerfd_create failed: {}", std::strerror(errno));
+            return false;
+        }
+    } else if (config_.daemon.idle_exit_minutes > 0) {
+        log("Idle exit needs socket activation (speak-anywhere.socket); staying up");
+    }
+
+    // Config changes apply without a restart. The directory is watched, not
+    // the file: editors save by renaming a new file over the old one.
+    if (!config_path_.empty()) {
+        auto dir = fs::path(config_path_).parent_path();
+        config_watch_fd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (config_watch_fd_ >= 0 &&
+            inotify_add_watch(config_watch_fd_, dir.empty() ? "." : dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+            ::close(config_watch_fd_);
+            config_watch_fd_ = -1;
+        }
+        log(config_watch_fd_ >= 0 ? "Watching " + config_path_ : "Config file not watched (SIGHUP reloads it)");
+    }
+
+    step("event fds");
+
+    sway.join();
+    if (focused) {
+        core_.set_focused_window(*focused);
+        if (subscribed) {
+            log("Sway IPC connected");
+        }
+    } else {
+        log("Sway IPC not available (window context disabled)");
+    }
+    log(std::format("startup: Sway IPC in {:.1f} ms (in the background)", sway_s.value_or(0) * 1000));
+    lap = StageSpan::Clock::now();
+
     // Register FDs with epoll
     auto add_fd = [this](int fd, uint32_t events) {
         epoll_event ev{.events = events, .data = {.fd = fd}};
@@ -92,11 +335,35 @@ bool LinuxEventLoop::init() {
     add_fd(signal_fd_, EPOLLIN);
     add_fd(ipc_server_.server_fd(), EPOLLIN);
     add_fd(worker_event_fd_, EPOLLIN);
+    add_fd(audio_timer_fd_, EPOLLIN);
+    add_fd(auto_stop_timer_fd_, EPOLLIN);
+    add_fd(curl_timer_fd_, EPOLLIN);
+    add_fd(probe_timer_fd_, EPOLLIN);
+    if (config_watch_fd_ >= 0) add_fd(config_watch_fd_, EPOLLIN);
+    if (idle_timer_fd_ >= 0) {
+        add_fd(idle_timer_fd_, EPOLLIN);
+        update_idle_timer(true);
+    }
+    core_.set_transfers(&transfers_);
+    update_probe_timer();
 
     if (window_mgr_.event_fd() >= 0) {
         add_fd(window_mgr_.event_fd(), EPOLLIN);
     }
 
+    if (proc_events_.fd() >= 0) {
+        add_fd(proc_events_.fd(), EPOLLIN);
+    }
+
+#ifdef SPEAK_ANYWHERE_HAVE_WAYLAND
+    if (wayland_.fd() >= 0) {
+        add_fd(wayland_.fd(), EPOLLIN);
+    }
+#endif
+
+    step("epoll");
+    log(std::format("startup: ready in {:.1f} ms", StageSpan::seconds_since(started) * 1000));
+
     running_.store(true, std::memory_order_release);
     return true;
 }
@@ -113,22 +380,40 @@ void LinuxEventLoop::run() {
             break;
         }
 
+        bool activity = false;  // a client connected or sent commands
         for (int i = 0; i < n; i++) {
             int fd = events[i].data.fd;
 
             if (fd == signal_fd_) {
                 signalfd_siginfo info;
                 ::read(signal_fd_, &info, sizeof(info));
+                if (info.ssi_signo == SIGHUP) {
+                    reload_config();
+                    continue;
+                }
                 log("Received signal, shutting down");
                 running_.store(false, std::memory_order_release);
                 break;
             }
 
             if (fd == ipc_server_.server_fd()) {
-                int client_fd = ipc_server_.accept_client();
-                if (client_fd >= 0) {
-                    epoll_event ev{.events = EPOLLIN, .data = {.fd = client_fd}};
+                // Clients are edge-triggered: each wakeup reads all they sent.
+                for (int client_fd; (client_fd = ipc_server_.accept_client()) >= 0;) {
+                    // A daemon of one user only answers that user (and root),
+                    // a shared one the members of daemon.socket_group too.
+                    uint32_t uid = ipc_server_.peer_uid(client_fd);
+                    if (uid != ::geteuid() && uid != 0 &&
+                        !(config_.daemon.multi_user && in_group(uid, socket_gid_))) {
+                        log(std::format("Refused a client of uid {}", uid));
+                        ipc_server_.close_client(client_fd);
+                        continue;
+                    }
+                    // EPOLLOUT: edge-triggered, it only reports a full socket
+                    // draining, when the client's queued output can go out.
+                    epoll_event ev{.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET,
+                                   .data = {.fd = client_fd}};
                     epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, client_fd, &ev);
+                    activity = true;
                 }
                 continue;
             }
@@ -137,6 +422,63 @@ void LinuxEventLoop::run() {
                 uint64_t val;
                 ::read(worker_event_fd_, &val, sizeof(val));
                 core_.on_transcription_complete();
+                update_audio_timer();
+                update_auto_stop_timer();
+                continue;
+            }
+
+            if (fd == audio_timer_fd_ || fd == auto_stop_timer_fd_) {
+                uint64_t expirations;
+                ::read(fd, &expirations, sizeof(expirations));
+                if (fd == auto_stop_timer_fd_) auto_stop_armed_ = false;
+                // A tick can end a hands-free recording.
+                core_.on_audio_tick();
+                update_audio_timer();
+                update_auto_stop_timer();
+                continue;
+            }
+
+            if (fd == idle_timer_fd_) {
+                uint64_t expirations;
+                ::read(fd, &expirations, sizeof(expirations));
+                idle_armed_ = false;
+                if (core_.idle()) {
+                    log(std::format("Idle for {} min, exiting", config_.daemon.idle_exit_minutes));
+                    running_.store(false, std::memory_order_release);
+                    break;
+                }
+                continue;
+            }
+
+            if (fd == config_watch_fd_) {
+                if (config_file_changed()) reload_config();
+                continue;
+            }
+
+            if (fd == curl_timer_fd_) {
+                uint64_t expirations;
+                ::read(fd, &expirations, sizeof(expirations));
+                // Finished transfers are delivered from in here.
+                transfers_.on_timeout();
+                update_audio_timer();
+                update_auto_stop_timer();
+                continue;
+            }
+
+            if (fd == probe_timer_fd_) {
+                uint64_t expirations;
+                ::read(fd, &expirations, sizeof(expirations));
+                core_.probe_backends();
+                continue;
+            }
+
+            if (transfers_.watches(fd)) {
+                uint32_t ready = events[i].events;
+                transfers_.on_socket(fd, ((ready & EPOLLIN) ? CurlMulti::Read : 0) |
+                                         ((ready & EPOLLOUT) ? CurlMulti::Write : 0) |
+                                         ((ready & (EPOLLERR | EPOLLHUP)) ? CurlMulti::Error : 0));
+                update_audio_timer();
+                update_auto_stop_timer();
                 continue;
             }
 
@@ -148,29 +490,195 @@ void LinuxEventLoop::run() {
                 continue;
             }
 
-            // Client fd
-            nlohmann::json cmd;
-            if (ipc_server_.read_command(fd, cmd)) {
-                std::string cmd_str = cmd.value("cmd", "");
-                auto response = core_.handle_command(cmd_str, cmd);
+            if (fd == proc_events_.fd()) {
+                if (!proc_events_.read_events()) {
+                    // The socket is closed (and out of epoll); the detector
+                    // sees the tracker inactive and reads /proc again.
+                    log("Proc connector failed (agent detection reads /proc)");
+                }
+                continue;
+            }
+
+#ifdef SPEAK_ANYWHERE_HAVE_WAYLAND
+            if (fd == wayland_.fd()) {
+                if (!wayland_.dispatch()) {
+                    // dispatch() disconnected, and closing the fd dropped it from epoll.
+                    log("Wayland connection lost (using wl-copy/wtype)");
+                }
+                continue;
+            }
+#endif
+
+            // Room on a client's socket: what was queued for it goes out
+            // first, then more of its export.
+            if (events[i].events & EPOLLOUT) {
+                bool open = ipc_server_.flush(fd);
+                if (open && core_.exporting(fd)) open = core_.pump_export(fd);
+                if (!open) {
+                    epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd, nullptr);
+                    ipc_server_.close_client(fd);
+                    core_.remove_client(fd);
+                    continue;
+                }
+                if (!(events[i].events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR))) continue;
+            }
+
+            // Client fd: every command it pipelined, in order
+            commands_.clear();
+            bool open = ipc_server_.read_commands(fd, commands_);
+            for (auto& cmd : commands_) {
+                // Anything but an object with a string "cmd" is an unknown command.
+                auto name = cmd.is_object() ? cmd.find("cmd") : cmd.end();
+                std::string cmd_str = name != cmd.end() && name->is_string() ? name->get<std::string>() : "";
+                auto response = core_.handle_command(cmd_str, cmd, ipc_server_.peer_uid(fd), fd);
 
                 if (response.value("status", "") == "transcribing") {
-                    core_.add_waiting_client(fd);
+                    core_.add_waiting_client(fd, response.value("job_id", uint64_t{0}));
                 } else {
                     ipc_server_.send_response(fd, response);
+                    if (cmd_str == "subscribe") core_.add_subscriber(fd);
+                    if (cmd_str == "export" && response.value("status", "") == "ok" && !core_.exporting(fd)) {
+                        core_.start_export(fd, cmd);
+                        // Level-triggered while it lasts: a pump that stops
+                        // with room left is called again on the next wait.
+                        epoll_event ev{.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP, .data = {.fd = fd}};
+                        epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, fd, &ev);
+                    }
                 }
-            } else {
+            }
+            if (!commands_.empty()) {
+                activity = true;
+                update_audio_timer();
+                update_auto_stop_timer();
+            }
+            if (!open) {
                 epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd, nullptr);
                 ipc_server_.close_client(fd);
-                core_.remove_waiting_client(fd);
+                core_.remove_client(fd);
             }
         }
+        if (idle_timer_fd_ >= 0) update_idle_timer(activity);
     }
 
     // Clean shutdown
     core_.shutdown();
 }
 
+void LinuxEventLoop::update_audio_timer() {
+    uint32_t ms = core_.audio_tick_ms();
+    if (ms == audio_timer_ms_) return;
+
+    itimerspec spec{};
+    if (ms > 0) {
+        long ns = static_cast<long>(std::max<uint32_t>(ms, 10)) * 1'000'000L;
+        spec.it_interval = {.tv_sec = ns / 1'000'000'000L, .tv_nsec = ns % 1'000'000'000L};
+        spec.it_value = spec.it_interval;
+    }
+    timerfd_settime(audio_timer_fd_, 0, &spec, nullptr);
+    audio_timer_ms_ = ms;
+}
+
+void LinuxEventLoop::update_auto_stop_timer() {
+    uint32_t ms = core_.auto_stop_ms();
+    if (ms == 0 && !auto_stop_armed_) return;
+
+    // One-shot, re-armed after every tick with what the latest audio leaves.
+    itimerspec spec{};
+    if (ms > 0) {
+        long ns = static_cast<long>(ms) * 1'000'000L;
+        spec.it_value = {.tv_sec = ns / 1'000'000'000L, .tv_nsec = ns % 1'000'000'000L};
+    }
+    timerfd_settime(auto_stop_timer_fd_, 0, &spec, nullptr);
+    auto_stop_armed_ = ms > 0;
+}
+
+void LinuxEventLoop::update_idle_timer(bool activity) {
+    bool idle = core_.idle();
+    // Counting down already; only a client restarts the count.
+    if (idle == idle_armed_ && !activity) return;
+
+    itimerspec spec{};
+    if (idle) spec.it_value.tv_sec = static_cast<time_t>(config_.daemon.idle_exit_minutes) * 60;
+    timerfd_settime(idle_timer_fd_, 0, &spec, nullptr);
+    idle_armed_ = idle;
+}
+
+void LinuxEventLoop::update_probe_timer() {
+    uint32_t ms = core_.probe_ms();
+    if (ms == probe_timer_ms_) return;
+
+    // The first probe goes out straight away, so a server that is down at
+    // startup is known to be before the first recording.
+    itimerspec spec{};
+    if (ms > 0) {
+        long ns = static_cast<long>(ms) * 1'000'000L;
+        spec.it_interval = {.tv_sec = ns / 1'000'000'000L, .tv_nsec = ns % 1'000'000'000L};
+        spec.it_value.tv_nsec = 1;
+    }
+    timerfd_settime(probe_timer_fd_, 0, &spec, nullptr);
+    probe_timer_ms_ = ms;
+}
+
+void LinuxEventLoop::watch_transfer(int fd, uint32_t events) {
+    if (events == 0) {
+        epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd, nullptr);
+        return;
+    }
+    epoll_event ev{.events = ((events & CurlMulti::Read) ? uint32_t{EPOLLIN} : 0) |
+                             ((events & CurlMulti::Write) ? uint32_t{EPOLLOUT} : 0),
+                   .data = {.fd = fd}};
+    // libcurl reports a socket again whenever what it waits for changes.
+    if (epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, fd, &ev) < 0 && errno == ENOENT) {
+        epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &ev);
+    }
+}
+
+void LinuxEventLoop::arm_transfer_timer(long ms) {
+    itimerspec spec{};
+    if (ms == 0) {
+        spec.it_value.tv_nsec = 1;  // all zeros would disarm it
+    } else if (ms > 0) {
+        spec.it_value = {.tv_sec = ms / 1000, .tv_nsec = (ms % 1000) * 1'000'000L};
+    }
+    timerfd_settime(curl_timer_fd_, 0, &spec, nullptr);
+}
+
+bool LinuxEventLoop::config_file_changed() {
+    auto name = fs::path(config_path_).filename().string();
+    alignas(inotify_event) char buf[4096];
+    bool changed = false;
+    for (ssize_t n; (n = ::read(config_watch_fd_, buf, sizeof(buf))) > 0;) {
+        for (char* p = buf; p < buf + n;) {
+            auto* ev = reinterpret_cast<inotify_event*>(p);
+            if (ev->len > 0 && name == ev->name) changed = true;
+            p += sizeof(inotify_event) + ev->len;
+        }
+    }
+    return changed;
+}
+
+void LinuxEventLoop::reload_config() {
+    if (config_path_.empty()) return;
+    // Half-written or broken, the file changes nothing: the running config
+    // stays until it parses.
+    auto next = Config::read(config_path_);
+    if (!next) {
+        std::println(stderr, "config: {}, keeping the running config", next.error());
+        return;
+    }
+    core_.reload(std::move(*next));
+    update_audio_timer();
+    update_auto_stop_timer();
+    update_probe_timer();
+}
+
+WaylandSession* LinuxEventLoop::wayland_session() {
+#ifdef SPEAK_ANYWHERE_HAVE_WAYLAND
+    if (wayland_.has_clipboard() || wayland_.has_keyboard()) return &wayland_;
+#endif
+    return nullptr;
+}
+
 void LinuxEventLoop::request_stop() {
     running_.store(false, std::memory_order_release);
 }
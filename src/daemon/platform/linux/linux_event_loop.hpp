@@ -1,18 +1,35 @@
 #pragma once
 
+#include "audio/file_capture.hpp"
 #include "config.hpp"
 #include "daemon_core.hpp"
+#include "platform/linux/locked_memory.hpp"
+#include "platform/linux/mmap_audio_archive.hpp"
 #include "platform/linux/pipewire_capture.hpp"
+#include "platform/linux/proc_event_tracker.hpp"
 #include "platform/linux/procfs_detector.hpp"
 #include "platform/linux/sway_window_manager.hpp"
 #include "platform/linux/unix_socket_server.hpp"
+#ifdef SPEAK_ANYWHERE_HAVE_WAYLAND
+#include "platform/linux/wayland_session.hpp"
+#endif
 #include "ring_buffer.hpp"
+#include "whisper/curl_multi.hpp"
 
 #include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class WaylandSession;
 
 class LinuxEventLoop {
 public:
-    explicit LinuxEventLoop(Config config, bool verbose = false);
+    // config_path, when not empty, is watched: changes to it are applied
+    // without a restart (as on SIGHUP). replay, when not empty, is a WAV file
+    // or a directory of them recorded in place of the microphone.
+    explicit LinuxEventLoop(Config config, bool verbose = false, std::string config_path = {},
+                            std::string replay = {});
     ~LinuxEventLoop();
 
     LinuxEventLoop(const LinuxEventLoop&) = delete;
@@ -24,16 +41,35 @@ public:
 
 private:
     void log(const std::string& msg);
+    void update_audio_timer();
+    void update_auto_stop_timer();
+    void watch_transfer(int fd, uint32_t events);
+    void arm_transfer_timer(long ms);
+    void update_idle_timer(bool activity);
+    void update_probe_timer();
+    // Whether the watch events waiting name the config file.
+    bool config_file_changed();
+    void reload_config();
+    WaylandSession* wayland_session();
 
-    Config config_;
+    Config config_;  // as started: what the loop reads only applies on restart
     bool verbose_;
+    std::string config_path_;
+    std::string replay_;
 
     // Platform implementations (constructed before core_)
+    LockedMemory capture_memory_;  // audio.lock_memory: the ring buffers' chunks
     RingBuffer ring_buf_;
     PipeWireCapture audio_capture_;
+    FileAudioCapture file_capture_;  // opened in init() when replaying
     SwayWindowManager window_mgr_;
+    ProcEventTracker proc_events_;  // before detector_, which points at it
     ProcfsDetector detector_;
     UnixSocketServer ipc_server_;
+    MmapAudioArchive audio_archive_;  // opened in init() when archive.enabled
+#ifdef SPEAK_ANYWHERE_HAVE_WAYLAND
+    WaylandSession wayland_;  // connected in init() unless output.native_wayland is off
+#endif
 
     // Portable business logic
     DaemonCore core_;
@@ -42,6 +78,19 @@ private:
     int epoll_fd_ = -1;
     int signal_fd_ = -1;
     int worker_event_fd_ = -1;
+    int audio_timer_fd_ = -1;
+    uint32_t audio_timer_ms_ = 0;
+    int auto_stop_timer_fd_ = -1;  // one-shot, at the moment silence could end the recording
+    bool auto_stop_armed_ = false;
+    int idle_timer_fd_ = -1;  // one-shot, daemon.idle_exit_minutes after the last activity
+    bool idle_armed_ = false;
+    int curl_timer_fd_ = -1;  // one-shot, when libcurl wants on_timeout()
+    int probe_timer_fd_ = -1;  // backend.health.probe_seconds
+    uint32_t probe_timer_ms_ = 0;
+    int config_watch_fd_ = -1;  // inotify, on the config file's directory
+    uint32_t socket_gid_ = 0;  // daemon.socket_group, with daemon.multi_user
+    CurlMulti transfers_;     // its sockets go into epoll_fd_ alongside ours
+    std::vector<nlohmann::json> commands_;  // read from one client, reused
 
     std::atomic<bool> running_{false};
 };
@@ -21,6 +21,9 @@ std::string data_dir() {
 }
 
 std::string ipc_endpoint() {
+    // Set for every user when they share one daemon (daemon.multi_user).
+    const char* shared = std::getenv("SPEAK_ANYWHERE_SOCKET");
+    if (shared && *shared) return shared;
     const char* xdg = std::getenv("XDG_RUNTIME_DIR");
     if (xdg) return std::string(xdg) + "/speak-anywhere.sock";
     return "/tmp/speak-anywhere.sock";
@@ -0,0 +1,63 @@
+#include "platform/linux/locked_memory.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace {
+
+size_t round_up(size_t n, size_t to) {
+    return (n + to - 1) / to * to;
+}
+
+// madvise(MADV_HUGEPAGE) succeeds even where the administrator turned
+// transparent hugepages off; the advice is only taken in "always" or
+// "madvise" mode.
+bool hugepages_enabled() {
+    std::ifstream f("/sys/kernel/mm/transparent_hugepage/enabled");
+    std::string mode;
+    std::getline(f, mode);
+    return !mode.empty() && mode.find("[never]") == std::string::npos;
+}
+
+} // namespace
+
+LockedMemory::LockedMemory(size_t bytes, bool hugepages) {
+    if (bytes == 0) return;
+
+    size_t page = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+    size_t size = round_up(bytes, hugepages ? HUGEPAGE_BYTES : page);
+    // Huge: map an extra hugepage so an aligned range can be cut out of it.
+    size_t mapped = hugepages ? size + HUGEPAGE_BYTES : size;
+    void* p = ::mmap(nullptr, mapped, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (p == MAP_FAILED) {
+        error_ = std::string("mmap() failed: ") + std::strerror(errno);
+        return;
+    }
+
+    auto* base = static_cast<uint8_t*>(p);
+    if (hugepages) {
+        auto addr = reinterpret_cast<uintptr_t>(base);
+        size_t head = round_up(addr, HUGEPAGE_BYTES) - addr;
+        if (head > 0) ::munmap(base, head);
+        if (size_t tail = mapped - head - size; tail > 0) ::munmap(base + head + size, tail);
+        base += head;
+        hugepages_ = ::madvise(base, size, MADV_HUGEPAGE) == 0 && hugepages_enabled();
+    }
+    data_ = base;
+    size_ = size;
+
+    // mlock() faults every page in as it locks them.
+    locked_ = ::mlock(data_, size_) == 0;
+    if (!locked_) {
+        error_ = std::string("mlock() failed: ") + std::strerror(errno);
+        std::memset(data_, 0, size_);
+    }
+}
+
+LockedMemory::~LockedMemory() {
+    // Unlocked along with the mapping.
+    if (data_) ::munmap(data_, size_);
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+
+// Anonymous memory mapped up front and locked into RAM (audio.lock_memory),
+// so the capture buffers carved from it are never swapped out or faulted in
+// while audio arrives. With hugepages the mapping is 2 MiB aligned and
+// advised onto transparent hugepages, which also takes the buffers' TLB
+// misses off the capture thread.
+//
+// Locking needs RLIMIT_MEMLOCK room (LimitMEMLOCK= in a systemd unit). When
+// it is refused the pages are still faulted in now, and locked() says so.
+class LockedMemory {
+public:
+    static constexpr size_t HUGEPAGE_BYTES = 2 << 20;
+
+    LockedMemory() = default;
+    LockedMemory(size_t bytes, bool hugepages);
+    ~LockedMemory();
+
+    LockedMemory(const LockedMemory&) = delete;
+    LockedMemory& operator=(const LockedMemory&) = delete;
+
+    // Empty if nothing was asked for or the mapping failed (see error()).
+    std::span<uint8_t> data() const { return {data_, size_}; }
+    bool locked() const { return locked_; }
+    bool hugepages() const { return hugepages_; }
+    // Why the memory isn't there, or isn't locked.
+    const std::string& error() const { return error_; }
+
+private:
+    uint8_t* data_ = nullptr;
+    size_t size_ = 0;
+    bool locked_ = false;
+    bool hugepages_ = false;
+    std::string error_;
+};
@@ -0,0 +1,232 @@
+#include "platform/linux/mmap_audio_archive.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <chrono>
+#include <cstring>
+#include <fcntl.h>
+#include <filesystem>
+#include <format>
+#include <print>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+bool write_all(int fd, const void* data, size_t size) {
+    auto* p = static_cast<const char*>(data);
+    while (size > 0) {
+        ssize_t n = ::write(fd, p, size);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        p += n;
+        size -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+// Microseconds since the epoch, so ids stay unique even if the directory is
+// wiped while history still refers to older clips.
+uint64_t now_us() {
+    auto since_epoch = std::chrono::system_clock::now().time_since_epoch();
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(since_epoch).count());
+}
+
+} // namespace
+
+MmapAudioArchive::MmapAudioArchive() = default;
+
+MmapAudioArchive::~MmapAudioArchive() {
+    close_segment();
+}
+
+std::string MmapAudioArchive::path(uint32_t number, const char* ext) const {
+    return std::format("{}/{:08}.{}", options_.dir, number, ext);
+}
+
+bool MmapAudioArchive::open(Options options) {
+    std::lock_guard lock(mu_);
+    options_ = std::move(options);
+
+    std::error_code ec;
+    fs::create_directories(options_.dir, ec);
+
+    std::vector<uint32_t> numbers;
+    for (auto& entry : fs::directory_iterator(options_.dir, ec)) {
+        if (entry.path().extension() != ".pcm") continue;
+        auto stem = entry.path().stem().string();
+        uint32_t n = 0;
+        auto [end, err] = std::from_chars(stem.data(), stem.data() + stem.size(), n);
+        if (err == std::errc{} && end == stem.data() + stem.size()) numbers.push_back(n);
+    }
+    if (ec) {
+        std::println(stderr, "archive: cannot read {}: {}", options_.dir, ec.message());
+        return false;
+    }
+    std::ranges::sort(numbers);
+
+    for (uint32_t n : numbers) load_segment(n);
+
+    // Keep appending to the newest segment.
+    bool ok = segments_.empty() ? start_segment(1) : open_files(segments_.back().number);
+    if (!ok) return false;
+    // The limit may have been lowered since the last run.
+    enforce_retention();
+    return true;
+}
+
+bool MmapAudioArchive::load_segment(uint32_t number) {
+    struct stat st{};
+    if (::stat(path(number, "pcm").c_str(), &st) < 0) return false;
+
+    Segment seg{.number = number, .bytes = static_cast<uint64_t>(st.st_size)};
+
+    int fd = ::open(path(number, "idx").c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd >= 0) {
+        IndexRecord rec;
+        // A crash between the two writes leaves a record (or samples) without
+        // the other half; such records are dropped.
+        while (::read(fd, &rec, sizeof(rec)) == static_cast<ssize_t>(sizeof(rec))) {
+            if (rec.offset + rec.samples * sizeof(int16_t) > seg.bytes) break;
+            seg.clips.push_back(rec);
+            last_id_ = std::max(last_id_, rec.id);
+        }
+        ::close(fd);
+        // Cut what was dropped, so appended records line up again.
+        [[maybe_unused]] int rc =
+            ::truncate(path(number, "idx").c_str(), static_cast<off_t>(seg.clips.size() * sizeof(rec)));
+    }
+
+    total_bytes_ += seg.bytes;
+    segments_.push_back(std::move(seg));
+    return true;
+}
+
+bool MmapAudioArchive::start_segment(uint32_t number) {
+    if (!open_files(number)) return false;
+    segments_.push_back(Segment{.number = number});
+    return true;
+}
+
+bool MmapAudioArchive::open_files(uint32_t number) {
+    close_segment();
+
+    data_fd_ = ::open(path(number, "pcm").c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0600);
+    index_fd_ = ::open(path(number, "idx").c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0600);
+    if (data_fd_ < 0 || index_fd_ < 0) {
+        std::println(stderr, "archive: cannot open segment {}: {}", number, std::strerror(errno));
+        close_segment();
+        return false;
+    }
+    return true;
+}
+
+void MmapAudioArchive::close_segment() {
+    if (data_fd_ >= 0) { ::close(data_fd_); data_fd_ = -1; }
+    if (index_fd_ >= 0) { ::close(index_fd_); index_fd_ = -1; }
+}
+
+uint64_t MmapAudioArchive::append(std::span<const int16_t> samples, uint32_t sample_rate) {
+    if (samples.empty()) return 0;
+    std::lock_guard lock(mu_);
+    if (data_fd_ < 0) return 0;
+
+    uint64_t bytes = samples.size_bytes();
+    if (segments_.back().bytes > 0 && segments_.back().bytes + bytes > options_.segment_bytes) {
+        if (!start_segment(segments_.back().number + 1)) return 0;
+    }
+
+    auto& seg = segments_.back();
+    IndexRecord rec{
+        .id = std::max(now_us(), last_id_ + 1),
+        .offset = seg.bytes,
+        .samples = samples.size(),
+        .sample_rate = sample_rate,
+        .reserved = 0,
+    };
+
+    // Samples first: an index record is only written for data that is there.
+    if (!write_all(data_fd_, samples.data(), bytes)) {
+        std::println(stderr, "archive: write failed: {}", std::strerror(errno));
+        [[maybe_unused]] int rc = ::ftruncate(data_fd_, static_cast<off_t>(seg.bytes));
+        return 0;
+    }
+    seg.bytes += bytes;
+    total_bytes_ += bytes;
+    if (!write_all(index_fd_, &rec, sizeof(rec))) {
+        std::println(stderr, "archive: index write failed: {}", std::strerror(errno));
+        return 0;
+    }
+    seg.clips.push_back(rec);
+    last_id_ = rec.id;
+
+    enforce_retention();
+    return rec.id;
+}
+
+std::optional<AudioClip> MmapAudioArchive::clip(uint64_t id) {
+    std::lock_guard lock(mu_);
+
+    // Ids ascend across segments as well as within them, and there are only
+    // ever a few segments.
+    auto seg = std::ranges::find_if(segments_.rbegin(), segments_.rend(), [id](const Segment& s) {
+        return !s.clips.empty() && s.clips.front().id <= id;
+    });
+    if (seg == segments_.rend()) return std::nullopt;
+    auto rec = std::ranges::lower_bound(seg->clips, id, {}, &IndexRecord::id);
+    if (rec == seg->clips.end() || rec->id != id) return std::nullopt;
+
+    int fd = ::open(path(seg->number, "pcm").c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return std::nullopt;
+
+    // mmap offsets have to be page aligned; the clip starts `lead` bytes in.
+    static const uint64_t page = static_cast<uint64_t>(::sysconf(_SC_PAGESIZE));
+    uint64_t start = rec->offset / page * page;
+    uint64_t lead = rec->offset - start;
+    size_t length = lead + rec->samples * sizeof(int16_t);
+
+    void* base = ::mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, static_cast<off_t>(start));
+    ::close(fd);
+    if (base == MAP_FAILED) return std::nullopt;
+    // It's about to be read in full, for the upload.
+    ::madvise(base, length, MADV_WILLNEED);
+
+    std::shared_ptr<const void> storage(base, [length](const void* p) {
+        ::munmap(const_cast<void*>(p), length);
+    });
+    auto* data = reinterpret_cast<const int16_t*>(static_cast<const char*>(base) + lead);
+    return AudioClip{
+        .samples = std::span(data, rec->samples),
+        .sample_rate = rec->sample_rate,
+        .storage = std::move(storage),
+    };
+}
+
+void MmapAudioArchive::enforce_retention() {
+    // A clip that is mapped right now stays readable: unlinking only drops
+    // the name, the mapping keeps the file.
+    while (total_bytes_ > options_.max_bytes && segments_.size() > 1) {
+        auto& oldest = segments_.front();
+        std::error_code ec;
+        fs::remove(path(oldest.number, "pcm"), ec);
+        fs::remove(path(oldest.number, "idx"), ec);
+        total_bytes_ -= oldest.bytes;
+        segments_.pop_front();
+    }
+}
+
+uint64_t MmapAudioArchive::size_bytes() const {
+    std::lock_guard lock(mu_);
+    return total_bytes_;
+}
+
+size_t MmapAudioArchive::segment_count() const {
+    std::lock_guard lock(mu_);
+    return segments_.size();
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "platform/audio_archive.hpp"
+
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Append-only PCM store in numbered segment files under one directory.
+// NNNNNNNN.pcm holds the samples of consecutive clips back to back and
+// NNNNNNNN.idx a fixed-size record (id, offset, length, rate) per clip.
+// clip() maps just the pages of one clip, so replay hands the samples to
+// the backend straight from the page cache.
+//
+// Retention works on whole segments: once the total passes max_bytes the
+// oldest segments are deleted, always keeping the one being written.
+class MmapAudioArchive : public AudioArchive {
+public:
+    struct Options {
+        std::string dir;
+        uint64_t max_bytes = 1024ull << 20;
+        uint64_t segment_bytes = 64ull << 20;
+    };
+
+    MmapAudioArchive();
+    ~MmapAudioArchive() override;
+
+    MmapAudioArchive(const MmapAudioArchive&) = delete;
+    MmapAudioArchive& operator=(const MmapAudioArchive&) = delete;
+
+    // Creates the directory if needed and loads the existing segments.
+    bool open(Options options);
+    bool is_open() const { return data_fd_ >= 0; }
+
+    uint64_t append(std::span<const int16_t> samples, uint32_t sample_rate) override;
+    std::optional<AudioClip> clip(uint64_t id) override;
+
+    uint64_t size_bytes() const;
+    size_t segment_count() const;
+
+private:
+    // On-disk index record, native byte order.
+    struct IndexRecord {
+        uint64_t id;
+        uint64_t offset;   // bytes into the segment's .pcm
+        uint64_t samples;
+        uint32_t sample_rate;
+        uint32_t reserved;
+    };
+    static_assert(sizeof(IndexRecord) == 32);
+
+    struct Segment {
+        uint32_t number = 0;
+        uint64_t bytes = 0;  // size of the .pcm
+        std::vector<IndexRecord> clips;  // ascending id
+    };
+
+    std::string path(uint32_t number, const char* ext) const;
+    bool load_segment(uint32_t number);
+    bool start_segment(uint32_t number);
+    bool open_files(uint32_t number);
+    void close_segment();
+    void enforce_retention();
+
+    Options options_;
+    mutable std::mutex mu_;
+    std::deque<Segment> segments_;  // oldest first; back() is being written
+    uint64_t total_bytes_ = 0;
+    uint64_t last_id_ = 0;
+    int data_fd_ = -1;
+    int index_fd_ = -1;
+};
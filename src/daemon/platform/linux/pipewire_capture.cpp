@@ -1,22 +1,51 @@
 #include "platform/linux/pipewire_capture.hpp"
 
+#include "platform/cpu_affinity.hpp"
+
+#include <algorithm>
+#include <chrono>
 #include <print>
 #include <spa/param/audio/format-utils.h>
 #include <spa/utils/result.h>
 
-PipeWireCapture::PipeWireCapture(RingBuffer& ring_buf, uint32_t sample_rate)
-    : ring_buf_(ring_buf), sample_rate_(sample_rate) {
-    pw_init(nullptr, nullptr);
+namespace {
+
+// Native mode: the converter empties the raw queue this often, this many
+// frames at a time.
+constexpr auto CONVERT_INTERVAL = std::chrono::milliseconds(5);
+constexpr size_t CONVERT_FRAMES = 4096;
+
+// Single-writer counter update: no locked instruction on the RT thread.
+template <typename T>
+void bump(std::atomic<T>& counter, T n) {
+    counter.store(counter.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
 }
 
+} // namespace
+
+PipeWireCapture::PipeWireCapture(RingBuffer& ring_buf, uint32_t sample_rate, uint32_t quantum,
+                                 bool native, CapturePlacement placement)
+    : ring_buf_(ring_buf), sample_rate_(sample_rate), quantum_(quantum), native_(native),
+      placement_(std::move(placement)),
+      raw_ring_(native ? RAW_RING_BYTES : 0, RingBuffer::DEFAULT_CHUNK_BYTES, placement_.raw_storage) {}
+
 PipeWireCapture::~PipeWireCapture() {
     stop();
-    pw_deinit();
+    if (pw_initialized_) pw_deinit();
 }
 
 bool PipeWireCapture::start() {
     if (capturing_.load(std::memory_order_relaxed)) return true;
 
+    // Loads PipeWire's support plugins: left to the first recording (or to
+    // arming) rather than done while the daemon starts.
+    if (!pw_initialized_) {
+        pw_init(nullptr, nullptr);
+        pw_initialized_ = true;
+    }
+
+    // Each capture gets a new thread loop, and so new threads to pin.
+    pin_pending_ = !placement_.cpus.empty();
     loop_ = pw_thread_loop_new("speak-anywhere", nullptr);
     if (!loop_) {
         std::println(stderr, "audio: failed to create thread loop");
@@ -31,6 +60,9 @@ bool PipeWireCapture::start() {
         PW_KEY_APP_NAME, "speak-anywhere",
         nullptr
     );
+    if (quantum_ > 0) {
+        pw_properties_setf(props, PW_KEY_NODE_LATENCY, "%u/%u", quantum_, sample_rate_);
+    }
 
     stream_ = pw_stream_new_simple(
         pw_thread_loop_get_loop(loop_),
@@ -47,14 +79,17 @@ bool PipeWireCapture::start() {
         return false;
     }
 
-    // Build format params: S16_LE, mono, 16kHz
+    // Build format params: S16_LE, mono, 16kHz; or, native, float at
+    // whatever rate and channels the source has (left out of the pod).
     uint8_t buf[1024];
     spa_pod_builder b = SPA_POD_BUILDER_INIT(buf, sizeof(buf));
-    auto info = SPA_AUDIO_INFO_RAW_INIT(
-        .format = SPA_AUDIO_FORMAT_S16_LE,
-        .rate = sample_rate_,
-        .channels = 1
-    );
+    auto info = native_
+        ? SPA_AUDIO_INFO_RAW_INIT(.format = SPA_AUDIO_FORMAT_F32)
+        : SPA_AUDIO_INFO_RAW_INIT(
+              .format = SPA_AUDIO_FORMAT_S16_LE,
+              .rate = sample_rate_,
+              .channels = 1
+          );
     const spa_pod* params[1];
     params[0] = spa_format_audio_raw_build(&b, SPA_PARAM_EnumFormat, &info);
 
@@ -88,6 +123,11 @@ bool PipeWireCapture::start() {
     }
 
     ring_buf_.reset();
+    if (native_) {
+        raw_ring_.reset();
+        resampler_.reset();
+        converter_ = std::jthread([this](std::stop_token stop) { convert_loop(stop); });
+    }
     capturing_.store(true, std::memory_order_release);
     return true;
 }
@@ -108,16 +148,61 @@ void PipeWireCapture::stop() {
         pw_thread_loop_destroy(loop_);
         loop_ = nullptr;
     }
+    // The callback can't run any more; converting what it left is the last
+    // step, so the consumer sees every sample once stop() returns.
+    converter_ = {};
+}
+
+void PipeWireCapture::convert_loop(std::stop_token stop) {
+    if (!placement_.cpus.empty()) pin(platform::pin_current_thread(placement_.cpus).has_value());
+    while (!stop.stop_requested()) {
+        convert_pending();
+        std::this_thread::sleep_for(CONVERT_INTERVAL);
+    }
+    convert_pending();
+}
+
+void PipeWireCapture::convert_pending() {
+    uint32_t rate = format_rate_.load(std::memory_order_acquire);
+    uint32_t channels = format_channels_.load(std::memory_order_acquire);
+    if (rate == 0 || channels == 0) return;
+    if (!resampler_ || resampler_->in_rate() != rate || resampler_->channels() != channels) {
+        resampler_.emplace(rate, sample_rate_, channels);
+    }
+
+    size_t frame_bytes = channels * sizeof(float);
+    while (size_t frames = std::min(raw_ring_.available() / frame_bytes, CONVERT_FRAMES)) {
+        convert_in_.resize(frames * channels);
+        raw_ring_.read(convert_in_.data(), frames * frame_bytes);
+        convert_out_.clear();
+        resampler_->process(convert_in_, convert_out_);
+        // Overflow here is counted by the ring buffer itself.
+        ring_buf_.write(convert_out_.data(), convert_out_.size() * sizeof(int16_t));
+    }
 }
 
 void PipeWireCapture::on_process(void* userdata) {
     auto* self = static_cast<PipeWireCapture*>(userdata);
+    auto& counters = self->counters_;
+    // steady_clock is a vDSO read: no syscall, no lock, fine on the RT thread.
+    auto begin = std::chrono::steady_clock::now();
+
+    // One syscall on the first callback of a capture, before its timing starts.
+    if (self->pin_pending_) {
+        self->pin_pending_ = false;
+        self->pin(platform::pin_current_thread(self->placement_.cpus).has_value());
+        begin = std::chrono::steady_clock::now();
+    }
 
     auto* buf = pw_stream_dequeue_buffer(self->stream_);
-    if (!buf) return;
+    if (!buf) {
+        if (self->capturing_.load(std::memory_order_relaxed)) bump(counters.underruns, uint64_t{1});
+        return;
+    }
 
     auto* d = &buf->buffer->datas[0];
-    if (!d->data) {
+    if (!d->data || d->chunk->size == 0) {
+        if (self->capturing_.load(std::memory_order_relaxed)) bump(counters.underruns, uint64_t{1});
         pw_stream_queue_buffer(self->stream_, buf);
         return;
     }
@@ -126,10 +211,72 @@ void PipeWireCapture::on_process(void* userdata) {
     size_t size = d->chunk->size;
 
     if (self->capturing_.load(std::memory_order_relaxed)) {
-        self->ring_buf_.write(data, size);
+        size_t frame_bytes = sizeof(int16_t);
+        size_t written;
+        if (self->native_) {
+            frame_bytes = sizeof(float) * std::max<uint32_t>(1, self->format_channels_.load(std::memory_order_relaxed));
+            written = self->raw_ring_.write(data, size);
+        } else {
+            written = self->ring_buf_.write(data, size);
+        }
+        bump(counters.callbacks, uint64_t{1});
+        bump(counters.bytes, uint64_t{written});
+        if (written < size) bump(counters.dropped_bytes, uint64_t{size - written});
+        counters.quantum.store(static_cast<uint32_t>(size / frame_bytes), std::memory_order_relaxed);
     }
 
     pw_stream_queue_buffer(self->stream_, buf);
+
+    if (self->capturing_.load(std::memory_order_relaxed)) {
+        auto ns = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - begin).count());
+        bump(counters.callback_ns_total, ns);
+        if (ns > counters.callback_ns_max.load(std::memory_order_relaxed)) {
+            counters.callback_ns_max.store(ns, std::memory_order_relaxed);
+        }
+    }
+}
+
+CaptureStats PipeWireCapture::stats() const {
+    CaptureStats s{
+        .callbacks = counters_.callbacks.load(std::memory_order_relaxed),
+        .bytes = counters_.bytes.load(std::memory_order_relaxed),
+        .dropped_bytes = counters_.dropped_bytes.load(std::memory_order_relaxed),
+        .underruns = counters_.underruns.load(std::memory_order_relaxed),
+        .quantum = counters_.quantum.load(std::memory_order_relaxed),
+        .callback_max_us = static_cast<double>(counters_.callback_ns_max.load(std::memory_order_relaxed)) / 1e3,
+    };
+    if (s.callbacks > 0) {
+        s.callback_avg_us = static_cast<double>(counters_.callback_ns_total.load(std::memory_order_relaxed)) /
+                            1e3 / static_cast<double>(s.callbacks);
+    }
+    if (auto* memory = placement_.memory; memory && memory->locked()) {
+        s.locked_bytes = memory->data().size();
+    }
+    s.hugepages = placement_.memory && placement_.memory->hugepages();
+    if (pinned_.load(std::memory_order_relaxed) && !pin_failed_.load(std::memory_order_relaxed)) {
+        s.cpus = placement_.cpus;
+    }
+    return s;
+}
+
+void PipeWireCapture::pin(bool ok) {
+    if (ok) pinned_.store(true, std::memory_order_relaxed);
+    else pin_failed_.store(true, std::memory_order_relaxed);
+}
+
+void PipeWireCapture::on_param_changed(void* userdata, uint32_t id, const spa_pod* param) {
+    auto* self = static_cast<PipeWireCapture*>(userdata);
+    if (!param || id != SPA_PARAM_Format) return;
+
+    spa_audio_info_raw info{};
+    if (spa_format_audio_raw_parse(param, &info) < 0) return;
+    self->format_channels_.store(info.channels, std::memory_order_release);
+    self->format_rate_.store(info.rate, std::memory_order_release);
+    if (self->native_) {
+        std::println(stderr, "audio: capturing {} Hz, {} channel(s), converting to {} Hz mono",
+                     info.rate, info.channels, self->sample_rate_);
+    }
 }
 
 void PipeWireCapture::on_state_changed(void* /*userdata*/, enum pw_stream_state old,
@@ -1,16 +1,38 @@
 #pragma once
 
+#include "audio/resampler.hpp"
+#include "platform/linux/locked_memory.hpp"
 #include "platform/audio_capture.hpp"
 #include "ring_buffer.hpp"
 
 #include <atomic>
 #include <cstdint>
+#include <optional>
+#include <span>
 #include <pipewire/pipewire.h>
 #include <spa/param/audio/format-utils.h>
+#include <stop_token>
+#include <thread>
+#include <vector>
+
+// Where the capture path runs (audio.lock_memory, audio.cpus).
+struct CapturePlacement {
+    const LockedMemory* memory = nullptr;  // the ring buffers' storage, for stats()
+    std::span<uint8_t> raw_storage;        // native mode's queue preallocated here
+    std::vector<int> cpus;                 // the callback and converter threads
+};
 
 class PipeWireCapture : public AudioCapture {
 public:
-    explicit PipeWireCapture(RingBuffer& ring_buf, uint32_t sample_rate = 16000);
+    // Native mode's queue: about 10 s of 48 kHz stereo float.
+    static constexpr size_t RAW_RING_BYTES = 4 << 20;
+
+    // quantum asks the graph for that many frames per callback (node
+    // latency); 0 leaves it to the server. native takes the device's own rate
+    // and channels as float and converts on a thread of ours instead of
+    // having PipeWire insert a converter.
+    explicit PipeWireCapture(RingBuffer& ring_buf, uint32_t sample_rate = 16000,
+                             uint32_t quantum = 0, bool native = false, CapturePlacement placement = {});
     ~PipeWireCapture() override;
 
     PipeWireCapture(const PipeWireCapture&) = delete;
@@ -19,22 +41,66 @@ public:
     bool start() override;
     void stop() override;
     bool is_capturing() const override { return capturing_.load(std::memory_order_relaxed); }
+    CaptureStats stats() const override;
 
 private:
     static void on_process(void* userdata);
     static void on_state_changed(void* userdata, enum pw_stream_state old,
                                  enum pw_stream_state state, const char* error);
+    static void on_param_changed(void* userdata, uint32_t id, const spa_pod* param);
+
+    // Native mode: moves what the callback queued in raw_ring_ through the
+    // resampler into ring_buf_, until stopped and drained.
+    void convert_loop(std::stop_token stop);
+    void convert_pending();
+    // Records whether a capture thread could be pinned to placement_.cpus.
+    void pin(bool ok);
 
     RingBuffer& ring_buf_;
     uint32_t sample_rate_;
+    uint32_t quantum_;
+    bool native_;
+    CapturePlacement placement_;
     std::atomic<bool> capturing_{false};
+    // Set by start() for the callback to pin its thread on its first run:
+    // which thread that is only shows there. pinned_ is set once a thread
+    // was, and stays off for good if one could not be.
+    bool pin_pending_ = false;
+    std::atomic<bool> pinned_{false};
+    std::atomic<bool> pin_failed_{false};
+
+    // Negotiated format, set by on_param_changed.
+    std::atomic<uint32_t> format_rate_{0};
+    std::atomic<uint32_t> format_channels_{0};
+
+    // Native mode only: interleaved float frames at the device rate, and
+    // the converter's state (used on its thread alone).
+    RingBuffer raw_ring_;
+    std::optional<Resampler> resampler_;
+    std::vector<float> convert_in_;
+    std::vector<int16_t> convert_out_;
+    std::jthread converter_;
+
+    // Written only by the process callback (so plain load/store, no RMW),
+    // read by stats() from the main thread.
+    struct alignas(64) Counters {
+        std::atomic<uint64_t> callbacks{0};
+        std::atomic<uint64_t> bytes{0};
+        std::atomic<uint64_t> dropped_bytes{0};
+        std::atomic<uint64_t> underruns{0};
+        std::atomic<uint32_t> quantum{0};
+        std::atomic<uint64_t> callback_ns_total{0};
+        std::atomic<uint64_t> callback_ns_max{0};
+    } counters_;
 
+    bool pw_initialized_ = false;  // pw_init() on the first start()
     pw_thread_loop* loop_ = nullptr;
     pw_stream* stream_ = nullptr;
 
     static constexpr pw_stream_events stream_events_ = {
         .version = PW_VERSION_STREAM_EVENTS,
         .state_changed = on_state_changed,
+        .param_changed = on_param_changed,
         .process = on_process,
     };
 };
@@ -0,0 +1,231 @@
+#include "platform/linux/proc_event_tracker.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <cstring>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <linux/cn_proc.h>
+#include <linux/connector.h>
+#include <linux/netlink.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// How long start() waits for the kernel to acknowledge the subscription.
+constexpr int SUBSCRIBE_TIMEOUT_MS = 1000;
+
+std::string read_comm(int pid) {
+    std::ifstream f(std::format("/proc/{}/comm", pid));
+    std::string comm;
+    if (f.is_open()) std::getline(f, comm);
+    return comm;
+}
+
+// /proc/<pid>/stat is "pid (comm) state ppid ..."; comm may contain spaces
+// and parens, so it ends at the last ')'.
+bool read_stat(int pid, int& ppid, std::string& comm) {
+    std::ifstream f(std::format("/proc/{}/stat", pid));
+    if (!f.is_open()) return false;
+    std::string stat;
+    std::getline(f, stat);
+
+    auto open = stat.find('(');
+    auto close = stat.rfind(')');
+    if (open == std::string::npos || close == std::string::npos || close + 4 >= stat.size()) {
+        return false;
+    }
+    comm = stat.substr(open + 1, close - open - 1);
+
+    const char* p = stat.data() + close + 4;  // past ") S "
+    return std::from_chars(p, stat.data() + stat.size(), ppid).ec == std::errc{};
+}
+
+} // namespace
+
+ProcEventTracker::ProcEventTracker() = default;
+
+ProcEventTracker::~ProcEventTracker() {
+    if (fd_ >= 0) ::close(fd_);
+}
+
+bool ProcEventTracker::start() {
+    fd_ = ::socket(AF_NETLINK, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, NETLINK_CONNECTOR);
+    if (fd_ < 0) return false;
+
+    sockaddr_nl addr{};
+    addr.nl_family = AF_NETLINK;
+    addr.nl_groups = CN_IDX_PROC;
+    if (::bind(fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 || !subscribe()) {
+        ::close(fd_);
+        fd_ = -1;
+        return false;
+    }
+
+    // Subscribed first, so nothing that happens during the scan is missed.
+    rescan();
+    return true;
+}
+
+bool ProcEventTracker::subscribe() {
+    // nlmsghdr, then cn_msg, whose flexible data member holds the op.
+    constexpr size_t size = NLMSG_LENGTH(sizeof(cn_msg) + sizeof(proc_cn_mcast_op));
+    alignas(nlmsghdr) char request[NLMSG_SPACE(size)] = {};
+
+    auto* header = reinterpret_cast<nlmsghdr*>(request);
+    header->nlmsg_len = size;
+    header->nlmsg_type = NLMSG_DONE;
+    auto* msg = static_cast<cn_msg*>(NLMSG_DATA(header));
+    msg->id = {.idx = CN_IDX_PROC, .val = CN_VAL_PROC};
+    msg->len = sizeof(proc_cn_mcast_op);
+    auto op = PROC_CN_MCAST_LISTEN;
+    std::memcpy(msg->data, &op, sizeof(op));
+    if (::send(fd_, request, size, 0) < 0) return false;
+
+    // The kernel answers with an ack event carrying the result; process
+    // events may already be queued ahead of it.
+    alignas(nlmsghdr) char buf[4096];
+    for (;;) {
+        pollfd pfd{.fd = fd_, .events = POLLIN};
+        if (::poll(&pfd, 1, SUBSCRIBE_TIMEOUT_MS) <= 0) return false;
+
+        ssize_t n = ::recv(fd_, buf, sizeof(buf), 0);
+        if (n < 0) {
+            if (errno == EINTR || errno == EAGAIN) continue;
+            return false;
+        }
+
+        auto len = static_cast<unsigned>(n);
+        for (auto* h = reinterpret_cast<nlmsghdr*>(buf); NLMSG_OK(h, len); h = NLMSG_NEXT(h, len)) {
+            auto* msg = static_cast<cn_msg*>(NLMSG_DATA(h));
+            auto* ev = reinterpret_cast<proc_event*>(msg->data);
+            if (ev->what == proc_event::PROC_EVENT_NONE) return ev->event_data.ack.err == 0;
+        }
+    }
+}
+
+bool ProcEventTracker::read_events() {
+    alignas(nlmsghdr) char buf[16384];
+    for (;;) {
+        ssize_t n = ::recv(fd_, buf, sizeof(buf), 0);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN) return true;
+            if (errno == ENOBUFS) {
+                // Events were dropped: the index can't be patched, rebuild it.
+                rescan();
+                continue;
+            }
+            ::close(fd_);
+            fd_ = -1;
+            processes_.clear();
+            return false;
+        }
+
+        auto len = static_cast<unsigned>(n);
+        for (auto* h = reinterpret_cast<nlmsghdr*>(buf); NLMSG_OK(h, len); h = NLMSG_NEXT(h, len)) {
+            if (h->nlmsg_type != NLMSG_DONE) continue;
+            auto* msg = static_cast<cn_msg*>(NLMSG_DATA(h));
+            if (msg->id.idx != CN_IDX_PROC || msg->id.val != CN_VAL_PROC) continue;
+            auto* ev = reinterpret_cast<proc_event*>(msg->data);
+
+            // Only whole processes are indexed; events of other threads are
+            // skipped (pid != tgid).
+            switch (ev->what) {
+                case proc_event::PROC_EVENT_FORK: {
+                    auto& fork = ev->event_data.fork;
+                    if (fork.child_pid != fork.child_tgid) break;
+                    add(fork.child_tgid, fork.parent_tgid, comm(fork.parent_tgid));
+                    break;
+                }
+                case proc_event::PROC_EVENT_EXEC: {
+                    // The event carries no name; it's the one read this takes.
+                    int pid = ev->event_data.exec.process_tgid;
+                    if (auto it = processes_.find(pid); it != processes_.end()) {
+                        it->second.comm = read_comm(pid);
+                    }
+                    break;
+                }
+                case proc_event::PROC_EVENT_COMM: {
+                    auto& c = ev->event_data.comm;
+                    if (c.process_pid != c.process_tgid) break;
+                    if (auto it = processes_.find(c.process_tgid); it != processes_.end()) {
+                        it->second.comm.assign(c.comm, ::strnlen(c.comm, sizeof(c.comm)));
+                    }
+                    break;
+                }
+                case proc_event::PROC_EVENT_EXIT: {
+                    auto& exit = ev->event_data.exit;
+                    if (exit.process_pid == exit.process_tgid) remove(exit.process_tgid);
+                    break;
+                }
+                default:
+                    break;
+            }
+        }
+    }
+}
+
+const std::vector<int>* ProcEventTracker::children(int pid) const {
+    auto it = processes_.find(pid);
+    return it != processes_.end() ? &it->second.children : nullptr;
+}
+
+const std::string& ProcEventTracker::comm(int pid) const {
+    static const std::string unknown;
+    auto it = processes_.find(pid);
+    return it != processes_.end() ? it->second.comm : unknown;
+}
+
+void ProcEventTracker::rescan() {
+    processes_.clear();
+
+    std::error_code ec;
+    for (auto& entry : fs::directory_iterator("/proc", ec)) {
+        auto name = entry.path().filename().string();
+        int pid = 0;
+        auto [end, err] = std::from_chars(name.data(), name.data() + name.size(), pid);
+        if (err != std::errc{} || end != name.data() + name.size()) continue;
+
+        Process proc;
+        if (read_stat(pid, proc.ppid, proc.comm)) processes_.emplace(pid, std::move(proc));
+    }
+
+    // Parents can come after their children in the listing, so link afterwards.
+    for (auto& [pid, proc] : processes_) {
+        if (auto it = processes_.find(proc.ppid); it != processes_.end()) {
+            it->second.children.push_back(pid);
+        }
+    }
+    for (auto& [pid, proc] : processes_) {
+        std::ranges::sort(proc.children);
+    }
+}
+
+void ProcEventTracker::add(int pid, int ppid, std::string comm) {
+    // A pid whose exit was never seen is being reused; drop the stale entry.
+    if (processes_.contains(pid)) remove(pid);
+
+    processes_[pid] = Process{.ppid = ppid, .comm = std::move(comm)};
+    if (auto it = processes_.find(ppid); it != processes_.end()) {
+        it->second.children.push_back(pid);
+    }
+}
+
+void ProcEventTracker::remove(int pid) {
+    auto it = processes_.find(pid);
+    if (it == processes_.end()) return;
+
+    if (auto parent = processes_.find(it->second.ppid); parent != processes_.end()) {
+        std::erase(parent->second.children, pid);
+    }
+    // Orphans get reparented without an event; they are simply no longer
+    // reachable from here.
+    processes_.erase(it);
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// In-memory process tree kept current by the netlink proc connector, so agent
+// detection can walk it without touching /proc.
+//
+// start() indexes /proc once and subscribes to fork/exec/comm/exit events;
+// the event loop polls fd() and calls read_events() when it's readable.
+// Subscribing needs CAP_NET_ADMIN, so for an ordinary user session start()
+// usually fails and detection falls back to reading /proc.
+class ProcEventTracker {
+public:
+    ProcEventTracker();
+    ~ProcEventTracker();
+
+    ProcEventTracker(const ProcEventTracker&) = delete;
+    ProcEventTracker& operator=(const ProcEventTracker&) = delete;
+
+    bool start();
+    bool active() const { return fd_ >= 0; }
+    int fd() const { return fd_; }
+
+    // Applies every queued event. When the socket overflowed and events were
+    // lost, the index is rebuilt from /proc. False if the socket failed.
+    bool read_events();
+
+    // Child processes of pid (threads are folded into their process), or
+    // nullptr if pid isn't known.
+    const std::vector<int>* children(int pid) const;
+    // Empty if pid isn't known.
+    const std::string& comm(int pid) const;
+
+    size_t process_count() const { return processes_.size(); }
+
+private:
+    struct Process {
+        int ppid = 0;
+        std::string comm;
+        std::vector<int> children;
+    };
+
+    bool subscribe();
+    void rescan();
+    void add(int pid, int ppid, std::string comm);
+    void remove(int pid);
+
+    int fd_ = -1;
+    std::unordered_map<int, Process> processes_;
+};
@@ -1,23 +1,107 @@
 #include "platform/linux/procfs_detector.hpp"
 
+#include "platform/linux/proc_event_tracker.hpp"
+
 #include <algorithm>
 #include <filesystem>
 #include <format>
 #include <fstream>
+#include <sstream>
+#include <utility>
 
 namespace fs = std::filesystem;
 
+namespace {
+
+// Enough for every window of a session; the map is only cleared past it.
+constexpr size_t MAX_CACHED = 64;
+
+// The tracker's tree is patched from events; don't trust it to be acyclic.
+constexpr int MAX_DEPTH = 256;
+
+} // namespace
+
 ProcfsDetector::ProcfsDetector(std::vector<std::string> known_agents)
-    : known_agents_(std::move(known_agents)) {}
+    : known_agents_(std::make_shared<const std::vector<std::string>>(std::move(known_agents))),
+      refresher_([this](std::stop_token stop) { refresh_loop(stop); }) {}
 
 DetectionResult ProcfsDetector::detect(int pid) const {
     if (pid <= 0) return {};
 
+    if (tracker_ && tracker_->active()) {
+        DetectionResult result;
+        search_index(pid, result);
+        return result;
+    }
+
+    auto start_time = read_start_time(pid);
+    if (!start_time) return {};
+
+    {
+        std::lock_guard lock(mu_);
+        auto it = cache_.find(pid);
+        if (it != cache_.end() && it->second.start_time == *start_time) {
+            auto result = it->second.result;
+            refresh_pid_ = pid;
+            refresh_cv_.notify_one();
+            return result;
+        }
+    }
+
+    auto result = scan(pid);
+    store(pid, *start_time, result);
+    return result;
+}
+
+void ProcfsDetector::prefetch(int pid) {
+    if (tracker_ && tracker_->active()) return;
+    if (pid > 0) request_refresh(pid);
+}
+
+void ProcfsDetector::set_agents(std::vector<std::string> agents) {
+    known_agents_.store(std::make_shared<const std::vector<std::string>>(std::move(agents)));
+    // What was found with the old list may not be an agent any more.
+    std::lock_guard lock(mu_);
+    cache_.clear();
+}
+
+DetectionResult ProcfsDetector::scan(int pid) const {
+    if (pid <= 0) return {};
+
     DetectionResult result;
     search_tree(pid, result);
     return result;
 }
 
+void ProcfsDetector::request_refresh(int pid) const {
+    {
+        std::lock_guard lock(mu_);
+        refresh_pid_ = pid;
+    }
+    refresh_cv_.notify_one();
+}
+
+void ProcfsDetector::store(int pid, uint64_t start_time, const DetectionResult& result) const {
+    std::lock_guard lock(mu_);
+    if (cache_.size() >= MAX_CACHED && !cache_.contains(pid)) cache_.clear();
+    cache_[pid] = CacheEntry{.start_time = start_time, .result = result};
+}
+
+void ProcfsDetector::refresh_loop(std::stop_token stop) {
+    std::unique_lock lock(mu_);
+    while (refresh_cv_.wait(lock, stop, [this] { return refresh_pid_ != 0; })) {
+        int pid = std::exchange(refresh_pid_, 0);
+        lock.unlock();
+
+        // A process that is gone has nothing to cache; its entry stays until
+        // the pid shows up again with another start time.
+        if (auto start_time = read_start_time(pid)) {
+            store(pid, *start_time, scan(pid));
+        }
+        lock.lock();
+    }
+}
+
 std::string ProcfsDetector::read_comm(int pid) {
     std::ifstream f(std::format("/proc/{}/comm", pid));
     if (!f.is_open()) return {};
@@ -33,6 +117,25 @@ std::string ProcfsDetector::read_cwd(int pid) {
     return path.string();
 }
 
+std::optional<uint64_t> ProcfsDetector::read_start_time(int pid) {
+    std::ifstream f(std::format("/proc/{}/stat", pid));
+    if (!f.is_open()) return std::nullopt;
+    std::string stat;
+    std::getline(f, stat);
+
+    // comm (field 2) may contain spaces and parens; count from its closing one.
+    auto close = stat.rfind(')');
+    if (close == std::string::npos) return std::nullopt;
+    std::istringstream fields(stat.substr(close + 1));
+
+    // starttime is field 22; fields 3..21 come first.
+    std::string skip;
+    for (int i = 3; i < 22; ++i) fields >> skip;
+    uint64_t start_time = 0;
+    if (!(fields >> start_time)) return std::nullopt;
+    return start_time;
+}
+
 std::vector<int> ProcfsDetector::get_children(int pid) {
     std::vector<int> children;
 
@@ -58,15 +161,35 @@ bool ProcfsDetector::search_tree(int pid, DetectionResult& result) const {
         auto comm = read_comm(child);
         if (comm.empty()) continue;
 
-        for (const auto& agent : known_agents_) {
-            if (comm.find(agent) != std::string::npos) {
-                result.agent = agent;
-                result.working_dir = read_cwd(child);
-                return true;
-            }
-        }
-
+        if (match_agent(child, comm, result)) return true;
         if (search_tree(child, result)) return true;
     }
     return false;
 }
+
+bool ProcfsDetector::search_index(int pid, DetectionResult& result, int depth) const {
+    auto* children = tracker_->children(pid);
+    if (!children || depth >= MAX_DEPTH) return false;
+
+    for (int child : *children) {
+        auto& comm = tracker_->comm(child);
+        if (comm.empty()) continue;
+
+        if (match_agent(child, comm, result)) return true;
+        if (search_index(child, result, depth + 1)) return true;
+    }
+    return false;
+}
+
+bool ProcfsDetector::match_agent(int pid, const std::string& comm, DetectionResult& result) const {
+    auto agents = known_agents_.load();
+    for (const auto& agent : *agents) {
+        if (comm.find(agent) != std::string::npos) {
+            result.agent = agent;
+            // Only read on a match; it changes too often to index.
+            result.working_dir = read_cwd(pid);
+            return true;
+        }
+    }
+    return false;
+}
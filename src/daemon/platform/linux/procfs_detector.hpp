@@ -2,20 +2,70 @@
 
 #include "platform/process_detector.hpp"
 
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stop_token>
 #include <string>
+#include <thread>
+#include <unordered_map>
 #include <vector>
 
+class ProcEventTracker;
+
+// Finds known agents among the descendants of a window's process.
+//
+// Walking /proc gets slow with big terminal or tmux trees, so results are
+// cached per process, keyed by pid and start time (which tells a reused pid
+// apart). prefetch() refreshes an entry on a background thread when focus
+// changes, and every cache hit schedules another refresh, so an agent started
+// after the window got focus is found by the next lookup.
+//
+// With an active ProcEventTracker none of that is needed: detect() walks the
+// tracker's in-memory tree on the calling (event loop) thread.
 class ProcfsDetector : public ProcessDetector {
 public:
     explicit ProcfsDetector(std::vector<std::string> known_agents);
 
     DetectionResult detect(int pid) const override;
+    void prefetch(int pid) override;
+    void set_agents(std::vector<std::string> agents) override;
+
+    // The uncached tree walk.
+    DetectionResult scan(int pid) const;
+
+    // Detects from tracker's process tree while it is active. The tracker
+    // must outlive the detector or be unset first.
+    void use_tracker(const ProcEventTracker* tracker) { tracker_ = tracker; }
 
 private:
+    struct CacheEntry {
+        uint64_t start_time = 0;
+        DetectionResult result;
+    };
+
     static std::string read_comm(int pid);
     static std::string read_cwd(int pid);
+    static std::optional<uint64_t> read_start_time(int pid);
     static std::vector<int> get_children(int pid);
     bool search_tree(int pid, DetectionResult& result) const;
+    bool search_index(int pid, DetectionResult& result, int depth = 0) const;
+    bool match_agent(int pid, const std::string& comm, DetectionResult& result) const;
+
+    void request_refresh(int pid) const;
+    void store(int pid, uint64_t start_time, const DetectionResult& result) const;
+    void refresh_loop(std::stop_token stop);
+
+    // Read by the refresh thread too: replaced whole, never changed in place.
+    std::atomic<std::shared_ptr<const std::vector<std::string>>> known_agents_;
+    const ProcEventTracker* tracker_ = nullptr;
 
-    std::vector<std::string> known_agents_;
+    mutable std::mutex mu_;
+    mutable std::condition_variable_any refresh_cv_;
+    mutable std::unordered_map<int, CacheEntry> cache_;
+    mutable int refresh_pid_ = 0;  // next pid for the background thread; 0: none
+    std::jthread refresher_;       // last: stopped before the members it uses go away
 };
@@ -1,5 +1,7 @@
 #include "platform/linux/sway_window_manager.hpp"
 
+#include "sway/focus_parser.hpp"
+
 #include <cerrno>
 #include <cstdlib>
 #include <cstring>
@@ -59,12 +61,7 @@ WindowInfo SwayWindowManager::get_focused_window() {
     std::string payload;
     if (!recv_message(query_fd_, type, payload)) return {};
 
-    try {
-        auto tree = nlohmann::json::parse(payload);
-        return find_focused(tree);
-    } catch (...) {
-        return {};
-    }
+    return sway::parse_focused_tree(payload);
 }
 
 bool SwayWindowManager::read_event(WindowInfo& info) {
@@ -76,24 +73,10 @@ bool SwayWindowManager::read_event(WindowInfo& info) {
 
     if (type != EVENT_WINDOW) return false;
 
-    try {
-        auto j = nlohmann::json::parse(payload);
-        auto change = j.value("change", "");
-        if (change != "focus") return false;
-
-        if (j.contains("container")) {
-            auto& c = j["container"];
-            info.app_id = c.value("app_id", "");
-            if (info.app_id.empty() && c.contains("window_properties")) {
-                info.window_class = c["window_properties"].value("class", "");
-            }
-            info.title = c.value("name", "");
-            info.pid = c.value("pid", 0);
-        }
-        return true;
-    } catch (...) {
-        return false;
-    }
+    auto focused = sway::parse_focus_event(payload);
+    if (!focused) return false;
+    info = std::move(*focused);
+    return true;
 }
 
 int SwayWindowManager::connect_socket(const std::string& path) {
@@ -152,30 +135,3 @@ bool SwayWindowManager::recv_message(int fd, uint32_t& type, std::string& payloa
 
     return true;
 }
-
-WindowInfo SwayWindowManager::find_focused(const nlohmann::json& node) {
-    if (node.value("focused", false)) {
-        WindowInfo info;
-        info.app_id = node.value("app_id", "");
-        if (info.app_id.empty() && node.contains("window_properties")) {
-            info.window_class = node["window_properties"].value("class", "");
-        }
-        info.title = node.value("name", "");
-        info.pid = node.value("pid", 0);
-        return info;
-    }
-
-    if (node.contains("nodes")) {
-        for (auto& child : node["nodes"]) {
-            auto info = find_focused(child);
-            if (!info.empty() || child.value("focused", false)) return info;
-        }
-    }
-    if (node.contains("floating_nodes")) {
-        for (auto& child : node["floating_nodes"]) {
-            auto info = find_focused(child);
-            if (!info.empty() || child.value("focused", false)) return info;
-        }
-    }
-    return {};
-}
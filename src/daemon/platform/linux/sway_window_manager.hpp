@@ -3,7 +3,6 @@
 #include "platform/window_manager.hpp"
 
 #include <cstdint>
-#include <nlohmann/json.hpp>
 #include <string>
 
 class SwayWindowManager : public WindowManager {
@@ -29,7 +28,6 @@ private:
     bool send_message(int fd, uint32_t type, const std::string& payload = "");
     bool recv_message(int fd, uint32_t& type, std::string& payload);
     int connect_socket(const std::string& path);
-    static WindowInfo find_focused(const nlohmann::json& node);
 
     int query_fd_ = -1;
     int event_fd_ = -1;
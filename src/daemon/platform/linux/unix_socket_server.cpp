@@ -1,13 +1,57 @@
 #include "platform/linux/unix_socket_server.hpp"
 
 #include <algorithm>
+#include <array>
 #include <cerrno>
+#include <cstdlib>
 #include <cstring>
+#include <fcntl.h>
 #include <print>
+#include <string_view>
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <sys/un.h>
 #include <unistd.h>
 
+namespace {
+
+// sd_listen_fds(3) without libsystemd: systemd passes sockets from fd 3 on
+// and names the process they are meant for in LISTEN_PID.
+constexpr int LISTEN_FDS_START = 3;
+
+// The listening socket systemd bound to `endpoint`, or -1 if there is none.
+// The variables are cleared either way so children don't pick them up.
+int listen_fd_from_systemd(const std::string& endpoint) {
+    const char* pid = std::getenv("LISTEN_PID");
+    const char* fds = std::getenv("LISTEN_FDS");
+    bool ours = pid && fds && std::atoi(pid) == ::getpid();
+    int count = ours ? std::atoi(fds) : 0;
+    ::unsetenv("LISTEN_PID");
+    ::unsetenv("LISTEN_FDS");
+    ::unsetenv("LISTEN_FDNAMES");
+
+    for (int fd = LISTEN_FDS_START; fd < LISTEN_FDS_START + count; ++fd) {
+        sockaddr_un addr{};
+        socklen_t len = sizeof(addr);
+        int listening = 0;
+        socklen_t opt_len = sizeof(listening);
+        if (::getsockname(fd, reinterpret_cast<sockaddr*>(&addr), &len) < 0 ||
+            addr.sun_family != AF_UNIX ||
+            ::getsockopt(fd, SOL_SOCKET, SO_ACCEPTCONN, &listening, &opt_len) < 0 || !listening) {
+            continue;
+        }
+        if (std::string_view(addr.sun_path) != endpoint) continue;
+
+        // Inherited as systemd set it up: blocking, and kept across exec.
+        ::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL) | O_NONBLOCK);
+        ::fcntl(fd, F_SETFD, FD_CLOEXEC);
+        return fd;
+    }
+    return -1;
+}
+
+} // namespace
+
 UnixSocketServer::UnixSocketServer() = default;
 
 UnixSocketServer::~UnixSocketServer() {
@@ -15,6 +59,15 @@ UnixSocketServer::~UnixSocketServer() {
 }
 
 bool UnixSocketServer::start(const std::string& endpoint) {
+    // Socket activation: systemd made and owns the socket, so it is neither
+    // unlinked here nor in stop(). Clients queued in it since are accepted
+    // as usual.
+    server_fd_ = listen_fd_from_systemd(endpoint);
+    if (server_fd_ >= 0) {
+        socket_activated_ = true;
+        return true;
+    }
+
     socket_path_ = endpoint;
 
     ::unlink(endpoint.c_str());
@@ -54,9 +107,10 @@ bool UnixSocketServer::start(const std::string& endpoint) {
 
 void UnixSocketServer::stop() {
     for (auto& c : clients_) {
-        ::close(c.fd);
+        if (c.fd >= 0) ::close(c.fd);
     }
     clients_.clear();
+    subscribers_ = 0;
 
     if (server_fd_ >= 0) {
         ::close(server_fd_);
@@ -70,48 +124,204 @@ void UnixSocketServer::stop() {
 }
 
 int UnixSocketServer::accept_client() {
-    int fd = ::accept4(server_fd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
-    if (fd < 0) return -1;
-    clients_.push_back({fd, {}});
-    return fd;
+    while (true) {
+        int fd = ::accept4(server_fd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) return -1;
+        // Without the peer's uid the client can't be told apart from root:
+        // it is dropped, and the next one in the queue accepted.
+        ucred cred{};
+        socklen_t len = sizeof(cred);
+        if (::getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &cred, &len) != 0 || len != sizeof(cred)) {
+            ::close(fd);
+            continue;
+        }
+        // fds are small and reused, so the table is indexed by them directly.
+        if (static_cast<size_t>(fd) >= clients_.size()) clients_.resize(static_cast<size_t>(fd) + 1);
+        clients_[static_cast<size_t>(fd)] = {.fd = fd, .uid = cred.uid};
+        return fd;
+    }
+}
+
+bool UnixSocketServer::fill(ClientBuffer& client) {
+    // Everything before read_pos is parsed: drop it and receive straight into
+    // the buffer after whatever is left.
+    auto& buf = client.buf;
+    buf.erase(0, client.read_pos);
+    client.read_pos = 0;
+
+    // Until EAGAIN, so an edge-triggered fd doesn't sit on unread data.
+    constexpr size_t READ_SIZE = 4096;
+    while (true) {
+        size_t old_size = buf.size();
+        buf.resize(old_size + READ_SIZE);
+        ssize_t n = ::recv(client.fd, buf.data() + old_size, READ_SIZE, 0);
+        buf.resize(old_size + static_cast<size_t>(std::max<ssize_t>(n, 0)));
+        if (n > 0) continue;
+        if (n < 0 && errno == EINTR) continue;
+        return n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK);
+    }
+}
+
+ipc::DecodeStatus UnixSocketServer::next_command(ClientBuffer& client, nlohmann::json& cmd) {
+    // Parsed where it lies, JSON line or binary frame.
+    auto decoded = ipc::decode(std::span<const char>(client.buf).subspan(client.read_pos), cmd);
+    if (decoded.status == ipc::DecodeStatus::Ok) {
+        client.read_pos += decoded.consumed;
+        client.encoding = decoded.encoding;
+    }
+    return decoded.status;
+}
+
+bool UnixSocketServer::read_commands(int client_fd, std::vector<nlohmann::json>& cmds) {
+    auto* client = find_client(client_fd);
+    if (!client) return false;
+
+    bool open = fill(*client);
+    while (true) {
+        nlohmann::json cmd;
+        auto status = next_command(*client, cmd);
+        if (status == ipc::DecodeStatus::Invalid) return false;
+        if (status == ipc::DecodeStatus::Incomplete) break;
+        cmds.push_back(std::move(cmd));
+    }
+    // Commands that came in before a hangup are still returned.
+    return open;
 }
 
 bool UnixSocketServer::read_command(int client_fd, nlohmann::json& cmd) {
     auto* client = find_client(client_fd);
     if (!client) return false;
 
-    char buf[4096];
-    ssize_t n = ::recv(client_fd, buf, sizeof(buf), 0);
-    if (n <= 0) return false;
+    auto status = next_command(*client, cmd);
+    if (status == ipc::DecodeStatus::Incomplete && fill(*client)) status = next_command(*client, cmd);
+    return status == ipc::DecodeStatus::Ok;
+}
 
-    client->buf.append(buf, static_cast<size_t>(n));
+bool UnixSocketServer::send_response(int client_fd, const nlohmann::json& response) {
+    auto* client = find_client(client_fd);
+    if (!client) return false;
+    return write(*client, ipc::encode(response, client->encoding));
+}
+
+long UnixSocketServer::send_some(int client_fd, std::string_view data) {
+    // Raw bytes must not overtake a queued response.
+    if (auto* client = find_client(client_fd); client && !client->out.empty()) {
+        if (!drain(*client)) return -1;
+        if (!client->out.empty()) return 0;
+    }
+    while (true) {
+        ssize_t sent = ::send(client_fd, data.data(), data.size(), MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (sent >= 0) return static_cast<long>(sent);
+        if (errno == EINTR) continue;
+        return errno == EAGAIN || errno == EWOULDBLOCK ? 0 : -1;
+    }
+}
+
+bool UnixSocketServer::flush(int client_fd) {
+    auto* client = find_client(client_fd);
+    return client && drain(*client);
+}
 
-    auto pos = client->buf.find('\n');
-    if (pos == std::string::npos) return false;
+size_t UnixSocketServer::queued(int client_fd) const {
+    if (client_fd < 0 || static_cast<size_t>(client_fd) >= clients_.size()) return 0;
+    return clients_[static_cast<size_t>(client_fd)].out_bytes;
+}
 
-    std::string line = client->buf.substr(0, pos);
-    client->buf.erase(0, pos + 1);
+bool UnixSocketServer::write(ClientBuffer& client, std::string_view msg) {
+    if (client.out.empty()) {
+        ssize_t sent;
+        do {
+            sent = ::send(client.fd, msg.data(), msg.size(), MSG_NOSIGNAL | MSG_DONTWAIT);
+        } while (sent < 0 && errno == EINTR);
+        if (sent < 0 && errno != EAGAIN && errno != EWOULDBLOCK) return false;
+        if (sent == static_cast<ssize_t>(msg.size())) return true;
+        msg.remove_prefix(static_cast<size_t>(std::max<ssize_t>(sent, 0)));
+    }
 
-    try {
-        cmd = nlohmann::json::parse(line);
-        return true;
-    } catch (const nlohmann::json::exception&) {
+    if (client.out_bytes + msg.size() > MAX_QUEUED_BYTES) {
+        std::println(stderr, "ipc: client fd {} fell {} bytes behind, disconnecting", client.fd,
+                     client.out_bytes + msg.size());
+        ::shutdown(client.fd, SHUT_RDWR);
+        client.out.clear();
+        client.out_pos = client.out_bytes = 0;
         return false;
     }
+    client.out.emplace_back(msg);
+    client.out_bytes += msg.size();
+    return true;
 }
 
-bool UnixSocketServer::send_response(int client_fd, const nlohmann::json& response) {
-    std::string msg = response.dump() + "\n";
-    ssize_t sent = ::send(client_fd, msg.data(), msg.size(), MSG_NOSIGNAL);
-    return sent == static_cast<ssize_t>(msg.size());
+bool UnixSocketServer::drain(ClientBuffer& client) {
+    constexpr size_t MAX_IOV = 64;
+    while (!client.out.empty()) {
+        std::array<iovec, MAX_IOV> iov;
+        size_t n = 0;
+        for (auto it = client.out.begin(); it != client.out.end() && n < MAX_IOV; ++it, ++n) {
+            size_t skip = n == 0 ? client.out_pos : 0;
+            iov[n] = {.iov_base = it->data() + skip, .iov_len = it->size() - skip};
+        }
+        ssize_t sent = ::writev(client.fd, iov.data(), static_cast<int>(n));
+        if (sent < 0) {
+            if (errno == EINTR) continue;
+            return errno == EAGAIN || errno == EWOULDBLOCK;
+        }
+
+        client.out_bytes -= static_cast<size_t>(sent);
+        size_t left = static_cast<size_t>(sent);
+        while (left > 0) {
+            size_t rest = client.out.front().size() - client.out_pos;
+            if (left < rest) {
+                client.out_pos += left;
+                break;
+            }
+            left -= rest;
+            client.out.pop_front();
+            client.out_pos = 0;
+        }
+    }
+    return true;
 }
 
 void UnixSocketServer::close_client(int client_fd) {
     ::close(client_fd);
-    std::erase_if(clients_, [client_fd](const ClientBuffer& c) { return c.fd == client_fd; });
+    if (auto* client = find_client(client_fd)) {
+        if (client->subscribed) --subscribers_;
+        *client = {};
+    }
+}
+
+void UnixSocketServer::subscribe(int client_fd) {
+    auto* client = find_client(client_fd);
+    if (!client || client->subscribed) return;
+    client->subscribed = true;
+    ++subscribers_;
+}
+
+uint32_t UnixSocketServer::peer_uid(int client_fd) const {
+    if (client_fd < 0 || static_cast<size_t>(client_fd) >= clients_.size()) return 0;
+    return clients_[static_cast<size_t>(client_fd)].uid;
+}
+
+void UnixSocketServer::publish(const nlohmann::json& event, std::optional<uint32_t> uid) {
+    if (subscribers_ == 0) return;
+
+    // Serialized once per encoding in use, whatever the number of subscribers.
+    std::array<std::string, 3> encoded;
+    for (auto& c : clients_) {
+        if (c.fd < 0 || !c.subscribed || (uid && c.uid != *uid)) continue;
+        auto& msg = encoded[static_cast<size_t>(c.encoding)];
+        if (msg.empty()) ipc::encode(event, c.encoding, msg);
+        // A subscriber that falls too far behind is cut off; the event loop
+        // sees the hangup and closes it.
+        if (!write(c, msg)) {
+            c.subscribed = false;
+            --subscribers_;
+        }
+    }
 }
 
 UnixSocketServer::ClientBuffer* UnixSocketServer::find_client(int fd) {
-    auto it = std::ranges::find_if(clients_, [fd](const ClientBuffer& c) { return c.fd == fd; });
-    return it != clients_.end() ? &*it : nullptr;
+    if (fd < 0 || static_cast<size_t>(fd) >= clients_.size()) return nullptr;
+    auto& client = clients_[static_cast<size_t>(fd)];
+    return client.fd == fd ? &client : nullptr;
 }
@@ -1,35 +1,75 @@
 #pragma once
 
+#include "ipc_protocol.hpp"
 #include "platform/ipc_server.hpp"
 
+#include <deque>
 #include <string>
+#include <string_view>
 #include <vector>
 
 class UnixSocketServer : public IpcServer {
 public:
+    // A client this far behind (a stuck subscriber, say) is disconnected
+    // rather than buffered for without end.
+    static constexpr size_t MAX_QUEUED_BYTES = 4u << 20;
+
     UnixSocketServer();
     ~UnixSocketServer() override;
 
     UnixSocketServer(const UnixSocketServer&) = delete;
     UnixSocketServer& operator=(const UnixSocketServer&) = delete;
 
+    // Takes over the listening socket if systemd passed one for endpoint
+    // (LISTEN_FDS), or binds it.
     bool start(const std::string& endpoint) override;
+    bool socket_activated() const { return socket_activated_; }
     void stop() override;
     int server_fd() const override { return server_fd_; }
     int accept_client() override;
-    bool read_command(int client_fd, nlohmann::json& cmd) override;
+    bool read_commands(int client_fd, std::vector<nlohmann::json>& cmds) override;
+    // The next complete command, reading more only if none is buffered yet.
+    // False if there is none (or the client is gone).
+    bool read_command(int client_fd, nlohmann::json& cmd);
     bool send_response(int client_fd, const nlohmann::json& response) override;
+    long send_some(int client_fd, std::string_view data) override;
+    bool flush(int client_fd) override;
+    // Bytes waiting for the client's socket to drain.
+    size_t queued(int client_fd) const;
     void close_client(int client_fd) override;
+    uint32_t peer_uid(int client_fd) const override;
+    void subscribe(int client_fd) override;
+    size_t subscriber_count() const override { return subscribers_; }
+    void publish(const nlohmann::json& event, std::optional<uint32_t> uid = std::nullopt) override;
 
 private:
     int server_fd_ = -1;
-    std::string socket_path_;
+    std::string socket_path_;  // unlinked on stop(); empty when systemd owns it
+    bool socket_activated_ = false;
 
     struct ClientBuffer {
-        int fd;
+        int fd = -1;  // -1: free slot
         std::string buf;
+        size_t read_pos = 0;  // start of the first unparsed message in buf
+        ipc::Encoding encoding = ipc::Encoding::JsonLines;  // of the last command
+        bool subscribed = false;
+        uint32_t uid = 0;  // SO_PEERCRED at accept
+        std::deque<std::string> out;  // messages the socket hasn't taken yet
+        size_t out_pos = 0;           // sent of out.front()
+        size_t out_bytes = 0;         // left to send, over all of out
     };
-    std::vector<ClientBuffer> clients_;
+    std::vector<ClientBuffer> clients_;  // indexed by fd
+    size_t subscribers_ = 0;
 
     ClientBuffer* find_client(int fd);
+    // Receives until EAGAIN. False once the client hung up or failed.
+    bool fill(ClientBuffer& client);
+    ipc::DecodeStatus next_command(ClientBuffer& client, nlohmann::json& cmd);
+    // Sends msg, or queues what the socket doesn't take behind what is
+    // queued already. False if the client failed or overflowed (it is shut
+    // down, and the event loop sees the hangup).
+    bool write(ClientBuffer& client, std::string_view msg);
+    // Sends queued messages, several per writev(), until EAGAIN. False if
+    // the socket failed.
+    bool drain(ClientBuffer& client);
 };
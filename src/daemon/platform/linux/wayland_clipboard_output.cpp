@@ -1,11 +1,27 @@
 #include "platform/linux/wayland_clipboard_output.hpp"
 
+#ifdef SPEAK_ANYWHERE_HAVE_WAYLAND
+#include "platform/linux/wayland_session.hpp"
+#endif
+
 #include <cerrno>
 #include <cstring>
 #include <sys/wait.h>
 #include <unistd.h>
 
+WaylandClipboardOutput::WaylandClipboardOutput(WaylandSession* session)
+    : session_(session) {}
+
 std::expected<void, std::string> WaylandClipboardOutput::deliver(const std::string& text) {
+#ifdef SPEAK_ANYWHERE_HAVE_WAYLAND
+    if (session_ && session_->has_clipboard()) {
+        return session_->set_clipboard(text);
+    }
+#endif
+    return wl_copy(text);
+}
+
+std::expected<void, std::string> WaylandClipboardOutput::wl_copy(const std::string& text) {
     int pipefd[2];
     if (::pipe(pipefd) < 0) {
         return std::unexpected(std::string("pipe() failed: ") + std::strerror(errno));
@@ -2,7 +2,17 @@
 
 #include "output/output.hpp"
 
+class WaylandSession;
+
+// Copies text to the clipboard. Uses the daemon's Wayland session when the
+// compositor offers wlr-data-control, and falls back to running wl-copy.
 class WaylandClipboardOutput : public OutputMethod {
 public:
+    explicit WaylandClipboardOutput(WaylandSession* session = nullptr);
     std::expected<void, std::string> deliver(const std::string& text) override;
+
+private:
+    WaylandSession* session_;
+
+    std::expected<void, std::string> wl_copy(const std::string& text);
 };
@@ -0,0 +1,365 @@
+#include "platform/linux/wayland_session.hpp"
+
+#include <virtual-keyboard-unstable-v1-client-protocol.h>
+#include <wayland-client.h>
+#include <wlr-data-control-unstable-v1-client-protocol.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <format>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr const char* TEXT_MIME_TYPES[] = {
+    "text/plain;charset=utf-8", "text/plain", "UTF8_STRING", "TEXT", "STRING",
+};
+
+// XKB keycodes stop at 255, and evdev code k is XKB keycode k + 8.
+constexpr size_t MAX_KEYSYMS = 247;
+
+// Decodes one UTF-8 sequence from text, advancing it. Malformed bytes come
+// back as U+FFFD.
+char32_t next_codepoint(std::string_view& text) {
+    auto byte = [&](size_t i) { return static_cast<unsigned char>(text[i]); };
+    unsigned char lead = byte(0);
+    size_t len = lead < 0x80 ? 1 : (lead >> 5) == 0x6 ? 2 : (lead >> 4) == 0xE ? 3
+               : (lead >> 3) == 0x1E ? 4 : 0;
+    if (len == 0 || len > text.size()) {
+        text.remove_prefix(1);
+        return U'\uFFFD';
+    }
+
+    char32_t cp = len == 1 ? lead : lead & (0x7F >> len);
+    for (size_t i = 1; i < len; ++i) {
+        if ((byte(i) & 0xC0) != 0x80) {
+            text.remove_prefix(i);
+            return U'\uFFFD';
+        }
+        cp = (cp << 6) | (byte(i) & 0x3F);
+    }
+    text.remove_prefix(len);
+    return cp;
+}
+
+std::string keysym_for(char32_t cp) {
+    switch (cp) {
+        case U'\n': return "Return";
+        case U'\t': return "Tab";
+        default: return std::format("U{:04X}", static_cast<uint32_t>(cp));
+    }
+}
+
+uint32_t now_ms() {
+    auto t = std::chrono::steady_clock::now().time_since_epoch();
+    return static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::milliseconds>(t).count());
+}
+
+std::string errno_message(const char* what) {
+    return std::string(what) + ": " + std::strerror(errno);
+}
+
+} // namespace
+
+WaylandSession::WaylandSession() = default;
+
+WaylandSession::~WaylandSession() {
+    disconnect();
+}
+
+bool WaylandSession::connect() {
+    display_ = wl_display_connect(nullptr);
+    if (!display_) return false;
+
+    static const wl_registry_listener registry_listener = {
+        .global = on_global,
+        .global_remove = on_global_remove,
+    };
+    registry_ = wl_display_get_registry(display_);
+    wl_registry_add_listener(registry_, &registry_listener, this);
+    wl_display_roundtrip(display_);
+
+    if (!seat_) {
+        disconnect();
+        return false;
+    }
+
+    if (data_manager_) {
+        static const zwlr_data_control_device_v1_listener device_listener = {
+            .data_offer = on_data_offer,
+            .selection = on_selection,
+            .finished = on_finished,
+            .primary_selection = on_primary_selection,
+        };
+        device_ = zwlr_data_control_manager_v1_get_data_device(data_manager_, seat_);
+        zwlr_data_control_device_v1_add_listener(device_, &device_listener, this);
+    }
+    if (keyboard_manager_) {
+        keyboard_ = zwp_virtual_keyboard_manager_v1_create_virtual_keyboard(keyboard_manager_, seat_);
+    }
+
+    // A compositor that refuses the virtual keyboard says so here.
+    if (wl_display_roundtrip(display_) < 0 || (!device_ && !keyboard_)) {
+        disconnect();
+        return false;
+    }
+    return true;
+}
+
+void WaylandSession::disconnect() {
+    if (!display_) return;
+
+    if (source_) zwlr_data_control_source_v1_destroy(source_);
+    if (selection_offer_) zwlr_data_control_offer_v1_destroy(selection_offer_);
+    if (device_) zwlr_data_control_device_v1_destroy(device_);
+    if (data_manager_) zwlr_data_control_manager_v1_destroy(data_manager_);
+    if (keyboard_) zwp_virtual_keyboard_v1_destroy(keyboard_);
+    if (keyboard_manager_) zwp_virtual_keyboard_manager_v1_destroy(keyboard_manager_);
+    if (seat_) wl_seat_destroy(seat_);
+    if (registry_) wl_registry_destroy(registry_);
+    wl_display_disconnect(display_);
+
+    display_ = nullptr;
+    registry_ = nullptr;
+    seat_ = nullptr;
+    data_manager_ = nullptr;
+    device_ = nullptr;
+    source_ = nullptr;
+    selection_offer_ = nullptr;
+    keyboard_manager_ = nullptr;
+    keyboard_ = nullptr;
+    keysyms_.clear();
+    keymap_dirty_ = false;
+}
+
+int WaylandSession::fd() const {
+    return display_ ? wl_display_get_fd(display_) : -1;
+}
+
+bool WaylandSession::dispatch() {
+    if (!display_) return false;
+    if (wl_display_dispatch(display_) < 0) {
+        disconnect();
+        return false;
+    }
+    // Handlers may have queued requests (destroying offers and sources).
+    wl_display_flush(display_);
+    return true;
+}
+
+std::expected<void, std::string> WaylandSession::set_clipboard(std::string text) {
+    if (!device_) return std::unexpected("compositor has no wlr-data-control");
+
+    static const zwlr_data_control_source_v1_listener source_listener = {
+        .send = on_send,
+        .cancelled = on_cancelled,
+    };
+
+    clipboard_ = std::move(text);
+    auto* source = zwlr_data_control_manager_v1_create_data_source(data_manager_);
+    zwlr_data_control_source_v1_add_listener(source, &source_listener, this);
+    for (const char* mime : TEXT_MIME_TYPES) {
+        zwlr_data_control_source_v1_offer(source, mime);
+    }
+    zwlr_data_control_device_v1_set_selection(device_, source);
+
+    // The previous source gets "cancelled" and is destroyed then.
+    source_ = source;
+    return flush();
+}
+
+std::expected<void, std::string> WaylandSession::tap(std::string_view keysym, uint32_t mods) {
+    if (!keyboard_) return std::unexpected("compositor has no virtual keyboard");
+
+    uint32_t key = keycode_for(keysym);
+    if (key == 0) {
+        reset_keymap();
+        key = keycode_for(keysym);
+    }
+    if (keymap_dirty_) {
+        if (auto res = upload_keymap(); !res) return res;
+    }
+
+    if (mods) zwp_virtual_keyboard_v1_modifiers(keyboard_, mods, 0, 0, 0);
+    send_key(key);
+    if (mods) zwp_virtual_keyboard_v1_modifiers(keyboard_, 0, 0, 0, 0);
+    return flush();
+}
+
+std::expected<void, std::string> WaylandSession::type(std::string_view text) {
+    if (!keyboard_) return std::unexpected("compositor has no virtual keyboard");
+
+    // Keys are collected until the keymap runs out of room, then that part is
+    // typed with the keymap it needs before starting over.
+    std::vector<uint32_t> keys;
+    auto send = [&]() -> std::expected<void, std::string> {
+        if (keymap_dirty_) {
+            if (auto res = upload_keymap(); !res) return res;
+        }
+        for (uint32_t key : keys) send_key(key);
+        keys.clear();
+        return flush();
+    };
+
+    while (!text.empty()) {
+        std::string keysym = keysym_for(next_codepoint(text));
+        uint32_t key = keycode_for(keysym);
+        if (key == 0) {
+            if (auto res = send(); !res) return res;
+            reset_keymap();
+            key = keycode_for(keysym);
+        }
+        keys.push_back(key);
+    }
+    return send();
+}
+
+uint32_t WaylandSession::keycode_for(std::string_view keysym) {
+    auto it = std::ranges::find(keysyms_, keysym);
+    if (it == keysyms_.end()) {
+        if (keysyms_.size() == MAX_KEYSYMS) return 0;
+        keysyms_.emplace_back(keysym);
+        keymap_dirty_ = true;
+        it = keysyms_.end() - 1;
+    }
+    return static_cast<uint32_t>(it - keysyms_.begin()) + 1;
+}
+
+void WaylandSession::reset_keymap() {
+    keysyms_.clear();
+    keymap_dirty_ = true;
+}
+
+void WaylandSession::send_key(uint32_t key) {
+    uint32_t t = now_ms();
+    zwp_virtual_keyboard_v1_key(keyboard_, t, key, WL_KEYBOARD_KEY_STATE_PRESSED);
+    zwp_virtual_keyboard_v1_key(keyboard_, t, key, WL_KEYBOARD_KEY_STATE_RELEASED);
+}
+
+std::expected<void, std::string> WaylandSession::upload_keymap() {
+    // One single-level key per keysym; XKB keycodes are evdev codes + 8.
+    std::string keycodes;
+    std::string symbols;
+    for (size_t i = 0; i < keysyms_.size(); ++i) {
+        keycodes += std::format("  <K{}> = {};\n", i + 1, i + 9);
+        symbols += std::format("  key <K{}> {{ [ {} ] }};\n", i + 1, keysyms_[i]);
+    }
+    std::string keymap = std::format(
+        "xkb_keymap {{\n"
+        "xkb_keycodes \"speak-anywhere\" {{\n  minimum = 8;\n  maximum = {};\n{}}};\n"
+        "xkb_types \"speak-anywhere\" {{ include \"complete\" }};\n"
+        "xkb_compatibility \"speak-anywhere\" {{ include \"complete\" }};\n"
+        "xkb_symbols \"speak-anywhere\" {{\n{}}};\n"
+        "}};\n",
+        keysyms_.size() + 9, keycodes, symbols);
+
+    int fd = ::memfd_create("speak-anywhere-keymap", MFD_CLOEXEC);
+    if (fd < 0) return std::unexpected(errno_message("memfd_create() failed"));
+
+    // The size handed over includes the terminating NUL.
+    size_t size = keymap.size() + 1;
+    size_t written = 0;
+    while (written < size) {
+        ssize_t n = ::write(fd, keymap.c_str() + written, size - written);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            ::close(fd);
+            return std::unexpected(errno_message("keymap write() failed"));
+        }
+        written += static_cast<size_t>(n);
+    }
+
+    zwp_virtual_keyboard_v1_keymap(keyboard_, WL_KEYBOARD_KEYMAP_FORMAT_XKB_V1, fd,
+                                   static_cast<uint32_t>(size));
+    ::close(fd);
+
+    // Keys sent before the compositor has compiled the keymap may be dropped.
+    if (wl_display_roundtrip(display_) < 0) {
+        return std::unexpected("wayland connection lost");
+    }
+    keymap_dirty_ = false;
+    return {};
+}
+
+std::expected<void, std::string> WaylandSession::flush() {
+    if (wl_display_flush(display_) < 0 && errno != EAGAIN) {
+        return std::unexpected(errno_message("wl_display_flush() failed"));
+    }
+    if (int err = wl_display_get_error(display_); err != 0) {
+        return std::unexpected(std::string("wayland connection error: ") + std::strerror(err));
+    }
+    return {};
+}
+
+void WaylandSession::on_global(void* data, wl_registry* registry, uint32_t name,
+                               const char* interface, uint32_t version) {
+    auto* self = static_cast<WaylandSession*>(data);
+    std::string_view iface = interface;
+
+    if (iface == wl_seat_interface.name && !self->seat_) {
+        self->seat_ = static_cast<wl_seat*>(
+            wl_registry_bind(registry, name, &wl_seat_interface, std::min(version, 1u)));
+    } else if (iface == zwlr_data_control_manager_v1_interface.name) {
+        self->data_manager_ = static_cast<zwlr_data_control_manager_v1*>(
+            wl_registry_bind(registry, name, &zwlr_data_control_manager_v1_interface, 1));
+    } else if (iface == zwp_virtual_keyboard_manager_v1_interface.name) {
+        self->keyboard_manager_ = static_cast<zwp_virtual_keyboard_manager_v1*>(
+            wl_registry_bind(registry, name, &zwp_virtual_keyboard_manager_v1_interface, 1));
+    }
+}
+
+void WaylandSession::on_global_remove(void*, wl_registry*, uint32_t) {}
+
+void WaylandSession::on_data_offer(void*, zwlr_data_control_device_v1*,
+                                   zwlr_data_control_offer_v1*) {
+    // Announced ahead of the selection event that hands it over.
+}
+
+void WaylandSession::on_selection(void* data, zwlr_data_control_device_v1*,
+                                  zwlr_data_control_offer_v1* offer) {
+    auto* self = static_cast<WaylandSession*>(data);
+    if (self->selection_offer_) zwlr_data_control_offer_v1_destroy(self->selection_offer_);
+    self->selection_offer_ = offer;
+}
+
+void WaylandSession::on_finished(void* data, zwlr_data_control_device_v1* device) {
+    auto* self = static_cast<WaylandSession*>(data);
+    zwlr_data_control_device_v1_destroy(device);
+    self->device_ = nullptr;
+}
+
+void WaylandSession::on_primary_selection(void*, zwlr_data_control_device_v1*,
+                                          zwlr_data_control_offer_v1* offer) {
+    // Primary selection isn't used (and needs version 2, which isn't bound).
+    if (offer) zwlr_data_control_offer_v1_destroy(offer);
+}
+
+void WaylandSession::on_send(void* data, zwlr_data_control_source_v1*,
+                             const char*, int32_t fd) {
+    auto* self = static_cast<WaylandSession*>(data);
+    const std::string& text = self->clipboard_;
+
+    // A reader that goes away fails with EPIPE (SIGPIPE is ignored by the daemon).
+    size_t written = 0;
+    while (written < text.size()) {
+        ssize_t n = ::write(fd, text.data() + written, text.size() - written);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        written += static_cast<size_t>(n);
+    }
+    ::close(fd);
+}
+
+void WaylandSession::on_cancelled(void* data, zwlr_data_control_source_v1* source) {
+    auto* self = static_cast<WaylandSession*>(data);
+    if (self->source_ == source) {
+        self->source_ = nullptr;
+        self->clipboard_.clear();
+    }
+    zwlr_data_control_source_v1_destroy(source);
+}
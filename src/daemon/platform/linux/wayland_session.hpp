@@ -0,0 +1,103 @@
+#pragma once
+
+#include <cstdint>
+#include <expected>
+#include <string>
+#include <string_view>
+#include <vector>
+
+struct wl_display;
+struct wl_registry;
+struct wl_seat;
+struct zwlr_data_control_manager_v1;
+struct zwlr_data_control_device_v1;
+struct zwlr_data_control_source_v1;
+struct zwlr_data_control_offer_v1;
+struct zwp_virtual_keyboard_manager_v1;
+struct zwp_virtual_keyboard_v1;
+
+// One Wayland connection for the daemon's lifetime. Owns the clipboard through
+// wlr-data-control and sends keystrokes through virtual-keyboard-unstable-v1,
+// so delivering text needs no wl-copy or wtype processes.
+//
+// Setting the clipboard only announces it: a client that pastes asks for the
+// data later, through an event on this connection. The event loop therefore
+// polls fd() and calls dispatch() whenever it is readable.
+//
+// Only built when CMake finds wayland-client (SPEAK_ANYWHERE_HAVE_WAYLAND).
+class WaylandSession {
+public:
+    // Real modifier bits of the generated keymap (xkb "complete" compat).
+    static constexpr uint32_t MOD_SHIFT = 1u << 0;
+    static constexpr uint32_t MOD_CTRL = 1u << 2;
+
+    WaylandSession();
+    ~WaylandSession();
+
+    WaylandSession(const WaylandSession&) = delete;
+    WaylandSession& operator=(const WaylandSession&) = delete;
+
+    // Connects to $WAYLAND_DISPLAY and binds the first seat. Succeeds if at
+    // least one of the two protocols is available.
+    bool connect();
+    void disconnect();
+
+    int fd() const;
+    // Reads and handles incoming events. False if the connection is gone.
+    bool dispatch();
+
+    bool has_clipboard() const { return device_ != nullptr; }
+    bool has_keyboard() const { return keyboard_ != nullptr; }
+
+    // Takes over the clipboard with text, offered as UTF-8 plain text.
+    std::expected<void, std::string> set_clipboard(std::string text);
+
+    // Presses and releases the key for an XKB keysym name ("v", "Return",
+    // "U00E9") with mods held. Keysyms are added to the uploaded keymap the
+    // first time they are used.
+    std::expected<void, std::string> tap(std::string_view keysym, uint32_t mods = 0);
+
+    // Types UTF-8 text key by key, whatever the user's keyboard layout.
+    std::expected<void, std::string> type(std::string_view text);
+
+private:
+    static void on_global(void* data, wl_registry* registry, uint32_t name,
+                          const char* interface, uint32_t version);
+    static void on_global_remove(void* data, wl_registry* registry, uint32_t name);
+
+    static void on_data_offer(void* data, zwlr_data_control_device_v1* device,
+                              zwlr_data_control_offer_v1* offer);
+    static void on_selection(void* data, zwlr_data_control_device_v1* device,
+                             zwlr_data_control_offer_v1* offer);
+    static void on_finished(void* data, zwlr_data_control_device_v1* device);
+    static void on_primary_selection(void* data, zwlr_data_control_device_v1* device,
+                                     zwlr_data_control_offer_v1* offer);
+
+    static void on_send(void* data, zwlr_data_control_source_v1* source,
+                        const char* mime_type, int32_t fd);
+    static void on_cancelled(void* data, zwlr_data_control_source_v1* source);
+
+    // Evdev code for keysym; appends it to the keymap if it's new. 0 if the
+    // keymap is full.
+    uint32_t keycode_for(std::string_view keysym);
+    // Starts an empty keymap once every keycode is taken.
+    void reset_keymap();
+    std::expected<void, std::string> upload_keymap();
+    void send_key(uint32_t key);
+    std::expected<void, std::string> flush();
+
+    wl_display* display_ = nullptr;
+    wl_registry* registry_ = nullptr;
+    wl_seat* seat_ = nullptr;
+
+    zwlr_data_control_manager_v1* data_manager_ = nullptr;
+    zwlr_data_control_device_v1* device_ = nullptr;
+    zwlr_data_control_source_v1* source_ = nullptr;
+    zwlr_data_control_offer_v1* selection_offer_ = nullptr;  // someone else's clipboard
+    std::string clipboard_;
+
+    zwp_virtual_keyboard_manager_v1* keyboard_manager_ = nullptr;
+    zwp_virtual_keyboard_v1* keyboard_ = nullptr;
+    std::vector<std::string> keysyms_;  // keysyms_[i] is evdev code i + 1
+    bool keymap_dirty_ = false;          // keysyms_ changed since the last upload
+};
@@ -1,27 +1,22 @@
 #include "platform/linux/wayland_type_output.hpp"
 #include "platform/linux/wayland_clipboard_output.hpp"
 
+#ifdef SPEAK_ANYWHERE_HAVE_WAYLAND
+#include "platform/linux/wayland_session.hpp"
+#endif
+
 #include <cerrno>
 #include <cstring>
 #include <sys/wait.h>
 #include <unistd.h>
+#include <vector>
 
-WaylandTypeOutput::WaylandTypeOutput(bool is_terminal)
-    : is_terminal_(is_terminal) {}
-
-std::expected<void, std::string> WaylandTypeOutput::deliver(const std::string& text) {
-    if (is_terminal_) {
-        return terminal_paste(text);
-    }
-    return general_paste(text);
-}
-
-std::expected<void, std::string> WaylandTypeOutput::terminal_paste(const std::string& text) {
-    WaylandClipboardOutput clip;
-    auto res = clip.deliver(text);
-    if (!res) return res;
+namespace {
 
-    ::usleep(10000);
+// Runs wtype with args and waits for it; what names the attempt in errors.
+std::expected<void, std::string> wtype(std::vector<const char*> args, const std::string& what) {
+    args.insert(args.begin(), "wtype");
+    args.push_back(nullptr);
 
     pid_t pid = ::fork();
     if (pid < 0) {
@@ -29,7 +24,7 @@ std::expected<void, std::string> WaylandTypeOutput::terminal_paste(const std::st
     }
 
     if (pid == 0) {
-        ::execlp("wtype", "wtype", "-M", "ctrl", "-M", "shift", "-k", "v", nullptr);
+        ::execvp("wtype", const_cast<char* const*>(args.data()));
         ::_exit(127);
     }
 
@@ -40,38 +35,57 @@ std::expected<void, std::string> WaylandTypeOutput::terminal_paste(const std::st
     }
 
     if (WIFEXITED(status) && WEXITSTATUS(status) != 0) {
-        return std::unexpected("wtype terminal paste failed with code " + std::to_string(WEXITSTATUS(status)));
+        return std::unexpected("wtype " + what + " failed with code " + std::to_string(WEXITSTATUS(status)));
     }
 
     return {};
 }
 
-std::expected<void, std::string> WaylandTypeOutput::general_paste(const std::string& text) {
-    WaylandClipboardOutput clip;
-    auto res = clip.deliver(text);
-    if (!res) return res;
+} // namespace
 
-    ::usleep(10000);
+WaylandTypeOutput::WaylandTypeOutput(OutputStrategy strategy, WaylandSession* session)
+    : strategy_(strategy), session_(session) {}
 
-    pid_t pid = ::fork();
-    if (pid < 0) {
-        return std::unexpected(std::string("fork() failed: ") + std::strerror(errno));
-    }
+std::expected<void, std::string> WaylandTypeOutput::deliver(const std::string& text) {
+    if (strategy_.delivery == Delivery::Type) return type(text);
+    return paste(text);
+}
 
-    if (pid == 0) {
-        ::execlp("wtype", "wtype", "-M", "ctrl", "-k", "v", nullptr);
-        ::_exit(127);
+std::expected<void, std::string> WaylandTypeOutput::append(const std::string& text) {
+#ifdef SPEAK_ANYWHERE_HAVE_WAYLAND
+    // Terminals would take typed control characters as input of their own.
+    if (!strategy_.shift && session_ && session_->has_keyboard()) {
+        return session_->type(text);
     }
+#endif
+    return deliver(text);
+}
 
-    int status;
-    while (::waitpid(pid, &status, 0) < 0) {
-        if (errno == EINTR) continue;
-        return std::unexpected(std::string("waitpid() failed: ") + std::strerror(errno));
+std::expected<void, std::string> WaylandTypeOutput::paste(const std::string& text) {
+#ifdef SPEAK_ANYWHERE_HAVE_WAYLAND
+    if (session_ && session_->has_clipboard() && session_->has_keyboard()) {
+        // Both requests travel on the same connection, so the compositor has
+        // switched the selection before it forwards the key: no settle delay.
+        auto res = session_->set_clipboard(text);
+        if (!res) return res;
+        uint32_t mods = WaylandSession::MOD_CTRL;
+        if (strategy_.shift) mods |= WaylandSession::MOD_SHIFT;
+        return session_->tap("v", mods);
     }
+#endif
+    WaylandClipboardOutput clip;
+    auto res = clip.deliver(text);
+    if (!res) return res;
 
-    if (WIFEXITED(status) && WEXITSTATUS(status) != 0) {
-        return std::unexpected("wtype general paste failed with code " + std::to_string(WEXITSTATUS(status)));
-    }
+    ::usleep(10000);
 
-    return {};
+    if (strategy_.shift) return wtype({"-M", "ctrl", "-M", "shift", "-k", "v"}, "terminal paste");
+    return wtype({"-M", "ctrl", "-k", "v"}, "general paste");
+}
+
+std::expected<void, std::string> WaylandTypeOutput::type(const std::string& text) {
+#ifdef SPEAK_ANYWHERE_HAVE_WAYLAND
+    if (session_ && session_->has_keyboard()) return session_->type(text);
+#endif
+    return wtype({"--", text.c_str()}, "typing");
 }
@@ -2,14 +2,29 @@
 
 #include "output/output.hpp"
 
+class WaylandSession;
+
+// Puts text into the focused window. Pasting: clipboard, then Ctrl+V (or
+// Ctrl+Shift+V, for terminals). Typing: key by key through the virtual
+// keyboard. Native through the daemon's Wayland session when the compositor
+// has the protocols, otherwise through wl-copy and wtype.
+//
+// Incrementally, segments are typed key by key through the virtual keyboard.
+// Terminals, and sessions without one, get every segment pasted instead.
 class WaylandTypeOutput : public OutputMethod {
 public:
-    explicit WaylandTypeOutput(bool is_terminal = false);
+    explicit WaylandTypeOutput(OutputStrategy strategy = {}, WaylandSession* session = nullptr);
     std::expected<void, std::string> deliver(const std::string& text) override;
 
+    bool incremental() const override { return true; }
+    std::expected<void, std::string> begin() override { return {}; }
+    std::expected<void, std::string> append(const std::string& text) override;
+    std::expected<void, std::string> commit() override { return {}; }
+
 private:
-    bool is_terminal_;
+    OutputStrategy strategy_;
+    WaylandSession* session_;
 
-    std::expected<void, std::string> terminal_paste(const std::string& text);
-    std::expected<void, std::string> general_paste(const std::string& text);
+    std::expected<void, std::string> paste(const std::string& text);
+    std::expected<void, std::string> type(const std::string& text);
 };
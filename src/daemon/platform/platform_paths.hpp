@@ -6,6 +6,7 @@ namespace platform {
 
 std::string config_dir();
 std::string data_dir();
+// $SPEAK_ANYWHERE_SOCKET if set, else speak-anywhere.sock in the runtime dir.
 std::string ipc_endpoint();
 
 } // namespace platform
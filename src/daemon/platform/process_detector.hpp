@@ -1,6 +1,7 @@
 #pragma once
 
 #include <string>
+#include <vector>
 
 struct DetectionResult {
     std::string agent;
@@ -11,4 +12,12 @@ class ProcessDetector {
 public:
     virtual ~ProcessDetector() = default;
     virtual DetectionResult detect(int pid) const = 0;
+
+    // The window of pid got focus and detect(pid) is likely to follow.
+    // Detectors that cache can look it up ahead of time.
+    virtual void prefetch(int /*pid*/) {}
+
+    // Looks for these agents from now on (config reload). A detection
+    // already under way may still match the old ones.
+    virtual void set_agents(std::vector<std::string> /*agents*/) {}
 };
@@ -1,69 +1,157 @@
 #pragma once
 
+#include <algorithm>
 #include <atomic>
 #include <cstddef>
 #include <cstdint>
 #include <cstring>
+#include <memory>
+#include <new>
 #include <span>
 #include <vector>
 
-// Lock-free single-producer single-consumer ring buffer.
+// Lock-free single-producer single-consumer byte queue.
 // Producer (PipeWire thread) calls write(). Consumer (main thread) calls read().
+//
+// Storage is a linked list of fixed-size chunks rather than one capacity-sized
+// array: only the chunks holding unread audio exist, so a one-hour cap costs
+// nothing until an hour is actually queued. A chunk the consumer has finished
+// with goes on a free list that the producer takes from before it allocates,
+// so once the queue has reached its usual depth no more allocation happens.
+// Chunks stay where they are until consumed, and visit_readable() hands them
+// out in place.
+//
+// Given storage of at least storage_bytes(), every chunk is carved from it up
+// front instead: the caller decides where the audio lives (locked, on
+// hugepages) and the producer never allocates at all.
 class RingBuffer {
 public:
-    explicit RingBuffer(size_t capacity_bytes)
-        : buf_(capacity_bytes), capacity_(capacity_bytes) {}
+    static constexpr size_t DEFAULT_CHUNK_BYTES = 16 << 10;  // 0.5 s of 16 kHz mono
 
-    // Producer: write data into ring buffer. Returns bytes actually written.
+    // capacity_bytes bounds the unread data; writes beyond it are dropped
+    // and counted. storage too small for every chunk is not used.
+    explicit RingBuffer(size_t capacity_bytes, size_t chunk_bytes = DEFAULT_CHUNK_BYTES,
+                        std::span<uint8_t> storage = {})
+        : capacity_(capacity_bytes),
+          chunk_bytes_(chunk_size(capacity_bytes, chunk_bytes)),
+          max_chunks_(chunk_count(capacity_bytes, chunk_bytes_)) {
+        owned_.reserve(max_chunks_);
+        if (storage.size() >= max_chunks_ * chunk_bytes_) {
+            for (size_t i = 0; i < max_chunks_; ++i) {
+                owned_.push_back(std::make_unique<Chunk>());
+                owned_.back()->data = storage.data() + i * chunk_bytes_;
+                if (i > 0) recycle(owned_.back().get());
+            }
+            allocated_.store(max_chunks_, std::memory_order_relaxed);
+            preallocated_ = true;
+            head_ = tail_ = owned_.front().get();
+        } else {
+            head_ = tail_ = allocate();
+        }
+    }
+
+    // Storage a buffer of this capacity and chunk size takes when every chunk
+    // exists: what to pass the constructor to preallocate.
+    static size_t storage_bytes(size_t capacity_bytes, size_t chunk_bytes = DEFAULT_CHUNK_BYTES) {
+        size_t chunk = chunk_size(capacity_bytes, chunk_bytes);
+        return chunk_count(capacity_bytes, chunk) * chunk;
+    }
+
+    RingBuffer(const RingBuffer&) = delete;
+    RingBuffer& operator=(const RingBuffer&) = delete;
+
+    // Producer: write data into the buffer. Returns bytes actually written.
     size_t write(const void* data, size_t len) {
         size_t w = write_pos_.load(std::memory_order_relaxed);
         size_t r = read_pos_.load(std::memory_order_acquire);
 
-        size_t avail = capacity_ - (w - r);
-        size_t to_write = std::min(len, avail);
-        if (to_write == 0) return 0;
-
+        size_t to_write = std::min(len, capacity_ - (w - r));
         auto src = static_cast<const uint8_t*>(data);
-        size_t offset = w % capacity_;
-        size_t first = std::min(to_write, capacity_ - offset);
-        std::memcpy(buf_.data() + offset, src, first);
-        if (first < to_write) {
-            std::memcpy(buf_.data(), src + first, to_write - first);
+        size_t done = 0;
+        while (done < to_write) {
+            if (w == tail_base_ + chunk_bytes_) {
+                Chunk* next = take_chunk();
+                if (!next) break;
+                // Linked before write_pos_ moves past the boundary, so the
+                // consumer always finds it.
+                tail_->next.store(next, std::memory_order_release);
+                tail_ = next;
+                tail_base_ += chunk_bytes_;
+            }
+            size_t n = std::min(tail_base_ + chunk_bytes_ - w, to_write - done);
+            std::memcpy(tail_->data + (w - tail_base_), src + done, n);
+            w += n;
+            done += n;
         }
 
-        write_pos_.store(w + to_write, std::memory_order_release);
-        return to_write;
+        if (done < len) {
+            overflow_bytes_.fetch_add(len - done, std::memory_order_relaxed);
+            overflows_.fetch_add(1, std::memory_order_relaxed);
+        }
+        if (done > 0) write_pos_.store(w, std::memory_order_release);
+        return done;
     }
 
     // Consumer: read up to max_len bytes. Returns bytes actually read.
     size_t read(void* dest, size_t max_len) {
+        auto dst = static_cast<uint8_t*>(dest);
+        size_t n = visit_readable(max_len, [&dst](std::span<const uint8_t> piece) {
+            std::memcpy(dst, piece.data(), piece.size());
+            dst += piece.size();
+        });
+        consume(n);
+        return n;
+    }
+
+    // Consumer: calls f with up to max_len readable bytes as contiguous
+    // pieces, in order, straight from the chunks. Nothing is consumed until
+    // consume() is called. Returns the number of bytes visited.
+    template <typename F>
+    size_t visit_readable(size_t max_len, F&& f) const {
         size_t r = read_pos_.load(std::memory_order_relaxed);
         size_t w = write_pos_.load(std::memory_order_acquire);
+        size_t end = r + std::min(max_len, w - r);
 
-        size_t avail = w - r;
-        size_t to_read = std::min(max_len, avail);
-        if (to_read == 0) return 0;
-
-        auto dst = static_cast<uint8_t*>(dest);
-        size_t offset = r % capacity_;
-        size_t first = std::min(to_read, capacity_ - offset);
-        std::memcpy(dst, buf_.data() + offset, first);
-        if (first < to_read) {
-            std::memcpy(dst + first, buf_.data(), to_read - first);
+        const Chunk* chunk = head_;
+        size_t base = head_base_;
+        for (size_t pos = r; pos < end;) {
+            if (pos == base + chunk_bytes_) {
+                chunk = chunk->next.load(std::memory_order_acquire);
+                base += chunk_bytes_;
+            }
+            size_t n = std::min(base + chunk_bytes_, end) - pos;
+            f(std::span<const uint8_t>(chunk->data + (pos - base), n));
+            pos += n;
         }
+        return end - r;
+    }
 
-        read_pos_.store(r + to_read, std::memory_order_release);
-        return to_read;
+    // Consumer: the readable bytes as contiguous pieces, in order.
+    std::vector<std::span<const uint8_t>> readable_spans() const {
+        std::vector<std::span<const uint8_t>> spans;
+        visit_readable(SIZE_MAX, [&spans](std::span<const uint8_t> piece) { spans.push_back(piece); });
+        return spans;
+    }
+
+    // Consumer: release len bytes previously visited. Chunks read to the end
+    // go back to the free list.
+    void consume(size_t len) {
+        size_t r = read_pos_.load(std::memory_order_relaxed) + len;
+        read_pos_.store(r, std::memory_order_release);
+
+        while (r >= head_base_ + chunk_bytes_) {
+            Chunk* next = head_->next.load(std::memory_order_acquire);
+            if (!next) break;  // the producer is still on this chunk
+            recycle(head_);
+            head_ = next;
+            head_base_ += chunk_bytes_;
+        }
     }
 
     // Consumer: drain all available data into a vector of int16_t samples.
     std::vector<int16_t> drain_all() {
-        size_t r = read_pos_.load(std::memory_order_relaxed);
-        size_t w = write_pos_.load(std::memory_order_acquire);
-        size_t avail = w - r;
-
         // Align to sample boundary (2 bytes per int16_t)
-        avail &= ~size_t(1);
+        size_t avail = available() & ~size_t(1);
         if (avail == 0) return {};
 
         std::vector<int16_t> samples(avail / sizeof(int16_t));
@@ -77,14 +165,92 @@ public:
         return w - r;
     }
 
+    // Consumer: drops everything unread.
     void reset() {
-        read_pos_.store(0, std::memory_order_relaxed);
-        write_pos_.store(0, std::memory_order_relaxed);
+        consume(available());
+    }
+
+    size_t capacity() const { return capacity_; }
+    // Whether every chunk came from the storage given to the constructor.
+    bool preallocated() const { return preallocated_; }
+    // Memory held in chunks, queued or on the free list.
+    size_t allocated_bytes() const {
+        return allocated_.load(std::memory_order_relaxed) * chunk_bytes_;
     }
+    // Audio dropped because the buffer was full, and how many writes it took.
+    uint64_t overflow_bytes() const { return overflow_bytes_.load(std::memory_order_relaxed); }
+    uint64_t overflows() const { return overflows_.load(std::memory_order_relaxed); }
 
 private:
-    std::vector<uint8_t> buf_;
+    struct Chunk {
+        uint8_t* data = nullptr;           // into storage, or into buffer
+        std::unique_ptr<uint8_t[]> buffer;  // allocated here (no storage given)
+        std::atomic<Chunk*> next{nullptr};  // in the queue, or on the free list
+    };
+
+    static size_t chunk_size(size_t capacity_bytes, size_t chunk_bytes) {
+        return std::max<size_t>(2, std::min(chunk_bytes, (capacity_bytes + 1) & ~size_t(1)));
+    }
+    // Unread data touches at most this many chunks: a partly read head, a
+    // partly written tail and the full ones between.
+    static size_t chunk_count(size_t capacity_bytes, size_t chunk) {
+        return capacity_bytes / chunk + 2;
+    }
+
+    // Only the producer allocates, and never more than max_chunks_ (so the
+    // reserved owned_ never reallocates on the audio thread).
+    Chunk* allocate() {
+        if (owned_.size() >= max_chunks_) return nullptr;
+        auto* chunk = new (std::nothrow) Chunk;
+        if (!chunk) return nullptr;
+        chunk->buffer.reset(new (std::nothrow) uint8_t[chunk_bytes_]);
+        if (!chunk->buffer) {
+            delete chunk;
+            return nullptr;
+        }
+        chunk->data = chunk->buffer.get();
+        owned_.emplace_back(chunk);
+        allocated_.fetch_add(1, std::memory_order_relaxed);
+        return chunk;
+    }
+
+    // Producer: a chunk from the free list, or a new one while under the cap.
+    // The producer is the only one popping, so the list can't suffer ABA.
+    Chunk* take_chunk() {
+        Chunk* top = free_.load(std::memory_order_acquire);
+        while (top && !free_.compare_exchange_weak(top, top->next.load(std::memory_order_relaxed),
+                                                   std::memory_order_acquire)) {}
+        Chunk* chunk = top ? top : allocate();
+        if (chunk) chunk->next.store(nullptr, std::memory_order_relaxed);
+        return chunk;
+    }
+
+    // Consumer: pushes a drained chunk on the free list.
+    void recycle(Chunk* chunk) {
+        Chunk* top = free_.load(std::memory_order_relaxed);
+        do {
+            chunk->next.store(top, std::memory_order_relaxed);
+        } while (!free_.compare_exchange_weak(top, chunk, std::memory_order_release,
+                                              std::memory_order_relaxed));
+    }
+
     size_t capacity_;
+    size_t chunk_bytes_;
+    size_t max_chunks_;
+    std::vector<std::unique_ptr<Chunk>> owned_;  // producer appends; freed on destruction
+    std::atomic<size_t> allocated_{0};
+    std::atomic<Chunk*> free_{nullptr};
+    bool preallocated_ = false;
+
+    // Producer side: the chunk being written and the position it starts at.
     alignas(64) std::atomic<size_t> write_pos_{0};
+    Chunk* tail_ = nullptr;
+    size_t tail_base_ = 0;
+    std::atomic<uint64_t> overflow_bytes_{0};
+    std::atomic<uint64_t> overflows_{0};
+
+    // Consumer side: the chunk holding read_pos_ and the position it starts at.
     alignas(64) std::atomic<size_t> read_pos_{0};
+    Chunk* head_ = nullptr;
+    size_t head_base_ = 0;
 };
@@ -1,9 +1,30 @@
 #include "session.hpp"
 
+#include <algorithm>
+#include <cstring>
 #include <print>
 
-Session::Session(RingBuffer& ring_buf, AudioCapture& capture, uint32_t sample_rate)
-    : ring_buf_(ring_buf), capture_(capture), sample_rate_(sample_rate) {}
+Session::Session(RingBuffer& ring_buf, AudioCapture& capture, uint32_t sample_rate,
+                 uint32_t max_seconds)
+    : ring_buf_(ring_buf), capture_(capture), sample_rate_(sample_rate),
+      max_samples_(static_cast<size_t>(max_seconds) * sample_rate) {}
+
+bool Session::arm(uint32_t preroll_ms) {
+    ring_buf_.reset();
+    if (!capture_.start()) {
+        std::println(stderr, "session: failed to start audio capture");
+        return false;
+    }
+    armed_ = true;
+    preroll_bytes_ = static_cast<size_t>(preroll_ms) * sample_rate_ / 1000 * sizeof(int16_t);
+    return true;
+}
+
+void Session::discard_stale() {
+    if (!armed_ || state_ == SessionState::Recording) return;
+    size_t avail = ring_buf_.available() & ~size_t(1);
+    if (avail > preroll_bytes_) ring_buf_.consume(avail - preroll_bytes_);
+}
 
 bool Session::start_recording(const WindowInfo& window) {
     if (state_ != SessionState::Idle) {
@@ -11,10 +32,16 @@ bool Session::start_recording(const WindowInfo& window) {
         return false;
     }
 
-    ring_buf_.reset();
-    if (!capture_.start()) {
-        std::println(stderr, "session: failed to start audio capture");
-        return false;
+    samples_.clear();
+    if (armed_ && capture_.is_capturing()) {
+        // The stream is already running; the recording begins with the pre-roll.
+        discard_stale();
+    } else {
+        ring_buf_.reset();
+        if (!capture_.start()) {
+            std::println(stderr, "session: failed to start audio capture");
+            return false;
+        }
     }
 
     window_context_ = window;
@@ -28,10 +55,34 @@ std::vector<int16_t> Session::stop_recording() {
         return {};
     }
 
-    capture_.stop();
-    auto samples = ring_buf_.drain_all();
+    if (!armed_) capture_.stop();
+    pump();
     state_ = SessionState::Transcribing;
-    return samples;
+    return std::move(samples_);
+}
+
+std::span<int16_t> Session::pump() {
+    if (state_ != SessionState::Recording) return {};
+
+    // Copy straight out of the ring buffer's chunks into the recording.
+    size_t bytes = ring_buf_.available() & ~size_t(1);
+    size_t count = bytes / sizeof(int16_t);
+    size_t keep = count;
+    if (max_samples_ > 0) {
+        keep = std::min(count, max_samples_ - std::min(max_samples_, samples_.size()));
+    }
+
+    size_t offset = samples_.size();
+    samples_.resize(offset + keep);
+    auto* dst = reinterpret_cast<uint8_t*>(samples_.data() + offset);
+    ring_buf_.visit_readable(keep * sizeof(int16_t), [&dst](std::span<const uint8_t> piece) {
+        std::memcpy(dst, piece.data(), piece.size());
+        dst += piece.size();
+    });
+
+    // Audio past max_seconds is consumed and dropped, as the ring buffer would.
+    ring_buf_.consume(bytes);
+    return std::span<int16_t>(samples_).subspan(offset);
 }
 
 void Session::set_transcribing() {
@@ -8,6 +8,7 @@
 #include <chrono>
 #include <cstdint>
 #include <functional>
+#include <span>
 #include <string>
 #include <vector>
 
@@ -19,9 +20,24 @@ public:
                                                   uint32_t sample_rate,
                                                   WindowInfo context)>;
 
-    Session(RingBuffer& ring_buf, AudioCapture& capture, uint32_t sample_rate);
+    // max_seconds caps the recording length (0 = unbounded).
+    Session(RingBuffer& ring_buf, AudioCapture& capture, uint32_t sample_rate,
+            uint32_t max_seconds = 0);
+
+    // Keeps capture running between recordings, holding the last preroll_ms
+    // of audio so start is instant and includes the first syllable.
+    bool arm(uint32_t preroll_ms);
+    bool armed() const { return armed_; }
+    // Armed, not recording: drops ring buffer audio older than the pre-roll.
+    void discard_stale();
 
     bool start_recording(const WindowInfo& window);
+    // Moves newly captured audio from the ring buffer into the recording.
+    // Returns the samples appended by this call (valid until the next pump),
+    // writable so they can be cleaned up in place.
+    std::span<int16_t> pump();
+    // Audio recorded so far (valid until the next pump or stop).
+    std::span<const int16_t> samples() const { return samples_; }
     // Returns audio samples if recording was active, empty if not.
     std::vector<int16_t> stop_recording();
     void set_transcribing();
@@ -35,6 +51,10 @@ private:
     RingBuffer& ring_buf_;
     AudioCapture& capture_;
     uint32_t sample_rate_;
+    size_t max_samples_;
+    bool armed_ = false;
+    size_t preroll_bytes_ = 0;
+    std::vector<int16_t> samples_;
     SessionState state_ = SessionState::Idle;
     std::chrono::steady_clock::time_point record_start_;
     WindowInfo window_context_;
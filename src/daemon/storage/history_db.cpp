@@ -1,11 +1,184 @@
 #include "history_db.hpp"
 
+#include <algorithm>
+#include <cctype>
+#include <charconv>
 #include <cstdlib>
 #include <filesystem>
+#include <format>
 #include <print>
 
 namespace fs = std::filesystem;
 
+namespace {
+
+// The writer thread and the daemon's reads use separate connections.
+constexpr int BUSY_TIMEOUT_MS = 1000;
+// A connection opening the file while another upgrades it waits this long.
+constexpr int UPGRADE_BUSY_TIMEOUT_MS = 30000;
+
+// Columns every entry query selects first, in read_entry() order.
+constexpr const char* ENTRY_COLUMNS =
+    "t.id, t.timestamp, t.text, t.audio_duration, t.processing_time, "
+    "ac.value, t.app_id, t.window_class, wt.value, t.agent, wd.value, t.backend, "
+    "t.drain_time, t.encode_time, t.connect_time, t.upload_time, t.inference_time, t.parse_time, "
+    "t.output_time, t.total_time, t.audio_id";
+constexpr int ENTRY_COLUMN_COUNT = 21;
+// Looks the interned context strings up for ENTRY_COLUMNS.
+constexpr const char* ENTRY_JOINS =
+    " LEFT JOIN context_strings ac ON ac.id = t.app_context_id"
+    " LEFT JOIN context_strings wt ON wt.id = t.window_title_id"
+    " LEFT JOIN context_strings wd ON wd.id = t.working_dir_id";
+
+// Filters shared by both search statements: ?1 is the FTS query, ?2..?6 the
+// HistoryFilter fields, ?7/?8 the cursor and ?9 the limit. Unbound are NULL.
+constexpr const char* SEARCH_FILTERS =
+    " AND (?2 IS NULL OR t.app_id = ?2)"
+    " AND (?3 IS NULL OR t.agent = ?3)"
+    " AND (?4 IS NULL OR wd.value = ?4"
+    "      OR substr(wd.value, 1, length(?4) + 1) = ?4 || '/')"
+    " AND (?5 IS NULL OR t.timestamp >= ?5)"
+    " AND (?6 IS NULL OR t.timestamp < ?6)";
+
+// Rollup keys and values of one transcriptions row, `r` being new, old or t.
+// Words are counted as the spaces in the trimmed text plus one, which is
+// what whisper's single-spaced output gives.
+std::string rollup_day(std::string_view r) { return std::format("substr({}.timestamp, 1, 10)", r); }
+std::string rollup_app(std::string_view r) { return std::format("COALESCE({0}.app_id, {0}.window_class, '')", r); }
+std::string rollup_agent(std::string_view r) { return std::format("COALESCE({}.agent, '')", r); }
+std::string rollup_backend(std::string_view r) { return std::format("COALESCE({}.backend, '')", r); }
+std::string rollup_words(std::string_view r) {
+    return std::format("(CASE WHEN trim({0}.text) = '' THEN 0 "
+                       "ELSE length(trim({0}.text)) - length(replace(trim({0}.text), ' ', '')) + 1 END)", r);
+}
+
+bool has_table(sqlite3* db, const char* name) {
+    bool found = false;
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v2(db, "SELECT 1 FROM sqlite_master WHERE name = ?", -1, &stmt, nullptr) == SQLITE_OK) {
+        sqlite3_bind_text(stmt, 1, name, -1, SQLITE_STATIC);
+        found = sqlite3_step(stmt) == SQLITE_ROW;
+    }
+    sqlite3_finalize(stmt);
+    return found;
+}
+
+bool has_column(sqlite3* db, const char* table, const char* column) {
+    bool found = false;
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v2(db, "SELECT 1 FROM pragma_table_info(?) WHERE name = ?", -1, &stmt, nullptr) ==
+        SQLITE_OK) {
+        sqlite3_bind_text(stmt, 1, table, -1, SQLITE_STATIC);
+        sqlite3_bind_text(stmt, 2, column, -1, SQLITE_STATIC);
+        found = sqlite3_step(stmt) == SQLITE_ROW;
+    }
+    sqlite3_finalize(stmt);
+    return found;
+}
+
+int pragma_int(sqlite3* db, const char* sql) {
+    int value = 0;
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) == SQLITE_OK && sqlite3_step(stmt) == SQLITE_ROW) {
+        value = sqlite3_column_int(stmt, 0);
+    }
+    sqlite3_finalize(stmt);
+    return value;
+}
+
+// Resets a prepared statement on the way out. One left on a row keeps its
+// connection's read transaction open: the connection goes on seeing that
+// snapshot, can't start writing after another connection has, and holds
+// off checkpoints.
+struct ResetOnExit {
+    sqlite3_stmt* stmt;
+    ~ResetOnExit() { sqlite3_reset(stmt); }
+};
+
+std::string get_text(sqlite3_stmt* stmt, int col) {
+    auto* p = sqlite3_column_text(stmt, col);
+    return p ? reinterpret_cast<const char*>(p) : "";
+}
+
+std::optional<double> get_time(sqlite3_stmt* stmt, int col) {
+    if (sqlite3_column_type(stmt, col) == SQLITE_NULL) return std::nullopt;
+    return sqlite3_column_double(stmt, col);
+}
+
+HistoryEntry read_entry(sqlite3_stmt* stmt) {
+    HistoryEntry e;
+    e.id = sqlite3_column_int64(stmt, 0);
+    e.timestamp = get_text(stmt, 1);
+    e.text = get_text(stmt, 2);
+    e.audio_duration = sqlite3_column_double(stmt, 3);
+    e.processing_time = sqlite3_column_double(stmt, 4);
+    e.app_context = get_text(stmt, 5);
+    e.app_id = get_text(stmt, 6);
+    e.window_class = get_text(stmt, 7);
+    e.window_title = get_text(stmt, 8);
+    e.agent = get_text(stmt, 9);
+    e.working_dir = get_text(stmt, 10);
+    e.backend = get_text(stmt, 11);
+    e.timings.drain_s = get_time(stmt, 12);
+    e.timings.encode_s = get_time(stmt, 13);
+    e.timings.connect_s = get_time(stmt, 14);
+    e.timings.upload_s = get_time(stmt, 15);
+    e.timings.inference_s = get_time(stmt, 16);
+    e.timings.parse_s = get_time(stmt, 17);
+    e.timings.output_s = get_time(stmt, 18);
+    e.timings.total_s = get_time(stmt, 19);
+    e.audio_id = static_cast<uint64_t>(sqlite3_column_int64(stmt, 20));
+    return e;
+}
+
+// Turns free text into an FTS5 query: every word becomes a quoted string, so
+// punctuation and FTS keywords (AND, NEAR, ...) are matched literally. A
+// trailing * is kept as a prefix match.
+std::string fts_query(std::string_view text) {
+    std::string out;
+    size_t i = 0;
+    while (i < text.size()) {
+        while (i < text.size() && std::isspace(static_cast<unsigned char>(text[i]))) ++i;
+        size_t start = i;
+        while (i < text.size() && !std::isspace(static_cast<unsigned char>(text[i]))) ++i;
+        auto word = text.substr(start, i - start);
+        if (word.empty()) continue;
+
+        bool prefix = word.size() > 1 && word.back() == '*';
+        if (prefix) word.remove_suffix(1);
+
+        if (!out.empty()) out += ' ';
+        out += '"';
+        for (char c : word) {
+            if (c == '"') out += '"';
+            out += c;
+        }
+        out += '"';
+        if (prefix) out += '*';
+    }
+    return out;
+}
+
+} // namespace
+
+std::string SearchCursor::encode() const {
+    return std::format("{},{}", rank, id);
+}
+
+std::optional<SearchCursor> SearchCursor::parse(std::string_view s) {
+    auto comma = s.find(',');
+    if (comma == std::string_view::npos) return std::nullopt;
+
+    SearchCursor c;
+    auto rank = s.substr(0, comma);
+    auto id = s.substr(comma + 1);
+    if (std::from_chars(rank.data(), rank.data() + rank.size(), c.rank).ptr != rank.data() + rank.size() ||
+        std::from_chars(id.data(), id.data() + id.size(), c.id).ptr != id.data() + id.size()) {
+        return std::nullopt;
+    }
+    return c;
+}
+
 HistoryDb::HistoryDb() = default;
 
 HistoryDb::~HistoryDb() {
@@ -25,63 +198,261 @@ bool HistoryDb::open(const std::string& path) {
         return false;
     }
 
-    // Enable WAL mode for better concurrent access
-    sqlite3_exec(db_, "PRAGMA journal_mode=WAL;", nullptr, nullptr, nullptr);
+    // Only takes effect before the first table is created; older databases
+    // are converted by migrate_schema(). maintain() hands the pages that
+    // deleted rows free back to the file system.
+    sqlite3_exec(db_, "PRAGMA auto_vacuum=INCREMENTAL;", nullptr, nullptr, nullptr);
+    // Enable WAL mode for better concurrent access. With WAL, NORMAL only
+    // syncs at checkpoints: a power cut can lose the last commits, never
+    // corrupt the database.
+    sqlite3_exec(db_, "PRAGMA journal_mode=WAL; PRAGMA synchronous=NORMAL;", nullptr, nullptr,
+                 nullptr);
+    sqlite3_busy_timeout(db_, BUSY_TIMEOUT_MS);
 
-    if (!create_tables()) return false;
-    migrate_schema();
+    if (schema_version() < SCHEMA_VERSION && !upgrade_schema()) return false;
+    // auto_vacuum only changes with a VACUUM, which rewrites the whole file
+    // (and gives back what the version 3 migration freed). It can't run in
+    // a transaction; if another connection is busy it's tried on the next open.
+    if (pragma_int(db_, "PRAGMA auto_vacuum") != 2) {
+        sqlite3_exec(db_, "PRAGMA auto_vacuum=INCREMENTAL; VACUUM;", nullptr, nullptr, nullptr);
+    }
+    bool have_fts = create_search_index();
 
     // Prepare statements
     const char* insert_sql =
         "INSERT INTO transcriptions (text, audio_duration, processing_time, "
-        "app_context, app_id, window_class, window_title, agent, working_dir, backend) "
-        "VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?)";
+        "app_context_id, app_id, window_class, window_title_id, agent, working_dir_id, backend, "
+        "drain_time, encode_time, connect_time, upload_time, inference_time, parse_time, "
+        "output_time, total_time, audio_id, timestamp) "
+        "VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, "
+        "COALESCE(?, strftime('%Y-%m-%dT%H:%M:%f','now')))";
+
+    auto recent_sql = std::format(
+        "SELECT {} FROM transcriptions t{} ORDER BY t.id DESC LIMIT ?", ENTRY_COLUMNS, ENTRY_JOINS);
+    auto after_sql = std::format(
+        "SELECT {} FROM transcriptions t{} WHERE t.id > ? ORDER BY t.id LIMIT ?", ENTRY_COLUMNS, ENTRY_JOINS);
+    auto get_sql = std::format("SELECT {} FROM transcriptions t{} WHERE t.id = ?", ENTRY_COLUMNS, ENTRY_JOINS);
+
+    // The cursor keeps pages stable without OFFSET, which would rescan every
+    // earlier page. The snippet is around the best-matching terms.
+    auto search_sql = std::format(
+        "SELECT {}, snippet(transcriptions_fts, 0, '[', ']', '...', 16), transcriptions_fts.rank "
+        "FROM transcriptions_fts JOIN transcriptions t ON t.id = transcriptions_fts.rowid{} "
+        "WHERE transcriptions_fts MATCH ?1{}"
+        " AND (?7 IS NULL OR transcriptions_fts.rank > ?7"
+        "      OR (transcriptions_fts.rank = ?7 AND t.id < ?8))"
+        " ORDER BY transcriptions_fts.rank, t.id DESC LIMIT ?9",
+        ENTRY_COLUMNS, ENTRY_JOINS, SEARCH_FILTERS);
 
-    const char* recent_sql =
-        "SELECT id, timestamp, text, audio_duration, processing_time, "
-        "app_context, app_id, window_class, window_title, agent, working_dir, backend "
-        "FROM transcriptions ORDER BY id DESC LIMIT ?";
+    auto filter_sql = std::format(
+        "SELECT {}, t.text, 0.0 FROM transcriptions t{} WHERE ?1 IS NULL{}"
+        " AND (?7 IS NULL OR t.id < ?8)"
+        " ORDER BY t.id DESC LIMIT ?9",
+        ENTRY_COLUMNS, ENTRY_JOINS, SEARCH_FILTERS);
 
     if (sqlite3_prepare_v2(db_, insert_sql, -1, &insert_stmt_, nullptr) != SQLITE_OK) {
         std::println(stderr, "db: prepare insert failed: {}", sqlite3_errmsg(db_));
         return false;
     }
 
-    if (sqlite3_prepare_v2(db_, recent_sql, -1, &recent_stmt_, nullptr) != SQLITE_OK) {
+    if (sqlite3_prepare_v2(db_, "SELECT id FROM context_strings WHERE value = ?", -1, &find_string_stmt_,
+                           nullptr) != SQLITE_OK ||
+        sqlite3_prepare_v2(db_, "INSERT INTO context_strings (value) VALUES (?)", -1, &add_string_stmt_,
+                           nullptr) != SQLITE_OK) {
+        std::println(stderr, "db: prepare context strings failed: {}", sqlite3_errmsg(db_));
+        return false;
+    }
+
+    if (sqlite3_prepare_v2(db_, recent_sql.c_str(), -1, &recent_stmt_, nullptr) != SQLITE_OK) {
         std::println(stderr, "db: prepare recent failed: {}", sqlite3_errmsg(db_));
         return false;
     }
 
+    if (sqlite3_prepare_v2(db_, after_sql.c_str(), -1, &after_stmt_, nullptr) != SQLITE_OK) {
+        std::println(stderr, "db: prepare after failed: {}", sqlite3_errmsg(db_));
+        return false;
+    }
+
+    if (sqlite3_prepare_v2(db_, get_sql.c_str(), -1, &get_stmt_, nullptr) != SQLITE_OK) {
+        std::println(stderr, "db: prepare get failed: {}", sqlite3_errmsg(db_));
+        return false;
+    }
+
+    if (sqlite3_prepare_v2(db_, filter_sql.c_str(), -1, &filter_stmt_, nullptr) != SQLITE_OK) {
+        std::println(stderr, "db: prepare filter failed: {}", sqlite3_errmsg(db_));
+        return false;
+    }
+
+    if (have_fts && sqlite3_prepare_v2(db_, search_sql.c_str(), -1, &search_stmt_, nullptr) != SQLITE_OK) {
+        std::println(stderr, "db: prepare search failed: {}", sqlite3_errmsg(db_));
+    }
+
     return true;
 }
 
 void HistoryDb::close() {
     if (insert_stmt_) { sqlite3_finalize(insert_stmt_); insert_stmt_ = nullptr; }
     if (recent_stmt_) { sqlite3_finalize(recent_stmt_); recent_stmt_ = nullptr; }
+    if (after_stmt_) { sqlite3_finalize(after_stmt_); after_stmt_ = nullptr; }
+    if (get_stmt_) { sqlite3_finalize(get_stmt_); get_stmt_ = nullptr; }
+    if (search_stmt_) { sqlite3_finalize(search_stmt_); search_stmt_ = nullptr; }
+    if (filter_stmt_) { sqlite3_finalize(filter_stmt_); filter_stmt_ = nullptr; }
+    if (find_string_stmt_) { sqlite3_finalize(find_string_stmt_); find_string_stmt_ = nullptr; }
+    if (add_string_stmt_) { sqlite3_finalize(add_string_stmt_); add_string_stmt_ = nullptr; }
     if (db_) { sqlite3_close(db_); db_ = nullptr; }
 }
 
 bool HistoryDb::insert(const std::string& text, double audio_duration, double processing_time,
-                       const WindowInfo& ctx, const std::string& backend) {
+                       const WindowInfo& context, const std::string& backend,
+                       const StageTimings& timings) {
+    return insert(HistoryRecord{
+        .text = text,
+        .audio_duration = audio_duration,
+        .processing_time = processing_time,
+        .context = context,
+        .backend = backend,
+        .timings = timings,
+    });
+}
+
+bool HistoryDb::insert_batch(std::span<const HistoryRecord> records) {
     if (!insert_stmt_) return false;
 
+    if (sqlite3_exec(db_, "BEGIN IMMEDIATE", nullptr, nullptr, nullptr) != SQLITE_OK) {
+        std::println(stderr, "db: begin failed: {}", sqlite3_errmsg(db_));
+        return false;
+    }
+    // A row that fails is logged by insert() and doesn't hold back the rest.
+    bool ok = true;
+    for (auto& r : records) ok = insert(r) && ok;
+
+    if (sqlite3_exec(db_, "COMMIT", nullptr, nullptr, nullptr) != SQLITE_OK) {
+        std::println(stderr, "db: commit failed: {}", sqlite3_errmsg(db_));
+        sqlite3_exec(db_, "ROLLBACK", nullptr, nullptr, nullptr);
+        return false;
+    }
+    return ok;
+}
+
+bool HistoryDb::import(std::span<const HistoryRecord> records) {
+    if (!insert_stmt_) return false;
+
+    if (sqlite3_exec(db_, "BEGIN IMMEDIATE", nullptr, nullptr, nullptr) != SQLITE_OK) {
+        std::println(stderr, "db: begin failed: {}", sqlite3_errmsg(db_));
+        return false;
+    }
+    for (auto& r : records) {
+        if (!insert(r)) {
+            sqlite3_exec(db_, "ROLLBACK", nullptr, nullptr, nullptr);
+            return false;
+        }
+    }
+    if (sqlite3_exec(db_, "COMMIT", nullptr, nullptr, nullptr) != SQLITE_OK) {
+        std::println(stderr, "db: commit failed: {}", sqlite3_errmsg(db_));
+        sqlite3_exec(db_, "ROLLBACK", nullptr, nullptr, nullptr);
+        return false;
+    }
+    return true;
+}
+
+void HistoryDb::set_auto_checkpoint(bool enabled) {
+    if (db_) sqlite3_wal_autocheckpoint(db_, enabled ? 1000 : 0);
+}
+
+void HistoryDb::checkpoint() {
+    if (!db_) return;
+    // PASSIVE copies what it can without waiting on readers.
+    int rc = sqlite3_wal_checkpoint_v2(db_, nullptr, SQLITE_CHECKPOINT_PASSIVE, nullptr, nullptr);
+    if (rc != SQLITE_OK && rc != SQLITE_BUSY) {
+        std::println(stderr, "db: checkpoint failed: {}", sqlite3_errmsg(db_));
+    }
+}
+
+void HistoryDb::maintain() {
+    if (!db_) return;
+    // optimize runs ANALYZE where the query planner's statistics have gone
+    // stale. The incremental vacuum moves free pages to the end of the file
+    // and the TRUNCATE checkpoint, which waits for readers, copies that back
+    // and empties the WAL, so both files shrink. Then this connection drops
+    // its page cache until the next query needs it.
+    const char* sql = "PRAGMA optimize; PRAGMA incremental_vacuum; PRAGMA wal_checkpoint(TRUNCATE);";
+    char* err = nullptr;
+    if (sqlite3_exec(db_, sql, nullptr, nullptr, &err) != SQLITE_OK) {
+        std::println(stderr, "db: maintenance failed: {}", err ? err : "unknown");
+        sqlite3_free(err);
+    }
+    sqlite3_db_release_memory(db_);
+}
+
+int64_t HistoryDb::intern(const std::string& value) {
+    if (value.empty()) return 0;
+
+    {
+        ResetOnExit reset{find_string_stmt_};
+        sqlite3_bind_text(find_string_stmt_, 1, value.c_str(), static_cast<int>(value.size()), SQLITE_STATIC);
+        if (sqlite3_step(find_string_stmt_) == SQLITE_ROW) return sqlite3_column_int64(find_string_stmt_, 0);
+    }
+
+    ResetOnExit reset{add_string_stmt_};
+    sqlite3_bind_text(add_string_stmt_, 1, value.c_str(), static_cast<int>(value.size()), SQLITE_STATIC);
+    if (sqlite3_step(add_string_stmt_) != SQLITE_DONE) {
+        std::println(stderr, "db: insert failed: {}", sqlite3_errmsg(db_));
+        return -1;
+    }
+    return sqlite3_last_insert_rowid(db_);
+}
+
+bool HistoryDb::insert(const HistoryRecord& record) {
+    if (!insert_stmt_) return false;
+    // Outside a transaction, the row and the strings it interns commit together.
+    if (sqlite3_get_autocommit(db_)) return insert_batch(std::span(&record, 1));
+
+    auto& ctx = record.context;
+    auto& timings = record.timings;
+
+    int64_t string_ids[] = {intern(ctx.context), intern(ctx.title), intern(ctx.working_dir)};
+    if (std::ranges::find(string_ids, -1) != std::end(string_ids)) return false;
+
     sqlite3_reset(insert_stmt_);
-    sqlite3_bind_text(insert_stmt_, 1, text.c_str(), -1, SQLITE_TRANSIENT);
-    sqlite3_bind_double(insert_stmt_, 2, audio_duration);
-    sqlite3_bind_double(insert_stmt_, 3, processing_time);
+    sqlite3_bind_text(insert_stmt_, 1, record.text.c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_double(insert_stmt_, 2, record.audio_duration);
+    sqlite3_bind_double(insert_stmt_, 3, record.processing_time);
 
     auto bind_nullable = [this](int idx, const std::string& val) {
         if (val.empty()) sqlite3_bind_null(insert_stmt_, idx);
         else sqlite3_bind_text(insert_stmt_, idx, val.c_str(), -1, SQLITE_TRANSIENT);
     };
 
-    bind_nullable(4, ctx.context);
+    auto bind_string_id = [this](int idx, int64_t id) {
+        if (id == 0) sqlite3_bind_null(insert_stmt_, idx);
+        else sqlite3_bind_int64(insert_stmt_, idx, id);
+    };
+
+    bind_string_id(4, string_ids[0]);
     bind_nullable(5, ctx.app_id);
     bind_nullable(6, ctx.window_class);
-    bind_nullable(7, ctx.title);
+    bind_string_id(7, string_ids[1]);
     bind_nullable(8, ctx.agent);
-    bind_nullable(9, ctx.working_dir);
-    bind_nullable(10, backend);
+    bind_string_id(9, string_ids[2]);
+    bind_nullable(10, record.backend);
+
+    auto bind_time = [this](int idx, const std::optional<double>& val) {
+        if (val) sqlite3_bind_double(insert_stmt_, idx, *val);
+        else sqlite3_bind_null(insert_stmt_, idx);
+    };
+
+    bind_time(11, timings.drain_s);
+    bind_time(12, timings.encode_s);
+    bind_time(13, timings.connect_s);
+    bind_time(14, timings.upload_s);
+    bind_time(15, timings.inference_s);
+    bind_time(16, timings.parse_s);
+    bind_time(17, timings.output_s);
+    bind_time(18, timings.total_s);
+
+    if (record.audio_id) sqlite3_bind_int64(insert_stmt_, 19, static_cast<int64_t>(record.audio_id));
+    else sqlite3_bind_null(insert_stmt_, 19);
+    bind_nullable(20, record.timestamp);
 
     int rc = sqlite3_step(insert_stmt_);
     if (rc != SQLITE_DONE) {
@@ -98,31 +469,225 @@ std::vector<HistoryEntry> HistoryDb::recent(int limit) {
     sqlite3_reset(recent_stmt_);
     sqlite3_bind_int(recent_stmt_, 1, limit);
 
-    auto get_text = [](sqlite3_stmt* stmt, int col) -> std::string {
-        auto* p = sqlite3_column_text(stmt, col);
-        return p ? reinterpret_cast<const char*>(p) : "";
+    while (sqlite3_step(recent_stmt_) == SQLITE_ROW) {
+        entries.push_back(read_entry(recent_stmt_));
+    }
+
+    return entries;
+}
+
+std::vector<HistoryEntry> HistoryDb::after(int64_t after_id, int limit) {
+    std::vector<HistoryEntry> entries;
+    if (!after_stmt_) return entries;
+
+    sqlite3_reset(after_stmt_);
+    sqlite3_bind_int64(after_stmt_, 1, after_id);
+    sqlite3_bind_int(after_stmt_, 2, limit);
+    while (sqlite3_step(after_stmt_) == SQLITE_ROW) {
+        entries.push_back(read_entry(after_stmt_));
+    }
+    return entries;
+}
+
+std::optional<HistoryEntry> HistoryDb::get(int64_t id) {
+    if (!get_stmt_) return std::nullopt;
+
+    // The entry is read before the statement is reset.
+    ResetOnExit reset{get_stmt_};
+    sqlite3_bind_int64(get_stmt_, 1, id);
+    if (sqlite3_step(get_stmt_) != SQLITE_ROW) return std::nullopt;
+    return read_entry(get_stmt_);
+}
+
+std::expected<SearchPage, std::string> HistoryDb::search(const std::string& query,
+                                                         const HistoryFilter& filter,
+                                                         std::optional<SearchCursor> after,
+                                                         int limit) {
+    auto match = fts_query(query);
+    sqlite3_stmt* stmt = match.empty() ? filter_stmt_ : search_stmt_;
+    if (!stmt) {
+        return std::unexpected(db_ ? "full-text search unavailable (SQLite without FTS5)"
+                                   : "history disabled");
+    }
+
+    limit = std::max(limit, 1);
+    // A full page stops before the last row.
+    ResetOnExit reset{stmt};
+    sqlite3_clear_bindings(stmt);
+
+    auto bind_filter = [stmt](int idx, const std::string& val) {
+        if (!val.empty()) sqlite3_bind_text(stmt, idx, val.c_str(), -1, SQLITE_TRANSIENT);
     };
 
-    while (sqlite3_step(recent_stmt_) == SQLITE_ROW) {
-        HistoryEntry e;
-        e.id = sqlite3_column_int64(recent_stmt_, 0);
-        e.timestamp = get_text(recent_stmt_, 1);
-        e.text = get_text(recent_stmt_, 2);
-        e.audio_duration = sqlite3_column_double(recent_stmt_, 3);
-        e.processing_time = sqlite3_column_double(recent_stmt_, 4);
-        e.app_context = get_text(recent_stmt_, 5);
-        e.app_id = get_text(recent_stmt_, 6);
-        e.window_class = get_text(recent_stmt_, 7);
-        e.window_title = get_text(recent_stmt_, 8);
-        e.agent = get_text(recent_stmt_, 9);
-        e.working_dir = get_text(recent_stmt_, 10);
-        e.backend = get_text(recent_stmt_, 11);
-        entries.push_back(std::move(e));
+    bind_filter(1, match);
+    bind_filter(2, filter.app_id);
+    bind_filter(3, filter.agent);
+    bind_filter(4, filter.working_dir);
+    bind_filter(5, filter.since);
+    bind_filter(6, filter.before);
+    if (after) {
+        sqlite3_bind_double(stmt, 7, after->rank);
+        sqlite3_bind_int64(stmt, 8, after->id);
+    }
+    // One extra row tells whether there is a next page.
+    sqlite3_bind_int(stmt, 9, limit + 1);
+
+    SearchPage page;
+    int rc;
+    while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+        if (page.hits.size() == static_cast<size_t>(limit)) {
+            auto& last = page.hits.back();
+            page.next = SearchCursor{.rank = last.rank, .id = last.entry.id};
+            break;
+        }
+        page.hits.push_back(SearchHit{
+            .entry = read_entry(stmt),
+            .snippet = get_text(stmt, ENTRY_COLUMN_COUNT),
+            .rank = sqlite3_column_double(stmt, ENTRY_COLUMN_COUNT + 1),
+        });
+    }
+    if (rc != SQLITE_ROW && rc != SQLITE_DONE) {
+        return std::unexpected(std::format("search failed: {}", sqlite3_errmsg(db_)));
+    }
+    return page;
+}
+
+std::expected<HistoryStats, std::string> HistoryDb::stats(const std::string& since,
+                                                         const std::string& before) {
+    if (!db_) return std::unexpected("history disabled");
+
+    // Empty bounds bind as NULL and drop out.
+    auto query = [this, &since, &before](const char* sql, auto&& read) -> std::optional<std::string> {
+        sqlite3_stmt* stmt = nullptr;
+        if (sqlite3_prepare_v2(db_, sql, -1, &stmt, nullptr) != SQLITE_OK) {
+            return std::format("stats failed: {}", sqlite3_errmsg(db_));
+        }
+        if (!since.empty()) sqlite3_bind_text(stmt, 1, since.c_str(), -1, SQLITE_TRANSIENT);
+        if (!before.empty()) sqlite3_bind_text(stmt, 2, before.c_str(), -1, SQLITE_TRANSIENT);
+        int rc;
+        while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) read(stmt);
+        sqlite3_finalize(stmt);
+        if (rc != SQLITE_DONE) return std::format("stats failed: {}", sqlite3_errmsg(db_));
+        return std::nullopt;
+    };
+
+    HistoryStats stats;
+    auto err = query(
+        "SELECT day, app, agent, entries, words, audio_seconds FROM daily_usage "
+        "WHERE entries > 0 AND (?1 IS NULL OR day >= ?1) AND (?2 IS NULL OR day < ?2) "
+        "ORDER BY day, entries DESC",
+        [&stats](sqlite3_stmt* stmt) {
+            stats.days.push_back({
+                .day = get_text(stmt, 0),
+                .app = get_text(stmt, 1),
+                .agent = get_text(stmt, 2),
+                .entries = sqlite3_column_int64(stmt, 3),
+                .words = sqlite3_column_int64(stmt, 4),
+                .audio_seconds = sqlite3_column_double(stmt, 5),
+            });
+        });
+    if (!err) {
+        err = query(
+            "SELECT backend, SUM(entries), SUM(audio_seconds), SUM(processing_seconds) FROM daily_backend "
+            "WHERE (?1 IS NULL OR day >= ?1) AND (?2 IS NULL OR day < ?2) "
+            "GROUP BY backend HAVING SUM(entries) > 0 ORDER BY SUM(entries) DESC",
+            [&stats](sqlite3_stmt* stmt) {
+                stats.backends.push_back({
+                    .backend = get_text(stmt, 0),
+                    .entries = sqlite3_column_int64(stmt, 1),
+                    .audio_seconds = sqlite3_column_double(stmt, 2),
+                    .processing_seconds = sqlite3_column_double(stmt, 3),
+                });
+            });
+    }
+    if (err) return std::unexpected(*err);
+    return stats;
+}
+
+bool HistoryDb::cache_put(const CachedTranscript& entry) {
+    if (!db_) return false;
+
+    sqlite3_stmt* stmt = nullptr;
+    const char* sql = "INSERT OR REPLACE INTO transcript_cache (key, text, audio_duration, processing_time) "
+                      "VALUES (?, ?, ?, ?)";
+    if (sqlite3_prepare_v2(db_, sql, -1, &stmt, nullptr) != SQLITE_OK) {
+        std::println(stderr, "db: prepare cache insert failed: {}", sqlite3_errmsg(db_));
+        return false;
     }
+    sqlite3_bind_int64(stmt, 1, static_cast<sqlite3_int64>(entry.key));
+    sqlite3_bind_text(stmt, 2, entry.text.c_str(), static_cast<int>(entry.text.size()), SQLITE_STATIC);
+    sqlite3_bind_double(stmt, 3, entry.audio_duration);
+    sqlite3_bind_double(stmt, 4, entry.processing_time);
+    int rc = sqlite3_step(stmt);
+    sqlite3_finalize(stmt);
+    if (rc != SQLITE_DONE) {
+        std::println(stderr, "db: cache insert failed: {}", sqlite3_errmsg(db_));
+        return false;
+    }
+    return true;
+}
 
+std::vector<CachedTranscript> HistoryDb::cache_load(size_t keep) {
+    std::vector<CachedTranscript> entries;
+    if (!db_) return entries;
+
+    sqlite3_stmt* stmt = nullptr;
+    const char* sql = "SELECT key, text, audio_duration, processing_time FROM transcript_cache "
+                      "ORDER BY id DESC LIMIT ?";
+    if (sqlite3_prepare_v2(db_, sql, -1, &stmt, nullptr) != SQLITE_OK) return entries;
+    sqlite3_bind_int64(stmt, 1, static_cast<sqlite3_int64>(keep));
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        entries.push_back({
+            .key = static_cast<uint64_t>(sqlite3_column_int64(stmt, 0)),
+            .text = get_text(stmt, 1),
+            .audio_duration = sqlite3_column_double(stmt, 2),
+            .processing_time = sqlite3_column_double(stmt, 3),
+        });
+    }
+    sqlite3_finalize(stmt);
+
+    if (sqlite3_prepare_v2(db_,
+                           "DELETE FROM transcript_cache WHERE key NOT IN "
+                           "(SELECT key FROM transcript_cache ORDER BY id DESC LIMIT ?)",
+                           -1, &stmt, nullptr) == SQLITE_OK) {
+        sqlite3_bind_int64(stmt, 1, static_cast<sqlite3_int64>(keep));
+        sqlite3_step(stmt);
+    }
+    sqlite3_finalize(stmt);
     return entries;
 }
 
+int HistoryDb::schema_version() {
+    int version = 0;
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v2(db_, "PRAGMA user_version", -1, &stmt, nullptr) == SQLITE_OK &&
+        sqlite3_step(stmt) == SQLITE_ROW) {
+        version = sqlite3_column_int(stmt, 0);
+    }
+    sqlite3_finalize(stmt);
+    return version;
+}
+
+bool HistoryDb::upgrade_schema() {
+    // Another connection to the file may be opening it too. The write lock
+    // comes first and the version is read again under it, so one of them
+    // upgrades and the others find it done.
+    sqlite3_busy_timeout(db_, UPGRADE_BUSY_TIMEOUT_MS);
+    bool ok = sqlite3_exec(db_, "BEGIN IMMEDIATE", nullptr, nullptr, nullptr) == SQLITE_OK;
+    if (ok && schema_version() < SCHEMA_VERSION) {
+        ok = create_tables() && migrate_schema() && create_rollups() &&
+             sqlite3_exec(db_, std::format("PRAGMA user_version = {}", SCHEMA_VERSION).c_str(), nullptr,
+                          nullptr, nullptr) == SQLITE_OK;
+    }
+    ok = ok && sqlite3_exec(db_, "COMMIT", nullptr, nullptr, nullptr) == SQLITE_OK;
+    if (!ok) {
+        std::println(stderr, "db: schema upgrade failed: {}", sqlite3_errmsg(db_));
+        sqlite3_exec(db_, "ROLLBACK", nullptr, nullptr, nullptr);
+    }
+    sqlite3_busy_timeout(db_, BUSY_TIMEOUT_MS);
+    return ok;
+}
+
 bool HistoryDb::create_tables() {
     const char* sql = R"(
         CREATE TABLE IF NOT EXISTS transcriptions (
@@ -131,13 +696,33 @@ bool HistoryDb::create_tables() {
             text TEXT NOT NULL,
             audio_duration REAL,
             processing_time REAL,
-            app_context TEXT,
+            app_context_id INTEGER,
             app_id TEXT,
             window_class TEXT,
-            window_title TEXT,
+            window_title_id INTEGER,
             agent TEXT,
-            working_dir TEXT,
-            backend TEXT
+            working_dir_id INTEGER,
+            backend TEXT,
+            drain_time REAL,
+            encode_time REAL,
+            connect_time REAL,
+            upload_time REAL,
+            inference_time REAL,
+            parse_time REAL,
+            output_time REAL,
+            total_time REAL,
+            audio_id INTEGER
+        );
+        CREATE TABLE IF NOT EXISTS context_strings (
+            id INTEGER PRIMARY KEY,
+            value TEXT NOT NULL UNIQUE
+        );
+        CREATE TABLE IF NOT EXISTS transcript_cache (
+            id INTEGER PRIMARY KEY AUTOINCREMENT,
+            key INTEGER NOT NULL UNIQUE,
+            text TEXT NOT NULL,
+            audio_duration REAL,
+            processing_time REAL
         );
     )";
 
@@ -151,20 +736,177 @@ bool HistoryDb::create_tables() {
     return true;
 }
 
-void HistoryDb::migrate_schema() {
+bool HistoryDb::migrate_schema() {
     // ALTER TABLE ADD COLUMN is a no-op if the column already exists in SQLite
     // (returns error, which we ignore). This handles upgrades from older schemas.
     static const char* migrations[] = {
-        "ALTER TABLE transcriptions ADD COLUMN app_context TEXT",
+        "ALTER TABLE transcriptions ADD COLUMN app_context_id INTEGER",
         "ALTER TABLE transcriptions ADD COLUMN app_id TEXT",
         "ALTER TABLE transcriptions ADD COLUMN window_class TEXT",
-        "ALTER TABLE transcriptions ADD COLUMN window_title TEXT",
+        "ALTER TABLE transcriptions ADD COLUMN window_title_id INTEGER",
         "ALTER TABLE transcriptions ADD COLUMN agent TEXT",
-        "ALTER TABLE transcriptions ADD COLUMN working_dir TEXT",
+        "ALTER TABLE transcriptions ADD COLUMN working_dir_id INTEGER",
         "ALTER TABLE transcriptions ADD COLUMN backend TEXT",
+        "ALTER TABLE transcriptions ADD COLUMN drain_time REAL",
+        "ALTER TABLE transcriptions ADD COLUMN encode_time REAL",
+        "ALTER TABLE transcriptions ADD COLUMN connect_time REAL",
+        "ALTER TABLE transcriptions ADD COLUMN upload_time REAL",
+        "ALTER TABLE transcriptions ADD COLUMN inference_time REAL",
+        "ALTER TABLE transcriptions ADD COLUMN parse_time REAL",
+        "ALTER TABLE transcriptions ADD COLUMN output_time REAL",
+        "ALTER TABLE transcriptions ADD COLUMN total_time REAL",
+        "ALTER TABLE transcriptions ADD COLUMN audio_id INTEGER",
     };
 
     for (const char* sql : migrations) {
         sqlite3_exec(db_, sql, nullptr, nullptr, nullptr);
     }
+
+    // Before version 3 every row held its own copy of the window title,
+    // working directory and app context. Each distinct string moves to
+    // context_strings once and the rows keep its id. A row whose string is
+    // already gone keeps the id it has.
+    if (has_column(db_, "transcriptions", "window_title")) {
+        for (const char* column : {"app_context", "window_title", "working_dir"}) {
+            sqlite3_exec(db_, std::format("ALTER TABLE transcriptions ADD COLUMN {} TEXT", column).c_str(),
+                         nullptr, nullptr, nullptr);
+        }
+        const char* intern = R"(
+            INSERT OR IGNORE INTO context_strings (value)
+                SELECT app_context FROM transcriptions WHERE app_context IS NOT NULL
+                UNION SELECT window_title FROM transcriptions WHERE window_title IS NOT NULL
+                UNION SELECT working_dir FROM transcriptions WHERE working_dir IS NOT NULL;
+            UPDATE transcriptions SET
+                app_context_id = COALESCE((SELECT id FROM context_strings WHERE value = app_context),
+                                          app_context_id),
+                window_title_id = COALESCE((SELECT id FROM context_strings WHERE value = window_title),
+                                           window_title_id),
+                working_dir_id = COALESCE((SELECT id FROM context_strings WHERE value = working_dir),
+                                          working_dir_id),
+                app_context = NULL, window_title = NULL, working_dir = NULL
+            WHERE app_context IS NOT NULL OR window_title IS NOT NULL OR working_dir IS NOT NULL;
+        )";
+        char* err = nullptr;
+        if (sqlite3_exec(db_, intern, nullptr, nullptr, &err) != SQLITE_OK) {
+            std::println(stderr, "db: interning context strings failed: {}", err ? err : "unknown");
+            sqlite3_free(err);
+            return false;
+        }
+        // DROP COLUMN needs SQLite 3.35. Older ones keep the columns, empty.
+        sqlite3_exec(db_,
+                     "ALTER TABLE transcriptions DROP COLUMN app_context;"
+                     "ALTER TABLE transcriptions DROP COLUMN window_title;"
+                     "ALTER TABLE transcriptions DROP COLUMN working_dir;",
+                     nullptr, nullptr, nullptr);
+    }
+    return true;
+}
+
+bool HistoryDb::create_search_index() {
+    // External-content FTS5 table: it stores only the index, the text stays in
+    // transcriptions. The triggers keep the two in step.
+    bool existed = has_table(db_, "transcriptions_fts");
+
+    const char* sql = R"(
+        CREATE VIRTUAL TABLE IF NOT EXISTS transcriptions_fts USING fts5(
+            text, content='transcriptions', content_rowid='id',
+            tokenize='unicode61 remove_diacritics 2'
+        );
+        CREATE TRIGGER IF NOT EXISTS transcriptions_fts_insert AFTER INSERT ON transcriptions BEGIN
+            INSERT INTO transcriptions_fts(rowid, text) VALUES (new.id, new.text);
+        END;
+        CREATE TRIGGER IF NOT EXISTS transcriptions_fts_delete AFTER DELETE ON transcriptions BEGIN
+            INSERT INTO transcriptions_fts(transcriptions_fts, rowid, text)
+            VALUES ('delete', old.id, old.text);
+        END;
+        CREATE TRIGGER IF NOT EXISTS transcriptions_fts_update AFTER UPDATE OF text ON transcriptions BEGIN
+            INSERT INTO transcriptions_fts(transcriptions_fts, rowid, text)
+            VALUES ('delete', old.id, old.text);
+            INSERT INTO transcriptions_fts(rowid, text) VALUES (new.id, new.text);
+        END;
+    )";
+
+    char* err = nullptr;
+    if (sqlite3_exec(db_, sql, nullptr, nullptr, &err) != SQLITE_OK) {
+        std::println(stderr, "db: search index unavailable: {}", err ? err : "unknown");
+        sqlite3_free(err);
+        return false;
+    }
+
+    // A database from before the index existed: index the rows it already has.
+    if (!existed) {
+        sqlite3_exec(db_, "INSERT INTO transcriptions_fts(transcriptions_fts) VALUES ('rebuild')",
+                     nullptr, nullptr, nullptr);
+    }
+    return true;
+}
+
+bool HistoryDb::create_rollups() {
+    // Triggers, like the search index: whichever connection inserts or
+    // deletes a row updates the rollups in the same transaction.
+    bool existed = has_table(db_, "daily_usage");
+
+    auto sql = std::format(R"(
+        CREATE TABLE IF NOT EXISTS daily_usage (
+            day TEXT NOT NULL,
+            app TEXT NOT NULL,
+            agent TEXT NOT NULL,
+            entries INTEGER NOT NULL,
+            words INTEGER NOT NULL,
+            audio_seconds REAL NOT NULL,
+            PRIMARY KEY (day, app, agent)
+        ) WITHOUT ROWID;
+        CREATE TABLE IF NOT EXISTS daily_backend (
+            day TEXT NOT NULL,
+            backend TEXT NOT NULL,
+            entries INTEGER NOT NULL,
+            audio_seconds REAL NOT NULL,
+            processing_seconds REAL NOT NULL,
+            PRIMARY KEY (day, backend)
+        ) WITHOUT ROWID;
+        CREATE INDEX IF NOT EXISTS transcriptions_app_time ON transcriptions (app_id, timestamp);
+        CREATE INDEX IF NOT EXISTS transcriptions_backend_time ON transcriptions (backend, timestamp);
+        CREATE TRIGGER IF NOT EXISTS transcriptions_rollup_insert AFTER INSERT ON transcriptions BEGIN
+            INSERT INTO daily_usage VALUES ({0}, {1}, {2}, 1, {3}, COALESCE(new.audio_duration, 0))
+            ON CONFLICT (day, app, agent) DO UPDATE SET
+                entries = entries + 1, words = words + excluded.words,
+                audio_seconds = audio_seconds + excluded.audio_seconds;
+            INSERT INTO daily_backend VALUES ({0}, {4}, 1, COALESCE(new.audio_duration, 0),
+                                              COALESCE(new.processing_time, 0))
+            ON CONFLICT (day, backend) DO UPDATE SET
+                entries = entries + 1, audio_seconds = audio_seconds + excluded.audio_seconds,
+                processing_seconds = processing_seconds + excluded.processing_seconds;
+        END;
+        CREATE TRIGGER IF NOT EXISTS transcriptions_rollup_delete AFTER DELETE ON transcriptions BEGIN
+            UPDATE daily_usage SET
+                entries = entries - 1, words = words - {8},
+                audio_seconds = audio_seconds - COALESCE(old.audio_duration, 0)
+            WHERE day = {5} AND app = {6} AND agent = {7};
+            UPDATE daily_backend SET
+                entries = entries - 1, audio_seconds = audio_seconds - COALESCE(old.audio_duration, 0),
+                processing_seconds = processing_seconds - COALESCE(old.processing_time, 0)
+            WHERE day = {5} AND backend = {9};
+        END;
+    )",
+        rollup_day("new"), rollup_app("new"), rollup_agent("new"), rollup_words("new"), rollup_backend("new"),
+        rollup_day("old"), rollup_app("old"), rollup_agent("old"), rollup_words("old"), rollup_backend("old"));
+
+    char* err = nullptr;
+    if (sqlite3_exec(db_, sql.c_str(), nullptr, nullptr, &err) != SQLITE_OK) {
+        std::println(stderr, "db: create rollups failed: {}", err ? err : "unknown");
+        sqlite3_free(err);
+        return false;
+    }
+
+    // A database from before the rollups: one pass over the rows it has.
+    if (!existed) {
+        auto backfill = std::format(
+            "INSERT INTO daily_usage SELECT {0}, {1}, {2}, COUNT(*), SUM({3}), "
+            "SUM(COALESCE(t.audio_duration, 0)) FROM transcriptions t GROUP BY 1, 2, 3;"
+            "INSERT INTO daily_backend SELECT {0}, {4}, COUNT(*), SUM(COALESCE(t.audio_duration, 0)), "
+            "SUM(COALESCE(t.processing_time, 0)) FROM transcriptions t GROUP BY 1, 2;",
+            rollup_day("t"), rollup_app("t"), rollup_agent("t"), rollup_words("t"), rollup_backend("t"));
+        sqlite3_exec(db_, backfill.c_str(), nullptr, nullptr, nullptr);
+    }
+    return true;
 }
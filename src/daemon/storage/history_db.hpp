@@ -1,10 +1,15 @@
 #pragma once
 
+#include "../metrics.hpp"
 #include "../sway/window_info.hpp"
 
 #include <cstdint>
+#include <expected>
+#include <optional>
+#include <span>
 #include <sqlite3.h>
 #include <string>
+#include <string_view>
 #include <vector>
 
 struct HistoryEntry {
@@ -20,6 +25,85 @@ struct HistoryEntry {
     std::string agent;
     std::string working_dir;
     std::string backend;
+    StageTimings timings;  // history_s is never stored: it isn't known at insert
+    uint64_t audio_id = 0;  // clip in the audio archive, 0 if none was kept
+};
+
+// One transcription as insert() stores it.
+struct HistoryRecord {
+    std::string text;
+    double audio_duration = 0;
+    double processing_time = 0;
+    WindowInfo context;
+    std::string backend;
+    StageTimings timings;
+    uint64_t audio_id = 0;
+    std::string timestamp;  // empty: now (an import keeps the original)
+};
+
+// A backend result kept by TranscriptCache, as the backend returned it
+// (before post-processing).
+struct CachedTranscript {
+    uint64_t key = 0;
+    std::string text;
+    double audio_duration = 0;
+    double processing_time = 0;
+};
+
+// Narrows a search; empty fields don't filter. Timestamps compare as the
+// stored UTC strings, so a bare date ("2026-03-01") works for either bound.
+struct HistoryFilter {
+    std::string app_id;
+    std::string agent;
+    std::string working_dir;  // this directory or anything below it
+    std::string since;        // inclusive
+    std::string before;       // exclusive
+};
+
+// Position after the last hit of a page. Hits are ordered by rank, then by
+// newest id, so the next page starts strictly after this pair.
+struct SearchCursor {
+    double rank = 0;
+    int64_t id = 0;
+
+    std::string encode() const;
+    static std::optional<SearchCursor> parse(std::string_view s);
+};
+
+struct SearchHit {
+    HistoryEntry entry;
+    std::string snippet;  // matched terms wrapped in [ ]
+    double rank;          // bm25, lower is better; 0 without a query
+};
+
+struct SearchPage {
+    std::vector<SearchHit> hits;
+    std::optional<SearchCursor> next;  // set when more hits follow
+};
+
+// Dictation per UTC day, app (Wayland app_id, else X11 class) and agent.
+struct UsageDay {
+    std::string day;  // YYYY-MM-DD
+    std::string app;
+    std::string agent;
+    int64_t entries = 0;
+    int64_t words = 0;  // runs of text between spaces
+    double audio_seconds = 0;
+};
+
+struct BackendUsage {
+    std::string backend;
+    int64_t entries = 0;
+    double audio_seconds = 0;
+    double processing_seconds = 0;
+
+    // Seconds of processing per second of audio, over all its entries.
+    double real_time_factor() const { return audio_seconds > 0 ? processing_seconds / audio_seconds : 0; }
+};
+
+struct HistoryStats {
+    std::vector<UsageDay> days;  // oldest day first
+    std::vector<BackendUsage> backends;
 };
 
 class HistoryDb {
@@ -30,19 +114,75 @@ public:
     HistoryDb(const HistoryDb&) = delete;
     HistoryDb& operator=(const HistoryDb&) = delete;
 
+    // Stored in PRAGMA user_version once the tables are created and migrated,
+    // so later opens skip both. Bump it with every change to either.
+    static constexpr int SCHEMA_VERSION = 3;
+
     bool open(const std::string& path);
     void close();
 
     bool insert(const std::string& text, double audio_duration, double processing_time,
-                const WindowInfo& context, const std::string& backend);
+                const WindowInfo& context, const std::string& backend,
+                const StageTimings& timings = {});
+    bool insert(const HistoryRecord& record);
+    // Inserts all records in one transaction, so they share a single commit.
+    bool insert_batch(std::span<const HistoryRecord> records);
+    // Like insert_batch, but all or nothing: one failed row rolls back the rest.
+    bool import(std::span<const HistoryRecord> records);
+
+    // SQLite checkpoints inside whichever commit grows the WAL past 1000
+    // pages. Disabled, the WAL is only copied back by checkpoint().
+    void set_auto_checkpoint(bool enabled);
+    void checkpoint();
+    // Upkeep for when nothing is being written: refreshes the query planner's
+    // statistics, returns free pages to the file system, truncates the WAL
+    // and releases this connection's page cache.
+    void maintain();
 
     std::vector<HistoryEntry> recent(int limit = 10);
+    // Entries with an id above after_id, oldest first. Paging on the id
+    // keeps every page an index seek, however deep into the history.
+    std::vector<HistoryEntry> after(int64_t after_id, int limit);
+    std::optional<HistoryEntry> get(int64_t id);
+
+    // Full-text search over the transcribed text. Each word of `query` must
+    // appear (a trailing * matches a prefix); an empty query lists the
+    // filtered entries newest first.
+    std::expected<SearchPage, std::string> search(const std::string& query,
+                                                  const HistoryFilter& filter = {},
+                                                  std::optional<SearchCursor> after = std::nullopt,
+                                                  int limit = 20);
+
+    // Usage for the days from since (inclusive) to before (exclusive), both
+    // "YYYY-MM-DD" or empty for no bound. Read from the rollup tables, which
+    // triggers keep current, so the cost grows with days, not entries.
+    std::expected<HistoryStats, std::string> stats(const std::string& since = {},
+                                                   const std::string& before = {});
+
+    // The transcript_cache table. Rows are replaced by key.
+    bool cache_put(const CachedTranscript& entry);
+    // The newest `keep` rows, newest first. Older rows are deleted.
+    std::vector<CachedTranscript> cache_load(size_t keep);
 
 private:
+    int schema_version();
+    // Brings an older file up to SCHEMA_VERSION in one transaction.
+    bool upgrade_schema();
     bool create_tables();
-    void migrate_schema();
+    bool migrate_schema();
+    bool create_search_index();
+    bool create_rollups();
+    // Id of `value` in context_strings, added if it is new. 0 for an empty
+    // string, which is stored as NULL, and -1 if it couldn't be added.
+    int64_t intern(const std::string& value);
 
     sqlite3* db_ = nullptr;
     sqlite3_stmt* insert_stmt_ = nullptr;
     sqlite3_stmt* recent_stmt_ = nullptr;
+    sqlite3_stmt* after_stmt_ = nullptr;
+    sqlite3_stmt* get_stmt_ = nullptr;
+    sqlite3_stmt* search_stmt_ = nullptr;
+    sqlite3_stmt* filter_stmt_ = nullptr;
+    sqlite3_stmt* find_string_stmt_ = nullptr;
+    sqlite3_stmt* add_string_stmt_ = nullptr;
 };
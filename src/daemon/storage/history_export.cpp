@@ -0,0 +1,276 @@
+#include "history_export.hpp"
+
+#include <charconv>
+#include <format>
+#include <nlohmann/json.hpp>
+#include <unordered_map>
+
+namespace history_io {
+
+namespace {
+
+// CSV columns before the stage timings, in export order.
+constexpr const char* CSV_COLUMNS[] = {
+    "id", "timestamp", "text", "audio_duration", "processing_time", "app_context", "app_id",
+    "window_class", "window_title", "agent", "working_dir", "backend",
+};
+
+// history_s is measured after the row is written, so it is never stored.
+bool stored(const StageField& stage) {
+    return stage.value != &StageTimings::history_s;
+}
+
+void append_csv_field(std::string& out, std::string_view field) {
+    if (field.find_first_of(",\"\r\n") == std::string_view::npos) {
+        out += field;
+        return;
+    }
+    out += '"';
+    for (char c : field) {
+        if (c == '"') out += '"';
+        out += c;
+    }
+    out += '"';
+}
+
+std::optional<double> parse_double(std::string_view s) {
+    double v = 0;
+    if (std::from_chars(s.data(), s.data() + s.size(), v).ptr != s.data() + s.size()) return std::nullopt;
+    return v;
+}
+
+struct CsvRecord {
+    std::vector<std::string> fields;
+    size_t line = 0;  // where the record starts
+};
+
+// RFC 4180: quoted fields may hold commas, doubled quotes and newlines.
+std::expected<std::vector<CsvRecord>, std::string> split_csv(std::string_view data) {
+    std::vector<CsvRecord> records;
+    CsvRecord record{.line = 1};
+    std::string field;
+    bool quoted = false;
+    bool was_quoted = false;
+    size_t line = 1;
+
+    auto end_record = [&] {
+        record.fields.push_back(std::move(field));
+        field.clear();
+        // A blank line is no record.
+        if (record.fields.size() > 1 || !record.fields[0].empty() || was_quoted) {
+            records.push_back(std::move(record));
+        }
+        record = CsvRecord{.line = line};
+        was_quoted = false;
+    };
+
+    for (size_t i = 0; i < data.size(); ++i) {
+        char c = data[i];
+        if (quoted) {
+            if (c != '"') {
+                if (c == '\n') ++line;
+                field += c;
+            } else if (i + 1 < data.size() && data[i + 1] == '"') {
+                field += '"';
+                ++i;
+            } else {
+                quoted = false;
+            }
+            continue;
+        }
+        if (c == '"' && field.empty()) {
+            quoted = was_quoted = true;
+        } else if (c == ',') {
+            record.fields.push_back(std::move(field));
+            field.clear();
+        } else if (c == '\n') {
+            ++line;
+            end_record();
+        } else if (c != '\r') {
+            field += c;
+        }
+    }
+    if (quoted) return std::unexpected(std::format("line {}: unterminated quote", record.line));
+    if (!field.empty() || !record.fields.empty() || was_quoted) end_record();
+    return records;
+}
+
+std::expected<std::vector<HistoryRecord>, std::string> parse_csv(std::string_view data) {
+    auto records = split_csv(data);
+    if (!records) return std::unexpected(records.error());
+    if (records->empty()) return std::vector<HistoryRecord>{};
+
+    std::unordered_map<std::string, size_t> columns;
+    for (size_t i = 0; i < records->front().fields.size(); ++i) columns[records->front().fields[i]] = i;
+    if (!columns.contains("text")) return std::unexpected("line 1: no text column");
+
+    std::vector<HistoryRecord> out;
+    out.reserve(records->size() - 1);
+    for (size_t r = 1; r < records->size(); ++r) {
+        auto& rec = (*records)[r];
+        auto get = [&rec, &columns](std::string_view name) -> std::string {
+            auto it = columns.find(std::string(name));
+            return it != columns.end() && it->second < rec.fields.size() ? rec.fields[it->second] : "";
+        };
+        std::string bad;
+        auto number = [&](std::string_view name) -> std::optional<double> {
+            auto s = get(name);
+            if (s.empty()) return std::nullopt;
+            auto v = parse_double(s);
+            if (!v && bad.empty()) bad = name;
+            return v;
+        };
+
+        HistoryRecord h{
+            .text = get("text"),
+            .audio_duration = number("audio_duration").value_or(0),
+            .processing_time = number("processing_time").value_or(0),
+            .context = {.app_id = get("app_id"), .window_class = get("window_class"),
+                        .title = get("window_title"), .agent = get("agent"),
+                        .working_dir = get("working_dir"), .context = get("app_context")},
+            .backend = get("backend"),
+            .timestamp = get("timestamp"),
+        };
+        for (auto& stage : STAGES) {
+            if (stored(stage)) h.timings.*stage.value = number(std::format("{}_time", stage.name));
+        }
+        if (!bad.empty()) return std::unexpected(std::format("line {}: bad {}", rec.line, bad));
+        if (h.text.empty()) return std::unexpected(std::format("line {}: no text", rec.line));
+        out.push_back(std::move(h));
+    }
+    return out;
+}
+
+std::expected<std::vector<HistoryRecord>, std::string> parse_ndjson(std::string_view data) {
+    std::vector<HistoryRecord> out;
+    size_t line = 0;
+    while (!data.empty()) {
+        ++line;
+        auto eol = data.find('\n');
+        auto text = data.substr(0, eol);
+        data.remove_prefix(eol == std::string_view::npos ? data.size() : eol + 1);
+        if (!text.empty() && text.back() == '\r') text.remove_suffix(1);
+        if (text.empty()) continue;
+
+        auto j = nlohmann::json::parse(text, nullptr, false);
+        if (!j.is_object()) return std::unexpected(std::format("line {}: not a JSON object", line));
+        auto str = [&j](const char* key) {
+            auto it = j.find(key);
+            return it != j.end() && it->is_string() ? it->get<std::string>() : std::string{};
+        };
+        auto num = [&j](const nlohmann::json& obj, const char* key) -> std::optional<double> {
+            auto it = obj.find(key);
+            if (it == obj.end() || !it->is_number()) return std::nullopt;
+            return it->get<double>();
+        };
+
+        HistoryRecord h{
+            .text = str("text"),
+            .audio_duration = num(j, "audio_duration").value_or(0),
+            .processing_time = num(j, "processing_time").value_or(0),
+            .context = {.app_id = str("app_id"), .window_class = str("window_class"),
+                        .title = str("window_title"), .agent = str("agent"),
+                        .working_dir = str("working_dir"), .context = str("app_context")},
+            .backend = str("backend"),
+            .timestamp = str("timestamp"),
+        };
+        if (auto t = j.find("timings"); t != j.end() && t->is_object()) {
+            for (auto& stage : STAGES) {
+                if (stored(stage)) h.timings.*stage.value = num(*t, stage.name);
+            }
+        }
+        if (h.text.empty()) return std::unexpected(std::format("line {}: no text", line));
+        out.push_back(std::move(h));
+    }
+    return out;
+}
+
+} // namespace
+
+std::optional<Format> parse_format(std::string_view name) {
+    if (name == "ndjson" || name == "jsonl") return Format::Ndjson;
+    if (name == "csv") return Format::Csv;
+    return std::nullopt;
+}
+
+std::string header(Format format) {
+    if (format != Format::Csv) return {};
+    std::string out;
+    for (auto* column : CSV_COLUMNS) {
+        if (!out.empty()) out += ',';
+        out += column;
+    }
+    for (auto& stage : STAGES) {
+        if (stored(stage)) out += std::format(",{}_time", stage.name);
+    }
+    out += '\n';
+    return out;
+}
+
+void append_row(std::string& out, const HistoryEntry& e, Format format) {
+    if (format == Format::Ndjson) {
+        nlohmann::json timings = nlohmann::json::object();
+        for (auto& stage : STAGES) {
+            if (auto& v = e.timings.*stage.value) timings[stage.name] = *v;
+        }
+        out += nlohmann::json{
+            {"id", e.id},
+            {"timestamp", e.timestamp},
+            {"text", e.text},
+            {"audio_duration", e.audio_duration},
+            {"processing_time", e.processing_time},
+            {"app_context", e.app_context},
+            {"app_id", e.app_id},
+            {"window_class", e.window_class},
+            {"window_title", e.window_title},
+            {"agent", e.agent},
+            {"working_dir", e.working_dir},
+            {"backend", e.backend},
+            {"timings", std::move(timings)},
+        }.dump(-1, ' ', false, nlohmann::json::error_handler_t::replace);
+        out += '\n';
+        return;
+    }
+
+    std::format_to(std::back_inserter(out), "{},", e.id);
+    append_csv_field(out, e.timestamp);
+    out += ',';
+    append_csv_field(out, e.text);
+    std::format_to(std::back_inserter(out), ",{},{}", e.audio_duration, e.processing_time);
+    for (auto* field : {&e.app_context, &e.app_id, &e.window_class, &e.window_title, &e.agent,
+                        &e.working_dir, &e.backend}) {
+        out += ',';
+        append_csv_field(out, *field);
+    }
+    for (auto& stage : STAGES) {
+        if (!stored(stage)) continue;
+        out += ',';
+        if (auto& v = e.timings.*stage.value) std::format_to(std::back_inserter(out), "{}", *v);
+    }
+    out += '\n';
+}
+
+std::expected<std::vector<HistoryRecord>, std::string> parse(std::string_view data, Format format) {
+    return format == Format::Csv ? parse_csv(data) : parse_ndjson(data);
+}
+
+} // namespace history_io
+
+HistoryExport::HistoryExport(HistoryDb& db, history_io::Format format, int page_rows)
+    : db_(db), format_(format), page_rows_(page_rows) {}
+
+std::string HistoryExport::next() {
+    if (done_) return {};
+
+    std::string out;
+    if (!started_) {
+        started_ = true;
+        out = history_io::header(format_);
+    }
+    auto page = db_.after(after_id_, page_rows_);
+    if (page.size() < static_cast<size_t>(page_rows_)) done_ = true;
+    for (auto& e : page) history_io::append_row(out, e, format_);
+    if (!page.empty()) after_id_ = page.back().id;
+    rows_ += page.size();
+    return out;
+}
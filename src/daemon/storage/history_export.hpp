@@ -0,0 +1,54 @@
+#pragma once
+
+#include "history_db.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <expected>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// The history as text, for `sa export` and `sa import`: one JSON object per
+// line, or CSV with a header row. Both carry every stored column but the
+// archived clip, which doesn't travel with the text.
+namespace history_io {
+
+enum class Format { Ndjson, Csv };
+
+std::optional<Format> parse_format(std::string_view name);
+
+// What a file starts with: the CSV column names, or nothing.
+std::string header(Format format);
+// One entry as a line (CSV quotes text that spans lines).
+void append_row(std::string& out, const HistoryEntry& entry, Format format);
+
+// Every row of an exported file, in file order. Fails on the first row
+// without text or that doesn't parse, naming its line; ids are dropped, the
+// importing database hands out its own.
+std::expected<std::vector<HistoryRecord>, std::string> parse(std::string_view data, Format format);
+
+} // namespace history_io
+
+// Reads the whole history out a page at a time, oldest first, for a client
+// that may take a while to read it: nothing is held between pages but the
+// last id, and each page is a seek on the primary key (no OFFSET).
+class HistoryExport {
+public:
+    HistoryExport(HistoryDb& db, history_io::Format format, int page_rows = 256);
+
+    // The next page of rows as text, the header before the first. Empty once
+    // every row is out.
+    std::string next();
+    size_t rows() const { return rows_; }
+
+private:
+    HistoryDb& db_;
+    history_io::Format format_;
+    int page_rows_;
+    int64_t after_id_ = 0;
+    size_t rows_ = 0;
+    bool started_ = false;
+    bool done_ = false;
+};
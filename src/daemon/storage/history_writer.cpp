@@ -0,0 +1,99 @@
+#include "history_writer.hpp"
+
+#include <chrono>
+
+namespace {
+
+// How long writes have to pause before the WAL is checkpointed.
+constexpr auto CHECKPOINT_IDLE = std::chrono::seconds(2);
+// How much longer before HistoryDb::maintain() runs. Dictation comes in
+// bursts; this is well after one, and rare enough for its full checkpoint.
+constexpr auto MAINTAIN_IDLE = std::chrono::minutes(5);
+
+} // namespace
+
+HistoryWriter::HistoryWriter() = default;
+
+HistoryWriter::~HistoryWriter() {
+    close();
+}
+
+bool HistoryWriter::open(const std::string& path) {
+    if (!db_.open(path)) return false;
+    db_.set_auto_checkpoint(false);
+    done_ = false;
+    thread_ = std::thread([this] { run(); });
+    return true;
+}
+
+void HistoryWriter::close() {
+    if (!thread_.joinable()) return;
+    {
+        std::lock_guard lock(mu_);
+        done_ = true;
+    }
+    work_cv_.notify_one();
+    thread_.join();
+    db_.close();
+}
+
+bool HistoryWriter::submit(HistoryRecord record) {
+    if (!active()) return false;
+    {
+        std::unique_lock lock(mu_);
+        idle_cv_.wait(lock, [this] { return queue_.size() < MAX_QUEUED; });
+        queue_.push_back(std::move(record));
+    }
+    work_cv_.notify_one();
+    return true;
+}
+
+void HistoryWriter::flush() {
+    if (!active()) return;
+    std::unique_lock lock(mu_);
+    idle_cv_.wait(lock, [this] { return queue_.empty() && !writing_; });
+}
+
+void HistoryWriter::run() {
+    std::vector<HistoryRecord> batch;
+    bool dirty = false;  // committed since the last checkpoint
+    bool stale = false;  // committed since the last maintain()
+    for (;;) {
+        {
+            std::unique_lock lock(mu_);
+            auto ready = [this] { return done_ || !queue_.empty(); };
+            if (dirty) {
+                if (!work_cv_.wait_for(lock, CHECKPOINT_IDLE, ready)) {
+                    lock.unlock();
+                    db_.checkpoint();
+                    dirty = false;
+                    continue;
+                }
+            } else if (stale) {
+                if (!work_cv_.wait_for(lock, MAINTAIN_IDLE, ready)) {
+                    lock.unlock();
+                    db_.maintain();
+                    stale = false;
+                    continue;
+                }
+            } else {
+                work_cv_.wait(lock, ready);
+            }
+            if (queue_.empty()) break;  // done_
+            batch.swap(queue_);
+            writing_ = true;
+        }
+        idle_cv_.notify_all();
+
+        db_.insert_batch(batch);
+        batch.clear();
+        dirty = stale = true;
+
+        {
+            std::lock_guard lock(mu_);
+            writing_ = false;
+        }
+        idle_cv_.notify_all();
+    }
+    if (dirty) db_.checkpoint();
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "history_db.hpp"
+
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Writes history on its own thread with its own connection, so the commit
+// (and its fsync) never delays the event loop. Rows submitted while a batch
+// is being written go out together in the next transaction, and the WAL is
+// checkpointed once writes have gone quiet. After a longer quiet spell the
+// thread runs HistoryDb::maintain(), off the event loop like the writes.
+class HistoryWriter {
+public:
+    // submit() blocks once this many rows are waiting, rather than drop them.
+    static constexpr size_t MAX_QUEUED = 256;
+
+    HistoryWriter();
+    ~HistoryWriter();
+
+    HistoryWriter(const HistoryWriter&) = delete;
+    HistoryWriter& operator=(const HistoryWriter&) = delete;
+
+    // Opens the database (schema included) and starts the thread.
+    bool open(const std::string& path);
+    // Writes everything still queued, checkpoints and stops the thread.
+    void close();
+    bool active() const { return thread_.joinable(); }
+
+    // Queues a row. It is visible to readers once its batch commits.
+    bool submit(HistoryRecord record);
+    // Waits until every row submitted so far has been committed.
+    void flush();
+
+private:
+    void run();
+
+    HistoryDb db_;
+
+    std::mutex mu_;
+    std::condition_variable work_cv_;
+    std::condition_variable idle_cv_;  // queue shrank or a batch finished
+    std::vector<HistoryRecord> queue_;
+    bool writing_ = false;
+    bool done_ = false;
+    std::thread thread_;
+};
@@ -0,0 +1,169 @@
+#include "sway/focus_parser.hpp"
+
+#include <nlohmann/json.hpp>
+#include <string>
+#include <vector>
+
+namespace sway {
+
+namespace {
+
+using json = nlohmann::json;
+
+// SAX handler over either a GET_TREE reply or a window event. Keeps a stack
+// of what each open object or array is, and fills in containers' fields from
+// the values directly inside them. Returning false from a callback ends the
+// parse, which is how it stops early.
+class FocusHandler : public nlohmann::json_sax<json> {
+public:
+    enum class Mode { Tree, Event };
+
+    explicit FocusHandler(Mode mode) : mode_(mode) {}
+
+    bool found() const { return found_; }
+    bool focus_change() const { return focus_change_; }
+    WindowInfo result() const {
+        WindowInfo info = result_;
+        // The X11 class only matters for windows without a Wayland app_id.
+        if (!info.app_id.empty()) info.window_class.clear();
+        return info;
+    }
+
+    bool null() override { return true; }
+
+    bool boolean(bool val) override {
+        if (auto* c = container(); c && key_ == "focused") c->focused = val;
+        return true;
+    }
+
+    bool number_integer(number_integer_t val) override {
+        if (auto* c = container(); c && key_ == "pid") c->info.pid = static_cast<int>(val);
+        return true;
+    }
+
+    bool number_unsigned(number_unsigned_t val) override {
+        return number_integer(static_cast<number_integer_t>(val));
+    }
+
+    bool number_float(number_float_t, const string_t&) override { return true; }
+
+    bool string(string_t& val) override {
+        if (frames_.empty()) return true;
+        auto& top = frames_.back();
+
+        if (top.kind == Kind::Container) {
+            if (key_ == "app_id") top.info.app_id = std::move(val);
+            else if (key_ == "name") top.info.title = std::move(val);
+        } else if (top.kind == Kind::Properties && key_ == "class") {
+            // The window_properties object's parent is its container.
+            frames_[frames_.size() - 2].info.window_class = std::move(val);
+        } else if (top.kind == Kind::Event && key_ == "change") {
+            if (val != "focus") return false;
+            focus_change_ = true;
+            if (found_) return false;
+        }
+        return true;
+    }
+
+    bool binary(binary_t&) override { return true; }
+
+    bool start_object(std::size_t) override {
+        frames_.push_back({.kind = object_kind()});
+        return true;
+    }
+
+    bool key(string_t& val) override {
+        key_ = std::move(val);
+        return true;
+    }
+
+    bool end_object() override {
+        Frame frame = std::move(frames_.back());
+        frames_.pop_back();
+        if (frame.kind != Kind::Container) return true;
+
+        if (mode_ == Mode::Tree && frame.focused) {
+            result_ = std::move(frame.info);
+            found_ = true;
+            return false;
+        }
+        if (mode_ == Mode::Event && frames_.size() == 1) {
+            result_ = std::move(frame.info);
+            found_ = true;
+            // Done, unless "change" is still to come.
+            return !focus_change_;
+        }
+        return true;
+    }
+
+    bool start_array(std::size_t) override {
+        bool children = mode_ == Mode::Tree && container() &&
+                        (key_ == "nodes" || key_ == "floating_nodes");
+        frames_.push_back({.kind = children ? Kind::Children : Kind::Other});
+        return true;
+    }
+
+    bool end_array() override {
+        frames_.pop_back();
+        return true;
+    }
+
+    bool parse_error(std::size_t, const std::string&, const nlohmann::detail::exception&) override {
+        return false;
+    }
+
+private:
+    enum class Kind {
+        Container,   // a window, workspace, output...: fields are collected
+        Properties,  // its window_properties
+        Children,    // its nodes / floating_nodes array
+        Event,       // the top level of a window event
+        Other,
+    };
+
+    struct Frame {
+        Kind kind = Kind::Other;
+        WindowInfo info;
+        bool focused = false;
+    };
+
+    Kind object_kind() const {
+        if (frames_.empty()) return mode_ == Mode::Tree ? Kind::Container : Kind::Event;
+        switch (frames_.back().kind) {
+            case Kind::Children: return Kind::Container;
+            case Kind::Container: return key_ == "window_properties" ? Kind::Properties : Kind::Other;
+            case Kind::Event: return key_ == "container" ? Kind::Container : Kind::Other;
+            default: return Kind::Other;
+        }
+    }
+
+    // The container a value belongs to, if it sits directly inside one.
+    Frame* container() {
+        if (frames_.empty() || frames_.back().kind != Kind::Container) return nullptr;
+        return &frames_.back();
+    }
+
+    Mode mode_;
+    std::vector<Frame> frames_;
+    std::string key_;  // the key of the value being parsed (stale inside arrays)
+    WindowInfo result_;
+    bool found_ = false;
+    bool focus_change_ = false;
+};
+
+} // namespace
+
+WindowInfo parse_focused_tree(std::string_view text) {
+    FocusHandler handler(FocusHandler::Mode::Tree);
+    json::sax_parse(text, &handler);
+    return handler.found() ? handler.result() : WindowInfo{};
+}
+
+std::optional<WindowInfo> parse_focus_event(std::string_view text) {
+    FocusHandler handler(FocusHandler::Mode::Event);
+    json::sax_parse(text, &handler);
+    if (!handler.focus_change() || !handler.found()) return std::nullopt;
+    return handler.result();
+}
+
+} // namespace sway
@@ -0,0 +1,24 @@
+#pragma once
+
+#include "sway/window_info.hpp"
+
+#include <optional>
+#include <string_view>
+
+// Pulls the focused window out of Sway IPC JSON without building a DOM.
+//
+// Sway sends a window event for every title change, and terminals retitle
+// constantly, so these parse on the SAX interface, keep only app_id, pid,
+// name and window_properties.class, and stop as soon as the answer is known.
+namespace sway {
+
+// The focused container of a GET_TREE reply. Empty if nothing is focused or
+// the JSON is malformed.
+WindowInfo parse_focused_tree(std::string_view json);
+
+// The container of a window event whose change is "focus"; nullopt for other
+// changes and malformed JSON. Sway puts "change" first, so other events are
+// rejected before their container is read.
+std::optional<WindowInfo> parse_focus_event(std::string_view json);
+
+} // namespace sway
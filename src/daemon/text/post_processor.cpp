@@ -0,0 +1,59 @@
+#include "text/post_processor.hpp"
+
+#include <algorithm>
+#include <cctype>
+
+namespace {
+
+std::string lowercase(std::string s) {
+    std::transform(s.begin(), s.end(), s.begin(), ::tolower);
+    return s;
+}
+
+void append(std::vector<Replacer::Rule>& rules, const Config::PostProcess::Replacements& from) {
+    for (auto& [phrase, replacement] : from) rules.push_back({phrase, replacement});
+}
+
+} // namespace
+
+std::vector<Replacer::Rule> voice_command_rules() {
+    return {
+        {"new line", "\n"},
+        {"new paragraph", "\n\n"},
+        {"full stop", "."},
+        {"comma", ","},
+        {"question mark", "?"},
+        {"exclamation mark", "!"},
+        {"exclamation point", "!"},
+        {"colon", ":"},
+        {"semicolon", ";"},
+    };
+}
+
+PostProcessor::PostProcessor(const Config::PostProcess& config) {
+    std::vector<Replacer::Rule> global;
+    if (config.voice_commands) global = voice_command_rules();
+    append(global, config.replace);
+    global_ = Replacer(global);
+
+    for (auto& set : config.apps) {
+        if (set.app_id.empty() && set.agent.empty()) continue;
+        // Set rules come after the global ones so they override them.
+        auto rules = global;
+        append(rules, set.replace);
+        sets_.push_back({lowercase(set.app_id), lowercase(set.agent), Replacer(rules)});
+    }
+}
+
+const Replacer& PostProcessor::select(const WindowInfo& window) const {
+    if (sets_.empty()) return global_;
+
+    std::string app = lowercase(!window.app_id.empty() ? window.app_id : window.window_class);
+    std::string agent = lowercase(window.agent);
+    for (auto& set : sets_) {
+        if (!set.app_id.empty() && set.app_id != app) continue;
+        if (!set.agent.empty() && set.agent != agent) continue;
+        return set.replacer;
+    }
+    return global_;
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include "config.hpp"
+#include "sway/window_info.hpp"
+#include "text/replacer.hpp"
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Rewrites transcripts before they are typed out: the global replacements
+// from postprocess.replace, plus those of the first rule set whose app_id
+// and agent match the window the text goes to. Every combination is compiled
+// once, at startup, so choosing and applying one is a lookup and a single
+// pass over the text.
+class PostProcessor {
+public:
+    PostProcessor() = default;
+    explicit PostProcessor(const Config::PostProcess& config);
+
+    const Replacer& select(const WindowInfo& window) const;
+
+    std::string apply(std::string_view text, const WindowInfo& window) const {
+        return select(window).apply(text);
+    }
+
+    bool empty() const { return global_.empty() && sets_.empty(); }
+
+private:
+    struct Set {
+        std::string app_id;  // lowercased; empty matches any window
+        std::string agent;
+        Replacer replacer;
+    };
+
+    Replacer global_;
+    std::vector<Set> sets_;
+};
+
+// Spoken punctuation: "new line", "comma", "full stop", ...
+std::vector<Replacer::Rule> voice_command_rules();
@@ -0,0 +1,208 @@
+#include "text/prompt_builder.hpp"
+
+#include <algorithm>
+#include <array>
+#include <fstream>
+#include <iterator>
+#include <unordered_set>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// Enough for the projects of a session; the maps are only cleared past it.
+constexpr size_t MAX_CACHED = 32;
+// Bigger files are generated or data, not code anyone talks about.
+constexpr uintmax_t MAX_FILE_BYTES = 256 * 1024;
+// A file or directory name counts as much as an identifier used in this many files.
+constexpr uint32_t NAME_WEIGHT = 4;
+
+bool skipped_dir(const std::string& name) {
+    static constexpr std::array<std::string_view, 6> SKIPPED{
+        "node_modules", "build", "target", "dist", "vendor", "out"};
+    return name.empty() || name[0] == '.' || name[0] == '_' || name.starts_with("cmake-build") ||
+           std::ranges::find(SKIPPED, name) != SKIPPED.end();
+}
+
+bool is_source(const fs::path& path) {
+    static constexpr std::array<std::string_view, 22> EXTENSIONS{
+        ".c", ".cc", ".cpp", ".cxx", ".h", ".hh", ".hpp", ".py", ".rs", ".go", ".js",
+        ".jsx", ".ts", ".tsx", ".java", ".kt", ".swift", ".rb", ".lua", ".zig", ".cs", ".sh"};
+    auto ext = path.extension().string();
+    return std::ranges::find(EXTENSIONS, ext) != EXTENSIONS.end() ||
+           path.filename() == "CMakeLists.txt";
+}
+
+bool is_ident(char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+}
+
+// Identifiers whisper wouldn't spell that way by itself: camelCase,
+// PascalCase and snake_case. Plain words it gets right anyway, and
+// ALL_CAPS constants are rarely dictated.
+bool code_like(std::string_view word) {
+    if (word.size() < 4 || word.size() > 40 || word[0] == '_') return false;
+    if (word[0] >= '0' && word[0] <= '9') return false;
+    bool lower = false, upper_inside = false, underscore = false;
+    for (size_t i = 0; i < word.size(); ++i) {
+        char c = word[i];
+        if (c >= 'a' && c <= 'z') lower = true;
+        if (i > 0 && c >= 'A' && c <= 'Z') upper_inside = true;
+        if (c == '_') underscore = true;
+    }
+    return lower && (upper_inside || underscore);
+}
+
+void count_identifiers(const fs::path& path, std::unordered_map<std::string, uint32_t>& scores) {
+    std::ifstream f(path, std::ios::binary);
+    std::string text{std::istreambuf_iterator<char>(f), std::istreambuf_iterator<char>()};
+
+    std::unordered_set<std::string_view> seen;  // once per file
+    for (size_t i = 0; i < text.size();) {
+        if (!is_ident(text[i])) {
+            ++i;
+            continue;
+        }
+        size_t start = i;
+        while (i < text.size() && is_ident(text[i])) ++i;
+        std::string_view word(text.data() + start, i - start);
+        if (code_like(word) && seen.insert(word).second) ++scores[std::string(word)];
+    }
+}
+
+std::string glossary(const std::vector<std::string>& terms) {
+    constexpr size_t budget = PromptBuilder::MAX_PROMPT_CHARS - PromptBuilder::MAX_HISTORY_CHARS;
+    std::string out;
+    for (auto& term : terms) {
+        if (out.size() + term.size() + 2 > budget) break;
+        out += out.empty() ? "Glossary: " : ", ";
+        out += term;
+    }
+    if (!out.empty()) out += '.';
+    return out;
+}
+
+} // namespace
+
+PromptBuilder::PromptBuilder(Options options)
+    : options_(options),
+      refresher_([this](std::stop_token stop) { refresh_loop(stop); }) {}
+
+void PromptBuilder::prefetch(const std::string& dir) {
+    if (dir.empty()) return;
+    {
+        std::lock_guard lock(mu_);
+        refresh_dir_ = dir;
+    }
+    refresh_cv_.notify_one();
+}
+
+std::string PromptBuilder::prompt(const std::string& dir) const {
+    if (dir.empty()) return {};
+
+    std::lock_guard lock(mu_);
+    std::string out;
+    if (auto it = cache_.find(dir); it != cache_.end()) out = it->second.vocabulary;
+    if (auto it = recent_.find(dir); it != recent_.end()) {
+        if (!out.empty()) out += ' ';
+        out += it->second;
+    }
+    return out;
+}
+
+void PromptBuilder::remember(const std::string& dir, std::string_view text) {
+    if (dir.empty() || text.empty()) return;
+
+    // The end of the transcript, from a word start.
+    if (text.size() > MAX_HISTORY_CHARS) {
+        text.remove_prefix(text.size() - MAX_HISTORY_CHARS);
+        if (auto space = text.find(' '); space != std::string_view::npos) text.remove_prefix(space + 1);
+    }
+
+    std::lock_guard lock(mu_);
+    if (recent_.size() >= MAX_CACHED && !recent_.contains(dir)) recent_.clear();
+    recent_[dir] = std::string(text);
+}
+
+std::vector<std::string> PromptBuilder::scan(const std::string& dir, const Options& options,
+                                             Fingerprint& seen) {
+    std::error_code ec;
+    auto root_time = fs::last_write_time(dir, ec);
+    if (ec) return {};
+    seen.emplace_back(dir, root_time);
+
+    std::unordered_map<std::string, uint32_t> scores;
+    auto add_name = [&scores](const fs::path& path) {
+        auto stem = path.stem().string();
+        if (stem.size() >= 3 && std::ranges::any_of(stem, [](char c) { return c >= 'a' && c <= 'z'; })) {
+            scores[stem] += NAME_WEIGHT;
+        }
+    };
+
+    size_t files = 0;
+    fs::recursive_directory_iterator it(dir, fs::directory_options::skip_permission_denied, ec);
+    for (; !ec && it != fs::recursive_directory_iterator(); it.increment(ec)) {
+        const auto& entry = *it;
+        std::error_code entry_ec;
+        if (entry.is_directory(entry_ec)) {
+            if (skipped_dir(entry.path().filename().string()) || it.depth() + 1 >= options.max_depth) {
+                it.disable_recursion_pending();
+                continue;
+            }
+            if (auto t = entry.last_write_time(entry_ec); !entry_ec) seen.emplace_back(entry.path(), t);
+            add_name(entry.path());
+            continue;
+        }
+        if (!entry.is_regular_file(entry_ec) || !is_source(entry.path())) continue;
+        add_name(entry.path());
+        if (files >= options.max_files || entry.file_size(entry_ec) > MAX_FILE_BYTES || entry_ec) continue;
+
+        auto t = entry.last_write_time(entry_ec);
+        if (entry_ec) continue;
+        seen.emplace_back(entry.path(), t);
+        count_identifiers(entry.path(), scores);
+        ++files;
+    }
+
+    std::vector<std::pair<std::string, uint32_t>> ranked(scores.begin(), scores.end());
+    std::ranges::sort(ranked, [](auto& a, auto& b) {
+        return a.second != b.second ? a.second > b.second : a.first < b.first;
+    });
+    std::vector<std::string> terms;
+    for (auto& [term, score] : ranked) {
+        if (terms.size() >= options.max_terms) break;
+        terms.push_back(term);
+    }
+    return terms;
+}
+
+bool PromptBuilder::unchanged(const Fingerprint& seen) {
+    for (auto& [path, time] : seen) {
+        std::error_code ec;
+        if (fs::last_write_time(path, ec) != time || ec) return false;
+    }
+    return true;
+}
+
+void PromptBuilder::store(const std::string& dir, Entry entry) {
+    std::lock_guard lock(mu_);
+    if (cache_.size() >= MAX_CACHED && !cache_.contains(dir)) cache_.clear();
+    cache_[dir] = std::move(entry);
+}
+
+void PromptBuilder::refresh_loop(std::stop_token stop) {
+    std::unique_lock lock(mu_);
+    while (refresh_cv_.wait(lock, stop, [this] { return !refresh_dir_.empty(); })) {
+        auto dir = std::exchange(refresh_dir_, {});
+        Fingerprint seen;
+        if (auto it = cache_.find(dir); it != cache_.end()) seen = it->second.seen;
+        lock.unlock();
+
+        if (seen.empty() || !unchanged(seen)) {
+            Fingerprint fresh;
+            auto terms = scan(dir, options_, fresh);
+            store(dir, Entry{.vocabulary = glossary(terms), .seen = std::move(fresh)});
+        }
+        lock.lock();
+    }
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <stop_token>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Builds the whisper prompt for a recording from the project it is about:
+// identifiers and file names from the agent's working directory, followed by
+// the last transcript made there. Whisper reads the prompt as text that came
+// before the audio, so "DaemonCore" comes out as that rather than "demon core".
+//
+// Scanning a directory takes far too long for the way from stop to upload,
+// so it happens on a background thread, asked for by prefetch() when a window
+// gets focus or a recording starts. prompt() only reads the cache: a directory
+// that hasn't been scanned yet gets no vocabulary. A cached scan is redone
+// once the mtime of a directory or file it read has changed.
+class PromptBuilder {
+public:
+    struct Options {
+        size_t max_terms = 40;    // vocabulary entries in a prompt
+        size_t max_files = 2000;  // files read per scan
+        int max_depth = 4;        // directory levels below the working dir
+    };
+
+    explicit PromptBuilder(Options options);
+
+    PromptBuilder(const PromptBuilder&) = delete;
+    PromptBuilder& operator=(const PromptBuilder&) = delete;
+
+    // Scans dir on the background thread unless its cached scan is current.
+    void prefetch(const std::string& dir);
+
+    // Never blocks on a scan. Empty when there is nothing to say about dir.
+    std::string prompt(const std::string& dir) const;
+
+    // text was transcribed for dir; the next prompt there ends with it.
+    void remember(const std::string& dir, std::string_view text);
+
+    // Mtimes a scan depended on.
+    using Fingerprint = std::vector<std::pair<std::filesystem::path, std::filesystem::file_time_type>>;
+
+    // The uncached scan: dir's vocabulary, best first.
+    static std::vector<std::string> scan(const std::string& dir, const Options& options,
+                                         Fingerprint& seen);
+    static bool unchanged(const Fingerprint& seen);
+
+    // Whisper's prompt is cut at 224 tokens; this stays well inside that.
+    static constexpr size_t MAX_PROMPT_CHARS = 600;
+    static constexpr size_t MAX_HISTORY_CHARS = 200;
+
+private:
+    struct Entry {
+        std::string vocabulary;  // "Glossary: a, b, c."
+        Fingerprint seen;
+    };
+
+    void store(const std::string& dir, Entry entry);
+    void refresh_loop(std::stop_token stop);
+
+    Options options_;
+
+    mutable std::mutex mu_;
+    std::condition_variable_any refresh_cv_;
+    std::unordered_map<std::string, Entry> cache_;
+    std::unordered_map<std::string, std::string> recent_;  // dir -> last transcript
+    std::string refresh_dir_;  // next dir for the background thread; empty: none
+    std::jthread refresher_;   // last: stopped before the members it uses go away
+};
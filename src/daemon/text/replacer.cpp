@@ -0,0 +1,167 @@
+#include "text/replacer.hpp"
+
+#include <algorithm>
+#include <deque>
+#include <unordered_map>
+
+namespace {
+
+char lower(char c) {
+    return c >= 'A' && c <= 'Z' ? static_cast<char>(c - 'A' + 'a') : c;
+}
+
+// Letters, digits, apostrophes and anything non-ASCII (UTF-8) make up words.
+bool is_word(char c) {
+    auto u = static_cast<unsigned char>(c);
+    return (u >= '0' && u <= '9') || (u >= 'a' && u <= 'z') || (u >= 'A' && u <= 'Z') ||
+           u == '\'' || u >= 0x80;
+}
+
+bool is_space(char c) {
+    return c == ' ' || c == '\t';
+}
+
+// Replacements that attach to the word before them.
+bool attaches_left(const std::string& to) {
+    return !to.empty() && std::string_view(".,;:!?)\n").find(to.front()) != std::string_view::npos;
+}
+
+bool attaches_right(const std::string& to) {
+    return !to.empty() && to.back() == '\n';
+}
+
+} // namespace
+
+Replacer::Replacer(std::span<const Rule> rules) {
+    std::unordered_map<std::string, size_t> index;
+    for (auto& rule : rules) {
+        std::string from;
+        for (char c : rule.from) from += lower(c);
+        auto first = from.find_first_not_of(" \t");
+        if (first == std::string::npos) continue;
+        from = from.substr(first, from.find_last_not_of(" \t") - first + 1);
+
+        auto [it, inserted] = index.try_emplace(from, rules_.size());
+        if (inserted) {
+            rules_.push_back({std::move(from), rule.to});
+        } else {
+            rules_[it->second].to = rule.to;
+        }
+    }
+    if (rules_.empty()) return;
+
+    for (auto& rule : rules_) {
+        for (char c : rule.from) {
+            auto u = static_cast<unsigned char>(c);
+            if (class_of_[u] == 0) class_of_[u] = static_cast<uint16_t>(classes_++);
+        }
+    }
+    for (int c = 'a'; c <= 'z'; ++c) class_of_[c - 'a' + 'A'] = class_of_[c];
+
+    auto add_state = [this](uint32_t depth) {
+        next_.resize(next_.size() + classes_, -1);
+        out_.push_back(-1);
+        out_link_.push_back(-1);
+        depth_.push_back(depth);
+        return static_cast<int32_t>(out_.size() - 1);
+    };
+
+    // The trie of all phrases.
+    add_state(0);
+    for (size_t r = 0; r < rules_.size(); ++r) {
+        int32_t s = 0;
+        for (char c : rules_[r].from) {
+            auto& slot = next_[static_cast<size_t>(s) * classes_ + class_of_[static_cast<unsigned char>(c)]];
+            if (slot < 0) {
+                int32_t created = add_state(depth_[static_cast<size_t>(s)] + 1);
+                // add_state may have moved next_; look the slot up again.
+                next_[static_cast<size_t>(s) * classes_ + class_of_[static_cast<unsigned char>(c)]] = created;
+                s = created;
+            } else {
+                s = slot;
+            }
+        }
+        out_[static_cast<size_t>(s)] = static_cast<int32_t>(r);
+    }
+
+    // Breadth first, every missing edge becomes the edge of the failure state
+    // (the longest proper suffix that is also in the trie), which turns the
+    // trie into a DFA that never has to look back.
+    std::vector<int32_t> fail(out_.size(), 0);
+    std::deque<int32_t> queue{0};
+    while (!queue.empty()) {
+        int32_t u = queue.front();
+        queue.pop_front();
+        auto row = static_cast<size_t>(u) * classes_;
+        auto fail_row = static_cast<size_t>(fail[static_cast<size_t>(u)]) * classes_;
+        for (size_t cls = 0; cls < classes_; ++cls) {
+            int32_t v = next_[row + cls];
+            if (v < 0) {
+                next_[row + cls] = u == 0 ? 0 : next_[fail_row + cls];
+                continue;
+            }
+            auto vi = static_cast<size_t>(v);
+            fail[vi] = u == 0 ? 0 : next_[fail_row + cls];
+            auto f = static_cast<size_t>(fail[vi]);
+            out_link_[vi] = out_[f] >= 0 ? fail[vi] : out_link_[f];
+            queue.push_back(v);
+        }
+    }
+}
+
+std::string Replacer::apply(std::string_view text) const {
+    if (rules_.empty()) return std::string(text);
+
+    struct Match {
+        size_t start;
+        size_t end;
+        int32_t rule;
+    };
+    std::vector<Match> matches;
+
+    int32_t s = 0;
+    for (size_t i = 0; i < text.size(); ++i) {
+        s = step(s, static_cast<unsigned char>(text[i]));
+        for (int32_t t = out_[static_cast<size_t>(s)] >= 0 ? s : out_link_[static_cast<size_t>(s)];
+             t >= 0; t = out_link_[static_cast<size_t>(t)]) {
+            size_t end = i + 1;
+            size_t start = end - depth_[static_cast<size_t>(t)];
+            if (is_word(text[start]) && start > 0 && is_word(text[start - 1])) continue;
+            if (is_word(text[end - 1]) && end < text.size() && is_word(text[end])) continue;
+            matches.push_back({start, end, out_[static_cast<size_t>(t)]});
+        }
+    }
+    if (matches.empty()) return std::string(text);
+
+    std::ranges::sort(matches, [](const Match& a, const Match& b) {
+        return a.start != b.start ? a.start < b.start : a.end > b.end;
+    });
+
+    std::string out;
+    out.reserve(text.size());
+    size_t pos = 0;
+    for (auto& m : matches) {
+        if (m.start < pos) continue;  // overlaps the one taken before
+        auto& to = rules_[static_cast<size_t>(m.rule)].to;
+        out.append(text.substr(pos, m.start - pos));
+        if (attaches_left(to)) {
+            while (!out.empty() && is_space(out.back())) out.pop_back();
+        }
+        out += to;
+        pos = m.end;
+        if (attaches_right(to)) {
+            while (pos < text.size() && is_space(text[pos])) ++pos;
+        }
+    }
+    out.append(text.substr(pos));
+    return out;
+}
+
+std::string Replacer::apply_next(std::string_view shown, std::string_view piece) const {
+    // A replacement that attaches left at the start of the piece drops the
+    // separating space by itself. One that ended shown with a newline
+    // swallows the spaces after it, as it would within one text.
+    std::string out = apply(piece);
+    if (!rules_.empty() && shown.ends_with('\n')) out.erase(0, out.find_first_not_of(" \t"));
+    return out;
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Replaces whole words and phrases in a transcript, any number of rules in
+// one pass over the text.
+//
+// The rules are compiled into an Aho-Corasick automaton once; apply() then
+// walks the text byte by byte without backtracking, however many rules there
+// are. Matching is ASCII case-insensitive and only counts at word boundaries,
+// so "cube control" matches "Cube control," but not "cube controls". Where
+// matches overlap, the leftmost wins, then the longest.
+//
+// Replacements that start with punctuation or a newline swallow the space
+// before the match, and ones that end with a newline the space after it, so
+// "hello comma world" becomes "hello, world".
+class Replacer {
+public:
+    struct Rule {
+        std::string from;
+        std::string to;
+    };
+
+    Replacer() = default;
+    // A later rule for the same phrase overrides an earlier one.
+    explicit Replacer(std::span<const Rule> rules);
+
+    std::string apply(std::string_view text) const;
+    // apply() for text that goes out piece by piece: piece continues the
+    // transcript (with the space that separates it), and shown is the output
+    // so far. Joining the outputs gives what apply() gives for the whole,
+    // except for a phrase that spans the join.
+    std::string apply_next(std::string_view shown, std::string_view piece) const;
+
+    bool empty() const { return rules_.empty(); }
+    size_t rule_count() const { return rules_.size(); }
+    size_t state_count() const { return out_.size(); }
+
+private:
+    int32_t step(int32_t state, unsigned char c) const {
+        return next_[static_cast<size_t>(state) * classes_ + class_of_[c]];
+    }
+
+    // Bytes that occur in no rule share class 0, which always leads back to
+    // the root, so the transition table is states x (distinct bytes + 1).
+    std::array<uint16_t, 256> class_of_{};
+    size_t classes_ = 1;
+    std::vector<int32_t> next_;
+    std::vector<int32_t> out_;       // rule whose phrase ends at this state, or -1
+    std::vector<int32_t> out_link_;  // nearest suffix state with an output, or -1
+    std::vector<uint32_t> depth_;    // phrase length at each state
+    std::vector<Rule> rules_;        // from lowercased
+};
@@ -1,22 +1,31 @@
 #pragma once
 
+#include <algorithm>
+#include <array>
 #include <cstdint>
 #include <cstring>
+#include <expected>
 #include <span>
+#include <string>
 #include <vector>
 
-// Encodes raw PCM int16 samples into a WAV file in memory.
+// Encodes raw PCM int16 samples into a WAV file in memory, and reads such
+// files back (replayed captures).
 namespace wav {
 
-inline std::vector<uint8_t> encode(std::span<const int16_t> samples, uint32_t sample_rate) {
+constexpr size_t HEADER_SIZE = 44;
+
+// The 44-byte RIFF header for a mono 16-bit clip of num_samples samples.
+// Lets callers stream the PCM that follows without building the whole file.
+inline std::array<uint8_t, HEADER_SIZE> header(size_t num_samples, uint32_t sample_rate) {
     constexpr uint16_t channels = 1;
     constexpr uint16_t bits_per_sample = 16;
     uint32_t byte_rate = sample_rate * channels * bits_per_sample / 8;
     uint16_t block_align = channels * bits_per_sample / 8;
-    uint32_t data_size = static_cast<uint32_t>(samples.size() * sizeof(int16_t));
+    uint32_t data_size = static_cast<uint32_t>(num_samples * sizeof(int16_t));
     uint32_t file_size = 36 + data_size;
 
-    std::vector<uint8_t> out(44 + data_size);
+    std::array<uint8_t, HEADER_SIZE> out{};
     auto w = [&out, pos = size_t(0)](const void* data, size_t len) mutable {
         std::memcpy(out.data() + pos, data, len);
         pos += len;
@@ -37,9 +46,69 @@ inline std::vector<uint8_t> encode(std::span<const int16_t> samples, uint32_t sa
     w16(bits_per_sample);
     w("data", 4);
     w32(data_size);
-    std::memcpy(out.data() + 44, samples.data(), data_size);
 
     return out;
 }
 
+inline std::vector<uint8_t> encode(std::span<const int16_t> samples, uint32_t sample_rate) {
+    auto hdr = header(samples.size(), sample_rate);
+    size_t data_size = samples.size() * sizeof(int16_t);
+
+    std::vector<uint8_t> out(HEADER_SIZE + data_size);
+    std::memcpy(out.data(), hdr.data(), HEADER_SIZE);
+    std::memcpy(out.data() + HEADER_SIZE, samples.data(), data_size);
+    return out;
+}
+
+struct Clip {
+    std::vector<int16_t> samples;  // interleaved
+    uint32_t sample_rate = 0;
+    uint16_t channels = 0;
+};
+
+// 16-bit PCM, any rate and channel count. Chunks other than "fmt " and
+// "data" are skipped; a data size past the end (a recording cut short) takes
+// what is there.
+inline std::expected<Clip, std::string> decode(std::span<const uint8_t> file) {
+    auto u16 = [&file](size_t pos) {
+        uint16_t v;
+        std::memcpy(&v, file.data() + pos, 2);
+        return v;
+    };
+    auto u32 = [&file](size_t pos) {
+        uint32_t v;
+        std::memcpy(&v, file.data() + pos, 4);
+        return v;
+    };
+    auto tag = [&file](size_t pos, const char* name) { return std::memcmp(file.data() + pos, name, 4) == 0; };
+
+    if (file.size() < 12 || !tag(0, "RIFF") || !tag(8, "WAVE")) return std::unexpected("not a WAV file");
+
+    Clip clip;
+    bool have_format = false;
+    for (size_t pos = 12; pos + 8 <= file.size();) {
+        size_t size = u32(pos + 4);
+        size_t body = pos + 8;
+        if (tag(pos, "fmt ")) {
+            if (size < 16 || body + 16 > file.size()) return std::unexpected("truncated fmt chunk");
+            uint16_t format = u16(body);
+            // 0xFFFE (extensible) carries the PCM subformat further on.
+            if (format != 1 && format != 0xFFFE) return std::unexpected("not PCM");
+            if (u16(body + 14) != 16) return std::unexpected("not 16-bit");
+            clip.channels = u16(body + 2);
+            clip.sample_rate = u32(body + 4);
+            if (clip.channels == 0 || clip.sample_rate == 0) return std::unexpected("bad fmt chunk");
+            have_format = true;
+        } else if (tag(pos, "data")) {
+            if (!have_format) return std::unexpected("data before fmt");
+            size_t bytes = std::min(size, file.size() - body) & ~size_t(1);
+            clip.samples.resize(bytes / sizeof(int16_t));
+            std::memcpy(clip.samples.data(), file.data() + body, bytes);
+            return clip;
+        }
+        pos = body + size + (size & 1);  // chunks are padded to even sizes
+    }
+    return std::unexpected(have_format ? "no data chunk" : "no fmt chunk");
+}
+
 } // namespace wav
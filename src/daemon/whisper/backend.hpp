@@ -1,14 +1,45 @@
 #pragma once
 
+#include "audio/simd.hpp"
+#include "audio_encoder.hpp"
+#include "metrics.hpp"
+
 #include <cstdint>
 #include <expected>
+#include <functional>
 #include <span>
+#include <stop_token>
 #include <string>
+#include <string_view>
+#include <vector>
+
+class CurlMulti;
+
+// One piece of a clip that ChunkingBackend split up.
+struct ChunkTiming {
+    double start_s = 0.0;       // offset into the clip
+    double duration_s = 0.0;
+    double queued_s = 0.0;      // waiting for a free worker
+    double processing_s = 0.0;  // the backend request
+};
 
 struct TranscriptResult {
     std::string text;
     double duration_s = 0.0;
     double processing_s = 0.0;
+    // The backend fills in the stages it went through; the daemon adds its own.
+    StageTimings timings;
+    bool cached = false;  // answered by CachingBackend without a request
+    std::vector<ChunkTiming> chunks;  // empty unless the clip was split
+};
+
+// How a server behind a backend is doing (see CircuitBreaker).
+struct EndpointHealth {
+    std::string name;
+    std::string state;  // "closed", "open" or "half-open"
+    uint32_t consecutive_failures = 0;
+    uint64_t rejected = 0;  // requests failed fast while open
+    std::string last_error;
 };
 
 class WhisperBackend {
@@ -16,4 +47,66 @@ public:
     virtual ~WhisperBackend() = default;
     virtual std::expected<TranscriptResult, std::string>
         transcribe(std::span<const int16_t> audio, uint32_t sample_rate) = 0;
+
+    // Hint that a transcription is coming soon (recording started). Backends
+    // can use it to open connections ahead of time. Must not block.
+    virtual void warm_up() {}
+
+    // Upload format the backend sends ("wav", "flac" or "opus"). For anything
+    // but "wav", callers may encode while recording and use transcribe_encoded.
+    virtual std::string upload_format() const { return "wav"; }
+
+    virtual std::expected<TranscriptResult, std::string>
+        transcribe_encoded(const EncodedAudio& /*audio*/) {
+        return std::unexpected("backend does not accept encoded audio");
+    }
+
+    // Cancellable variants: give up once stop is requested. The defaults
+    // ignore the token, so backends that can't abort a request still work.
+    //
+    // prompt is text the model reads as if it came before the audio, which
+    // biases it towards the words in it (see PromptBuilder). Backends
+    // without prompt support ignore it.
+    virtual std::expected<TranscriptResult, std::string>
+        transcribe(std::span<const int16_t> audio, uint32_t sample_rate, std::stop_token /*stop*/,
+                   std::string_view /*prompt*/ = {}) {
+        return transcribe(audio, sample_rate);
+    }
+
+    virtual std::expected<TranscriptResult, std::string>
+        transcribe_encoded(const EncodedAudio& audio, std::stop_token /*stop*/,
+                           std::string_view /*prompt*/ = {}) {
+        return transcribe_encoded(audio);
+    }
+
+    // Float PCM in [-1, 1]. Backends whose model takes float report
+    // accepts_float(), and the daemon then converts while recording so stop
+    // only converts the last chunk. The default goes back to int16.
+    virtual bool accepts_float() const { return false; }
+
+    virtual std::expected<TranscriptResult, std::string>
+        transcribe(std::span<const float> audio, uint32_t sample_rate, std::stop_token stop,
+                   std::string_view prompt = {}) {
+        std::vector<int16_t> pcm(audio.size());
+        audio::to_int16(audio.data(), audio.size(), pcm.data());
+        return transcribe(std::span<const int16_t>(pcm), sample_rate, stop, prompt);
+    }
+
+    // Starts the request on an event loop's CurlMulti instead of blocking a
+    // thread in it; done then runs on the loop's thread. Returns the transfer
+    // id for CurlMulti::cancel, or 0 if this backend can only block, and the
+    // caller has to use transcribe() on a thread of its own. audio must stay
+    // valid until done runs.
+    using Done = std::function<void(std::expected<TranscriptResult, std::string>)>;
+    virtual uint64_t start_transcribe(CurlMulti& /*transfers*/, std::span<const int16_t> /*audio*/,
+                                      uint32_t /*sample_rate*/, std::string_view /*prompt*/,
+                                      Done /*done*/) {
+        return 0;
+    }
+
+    // Checks, with a cheap request on the event loop's transfers, that the
+    // server is still there; the answer (or its absence) feeds health().
+    // Backends without a server have nothing to check.
+    virtual void probe(CurlMulti& /*transfers*/) {}
+    virtual std::vector<EndpointHealth> health() const { return {}; }
 };
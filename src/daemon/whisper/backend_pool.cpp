@@ -0,0 +1,249 @@
+#include "backend_pool.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <numeric>
+#include <thread>
+#include <tuple>
+#include <utility>
+
+namespace {
+
+void append_error(std::string& errors, const std::string& name, const std::string& error) {
+    if (!errors.empty()) errors += "; ";
+    errors += name + ": " + error;
+}
+
+} // namespace
+
+std::optional<BackendPool::Mode> BackendPool::parse_mode(std::string_view name) {
+    if (name == "failover") return Mode::Failover;
+    if (name == "latency") return Mode::Latency;
+    if (name == "race") return Mode::Race;
+    return std::nullopt;
+}
+
+BackendPool::BackendPool(Mode mode) : mode_(mode) {}
+
+BackendPool::~BackendPool() {
+    std::lock_guard lock(stragglers_mu_);
+    for (auto& s : stragglers_) s.cancel.request_stop();
+    stragglers_.clear();
+}
+
+void BackendPool::add(std::string name, std::unique_ptr<WhisperBackend> backend) {
+    endpoints_.push_back(Endpoint{
+        .name = name,
+        .backend = std::move(backend),
+        .stats = {.name = name},
+    });
+}
+
+void BackendPool::add_fallback(std::string name, std::unique_ptr<WhisperBackend> backend) {
+    add(std::move(name), std::move(backend));
+    endpoints_.back().fallback = true;
+}
+
+std::expected<TranscriptResult, std::string>
+BackendPool::transcribe(std::span<const int16_t> audio, uint32_t sample_rate) {
+    return transcribe(audio, sample_rate, std::stop_token{});
+}
+
+std::expected<TranscriptResult, std::string>
+BackendPool::transcribe(std::span<const int16_t> audio, uint32_t sample_rate,
+                        std::stop_token stop, std::string_view prompt) {
+    if (mode_ == Mode::Race) {
+        // The losing request may still be unwinding after we return, so it
+        // needs its own copy of the audio (and prompt).
+        auto data = std::make_shared<const std::vector<int16_t>>(audio.begin(), audio.end());
+        return run([data, sample_rate, p = std::string(prompt)](WhisperBackend& b, std::stop_token s) {
+            return b.transcribe(*data, sample_rate, s, p);
+        }, stop);
+    }
+    return run([audio, sample_rate, prompt](WhisperBackend& b, std::stop_token s) {
+        return b.transcribe(audio, sample_rate, s, prompt);
+    }, stop);
+}
+
+std::expected<TranscriptResult, std::string>
+BackendPool::transcribe_encoded(const EncodedAudio& audio) {
+    return transcribe_encoded(audio, std::stop_token{});
+}
+
+std::expected<TranscriptResult, std::string>
+BackendPool::transcribe_encoded(const EncodedAudio& audio, std::stop_token stop,
+                                std::string_view prompt) {
+    if (mode_ == Mode::Race) {
+        auto data = std::make_shared<const EncodedAudio>(audio);
+        return run([data, p = std::string(prompt)](WhisperBackend& b, std::stop_token s) {
+            return b.transcribe_encoded(*data, s, p);
+        }, stop);
+    }
+    return run([&audio, prompt](WhisperBackend& b, std::stop_token s) {
+        return b.transcribe_encoded(audio, s, prompt);
+    }, stop);
+}
+
+void BackendPool::warm_up() {
+    for (auto& ep : endpoints_) ep.backend->warm_up();
+}
+
+std::string BackendPool::upload_format() const {
+    if (endpoints_.empty()) return "wav";
+    auto format = endpoints_.front().backend->upload_format();
+    for (auto& ep : endpoints_) {
+        if (ep.backend->upload_format() != format) return "wav";
+    }
+    return format;
+}
+
+void BackendPool::probe(CurlMulti& transfers) {
+    for (auto& ep : endpoints_) ep.backend->probe(transfers);
+}
+
+std::vector<EndpointHealth> BackendPool::health() const {
+    std::vector<EndpointHealth> out;
+    for (auto& ep : endpoints_) {
+        for (auto& h : ep.backend->health()) {
+            out.push_back(std::move(h));
+            out.back().name = ep.name;
+        }
+    }
+    return out;
+}
+
+std::vector<BackendPool::EndpointStats> BackendPool::stats() const {
+    std::lock_guard lock(stats_mu_);
+    std::vector<EndpointStats> out;
+    for (auto& ep : endpoints_) out.push_back(ep.stats);
+    return out;
+}
+
+std::vector<size_t> BackendPool::ranked() const {
+    std::vector<size_t> order(endpoints_.size());
+    std::iota(order.begin(), order.end(), 0);
+    if (mode_ == Mode::Failover) {
+        std::ranges::stable_partition(order, [this](size_t i) { return !endpoints_[i].fallback; });
+        return order;
+    }
+
+    // Unmeasured endpoints score 0 and so get tried first. Only requests
+    // running side by side see an in_flight above 0; they spread out.
+    std::lock_guard lock(stats_mu_);
+    std::ranges::stable_sort(order, {}, [this](size_t i) {
+        auto& s = endpoints_[i].stats;
+        return std::tuple(endpoints_[i].fallback, s.in_flight, s.seconds_per_audio_second);
+    });
+    return order;
+}
+
+std::expected<TranscriptResult, std::string>
+BackendPool::attempt_on(size_t index, const Attempt& attempt, std::stop_token stop) {
+    {
+        std::lock_guard lock(stats_mu_);
+        ++endpoints_[index].stats.in_flight;
+    }
+    auto result = attempt(*endpoints_[index].backend, stop);
+    std::lock_guard lock(stats_mu_);
+    --endpoints_[index].stats.in_flight;
+    return result;
+}
+
+void BackendPool::record(size_t index, const std::expected<TranscriptResult, std::string>& result) {
+    double sample = FAILURE_PENALTY;
+    if (result) {
+        if (result->duration_s <= 0.0) return;
+        sample = result->processing_s / result->duration_s;
+    }
+
+    std::lock_guard lock(stats_mu_);
+    auto& s = endpoints_[index].stats;
+    bool first = s.successes + s.failures == 0;
+    s.seconds_per_audio_second = first ? sample
+        : EWMA_ALPHA * sample + (1.0 - EWMA_ALPHA) * s.seconds_per_audio_second;
+    if (result) {
+        ++s.successes;
+    } else {
+        ++s.failures;
+    }
+}
+
+std::expected<TranscriptResult, std::string>
+BackendPool::run(const Attempt& attempt, std::stop_token stop) {
+    if (endpoints_.empty()) return std::unexpected("no backends configured");
+
+    auto order = ranked();
+    std::string errors;
+    size_t next = 0;
+
+    if (mode_ == Mode::Race && order.size() >= 2 && !endpoints_[order[1]].fallback) {
+        auto result = race(attempt, order[0], order[1], stop);
+        if (result) return result;
+        errors = result.error();
+        next = 2;
+    }
+
+    for (; next < order.size(); ++next) {
+        if (stop.stop_requested()) return std::unexpected("cancelled");
+        size_t i = order[next];
+        auto result = attempt_on(i, attempt, stop);
+        if (result || !stop.stop_requested()) record(i, result);
+        if (result) return result;
+        append_error(errors, endpoints_[i].name, result.error());
+    }
+    return std::unexpected(errors);
+}
+
+std::expected<TranscriptResult, std::string>
+BackendPool::race(const Attempt& attempt, size_t a, size_t b, std::stop_token stop) {
+    struct RaceState {
+        std::mutex mu;
+        std::condition_variable cv;
+        std::stop_source cancel;
+        std::optional<TranscriptResult> winner;
+        std::string errors;
+        int finished = 0;
+    };
+    auto state = std::make_shared<RaceState>();
+
+    {
+        std::lock_guard threads_lock(stragglers_mu_);
+        // Threads of earlier races that have since finished can be reaped now.
+        std::erase_if(stragglers_, [](const Straggler& s) { return s.done->load(); });
+
+        for (size_t i : {a, b}) {
+            auto done = std::make_shared<std::atomic<bool>>(false);
+            stragglers_.push_back(Straggler{
+                .done = done,
+                .cancel = state->cancel,
+                .thread = std::jthread([this, state, attempt, i, done] {
+                    auto result = attempt_on(i, attempt, state->cancel.get_token());
+                    // A loser aborted by the winner says nothing about its speed.
+                    if (result || !state->cancel.stop_requested()) record(i, result);
+                    {
+                        std::lock_guard lock(state->mu);
+                        ++state->finished;
+                        if (result && !state->winner) {
+                            state->winner = std::move(*result);
+                            state->cancel.request_stop();
+                        } else if (!result) {
+                            append_error(state->errors, endpoints_[i].name, result.error());
+                        }
+                    }
+                    state->cv.notify_all();
+                    done->store(true);
+                }),
+            });
+        }
+    }
+
+    std::stop_callback forward(stop, [state] { state->cancel.request_stop(); });
+
+    // The loser keeps running in the background until its cancellation lands;
+    // only the winner's latency matters to the caller.
+    std::unique_lock lock(state->mu);
+    state->cv.wait(lock, [&] { return state->winner || state->finished == 2; });
+    if (state->winner) return std::move(*state->winner);
+    return std::unexpected(state->errors);
+}
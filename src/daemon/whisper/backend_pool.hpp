@@ -0,0 +1,115 @@
+#pragma once
+
+#include "backend.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+// Several transcription endpoints behind one WhisperBackend.
+//
+//   failover: try endpoints in configured order until one succeeds
+//   latency:  try them in order of recent speed (EWMA of processing time per
+//             audio second), so a busy box loses traffic until it recovers;
+//             concurrent requests (chunks of one clip) go to the endpoint with
+//             the fewest requests in flight first
+//   race:     send to the two fastest at once, take the first success and
+//             cancel the other; falls back to the rest if both fail
+//
+// A fallback (the local model) is tried only once every endpoint has
+// failed; endpoints that are down fail at once (see CircuitBreaker), so
+// that is immediate.
+class BackendPool : public WhisperBackend {
+public:
+    enum class Mode { Failover, Latency, Race };
+    static std::optional<Mode> parse_mode(std::string_view name);
+
+    explicit BackendPool(Mode mode);
+    ~BackendPool() override;
+
+    BackendPool(const BackendPool&) = delete;
+    BackendPool& operator=(const BackendPool&) = delete;
+
+    void add(std::string name, std::unique_ptr<WhisperBackend> backend);
+    // Tried last, whatever the mode, and never raced.
+    void add_fallback(std::string name, std::unique_ptr<WhisperBackend> backend);
+    size_t size() const { return endpoints_.size(); }
+
+    std::expected<TranscriptResult, std::string>
+        transcribe(std::span<const int16_t> audio, uint32_t sample_rate) override;
+    std::expected<TranscriptResult, std::string>
+        transcribe(std::span<const int16_t> audio, uint32_t sample_rate,
+                   std::stop_token stop, std::string_view prompt = {}) override;
+    std::expected<TranscriptResult, std::string>
+        transcribe_encoded(const EncodedAudio& audio) override;
+    std::expected<TranscriptResult, std::string>
+        transcribe_encoded(const EncodedAudio& audio, std::stop_token stop,
+                           std::string_view prompt = {}) override;
+
+    void warm_up() override;
+    // The members' common format, or "wav" if they disagree.
+    std::string upload_format() const override;
+
+    void probe(CurlMulti& transfers) override;
+    // Every member's, named as added.
+    std::vector<EndpointHealth> health() const override;
+
+    struct EndpointStats {
+        std::string name;
+        double seconds_per_audio_second = 0.0;  // EWMA; 0 until measured
+        uint64_t successes = 0;
+        uint64_t failures = 0;
+        uint32_t in_flight = 0;
+    };
+    std::vector<EndpointStats> stats() const;
+
+    // Weight of the newest sample in the EWMA.
+    static constexpr double EWMA_ALPHA = 0.3;
+    // Recorded as the speed of a failed request, so broken endpoints sink.
+    static constexpr double FAILURE_PENALTY = 10.0;
+
+private:
+    using Attempt = std::function<std::expected<TranscriptResult, std::string>(
+        WhisperBackend&, std::stop_token)>;
+
+    std::expected<TranscriptResult, std::string> run(const Attempt& attempt, std::stop_token stop);
+    std::expected<TranscriptResult, std::string>
+        race(const Attempt& attempt, size_t a, size_t b, std::stop_token stop);
+
+    // Endpoint indices in the order they should be tried.
+    std::vector<size_t> ranked() const;
+    void record(size_t index, const std::expected<TranscriptResult, std::string>& result);
+    // Calls attempt on endpoint index, counted in its in_flight meanwhile.
+    std::expected<TranscriptResult, std::string>
+        attempt_on(size_t index, const Attempt& attempt, std::stop_token stop);
+
+    struct Endpoint {
+        std::string name;
+        std::unique_ptr<WhisperBackend> backend;
+        EndpointStats stats;
+        bool fallback = false;
+    };
+
+    // A race thread that may outlive the race it ran in.
+    struct Straggler {
+        std::shared_ptr<std::atomic<bool>> done;
+        std::stop_source cancel;
+        std::jthread thread;
+    };
+
+    Mode mode_;
+    std::vector<Endpoint> endpoints_;
+    mutable std::mutex stats_mu_;
+
+    // Declared after endpoints_ so the threads are joined before the
+    // backends they use are destroyed.
+    std::mutex stragglers_mu_;
+    std::vector<Straggler> stragglers_;
+};
@@ -0,0 +1,82 @@
+#include "caching_backend.hpp"
+
+#include "hash.hpp"
+
+#include <format>
+
+CachingBackend::CachingBackend(std::unique_ptr<WhisperBackend> inner,
+                               std::unique_ptr<TranscriptCache> cache, std::string params)
+    : inner_(std::move(inner)), cache_(std::move(cache)), params_(std::move(params)) {}
+
+uint64_t CachingBackend::key(Kind kind, const void* data, size_t bytes, uint32_t sample_rate,
+                             std::string_view extra) const {
+    // Everything but the audio is short; it only seeds the pass over the audio.
+    auto seed = hash::xxh64(std::format("{}\n{}\n{}\n{}", params_, static_cast<int>(kind),
+                                        sample_rate, extra));
+    return hash::xxh64(data, bytes, seed);
+}
+
+template <typename Request>
+std::expected<TranscriptResult, std::string>
+CachingBackend::cached(uint64_t key, Request&& request) {
+    if (auto hit = cache_->get(key)) return std::move(*hit);
+
+    auto result = request();
+    if (result) cache_->put(key, *result);
+    return result;
+}
+
+std::expected<TranscriptResult, std::string>
+CachingBackend::transcribe(std::span<const int16_t> audio, uint32_t sample_rate) {
+    return transcribe(audio, sample_rate, std::stop_token{});
+}
+
+std::expected<TranscriptResult, std::string>
+CachingBackend::transcribe(std::span<const int16_t> audio, uint32_t sample_rate,
+                           std::stop_token stop, std::string_view prompt) {
+    auto k = key(Kind::Pcm16, audio.data(), audio.size_bytes(), sample_rate, prompt);
+    return cached(k, [&] { return inner_->transcribe(audio, sample_rate, stop, prompt); });
+}
+
+uint64_t CachingBackend::start_transcribe(CurlMulti& transfers, std::span<const int16_t> audio,
+                                          uint32_t sample_rate, std::string_view prompt, Done done) {
+    auto k = key(Kind::Pcm16, audio.data(), audio.size_bytes(), sample_rate, prompt);
+    if (cache_->contains(k)) return 0;
+
+    uint64_t id = inner_->start_transcribe(transfers, audio, sample_rate, prompt,
+                                           [this, k, done = std::move(done)](auto result) {
+        if (result) cache_->put(k, *result);
+        done(std::move(result));
+    });
+    if (id) cache_->count_miss();
+    return id;
+}
+
+std::expected<TranscriptResult, std::string>
+CachingBackend::refresh(std::span<const int16_t> audio, uint32_t sample_rate, std::stop_token stop) {
+    auto result = inner_->transcribe(audio, sample_rate, stop);
+    if (result) cache_->put(key(Kind::Pcm16, audio.data(), audio.size_bytes(), sample_rate, {}), *result);
+    return result;
+}
+
+std::expected<TranscriptResult, std::string>
+CachingBackend::transcribe(std::span<const float> audio, uint32_t sample_rate,
+                           std::stop_token stop, std::string_view prompt) {
+    auto k = key(Kind::Float, audio.data(), audio.size_bytes(), sample_rate, prompt);
+    return cached(k, [&] { return inner_->transcribe(audio, sample_rate, stop, prompt); });
+}
+
+std::expected<TranscriptResult, std::string>
+CachingBackend::transcribe_encoded(const EncodedAudio& audio) {
+    return transcribe_encoded(audio, std::stop_token{});
+}
+
+std::expected<TranscriptResult, std::string>
+CachingBackend::transcribe_encoded(const EncodedAudio& audio, std::stop_token stop,
+                                   std::string_view prompt) {
+    // The mime type tells an Opus file from a FLAC one with the same bytes,
+    // however unlikely; the rate is in the file.
+    auto k = key(Kind::Encoded, audio.data.data(), audio.data.size(), 0,
+                 std::string(prompt) + '\n' + audio.mime_type);
+    return cached(k, [&] { return inner_->transcribe_encoded(audio, stop, prompt); });
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "backend.hpp"
+#include "transcript_cache.hpp"
+
+#include <memory>
+#include <string>
+#include <string_view>
+
+// Answers repeated audio from a TranscriptCache instead of the backend, so a
+// retry or a retranscribe of unchanged audio with the same model makes no
+// request at all.
+//
+// The key is XXH64 over the samples (or the encoded file), seeded with a hash
+// of `params` (the backend, its model and language, as DaemonCore describes
+// them), the sample rate and the prompt. Results that failed or were
+// cancelled are not kept.
+class CachingBackend : public WhisperBackend {
+public:
+    CachingBackend(std::unique_ptr<WhisperBackend> inner, std::unique_ptr<TranscriptCache> cache,
+                   std::string params);
+
+    std::expected<TranscriptResult, std::string>
+        transcribe(std::span<const int16_t> audio, uint32_t sample_rate) override;
+    std::expected<TranscriptResult, std::string>
+        transcribe(std::span<const int16_t> audio, uint32_t sample_rate,
+                   std::stop_token stop, std::string_view prompt = {}) override;
+    std::expected<TranscriptResult, std::string>
+        transcribe(std::span<const float> audio, uint32_t sample_rate,
+                   std::stop_token stop, std::string_view prompt = {}) override;
+    std::expected<TranscriptResult, std::string>
+        transcribe_encoded(const EncodedAudio& audio) override;
+    std::expected<TranscriptResult, std::string>
+        transcribe_encoded(const EncodedAudio& audio, std::stop_token stop,
+                           std::string_view prompt = {}) override;
+
+    // A hit returns 0: transcribe() answers it on the spot.
+    uint64_t start_transcribe(CurlMulti& transfers, std::span<const int16_t> audio,
+                              uint32_t sample_rate, std::string_view prompt, Done done) override;
+
+    void warm_up() override { inner_->warm_up(); }
+    std::string upload_format() const override { return inner_->upload_format(); }
+    bool accepts_float() const override { return inner_->accepts_float(); }
+
+    // Asks the backend even if the audio is cached, and keeps the new result.
+    std::expected<TranscriptResult, std::string>
+        refresh(std::span<const int16_t> audio, uint32_t sample_rate, std::stop_token stop);
+
+    TranscriptCache& cache() { return *cache_; }
+    const TranscriptCache& cache() const { return *cache_; }
+
+private:
+    // Samples, encoded files and float PCM of the same audio hash apart.
+    enum class Kind : uint8_t { Pcm16, Float, Encoded };
+    // extra: the prompt, plus the mime type of encoded audio.
+    uint64_t key(Kind kind, const void* data, size_t bytes, uint32_t sample_rate,
+                 std::string_view extra) const;
+
+    template <typename Request>
+    std::expected<TranscriptResult, std::string> cached(uint64_t key, Request&& request);
+
+    std::unique_ptr<WhisperBackend> inner_;
+    std::unique_ptr<TranscriptCache> cache_;
+    std::string params_;
+};
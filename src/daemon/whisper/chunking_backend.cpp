@@ -0,0 +1,205 @@
+#include "chunking_backend.hpp"
+
+#include "audio/vad.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <format>
+#include <mutex>
+#include <optional>
+#include <thread>
+
+namespace chunking {
+
+namespace {
+
+struct Word {
+    std::string key;  // lowercased, punctuation dropped
+    size_t end = 0;   // just past the word in the source text
+};
+
+std::vector<Word> words(std::string_view text) {
+    std::vector<Word> out;
+    size_t i = 0;
+    while (i < text.size()) {
+        while (i < text.size() && (text[i] == ' ' || text[i] == '\n' || text[i] == '\t')) ++i;
+        if (i == text.size()) break;
+        Word w;
+        for (; i < text.size() && text[i] != ' ' && text[i] != '\n' && text[i] != '\t'; ++i) {
+            auto c = static_cast<unsigned char>(text[i]);
+            if (c >= 'A' && c <= 'Z') {
+                w.key += static_cast<char>(c - 'A' + 'a');
+            } else if ((c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') || c == '\'' || c >= 0x80) {
+                w.key += static_cast<char>(c);
+            }
+        }
+        w.end = i;
+        out.push_back(std::move(w));
+    }
+    return out;
+}
+
+std::string_view trim(std::string_view s) {
+    auto first = s.find_first_not_of(" \n\t");
+    if (first == std::string_view::npos) return {};
+    return s.substr(first, s.find_last_not_of(" \n\t") - first + 1);
+}
+
+} // namespace
+
+std::vector<Span> plan(std::span<const int16_t> audio, uint32_t sample_rate, const Options& opts) {
+    size_t max_len = static_cast<size_t>(std::max<uint32_t>(opts.max_chunk_seconds, 1)) * sample_rate;
+    if (audio.size() <= max_len) return {{0, audio.size()}};
+
+    size_t min_len = std::min(static_cast<size_t>(opts.min_chunk_seconds) * sample_rate, max_len / 2);
+    size_t overlap = std::min(static_cast<size_t>(opts.overlap_ms) * sample_rate / 1000, min_len / 2);
+    size_t silence = static_cast<size_t>(opts.silence_ms) * sample_rate / 1000;
+    size_t step = std::max<size_t>(1, sample_rate / 100);
+
+    Vad vad(sample_rate, opts.threshold_db);
+    std::vector<Span> spans;
+    Span current;
+    std::optional<size_t> cut;
+
+    for (size_t pos = 0; pos < audio.size();) {
+        size_t take = std::min(step, audio.size() - pos);
+        vad.process(audio.subspan(pos, take));
+        pos += take;
+
+        // The pause keeps growing while it lasts; its middle moves with it.
+        if (vad.speech_detected() && vad.trailing_silence_samples() >= silence) {
+            size_t middle = vad.samples_processed() - vad.trailing_silence_samples() / 2;
+            if (middle >= current.begin + min_len) cut = middle;
+        }
+
+        if (pos - current.begin >= max_len && pos < audio.size()) {
+            if (cut) {
+                current.end = *cut;
+                spans.push_back(current);
+                current = {*cut, 0, false};
+            } else {
+                // Nowhere quiet to cut: both chunks get the words around the
+                // cut, and merge() drops the repeat.
+                current.end = pos;
+                spans.push_back(current);
+                current = {pos - overlap, 0, true};
+            }
+            cut.reset();
+        }
+    }
+    current.end = audio.size();
+    spans.push_back(current);
+    return spans;
+}
+
+std::string merge(std::string_view left, std::string_view right, size_t max_words) {
+    left = trim(left);
+    right = trim(right);
+
+    auto lw = words(left);
+    auto rw = words(right);
+    size_t drop = 0;
+    for (size_t k = std::min({max_words, lw.size(), rw.size()}); k > 0; --k) {
+        if (std::ranges::equal(lw.end() - static_cast<ptrdiff_t>(k), lw.end(), rw.begin(),
+                               rw.begin() + static_cast<ptrdiff_t>(k), {}, &Word::key, &Word::key)) {
+            drop = k;
+            break;
+        }
+    }
+    if (drop > 0) right = trim(right.substr(rw[drop - 1].end));
+
+    std::string out(left);
+    if (!out.empty() && !right.empty()) out += ' ';
+    out += right;
+    return out;
+}
+
+} // namespace chunking
+
+ChunkingBackend::ChunkingBackend(std::unique_ptr<WhisperBackend> inner, chunking::Options opts)
+    : inner_(std::move(inner)), opts_(opts) {}
+
+std::expected<TranscriptResult, std::string>
+ChunkingBackend::transcribe(std::span<const int16_t> audio, uint32_t sample_rate) {
+    return transcribe(audio, sample_rate, std::stop_token{});
+}
+
+std::expected<TranscriptResult, std::string>
+ChunkingBackend::transcribe(std::span<const int16_t> audio, uint32_t sample_rate,
+                            std::stop_token stop, std::string_view prompt) {
+    if (!splits(audio.size(), sample_rate)) return inner_->transcribe(audio, sample_rate, stop, prompt);
+    auto spans = chunking::plan(audio, sample_rate, opts_);
+    if (spans.size() < 2) return inner_->transcribe(audio, sample_rate, stop, prompt);
+
+    using Clock = std::chrono::steady_clock;
+    auto seconds_since = [](Clock::time_point t) {
+        return std::chrono::duration<double>(Clock::now() - t).count();
+    };
+    auto start = Clock::now();
+
+    struct Piece {
+        std::expected<TranscriptResult, std::string> result = std::unexpected("cancelled");
+        ChunkTiming timing;
+    };
+    std::vector<Piece> pieces(spans.size());
+
+    // One failed chunk leaves a hole in the text, so it cancels the rest.
+    std::stop_source cancel;
+    std::stop_callback forward(stop, [&cancel] { cancel.request_stop(); });
+    std::mutex error_mu;
+    std::string error;
+
+    std::atomic<size_t> next{0};
+    auto work = [&] {
+        for (size_t i; (i = next.fetch_add(1)) < spans.size();) {
+            auto& piece = pieces[i];
+            auto& span = spans[i];
+            piece.timing = ChunkTiming{
+                .start_s = static_cast<double>(span.begin) / sample_rate,
+                .duration_s = static_cast<double>(span.end - span.begin) / sample_rate,
+                .queued_s = seconds_since(start),
+            };
+            if (cancel.stop_requested()) continue;
+
+            auto sent = Clock::now();
+            piece.result = inner_->transcribe(audio.subspan(span.begin, span.end - span.begin),
+                                              sample_rate, cancel.get_token(), prompt);
+            piece.timing.processing_s = seconds_since(sent);
+            if (!piece.result) {
+                {
+                    std::lock_guard lock(error_mu);
+                    if (error.empty()) {
+                        error = std::format("chunk {} of {}: {}", i + 1, spans.size(),
+                                            piece.result.error());
+                    }
+                }
+                cancel.request_stop();
+            }
+        }
+    };
+
+    {
+        // The calling thread is one of the workers.
+        std::vector<std::jthread> workers;
+        size_t n = std::min<size_t>(std::max<uint32_t>(opts_.concurrency, 1), spans.size());
+        for (size_t w = 1; w < n; ++w) workers.emplace_back(work);
+        work();
+    }
+
+    if (stop.stop_requested()) return std::unexpected("cancelled");
+    if (!error.empty()) return std::unexpected(error);
+
+    TranscriptResult out{
+        .duration_s = static_cast<double>(audio.size()) / sample_rate,
+        .processing_s = seconds_since(start),
+    };
+    for (size_t i = 0; i < pieces.size(); ++i) {
+        auto& text = pieces[i].result->text;
+        out.text = spans[i].overlaps ? chunking::merge(out.text, text) : chunking::merge(out.text, text, 0);
+        out.chunks.push_back(pieces[i].timing);
+    }
+    // The chunks' own stages overlap; what the caller waited for is the lot.
+    out.timings.inference_s = out.processing_s;
+    return out;
+}
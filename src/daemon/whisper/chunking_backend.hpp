@@ -0,0 +1,96 @@
+#pragma once
+
+#include "backend.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace chunking {
+
+struct Options {
+    uint32_t max_chunk_seconds = 30;
+    uint32_t concurrency = 4;
+    uint32_t overlap_ms = 1000;
+    // Where to cut: the middle of the last pause of silence_ms that leaves
+    // the chunk at least min_chunk_seconds long.
+    double threshold_db = -45.0;
+    uint32_t silence_ms = 300;
+    uint32_t min_chunk_seconds = 10;
+};
+
+struct Span {
+    size_t begin = 0;
+    size_t end = 0;
+    // Cut without a pause: starts overlap_ms before the previous one ended.
+    bool overlaps = false;
+};
+
+// Splits a clip into chunks of at most max_chunk_seconds. A clip that fits
+// comes back as one span.
+std::vector<Span> plan(std::span<const int16_t> audio, uint32_t sample_rate, const Options& opts);
+
+// Joins the texts of two adjacent chunks. If the end of left and the start
+// of right are the same words (ignoring case and punctuation), up to
+// max_words of them, right's copy is dropped.
+std::string merge(std::string_view left, std::string_view right, size_t max_words = 8);
+
+} // namespace chunking
+
+// Sends long clips to the backend as several chunks at once.
+//
+// A meeting-length recording in one request waits for a single server to
+// get through all of it. Split at pauses, the chunks go out on up to
+// `concurrency` requests in parallel, which a BackendPool spreads over its
+// endpoints and a LanBackend over its pooled connections, and the texts are
+// joined in order. Clips no longer than max_chunk_seconds pass straight
+// through, as do encoded and float audio (the local model runs one
+// inference at a time, so splitting its input gains nothing).
+class ChunkingBackend : public WhisperBackend {
+public:
+    ChunkingBackend(std::unique_ptr<WhisperBackend> inner, chunking::Options opts);
+
+    std::expected<TranscriptResult, std::string>
+        transcribe(std::span<const int16_t> audio, uint32_t sample_rate) override;
+    std::expected<TranscriptResult, std::string>
+        transcribe(std::span<const int16_t> audio, uint32_t sample_rate,
+                   std::stop_token stop, std::string_view prompt = {}) override;
+    std::expected<TranscriptResult, std::string>
+        transcribe(std::span<const float> audio, uint32_t sample_rate,
+                   std::stop_token stop, std::string_view prompt = {}) override {
+        return inner_->transcribe(audio, sample_rate, stop, prompt);
+    }
+    std::expected<TranscriptResult, std::string>
+        transcribe_encoded(const EncodedAudio& audio) override {
+        return inner_->transcribe_encoded(audio);
+    }
+    std::expected<TranscriptResult, std::string>
+        transcribe_encoded(const EncodedAudio& audio, std::stop_token stop,
+                           std::string_view prompt = {}) override {
+        return inner_->transcribe_encoded(audio, stop, prompt);
+    }
+
+    // Only a clip that isn't split; the chunks need threads.
+    uint64_t start_transcribe(CurlMulti& transfers, std::span<const int16_t> audio,
+                              uint32_t sample_rate, std::string_view prompt, Done done) override {
+        if (splits(audio.size(), sample_rate)) return 0;
+        return inner_->start_transcribe(transfers, audio, sample_rate, prompt, std::move(done));
+    }
+
+    void warm_up() override { inner_->warm_up(); }
+    std::string upload_format() const override { return inner_->upload_format(); }
+    bool accepts_float() const override { return inner_->accepts_float(); }
+
+    // Whether a clip of this length would be split.
+    bool splits(size_t samples, uint32_t sample_rate) const {
+        return samples > static_cast<size_t>(opts_.max_chunk_seconds) * sample_rate;
+    }
+
+private:
+    std::unique_ptr<WhisperBackend> inner_;
+    chunking::Options opts_;
+};
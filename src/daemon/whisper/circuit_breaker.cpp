@@ -0,0 +1,56 @@
+#include "circuit_breaker.hpp"
+
+#include <algorithm>
+
+bool CircuitBreaker::allow(Clock::time_point now) {
+    std::lock_guard lock(mu_);
+    if (state_ == State::Closed) return true;
+    if (now - since_ >= options_.retry) {
+        state_ = State::HalfOpen;
+        since_ = now;
+        return true;
+    }
+    ++rejected_;
+    return false;
+}
+
+bool CircuitBreaker::closed() const {
+    std::lock_guard lock(mu_);
+    return state_ == State::Closed;
+}
+
+void CircuitBreaker::success() {
+    std::lock_guard lock(mu_);
+    state_ = State::Closed;
+    consecutive_ = 0;
+}
+
+void CircuitBreaker::failure(std::string error, Clock::time_point now) {
+    std::lock_guard lock(mu_);
+    last_error_ = std::move(error);
+    ++consecutive_;
+    if (state_ == State::Open) return;  // a probe; the retry clock keeps running
+    if (state_ == State::HalfOpen || consecutive_ >= std::max<uint32_t>(1, options_.failures)) {
+        state_ = State::Open;
+        since_ = now;
+    }
+}
+
+CircuitBreaker::Snapshot CircuitBreaker::snapshot() const {
+    std::lock_guard lock(mu_);
+    return {
+        .state = state_,
+        .consecutive_failures = consecutive_,
+        .rejected = rejected_,
+        .last_error = last_error_,
+    };
+}
+
+const char* CircuitBreaker::name(State state) {
+    switch (state) {
+    case State::Closed: return "closed";
+    case State::Open: return "open";
+    case State::HalfOpen: return "half-open";
+    }
+    return "closed";
+}
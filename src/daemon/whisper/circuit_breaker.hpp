@@ -0,0 +1,59 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+// Whether a transcription server is worth sending audio to.
+//
+// Closed: requests go out. After `failures` connection failures in a row
+// (requests or health probes) it opens, and requests fail at once instead of
+// waiting out the connect timeout, so a pool moves on to its next endpoint
+// straight away. Once `retry` has passed, one request is let through
+// (half-open); it closes the breaker if it gets an answer and opens it again
+// if not. A successful probe closes it whenever it arrives.
+//
+// Requests run on worker threads and probes on the event loop, so every
+// call takes the lock.
+class CircuitBreaker {
+public:
+    using Clock = std::chrono::steady_clock;
+    enum class State { Closed, Open, HalfOpen };
+
+    struct Options {
+        uint32_t failures = 2;
+        std::chrono::milliseconds retry{30000};
+    };
+
+    struct Snapshot {
+        State state = State::Closed;
+        uint32_t consecutive_failures = 0;
+        uint64_t rejected = 0;  // requests failed fast while open
+        std::string last_error;
+    };
+
+    explicit CircuitBreaker(Options options) : options_(options) {}
+
+    // Whether a request may go out now. Half-open lets one through at a
+    // time; a trial that never reports back (it was cancelled) is given
+    // up on after another retry period.
+    bool allow(Clock::time_point now = Clock::now());
+    // Closed, with nothing half-open in the way: a request would go out.
+    bool closed() const;
+
+    void success();
+    void failure(std::string error, Clock::time_point now = Clock::now());
+
+    Snapshot snapshot() const;
+    static const char* name(State state);
+
+private:
+    Options options_;
+    mutable std::mutex mu_;
+    State state_ = State::Closed;
+    uint32_t consecutive_ = 0;
+    uint64_t rejected_ = 0;
+    std::string last_error_;
+    Clock::time_point since_{};  // opened, or the half-open trial started
+};
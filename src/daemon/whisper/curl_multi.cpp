@@ -0,0 +1,143 @@
+#include "curl_multi.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <poll.h>
+
+CurlMulti::CurlMulti(Watch watch, Timer timer)
+    : watch_(std::move(watch)), timer_(std::move(timer)) {
+    curl_global_init(CURL_GLOBAL_DEFAULT);
+    multi_ = curl_multi_init();
+    if (multi_) {
+        curl_multi_setopt(multi_, CURLMOPT_SOCKETFUNCTION, socket_callback);
+        curl_multi_setopt(multi_, CURLMOPT_SOCKETDATA, this);
+        curl_multi_setopt(multi_, CURLMOPT_TIMERFUNCTION, timer_callback);
+        curl_multi_setopt(multi_, CURLMOPT_TIMERDATA, this);
+    }
+}
+
+CurlMulti::~CurlMulti() {
+    for (auto& t : transfers_) {
+        curl_multi_remove_handle(multi_, t.easy);
+        t.result = CURLE_ABORTED_BY_CALLBACK;
+        aborted_.push_back(std::move(t));
+    }
+    transfers_.clear();
+    finish();
+
+    if (multi_) curl_multi_cleanup(multi_);
+    curl_global_cleanup();
+}
+
+uint64_t CurlMulti::add(CURL* easy, Done done) {
+    if (!multi_ || curl_multi_add_handle(multi_, easy) != CURLM_OK) return 0;
+    uint64_t id = next_id_++;
+    transfers_.push_back(Transfer{.id = id, .easy = easy, .done = std::move(done)});
+    return id;
+}
+
+void CurlMulti::cancel(uint64_t id) {
+    auto it = std::ranges::find(transfers_, id, &Transfer::id);
+    if (it == transfers_.end()) return;
+
+    curl_multi_remove_handle(multi_, it->easy);
+    it->result = CURLE_ABORTED_BY_CALLBACK;
+    aborted_.push_back(std::move(*it));
+    transfers_.erase(it);
+    // The callback runs from the loop, not from under the caller.
+    timeout_ms_ = 0;
+    timer_(0);
+}
+
+void CurlMulti::on_socket(int fd, uint32_t events) {
+    int mask = 0;
+    if (events & Read) mask |= CURL_CSELECT_IN;
+    if (events & Write) mask |= CURL_CSELECT_OUT;
+    if (events & Error) mask |= CURL_CSELECT_ERR;
+    int running = 0;
+    curl_multi_socket_action(multi_, fd, mask, &running);
+    finish();
+}
+
+void CurlMulti::on_timeout() {
+    int running = 0;
+    curl_multi_socket_action(multi_, CURL_SOCKET_TIMEOUT, 0, &running);
+    finish();
+}
+
+void CurlMulti::finish() {
+    std::vector<Transfer> done = std::move(aborted_);
+    aborted_.clear();
+
+    int queued = 0;
+    while (CURLMsg* msg = curl_multi_info_read(multi_, &queued)) {
+        if (msg->msg != CURLMSG_DONE) continue;
+        // msg doesn't survive remove_handle.
+        CURL* easy = msg->easy_handle;
+        CURLcode result = msg->data.result;
+        curl_multi_remove_handle(multi_, easy);
+
+        auto it = std::ranges::find(transfers_, easy, &Transfer::easy);
+        if (it == transfers_.end()) continue;
+        it->result = result;
+        done.push_back(std::move(*it));
+        transfers_.erase(it);
+    }
+
+    // After the bookkeeping: a callback may start the next transfer.
+    for (auto& t : done) t.done(t.easy, t.result);
+}
+
+void CurlMulti::run_until_idle() {
+    while (active() > 0) {
+        if (!aborted_.empty()) {
+            finish();
+            continue;
+        }
+
+        std::vector<pollfd> fds;
+        for (auto [fd, events] : sockets_) {
+            fds.push_back({.fd = fd,
+                           .events = static_cast<short>(((events & Read) ? POLLIN : 0) |
+                                                        ((events & Write) ? POLLOUT : 0)),
+                           .revents = 0});
+        }
+        // Without a timeout from libcurl, look again every 100 ms.
+        int n = ::poll(fds.data(), fds.size(), timeout_ms_ < 0 ? 100 : static_cast<int>(timeout_ms_));
+        if (n < 0 && errno != EINTR) break;
+        if (n <= 0) {
+            timeout_ms_ = -1;
+            on_timeout();
+            continue;
+        }
+        for (auto& p : fds) {
+            if (p.revents == 0) continue;
+            uint32_t events = ((p.revents & POLLIN) ? uint32_t{Read} : 0u) |
+                              ((p.revents & POLLOUT) ? uint32_t{Write} : 0u) |
+                              ((p.revents & (POLLERR | POLLHUP)) ? uint32_t{Error} : 0u);
+            on_socket(p.fd, events);
+        }
+    }
+}
+
+int CurlMulti::socket_callback(CURL*, curl_socket_t fd, int what, void* userp, void*) {
+    auto* self = static_cast<CurlMulti*>(userp);
+    uint32_t events = 0;
+    if (what == CURL_POLL_IN || what == CURL_POLL_INOUT) events |= Read;
+    if (what == CURL_POLL_OUT || what == CURL_POLL_INOUT) events |= Write;
+
+    if (what == CURL_POLL_REMOVE) {
+        if (self->sockets_.erase(fd)) self->watch_(fd, 0);
+    } else {
+        self->sockets_[fd] = events;
+        self->watch_(fd, events);
+    }
+    return 0;
+}
+
+int CurlMulti::timer_callback(CURLM*, long timeout_ms, void* userp) {
+    auto* self = static_cast<CurlMulti*>(userp);
+    self->timeout_ms_ = timeout_ms;
+    self->timer_(timeout_ms);
+    return 0;
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstdint>
+#include <curl/curl.h>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
+// libcurl transfers driven by the caller's event loop rather than a thread
+// each: the multi "socket" API tells us which sockets to watch and when to
+// call back, and the loop reports readiness through on_socket/on_timeout.
+//
+// Everything happens on the loop's thread, done callbacks included. They run
+// from on_socket, on_timeout or run_until_idle, never from add or cancel, so
+// a caller may cancel while walking its own list of requests.
+class CurlMulti {
+public:
+    enum Events : uint32_t { Read = 1, Write = 2, Error = 4 };
+
+    // Watch fd for the given Read/Write events, or stop watching it (0).
+    using Watch = std::function<void(int fd, uint32_t events)>;
+    // Call on_timeout() in ms milliseconds (0: as soon as possible), or
+    // never (-1). Each call replaces the previous timeout.
+    using Timer = std::function<void(long ms)>;
+    // The transfer is out of the multi handle; the easy handle is the
+    // caller's again.
+    using Done = std::function<void(CURL* easy, CURLcode result)>;
+
+    CurlMulti(Watch watch, Timer timer);
+    // Transfers still running are aborted and their callbacks run.
+    ~CurlMulti();
+
+    CurlMulti(const CurlMulti&) = delete;
+    CurlMulti& operator=(const CurlMulti&) = delete;
+
+    // Starts a configured easy handle. Returns an id for cancel(), or 0 if
+    // libcurl refused it (done is then dropped without being called).
+    uint64_t add(CURL* easy, Done done);
+    // Aborts a transfer; its callback gets CURLE_ABORTED_BY_CALLBACK on the
+    // next on_timeout. Unknown or finished ids are ignored.
+    void cancel(uint64_t id);
+
+    void on_socket(int fd, uint32_t events);
+    void on_timeout();
+
+    bool watches(int fd) const { return sockets_.contains(fd); }
+    size_t active() const { return transfers_.size() + aborted_.size(); }
+
+    // Drives the transfers with poll() until none is left. For shutdown,
+    // once the event loop no longer runs.
+    void run_until_idle();
+
+private:
+    static int socket_callback(CURL* easy, curl_socket_t fd, int what, void* userp, void* socketp);
+    static int timer_callback(CURLM* multi, long timeout_ms, void* userp);
+
+    // Hands finished and cancelled transfers to their callbacks.
+    void finish();
+
+    struct Transfer {
+        uint64_t id = 0;
+        CURL* easy = nullptr;
+        Done done;
+        CURLcode result = CURLE_OK;
+    };
+
+    CURLM* multi_ = nullptr;
+    Watch watch_;
+    Timer timer_;
+    std::unordered_map<int, uint32_t> sockets_;  // fd -> events libcurl waits for
+    std::vector<Transfer> transfers_;            // a handful at most
+    std::vector<Transfer> aborted_;              // cancelled, callback still due
+    long timeout_ms_ = -1;
+    uint64_t next_id_ = 1;
+};
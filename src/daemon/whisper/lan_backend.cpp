@@ -1,9 +1,16 @@
 #include "lan_backend.hpp"
 #include "../wav_encoder.hpp"
+#include "curl_multi.hpp"
 
+#include <algorithm>
+#include <array>
 #include <chrono>
+#include <cstdio>
+#include <cstring>
 #include <curl/curl.h>
+#include <memory>
 #include <nlohmann/json.hpp>
+#include <optional>
 #include <print>
 
 using json = nlohmann::json;
@@ -14,48 +21,326 @@ static size_t write_callback(char* ptr, size_t size, size_t nmemb, void* userdat
     return size * nmemb;
 }
 
-LanBackend::LanBackend(std::string url, std::string api_format, std::string language)
+namespace {
+
+// Upload body for the "file" part: a short prefix (the WAV header, or nothing
+// for pre-encoded files) followed by the payload, both read in place. libcurl
+// pulls it through the callbacks below, so the audio is never copied into an
+// encoded buffer or into libcurl itself.
+struct UploadBody {
+    std::span<const uint8_t> prefix;
+    std::span<const uint8_t> payload;
+    size_t pos = 0;
+    // When libcurl took the last byte and when the response began, for
+    // splitting upload from inference.
+    std::chrono::steady_clock::time_point sent{};
+    std::chrono::steady_clock::time_point first_byte{};
+
+    size_t size() const { return prefix.size() + payload.size(); }
+};
+
+size_t body_read(char* buffer, size_t size, size_t nitems, void* arg) {
+    auto* body = static_cast<UploadBody*>(arg);
+    size_t want = size * nitems;
+    size_t done = 0;
+
+    if (body->pos < body->prefix.size()) {
+        size_t n = std::min(want, body->prefix.size() - body->pos);
+        std::memcpy(buffer, body->prefix.data() + body->pos, n);
+        body->pos += n;
+        done += n;
+    }
+    if (done < want && body->pos >= body->prefix.size()) {
+        size_t off = body->pos - body->prefix.size();
+        size_t n = std::min(want - done, body->payload.size() - off);
+        std::memcpy(buffer + done, body->payload.data() + off, n);
+        body->pos += n;
+        done += n;
+    }
+    if (body->pos == body->size() && done > 0) body->sent = std::chrono::steady_clock::now();
+    return done;
+}
+
+// Only headers after the body count: a "100 Continue" comes before the upload.
+size_t header_callback(char*, size_t size, size_t nitems, void* arg) {
+    auto* body = static_cast<UploadBody*>(arg);
+    using time_point = std::chrono::steady_clock::time_point;
+    if (body->sent != time_point{} && body->first_byte == time_point{}) {
+        body->first_byte = std::chrono::steady_clock::now();
+    }
+    return size * nitems;
+}
+
+int body_seek(void* arg, curl_off_t offset, int origin) {
+    auto* body = static_cast<UploadBody*>(arg);
+    if (origin != SEEK_SET || offset < 0 || static_cast<size_t>(offset) > body->size()) {
+        return CURL_SEEKFUNC_FAIL;
+    }
+    body->pos = static_cast<size_t>(offset);
+    return CURL_SEEKFUNC_OK;
+}
+
+void add_file_part(curl_mime* mime, UploadBody& body, const char* mime_type,
+                   const char* file_name) {
+    curl_mimepart* part = curl_mime_addpart(mime);
+    curl_mime_name(part, "file");
+    curl_mime_data_cb(part, static_cast<curl_off_t>(body.size()), body_read, body_seek,
+                      nullptr, &body);
+    curl_mime_filename(part, file_name);
+    curl_mime_type(part, mime_type);
+}
+
+int abort_on_stop(void* arg, curl_off_t, curl_off_t, curl_off_t, curl_off_t) {
+    return static_cast<std::stop_token*>(arg)->stop_requested() ? 1 : 0;
+}
+
+// No connection could be made, as opposed to a server that is slow to
+// answer (whisper.cpp serves one request at a time) or a request it refused.
+bool unreachable(CURL* curl, CURLcode res) {
+    if (res == CURLE_COULDNT_RESOLVE_HOST || res == CURLE_COULDNT_CONNECT || res == CURLE_SSL_CONNECT_ERROR) {
+        return true;
+    }
+    if (res != CURLE_OPERATION_TIMEDOUT) return false;
+    curl_off_t connected = 0;
+    curl_easy_getinfo(curl, CURLINFO_CONNECT_TIME_T, &connected);
+    return connected == 0;
+}
+
+} // namespace
+
+struct LanBackend::Request {
+    UploadBody body;
+    std::array<uint8_t, wav::HEADER_SIZE> header{};  // body.prefix for PCM sent asynchronously
+    double duration_s = 0.0;
+    std::stop_token stop;
+    std::optional<double> encode_s;
+
+    std::string endpoint;
+    curl_mime* mime = nullptr;
+    std::string response;
+    std::chrono::steady_clock::time_point start;
+    std::chrono::steady_clock::time_point perform_start;
+};
+
+LanBackend::LanBackend(std::string url, std::string api_format, std::string language,
+                       bool http2, std::string audio_format, uint32_t opus_bitrate,
+                       CircuitBreaker::Options health)
     : url_(std::move(url)), api_format_(std::move(api_format)),
-      language_(std::move(language)) {
+      language_(std::move(language)), http2_(http2),
+      audio_format_(std::move(audio_format)), opus_bitrate_(opus_bitrate),
+      health_(std::make_shared<Health>(health)) {
     curl_global_init(CURL_GLOBAL_DEFAULT);
+
+    if (audio_format_ != "wav" && !make_audio_encoder(audio_format_, 16000, opus_bitrate_)) {
+        std::println(stderr, "Audio format '{}' unavailable, uploading WAV", audio_format_);
+        audio_format_ = "wav";
+    }
+
+    share_ = curl_share_init();
+    if (share_) {
+        curl_share_setopt(share_, CURLSHOPT_LOCKFUNC, share_lock);
+        curl_share_setopt(share_, CURLSHOPT_UNLOCKFUNC, share_unlock);
+        curl_share_setopt(share_, CURLSHOPT_USERDATA, this);
+        curl_share_setopt(share_, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+        curl_share_setopt(share_, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+        curl_share_setopt(share_, CURLSHOPT_SHARE, CURL_LOCK_DATA_CONNECT);
+    }
 }
 
 LanBackend::~LanBackend() {
+    if (warm_thread_.joinable()) warm_thread_.join();
+
+    for (CURL* curl : idle_handles_) {
+        curl_easy_cleanup(curl);
+    }
+    idle_handles_.clear();
+
+    if (share_) curl_share_cleanup(share_);
     curl_global_cleanup();
 }
 
+void LanBackend::share_lock(CURL*, curl_lock_data data, curl_lock_access, void* userp) {
+    static_cast<LanBackend*>(userp)->share_mu_[data].lock();
+}
+
+void LanBackend::share_unlock(CURL*, curl_lock_data data, void* userp) {
+    static_cast<LanBackend*>(userp)->share_mu_[data].unlock();
+}
+
+CURL* LanBackend::acquire_handle() {
+    CURL* curl = nullptr;
+    {
+        std::lock_guard lock(pool_mu_);
+        if (!idle_handles_.empty()) {
+            curl = idle_handles_.back();
+            idle_handles_.pop_back();
+        }
+    }
+    if (!curl) curl = curl_easy_init();
+    if (!curl) return nullptr;
+
+    // Options are cleared on release, so (re)apply the persistent ones here.
+    if (share_) curl_easy_setopt(curl, CURLOPT_SHARE, share_);
+    curl_easy_setopt(curl, CURLOPT_TCP_KEEPALIVE, 1L);
+    curl_easy_setopt(curl, CURLOPT_TCP_KEEPIDLE, 30L);
+    curl_easy_setopt(curl, CURLOPT_TCP_KEEPINTVL, 15L);
+    curl_easy_setopt(curl, CURLOPT_DNS_CACHE_TIMEOUT, 300L);
+    if (http2_) {
+        curl_easy_setopt(curl, CURLOPT_HTTP_VERSION, CURL_HTTP_VERSION_2TLS);
+    }
+    return curl;
+}
+
+void LanBackend::release_handle(CURL* curl) {
+    // Reset drops per-request options but keeps the live connection.
+    curl_easy_reset(curl);
+    std::lock_guard lock(pool_mu_);
+    idle_handles_.push_back(curl);
+}
+
+void LanBackend::warm_up() {
+    if (warming_.exchange(true)) return;
+    if (warm_thread_.joinable()) warm_thread_.join();
+
+    warm_thread_ = std::jthread([this] {
+        CURL* curl = acquire_handle();
+        if (curl) {
+            // A bodiless request is enough to resolve, connect and (for https)
+            // complete the TLS handshake; the connection stays in the cache.
+            curl_easy_setopt(curl, CURLOPT_URL, url_.c_str());
+            curl_easy_setopt(curl, CURLOPT_NOBODY, 1L);
+            curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT, 3L);
+            curl_easy_setopt(curl, CURLOPT_TIMEOUT, 5L);
+            CURLcode res = curl_easy_perform(curl);
+            // By the time the recording stops, a server that is down is known to be.
+            if (res == CURLE_OK) {
+                health_->breaker.success();
+            } else if (unreachable(curl, res)) {
+                health_->breaker.failure(curl_easy_strerror(res));
+            }
+            release_handle(curl);
+        }
+        warming_.store(false);
+    });
+}
+
 std::expected<TranscriptResult, std::string>
 LanBackend::transcribe(std::span<const int16_t> audio, uint32_t sample_rate) {
+    return transcribe(audio, sample_rate, std::stop_token{});
+}
+
+std::expected<TranscriptResult, std::string>
+LanBackend::transcribe(std::span<const int16_t> audio, uint32_t sample_rate,
+                       std::stop_token stop, std::string_view prompt) {
     if (audio.empty()) {
         return std::unexpected("empty audio");
     }
 
     double duration_s = static_cast<double>(audio.size()) / sample_rate;
 
-    // Encode to WAV
-    auto wav_data = wav::encode(audio, sample_rate);
+    std::optional<double> encode_s;
+    if (audio_format_ != "wav") {
+        if (auto enc = make_audio_encoder(audio_format_, sample_rate, opus_bitrate_)) {
+            std::vector<uint8_t> data;
+            {
+                StageSpan span(encode_s);
+                enc->append(audio);
+                data = enc->finish();
+            }
+            auto result = upload({}, data, enc->mime_type(), enc->file_name(), duration_s,
+                                 stop, prompt);
+            if (result) result->timings.encode_s = encode_s;
+            return result;
+        }
+    }
 
-    auto start = std::chrono::steady_clock::now();
+    std::array<uint8_t, wav::HEADER_SIZE> header;
+    {
+        StageSpan span(encode_s);
+        header = wav::header(audio.size(), sample_rate);
+    }
+    auto result = upload(header, {reinterpret_cast<const uint8_t*>(audio.data()), audio.size_bytes()},
+                         "audio/wav", "audio.wav", duration_s, stop, prompt);
+    if (result) result->timings.encode_s = encode_s;
+    return result;
+}
 
-    CURL* curl = curl_easy_init();
+std::expected<TranscriptResult, std::string>
+LanBackend::transcribe_encoded(const EncodedAudio& audio) {
+    return transcribe_encoded(audio, std::stop_token{});
+}
+
+std::expected<TranscriptResult, std::string>
+LanBackend::transcribe_encoded(const EncodedAudio& audio, std::stop_token stop,
+                               std::string_view prompt) {
+    if (audio.data.empty()) {
+        return std::unexpected("empty audio");
+    }
+    return upload({}, audio.data, audio.mime_type.c_str(), audio.file_name.c_str(),
+                  audio.duration_s, stop, prompt);
+}
+
+uint64_t LanBackend::start_transcribe(CurlMulti& transfers, std::span<const int16_t> audio,
+                                      uint32_t sample_rate, std::string_view prompt, Done done) {
+    // A server marked down is left to upload(), which fails at once.
+    if (audio.empty() || audio_format_ != "wav" || !health_->breaker.closed()) return 0;
+
+    // Shared with the callback, which owns it until the transfer is over.
+    auto req = std::make_shared<Request>();
+    req->start = std::chrono::steady_clock::now();
+    req->duration_s = static_cast<double>(audio.size()) / sample_rate;
+    {
+        StageSpan span(req->encode_s);
+        req->header = wav::header(audio.size(), sample_rate);
+    }
+    req->body = {.prefix = req->header,
+                 .payload = {reinterpret_cast<const uint8_t*>(audio.data()), audio.size_bytes()}};
+
+    CURL* curl = prepare(*req, "audio/wav", "audio.wav", prompt);
+    if (!curl) return 0;
+    req->perform_start = std::chrono::steady_clock::now();
+    uint64_t id = transfers.add(curl, [this, req, done = std::move(done)](CURL* easy, CURLcode res) {
+        done(complete(*req, easy, res));
+    });
+    if (id == 0) complete(*req, curl, CURLE_FAILED_INIT);
+    return id;
+}
+
+std::expected<TranscriptResult, std::string>
+LanBackend::upload(std::span<const uint8_t> prefix, std::span<const uint8_t> payload,
+                   const char* mime_type, const char* file_name, double duration_s,
+                   std::stop_token stop, std::string_view prompt) {
+    if (!health_->breaker.allow()) {
+        auto h = health_->breaker.snapshot();
+        return std::unexpected("server unreachable, not trying it for now (" + h.last_error + ")");
+    }
+
+    Request req{.body = {.prefix = prefix, .payload = payload}, .duration_s = duration_s,
+                .stop = std::move(stop)};
+    req.start = std::chrono::steady_clock::now();
+
+    CURL* curl = prepare(req, mime_type, file_name, prompt);
     if (!curl) {
         return std::unexpected("curl_easy_init failed");
     }
+    req.perform_start = std::chrono::steady_clock::now();
+    CURLcode res = curl_easy_perform(curl);
+    return complete(req, curl, res);
+}
+
+CURL* LanBackend::prepare(Request& req, const char* mime_type, const char* file_name,
+                          std::string_view prompt) {
+    CURL* curl = acquire_handle();
+    if (!curl) return nullptr;
 
     // Build URL and form based on API format
-    std::string endpoint;
     curl_mime* mime = curl_mime_init(curl);
     curl_mimepart* part;
 
     if (api_format_ == "openai") {
-        endpoint = url_ + "/v1/audio/transcriptions";
+        req.endpoint = url_ + "/v1/audio/transcriptions";
 
-        part = curl_mime_addpart(mime);
-        curl_mime_name(part, "file");
-        curl_mime_data(part, reinterpret_cast<const char*>(wav_data.data()),
-                       wav_data.size());
-        curl_mime_filename(part, "audio.wav");
-        curl_mime_type(part, "audio/wav");
+        add_file_part(mime, req.body, mime_type, file_name);
 
         part = curl_mime_addpart(mime);
         curl_mime_name(part, "model");
@@ -70,14 +355,9 @@ LanBackend::transcribe(std::span<const int16_t> audio, uint32_t sample_rate) {
         curl_mime_data(part, "json", CURL_ZERO_TERMINATED);
     } else {
         // whisper.cpp server format
-        endpoint = url_ + "/inference";
+        req.endpoint = url_ + "/inference";
 
-        part = curl_mime_addpart(mime);
-        curl_mime_name(part, "file");
-        curl_mime_data(part, reinterpret_cast<const char*>(wav_data.data()),
-                       wav_data.size());
-        curl_mime_filename(part, "audio.wav");
-        curl_mime_type(part, "audio/wav");
+        add_file_part(mime, req.body, mime_type, file_name);
 
         part = curl_mime_addpart(mime);
         curl_mime_name(part, "temperature");
@@ -94,30 +374,78 @@ LanBackend::transcribe(std::span<const int16_t> audio, uint32_t sample_rate) {
         }
     }
 
-    std::string response_body;
+    // Both APIs call the field "prompt". libcurl copies it.
+    if (!prompt.empty()) {
+        part = curl_mime_addpart(mime);
+        curl_mime_name(part, "prompt");
+        curl_mime_data(part, prompt.data(), prompt.size());
+    }
+    req.mime = mime;
 
-    curl_easy_setopt(curl, CURLOPT_URL, endpoint.c_str());
+    curl_easy_setopt(curl, CURLOPT_URL, req.endpoint.c_str());
     curl_easy_setopt(curl, CURLOPT_MIMEPOST, mime);
     curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, write_callback);
-    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response_body);
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &req.response);
+    curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, header_callback);
+    curl_easy_setopt(curl, CURLOPT_HEADERDATA, &req.body);
     curl_easy_setopt(curl, CURLOPT_TIMEOUT, 120L);
     curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT, 10L);
+    if (req.stop.stop_possible()) {
+        // Polled by libcurl about once a second and on every transfer chunk.
+        curl_easy_setopt(curl, CURLOPT_NOPROGRESS, 0L);
+        curl_easy_setopt(curl, CURLOPT_XFERINFOFUNCTION, abort_on_stop);
+        curl_easy_setopt(curl, CURLOPT_XFERINFODATA, &req.stop);
+    }
+    return curl;
+}
 
-    CURLcode res = curl_easy_perform(curl);
+std::expected<TranscriptResult, std::string>
+LanBackend::complete(Request& req, CURL* curl, CURLcode res) {
+    auto end = std::chrono::steady_clock::now();
 
-    curl_mime_free(mime);
-    curl_easy_cleanup(curl);
+    // libcurl's timers and ours are both relative to the start of the transfer.
+    StageTimings timings;
+    timings.encode_s = req.encode_s;
+    if (res == CURLE_OK) {
+        auto info_s = [curl](CURLINFO what) {
+            curl_off_t us = 0;
+            curl_easy_getinfo(curl, what, &us);
+            return static_cast<double>(us) / 1e6;
+        };
+        auto since_start = [&req](std::chrono::steady_clock::time_point t, double fallback) {
+            if (t == std::chrono::steady_clock::time_point{}) return fallback;
+            return std::chrono::duration<double>(t - req.perform_start).count();
+        };
+        double pretransfer = info_s(CURLINFO_PRETRANSFER_TIME_T);
+        double sent = since_start(req.body.sent, pretransfer);
+        double first_byte = since_start(req.body.first_byte, info_s(CURLINFO_STARTTRANSFER_TIME_T));
 
-    auto end = std::chrono::steady_clock::now();
-    double processing_s = std::chrono::duration<double>(end - start).count();
+        timings.connect_s = std::max(info_s(CURLINFO_CONNECT_TIME_T),
+                                     info_s(CURLINFO_APPCONNECT_TIME_T));
+        timings.upload_s = std::max(0.0, sent - pretransfer);
+        timings.inference_s = std::max(0.0, first_byte - sent);
+        health_->breaker.success();
+    } else if (unreachable(curl, res)) {
+        health_->breaker.failure(curl_easy_strerror(res));
+    }
 
+    release_handle(curl);
+    curl_mime_free(req.mime);
+    req.mime = nullptr;
+
+    double processing_s = std::chrono::duration<double>(end - req.start).count();
+
+    if (res == CURLE_ABORTED_BY_CALLBACK) {
+        return std::unexpected("cancelled");
+    }
     if (res != CURLE_OK) {
         return std::unexpected(std::string("curl error: ") + curl_easy_strerror(res));
     }
 
     // Parse response
+    auto parse_start = std::chrono::steady_clock::now();
     try {
-        auto j = json::parse(response_body);
+        auto j = json::parse(req.response);
         std::string text;
 
         if (j.contains("text")) {
@@ -125,7 +453,7 @@ LanBackend::transcribe(std::span<const int16_t> audio, uint32_t sample_rate) {
         } else if (j.contains("error")) {
             return std::unexpected("server error: " + j["error"].get<std::string>());
         } else {
-            return std::unexpected("unexpected response: " + response_body);
+            return std::unexpected("unexpected response: " + req.response);
         }
 
         // Trim whitespace
@@ -137,12 +465,54 @@ LanBackend::transcribe(std::span<const int16_t> audio, uint32_t sample_rate) {
             }
         }
 
+        timings.parse_s = StageSpan::seconds_since(parse_start);
         return TranscriptResult{
             .text = std::move(text),
-            .duration_s = duration_s,
+            .duration_s = req.duration_s,
             .processing_s = processing_s,
+            .timings = timings,
         };
     } catch (const json::exception& e) {
         return std::unexpected(std::string("JSON parse error: ") + e.what());
     }
 }
+
+void LanBackend::probe(CurlMulti& transfers) {
+    // One at a time: a probe still connecting will report soon enough.
+    if (health_->probing.exchange(true)) return;
+
+    // A handle and connection of its own, outside the pool and the share,
+    // since the callback may run after this backend is gone.
+    CURL* curl = curl_easy_init();
+    if (!curl) {
+        health_->probing.store(false);
+        return;
+    }
+    curl_easy_setopt(curl, CURLOPT_URL, url_.c_str());
+    curl_easy_setopt(curl, CURLOPT_CONNECT_ONLY, 1L);
+    curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT_MS, PROBE_TIMEOUT_MS);
+    uint64_t id = transfers.add(curl, [health = health_](CURL* easy, CURLcode res) {
+        if (res == CURLE_OK) {
+            health->breaker.success();
+        } else if (res != CURLE_ABORTED_BY_CALLBACK) {
+            health->breaker.failure(std::string("probe: ") + curl_easy_strerror(res));
+        }
+        curl_easy_cleanup(easy);
+        health->probing.store(false);
+    });
+    if (id == 0) {
+        curl_easy_cleanup(curl);
+        health_->probing.store(false);
+    }
+}
+
+std::vector<EndpointHealth> LanBackend::health() const {
+    auto h = health_->breaker.snapshot();
+    return {{
+        .name = url_,
+        .state = CircuitBreaker::name(h.state),
+        .consecutive_failures = h.consecutive_failures,
+        .rejected = h.rejected,
+        .last_error = std::move(h.last_error),
+    }};
+}
@@ -1,21 +1,104 @@
 #pragma once
 
 #include "backend.hpp"
+#include "circuit_breaker.hpp"
 
+#include <atomic>
+#include <curl/curl.h>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <vector>
 
 class LanBackend : public WhisperBackend {
 public:
+    // Health probes only open a connection, and give up after this long.
+    static constexpr long PROBE_TIMEOUT_MS = 2000;
+
     // api_format: "whisper.cpp" or "openai"
+    // audio_format: "wav", "flac" or "opus" (falls back to "wav" if unavailable)
+    // health: when to stop sending requests to a server that can't be reached
     LanBackend(std::string url, std::string api_format = "whisper.cpp",
-               std::string language = "en");
+               std::string language = "en", bool http2 = false,
+               std::string audio_format = "wav", uint32_t opus_bitrate = 24000,
+               CircuitBreaker::Options health = {});
     ~LanBackend() override;
 
+    LanBackend(const LanBackend&) = delete;
+    LanBackend& operator=(const LanBackend&) = delete;
+
     std::expected<TranscriptResult, std::string>
         transcribe(std::span<const int16_t> audio, uint32_t sample_rate) override;
+    std::expected<TranscriptResult, std::string>
+        transcribe(std::span<const int16_t> audio, uint32_t sample_rate,
+                   std::stop_token stop, std::string_view prompt = {}) override;
+
+    // Opens a keep-alive connection to the server in the background.
+    void warm_up() override;
+
+    std::string upload_format() const override { return audio_format_; }
+    std::expected<TranscriptResult, std::string>
+        transcribe_encoded(const EncodedAudio& audio) override;
+    std::expected<TranscriptResult, std::string>
+        transcribe_encoded(const EncodedAudio& audio, std::stop_token stop,
+                           std::string_view prompt = {}) override;
+
+    // WAV uploads only: encoding FLAC or Opus here would hold up the loop.
+    uint64_t start_transcribe(CurlMulti& transfers, std::span<const int16_t> audio,
+                              uint32_t sample_rate, std::string_view prompt, Done done) override;
+
+    // Connects to the server and hangs up: enough to tell a server that is
+    // down from one that is busy.
+    void probe(CurlMulti& transfers) override;
+    std::vector<EndpointHealth> health() const override;
 
 private:
+    // One request's state, which libcurl's callbacks point into.
+    struct Request;
+
+    // Posts prefix + payload as the "file" part, both read in place.
+    std::expected<TranscriptResult, std::string>
+        upload(std::span<const uint8_t> prefix, std::span<const uint8_t> payload,
+               const char* mime_type, const char* file_name, double duration_s,
+               std::stop_token stop, std::string_view prompt);
+
+    // A handle set up to post req's body, or nullptr.
+    CURL* prepare(Request& req, const char* mime_type, const char* file_name,
+                  std::string_view prompt);
+    // Returns the handle to the pool and reads the response.
+    std::expected<TranscriptResult, std::string> complete(Request& req, CURL* curl, CURLcode res);
+
+    // Easy handles are pooled so concurrent requests (streamed segments) each
+    // get one; all of them share DNS, TLS session and connection caches.
+    CURL* acquire_handle();
+    void release_handle(CURL* curl);
+
+    static void share_lock(CURL* handle, curl_lock_data data, curl_lock_access access, void* userp);
+    static void share_unlock(CURL* handle, curl_lock_data data, void* userp);
+
     std::string url_;
     std::string api_format_;
     std::string language_;
+    bool http2_;
+    std::string audio_format_;
+    uint32_t opus_bitrate_;
+
+    CURLSH* share_ = nullptr;
+    std::mutex share_mu_[CURL_LOCK_DATA_LAST];
+
+    std::mutex pool_mu_;
+    std::vector<CURL*> idle_handles_;
+
+    // Shared with probes in flight, which may finish after a reload has
+    // destroyed this backend.
+    struct Health {
+        explicit Health(CircuitBreaker::Options options) : breaker(options) {}
+        CircuitBreaker breaker;
+        std::atomic<bool> probing{false};
+    };
+    std::shared_ptr<Health> health_;
+
+    std::atomic<bool> warming_{false};
+    std::jthread warm_thread_;
 };
@@ -0,0 +1,159 @@
+#include "local_backend.hpp"
+
+#include <whisper.h>
+
+#include <algorithm>
+#include <chrono>
+#include <print>
+
+namespace {
+
+constexpr uint32_t WHISPER_RATE = 16000;
+
+bool abort_on_stop(void* user_data) {
+    return static_cast<std::stop_token*>(user_data)->stop_requested();
+}
+
+// whisper.cpp's own logging is very chatty; keep only warnings and errors.
+void quiet_log(ggml_log_level level, const char* text, void*) {
+    if (level == GGML_LOG_LEVEL_WARN || level == GGML_LOG_LEVEL_ERROR) {
+        std::print(stderr, "whisper: {}", text);
+    }
+}
+
+} // namespace
+
+LocalWhisperBackend::LocalWhisperBackend(Options opts) : opts_(std::move(opts)) {
+    if (opts_.threads <= 0) {
+        opts_.threads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    }
+    whisper_log_set(quiet_log, nullptr);
+}
+
+LocalWhisperBackend::~LocalWhisperBackend() {
+    if (load_thread_.joinable()) load_thread_.join();
+    if (ctx_) whisper_free(ctx_);
+}
+
+std::expected<void, std::string> LocalWhisperBackend::load() {
+    std::lock_guard lock(mu_);
+    if (ctx_) return {};
+
+    auto start = std::chrono::steady_clock::now();
+    auto params = whisper_context_default_params();
+    params.use_gpu = opts_.use_gpu;
+    ctx_ = whisper_init_from_file_with_params(opts_.model_path.c_str(), params);
+    if (!ctx_) {
+        return std::unexpected("failed to load whisper model " + opts_.model_path);
+    }
+
+    auto end = std::chrono::steady_clock::now();
+    std::println(stderr, "whisper: loaded {} in {:.2f}s ({} threads, gpu {})", opts_.model_path,
+                 std::chrono::duration<double>(end - start).count(), opts_.threads,
+                 opts_.use_gpu ? "on" : "off");
+    return {};
+}
+
+void LocalWhisperBackend::warm_up() {
+    {
+        std::lock_guard lock(mu_);
+        if (ctx_) return;
+    }
+    if (load_thread_.joinable()) return;  // a load is already underway or done
+    load_thread_ = std::jthread([this] { load(); });
+}
+
+std::expected<TranscriptResult, std::string>
+LocalWhisperBackend::transcribe(std::span<const int16_t> audio, uint32_t sample_rate) {
+    return transcribe(audio, sample_rate, std::stop_token{});
+}
+
+std::expected<void, std::string> LocalWhisperBackend::prepare(size_t samples, uint32_t sample_rate) {
+    if (samples == 0) {
+        return std::unexpected("empty audio");
+    }
+    if (sample_rate != WHISPER_RATE) {
+        return std::unexpected("local whisper needs 16000 Hz audio");
+    }
+    return load();
+}
+
+std::expected<TranscriptResult, std::string>
+LocalWhisperBackend::transcribe(std::span<const int16_t> audio, uint32_t sample_rate,
+                                std::stop_token stop, std::string_view prompt) {
+    if (auto ready = prepare(audio.size(), sample_rate); !ready) {
+        return std::unexpected(ready.error());
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    std::lock_guard lock(mu_);
+
+    StageTimings timings;
+
+    // The model's input is float PCM in [-1, 1]; the buffer is reused.
+    {
+        StageSpan span(timings.encode_s);
+        pcm_.resize(audio.size());
+        audio::to_float(audio.data(), audio.size(), pcm_.data());
+    }
+    return infer(pcm_, sample_rate, stop, prompt, timings, start);
+}
+
+std::expected<TranscriptResult, std::string>
+LocalWhisperBackend::transcribe(std::span<const float> audio, uint32_t sample_rate,
+                                std::stop_token stop, std::string_view prompt) {
+    if (auto ready = prepare(audio.size(), sample_rate); !ready) {
+        return std::unexpected(ready.error());
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    std::lock_guard lock(mu_);
+    return infer(audio, sample_rate, stop, prompt, StageTimings{}, start);
+}
+
+std::expected<TranscriptResult, std::string>
+LocalWhisperBackend::infer(std::span<const float> pcm, uint32_t sample_rate, std::stop_token& stop,
+                           std::string_view prompt, StageTimings timings,
+                           std::chrono::steady_clock::time_point start) {
+    auto params = whisper_full_default_params(WHISPER_SAMPLING_GREEDY);
+    params.n_threads = opts_.threads;
+    params.language = opts_.language.empty() ? "auto" : opts_.language.c_str();
+    params.no_context = true;
+    params.print_progress = false;
+    params.print_realtime = false;
+    params.print_special = false;
+    params.print_timestamps = false;
+    params.abort_callback = abort_on_stop;
+    params.abort_callback_user_data = &stop;
+    std::string initial_prompt(prompt);  // whisper wants it NUL-terminated
+    if (!initial_prompt.empty()) params.initial_prompt = initial_prompt.c_str();
+
+    auto inference_start = std::chrono::steady_clock::now();
+    if (whisper_full(ctx_, params, pcm.data(), static_cast<int>(pcm.size())) != 0) {
+        if (stop.stop_requested()) return std::unexpected("cancelled");
+        return std::unexpected("whisper_full failed");
+    }
+    timings.inference_s = StageSpan::seconds_since(inference_start);
+
+    auto parse_start = std::chrono::steady_clock::now();
+    std::string text;
+    int segments = whisper_full_n_segments(ctx_);
+    for (int i = 0; i < segments; ++i) {
+        text += whisper_full_get_segment_text(ctx_, i);
+    }
+
+    // Trim whitespace
+    auto first = text.find_first_not_of(" \t\n\r");
+    auto last = text.find_last_not_of(" \t\n\r");
+    text = first == std::string::npos ? std::string{} : text.substr(first, last - first + 1);
+
+    timings.parse_s = StageSpan::seconds_since(parse_start);
+
+    auto end = std::chrono::steady_clock::now();
+    return TranscriptResult{
+        .text = std::move(text),
+        .duration_s = static_cast<double>(pcm.size()) / sample_rate,
+        .processing_s = std::chrono::duration<double>(end - start).count(),
+        .timings = timings,
+    };
+}
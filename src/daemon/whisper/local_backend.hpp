@@ -0,0 +1,68 @@
+#pragma once
+
+#include "backend.hpp"
+
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct whisper_context;
+
+// Runs whisper.cpp inside the daemon with the model kept loaded, so PCM goes
+// straight from the capture buffer into inference: no WAV, no HTTP.
+// Only built when CMake finds whisper.cpp (SPEAK_ANYWHERE_HAVE_WHISPER).
+class LocalWhisperBackend : public WhisperBackend {
+public:
+    struct Options {
+        std::string model_path;
+        std::string language = "en";
+        int threads = 0;         // 0: hardware concurrency
+        bool use_gpu = true;
+        bool lazy_load = false;  // load on first recording instead of at startup
+    };
+
+    explicit LocalWhisperBackend(Options opts);
+    ~LocalWhisperBackend() override;
+
+    LocalWhisperBackend(const LocalWhisperBackend&) = delete;
+    LocalWhisperBackend& operator=(const LocalWhisperBackend&) = delete;
+
+    // Loads the model now. Called from DaemonCore::init unless lazy_load.
+    std::expected<void, std::string> load();
+
+    std::expected<TranscriptResult, std::string>
+        transcribe(std::span<const int16_t> audio, uint32_t sample_rate) override;
+    std::expected<TranscriptResult, std::string>
+        transcribe(std::span<const int16_t> audio, uint32_t sample_rate,
+                   std::stop_token stop, std::string_view prompt = {}) override;
+
+    // Float goes to the model as it is, without the conversion pass.
+    bool accepts_float() const override { return true; }
+    std::expected<TranscriptResult, std::string>
+        transcribe(std::span<const float> audio, uint32_t sample_rate,
+                   std::stop_token stop, std::string_view prompt = {}) override;
+
+    // Starts a lazy model load in the background.
+    void warm_up() override;
+
+private:
+    // Checks and loads; called before taking mu_.
+    std::expected<void, std::string> prepare(size_t samples, uint32_t sample_rate);
+    // Runs the model over pcm with mu_ held.
+    std::expected<TranscriptResult, std::string>
+        infer(std::span<const float> pcm, uint32_t sample_rate, std::stop_token& stop,
+              std::string_view prompt, StageTimings timings,
+              std::chrono::steady_clock::time_point start);
+
+    Options opts_;
+
+    // whisper_context is not safe for concurrent whisper_full calls, so
+    // requests (streamed segments) take turns.
+    std::mutex mu_;
+    whisper_context* ctx_ = nullptr;
+    std::vector<float> pcm_;
+
+    std::jthread load_thread_;
+};
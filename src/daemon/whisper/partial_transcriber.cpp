@@ -0,0 +1,95 @@
+#include "partial_transcriber.hpp"
+
+#include <algorithm>
+
+PartialTranscriber::PartialTranscriber(WhisperBackend& backend, uint32_t sample_rate,
+                                       uint32_t interval_ms, std::function<void()> on_done)
+    : backend_(backend), sample_rate_(sample_rate),
+      min_interval_(interval_ms), interval_(interval_ms),
+      on_done_(std::move(on_done)) {}
+
+PartialTranscriber::~PartialTranscriber() = default;
+
+bool PartialTranscriber::due(std::chrono::steady_clock::time_point now) const {
+    return !busy() && now - last_start_ >= interval_;
+}
+
+void PartialTranscriber::start(std::span<const int16_t> audio, std::string prefix) {
+    // The previous request is done (due() said so); this only reaps its thread.
+    if (worker_.joinable()) worker_.join();
+
+    audio_.assign(audio.begin(), audio.end());
+    prefix_ = std::move(prefix);
+    cancelled_ = false;
+    done_.store(false, std::memory_order_relaxed);
+    last_start_ = std::chrono::steady_clock::now();
+
+    worker_ = std::jthread([this](std::stop_token stop) {
+        result_ = backend_.transcribe(audio_, sample_rate_, stop);
+        done_.store(true, std::memory_order_release);
+        if (on_done_) on_done_();
+    });
+}
+
+std::optional<PartialTranscriber::Hypothesis> PartialTranscriber::take() {
+    if (!worker_.joinable() || !done_.load(std::memory_order_acquire)) return std::nullopt;
+    worker_.join();
+    if (cancelled_ || !result_) return std::nullopt;
+
+    // Back off while the backend is slower than the interval.
+    auto took = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::duration<double>(result_->processing_s));
+    interval_ = std::max(min_interval_, took * 2);
+
+    std::string text = prefix_;
+    if (!result_->text.empty()) {
+        if (!text.empty()) text += ' ';
+        text += result_->text;
+    }
+    auto words = partial::split_words(text);
+    Hypothesis h{
+        .text = std::move(text),
+        .stable = partial::common_prefix(last_words_, words),
+        .audio_s = static_cast<double>(audio_.size()) / sample_rate_,
+        .processing_s = result_->processing_s,
+    };
+    last_words_ = std::move(words);
+    return h;
+}
+
+void PartialTranscriber::cancel() {
+    if (worker_.joinable()) {
+        // Whatever the worker still brings back is dropped by take().
+        worker_.request_stop();
+        if (done_.load(std::memory_order_acquire)) worker_.join();
+        cancelled_ = true;
+    }
+    last_words_.clear();
+    last_start_ = {};
+    interval_ = min_interval_;
+}
+
+namespace partial {
+
+std::vector<std::string> split_words(const std::string& text) {
+    std::vector<std::string> words;
+    size_t i = 0;
+    while (i < text.size()) {
+        while (i < text.size() && text[i] == ' ') ++i;
+        size_t start = i;
+        while (i < text.size() && text[i] != ' ') ++i;
+        if (i > start) words.emplace_back(text, start, i - start);
+    }
+    return words;
+}
+
+std::string common_prefix(const std::vector<std::string>& a, const std::vector<std::string>& b) {
+    std::string out;
+    for (size_t i = 0; i < std::min(a.size(), b.size()) && a[i] == b[i]; ++i) {
+        if (!out.empty()) out += ' ';
+        out += a[i];
+    }
+    return out;
+}
+
+} // namespace partial
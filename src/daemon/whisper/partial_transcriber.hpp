@@ -0,0 +1,79 @@
+#pragma once
+
+#include "backend.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <expected>
+#include <functional>
+#include <optional>
+#include <span>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Speculative transcriptions of a recording in progress, for live preview.
+// At most one request is in flight; it runs on its own thread at the
+// backend's mercy and is the first thing dropped when real work needs the
+// backend. Successive hypotheses are compared word by word: the part two of
+// them agree on is reported as stable, the rest may still change.
+class PartialTranscriber {
+public:
+    struct Hypothesis {
+        std::string text;
+        std::string stable;  // prefix of text that the previous hypothesis agreed on
+        double audio_s = 0.0;
+        double processing_s = 0.0;
+    };
+
+    PartialTranscriber(WhisperBackend& backend, uint32_t sample_rate,
+                       uint32_t interval_ms, std::function<void()> on_done = {});
+    ~PartialTranscriber();
+
+    PartialTranscriber(const PartialTranscriber&) = delete;
+    PartialTranscriber& operator=(const PartialTranscriber&) = delete;
+
+    // True when a new request may go out: nothing is in flight and the
+    // interval has passed. The interval stretches to twice the time the last
+    // request took, so a slow or busy backend gets fewer of them.
+    bool due(std::chrono::steady_clock::time_point now) const;
+    bool busy() const { return worker_.joinable() && !done_.load(std::memory_order_acquire); }
+
+    // Transcribes audio (copied) on a worker thread; prefix is prepended to
+    // its text, for audio that was already transcribed for good.
+    void start(std::span<const int16_t> audio, std::string prefix);
+
+    // Main thread: the hypothesis of the request that just finished, if any.
+    std::optional<Hypothesis> take();
+
+    // Aborts the request in flight, e.g. once the final pass needs the backend.
+    void cancel();
+
+    std::chrono::milliseconds interval() const { return interval_; }
+
+private:
+    WhisperBackend& backend_;
+    uint32_t sample_rate_;
+    std::chrono::milliseconds min_interval_;
+    std::chrono::milliseconds interval_;
+    std::function<void()> on_done_;
+    std::chrono::steady_clock::time_point last_start_{};
+
+    std::vector<int16_t> audio_;
+    std::string prefix_;
+    std::expected<TranscriptResult, std::string> result_ = std::unexpected("pending");
+    std::atomic<bool> done_{false};
+    bool cancelled_ = false;  // main thread only
+    std::jthread worker_;
+
+    std::vector<std::string> last_words_;
+};
+
+namespace partial {
+
+// Longest run of leading words a and b share, joined by single spaces.
+std::string common_prefix(const std::vector<std::string>& a, const std::vector<std::string>& b);
+std::vector<std::string> split_words(const std::string& text);
+
+} // namespace partial
@@ -0,0 +1,148 @@
+#include "streaming_transcriber.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <optional>
+
+StreamingTranscriber::StreamingTranscriber(WhisperBackend& backend, uint32_t sample_rate,
+                                           uint32_t segment_seconds,
+                                           std::optional<VadCuts> vad,
+                                           std::function<void()> on_segment)
+    : backend_(backend), sample_rate_(sample_rate),
+      segment_samples_(static_cast<size_t>(std::max<uint32_t>(segment_seconds, 1)) * sample_rate),
+      on_segment_(std::move(on_segment)) {
+    if (vad) {
+        vad_.emplace(sample_rate, vad->threshold_db);
+        vad_step_ = std::max<size_t>(1, sample_rate / 100);
+        silence_samples_ = static_cast<size_t>(vad->silence_ms) * sample_rate / 1000;
+        min_segment_samples_ = static_cast<size_t>(vad->min_segment_seconds) * sample_rate;
+    }
+}
+
+StreamingTranscriber::~StreamingTranscriber() = default;
+
+void StreamingTranscriber::feed(std::span<const int16_t> samples) {
+    samples_fed_ += samples.size();
+
+    while (!samples.empty()) {
+        size_t take = std::min(samples.size(), segment_samples_ - pending_.size());
+        // Step through large chunks in VAD-sized pieces so pauses inside them are seen.
+        if (vad_) take = std::min(take, vad_step_);
+        auto chunk = samples.first(take);
+        pending_.insert(pending_.end(), chunk.begin(), chunk.end());
+        samples = samples.subspan(take);
+
+        if (vad_) {
+            vad_->process(chunk);
+            if (vad_->in_speech()) pending_has_speech_ = true;
+            cut_at_pause();
+        }
+
+        if (pending_.size() == segment_samples_) {
+            pending_start_ += pending_.size();
+            dispatch(std::move(pending_));
+            pending_ = {};
+            pending_has_speech_ = vad_ && vad_->in_speech();
+        }
+    }
+}
+
+void StreamingTranscriber::cut_at_pause() {
+    if (!pending_has_speech_ || vad_->trailing_silence_samples() < silence_samples_) return;
+
+    // Split in the middle of the pause so neither side clips a word.
+    size_t cut = vad_->samples_processed() - vad_->trailing_silence_samples() / 2;
+    if (cut <= pending_start_ || cut - pending_start_ < min_segment_samples_) return;
+    size_t len = cut - pending_start_;
+
+    std::vector<int16_t> rest(pending_.begin() + len, pending_.end());
+    pending_.resize(len);
+    dispatch(std::move(pending_));
+    pending_ = std::move(rest);
+    pending_start_ = cut;
+    pending_has_speech_ = false;
+}
+
+void StreamingTranscriber::dispatch(std::vector<int16_t> audio) {
+    auto seg = std::make_unique<Segment>();
+    seg->audio = std::move(audio);
+    seg->worker = std::jthread([this, s = seg.get()](std::stop_token stop) {
+        s->result = backend_.transcribe(s->audio, sample_rate_, stop, prompt_);
+        s->done.store(true, std::memory_order_release);
+        if (on_segment_) on_segment_();
+    });
+    segments_.push_back(std::move(seg));
+}
+
+std::vector<std::string> StreamingTranscriber::take_finished() {
+    std::vector<std::string> texts;
+    while (segments_taken_ < segments_.size()) {
+        auto& seg = *segments_[segments_taken_];
+        if (!seg.done.load(std::memory_order_acquire) || !seg.result) break;
+        texts.push_back(seg.result->text);
+        ++segments_taken_;
+    }
+    return texts;
+}
+
+std::string StreamingTranscriber::finished_text() const {
+    std::string text;
+    for (auto& seg : segments_) {
+        if (!seg->done.load(std::memory_order_acquire) || !seg->result) break;
+        if (seg->result->text.empty()) continue;
+        if (!text.empty()) text += ' ';
+        text += seg->result->text;
+    }
+    return text;
+}
+
+std::expected<TranscriptResult, std::string> StreamingTranscriber::finish(std::stop_token stop) {
+    auto start = std::chrono::steady_clock::now();
+
+    // No more segments get dispatched once finish() runs, so the list is stable.
+    std::stop_callback cancel_segments(stop, [this] {
+        for (auto& seg : segments_) seg->worker.request_stop();
+    });
+
+    // A tail the VAD heard no speech in is just the pause after the last word.
+    bool silent_tail = vad_ && !pending_has_speech_ && !segments_.empty();
+
+    std::expected<TranscriptResult, std::string> tail = TranscriptResult{};
+    if (!pending_.empty() && !silent_tail) {
+        tail = backend_.transcribe(pending_, sample_rate_, stop, prompt_);
+    }
+
+    std::string text;
+    auto append = [&text](const std::string& part) {
+        if (part.empty()) return;
+        if (!text.empty()) text += ' ';
+        text += part;
+    };
+
+    // Once one segment has failed so has the result: the segments still
+    // running are stopped rather than waited for, and all of them joined
+    // before returning, so none outlives it by a backend timeout.
+    std::optional<std::string> error;
+    for (auto& seg : segments_) {
+        if (seg->worker.joinable()) seg->worker.join();
+        if (error) continue;
+        if (!seg->result) {
+            error = seg->result.error();
+            for (auto& other : segments_) other->worker.request_stop();
+            continue;
+        }
+        append(seg->result->text);
+    }
+    if (error) return std::unexpected(std::move(*error));
+    if (!tail) return std::unexpected(tail.error());
+    append(tail->text);
+
+    auto end = std::chrono::steady_clock::now();
+    return TranscriptResult{
+        .text = std::move(text),
+        .duration_s = static_cast<double>(samples_fed_) / sample_rate_,
+        .processing_s = std::chrono::duration<double>(end - start).count(),
+        // Only the tail was waited on; earlier segments overlapped the recording.
+        .timings = tail->timings,
+    };
+}
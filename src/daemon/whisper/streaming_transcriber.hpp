@@ -0,0 +1,97 @@
+#pragma once
+
+#include "audio/vad.hpp"
+#include "backend.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <expected>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <span>
+#include <stop_token>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Transcribes a recording while it is still being captured.
+// The main thread feeds samples as they are read from the ring buffer; every
+// finished segment is sent to the backend on its own thread, so on stop only
+// the final tail has to be uploaded and transcribed.
+//
+// Without VAD, segments are cut every segment_seconds. With VAD, a segment
+// ends at the first pause of silence_ms once it is min_segment_seconds long,
+// and segment_seconds becomes the hard upper limit.
+class StreamingTranscriber {
+public:
+    struct VadCuts {
+        double threshold_db = -45.0;
+        uint32_t silence_ms = 500;
+        uint32_t min_segment_seconds = 2;
+    };
+
+    // on_segment runs on a worker thread whenever a segment's transcription
+    // comes back; take_finished() then picks up the text.
+    StreamingTranscriber(WhisperBackend& backend, uint32_t sample_rate,
+                         uint32_t segment_seconds,
+                         std::optional<VadCuts> vad = std::nullopt,
+                         std::function<void()> on_segment = {});
+    ~StreamingTranscriber();
+
+    StreamingTranscriber(const StreamingTranscriber&) = delete;
+    StreamingTranscriber& operator=(const StreamingTranscriber&) = delete;
+
+    // Sent with every request. Main thread, before the first feed().
+    void set_prompt(std::string prompt) { prompt_ = std::move(prompt); }
+
+    // Main thread: append captured samples, dispatching full segments.
+    void feed(std::span<const int16_t> samples);
+
+    // Transcribes the remaining tail, waits for all segments and joins their
+    // text in order. Blocks; call from a worker thread. A stop request aborts
+    // the tail and every segment still in flight.
+    std::expected<TranscriptResult, std::string> finish(std::stop_token stop = {});
+
+    // Main thread: text of the segments transcribed since the last call, in
+    // recording order. Stops at the first segment still in flight (or failed),
+    // so nothing is returned out of order. Safe while finish() runs.
+    std::vector<std::string> take_finished();
+    // Like take_finished(), from the first segment and without taking
+    // anything, joined into one string.
+    std::string finished_text() const;
+
+    // Samples already handed to a segment; the rest is still pending.
+    size_t samples_dispatched() const { return pending_start_; }
+
+    size_t samples_fed() const { return samples_fed_; }
+    size_t segments_dispatched() const { return segments_.size(); }
+
+private:
+    struct Segment {
+        std::vector<int16_t> audio;
+        std::expected<TranscriptResult, std::string> result = std::unexpected("pending");
+        std::atomic<bool> done{false};
+        std::jthread worker;
+    };
+
+    void dispatch(std::vector<int16_t> audio);
+    void cut_at_pause();
+
+    WhisperBackend& backend_;
+    uint32_t sample_rate_;
+    size_t segment_samples_;
+    size_t samples_fed_ = 0;
+    std::vector<int16_t> pending_;
+    size_t pending_start_ = 0;  // absolute index of pending_[0]
+    bool pending_has_speech_ = false;
+
+    std::optional<Vad> vad_;
+    size_t vad_step_ = 0;
+    size_t silence_samples_ = 0;
+    size_t min_segment_samples_ = 0;
+    std::function<void()> on_segment_;
+    std::string prompt_;
+    std::vector<std::unique_ptr<Segment>> segments_;
+    size_t segments_taken_ = 0;
+};
@@ -0,0 +1,91 @@
+#include "transcript_cache.hpp"
+
+#include <ranges>
+
+TranscriptCache::TranscriptCache(size_t capacity) : capacity_(capacity) {}
+
+bool TranscriptCache::open(const std::string& path) {
+    std::lock_guard db_lock(db_mu_);
+    if (!db_.open(path)) return false;
+    persistent_ = true;
+
+    auto entries = db_.cache_load(capacity_);
+    std::lock_guard lock(mu_);
+    // Oldest first, so the newest ends up at the front. A result put while
+    // this was loading is newer than the stored one and stays.
+    for (auto& entry : entries | std::views::reverse) {
+        if (!index_.contains(entry.key)) insert(std::move(entry));
+    }
+    return true;
+}
+
+std::optional<TranscriptResult> TranscriptCache::get(uint64_t key) {
+    std::lock_guard lock(mu_);
+    auto it = index_.find(key);
+    if (it == index_.end()) {
+        ++misses_;
+        return std::nullopt;
+    }
+    ++hits_;
+    lru_.splice(lru_.begin(), lru_, it->second);
+    auto& entry = *it->second;
+    return TranscriptResult{
+        .text = entry.text,
+        .duration_s = entry.audio_duration,
+        .cached = true,
+    };
+}
+
+bool TranscriptCache::contains(uint64_t key) const {
+    std::lock_guard lock(mu_);
+    return index_.contains(key);
+}
+
+void TranscriptCache::count_miss() {
+    std::lock_guard lock(mu_);
+    ++misses_;
+}
+
+void TranscriptCache::put(uint64_t key, const TranscriptResult& result) {
+    CachedTranscript entry{
+        .key = key,
+        .text = result.text,
+        .audio_duration = result.duration_s,
+        .processing_time = result.processing_s,
+    };
+    {
+        std::lock_guard lock(mu_);
+        insert(entry);
+    }
+    std::lock_guard db_lock(db_mu_);
+    if (persistent_) db_.cache_put(entry);
+}
+
+void TranscriptCache::insert(CachedTranscript entry) {
+    if (capacity_ == 0) return;
+    if (auto it = index_.find(entry.key); it != index_.end()) {
+        lru_.erase(it->second);
+        index_.erase(it);
+    }
+    lru_.push_front(std::move(entry));
+    index_[lru_.front().key] = lru_.begin();
+    if (lru_.size() > capacity_) {
+        index_.erase(lru_.back().key);
+        lru_.pop_back();
+    }
+}
+
+size_t TranscriptCache::size() const {
+    std::lock_guard lock(mu_);
+    return lru_.size();
+}
+
+uint64_t TranscriptCache::hits() const {
+    std::lock_guard lock(mu_);
+    return hits_;
+}
+
+uint64_t TranscriptCache::misses() const {
+    std::lock_guard lock(mu_);
+    return misses_;
+}
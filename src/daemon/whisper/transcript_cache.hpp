@@ -0,0 +1,52 @@
+#pragma once
+
+#include "backend.hpp"
+#include "storage/history_db.hpp"
+
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+
+// Backend results by content: the key is a hash of the audio and of
+// everything else that shapes the text (see CachingBackend). An LRU in
+// memory, optionally backed by the history database's transcript_cache
+// table so it survives restarts. Thread-safe: jobs and streamed segments
+// look up and store from their worker threads.
+class TranscriptCache {
+public:
+    explicit TranscriptCache(size_t capacity);
+
+    // Keeps entries in the database at path (its own connection) and loads
+    // the newest `capacity` of them. May run while lookups are going on;
+    // until it is done they miss.
+    bool open(const std::string& path);
+
+    std::optional<TranscriptResult> get(uint64_t key);
+    void put(uint64_t key, const TranscriptResult& result);
+    // Neither counts as a lookup nor makes the entry recent.
+    bool contains(uint64_t key) const;
+    // A miss found by contains() rather than get().
+    void count_miss();
+
+    size_t size() const;
+    uint64_t hits() const;
+    uint64_t misses() const;
+
+private:
+    void insert(CachedTranscript entry);  // mu_ held
+
+    size_t capacity_;
+
+    mutable std::mutex mu_;
+    std::list<CachedTranscript> lru_;  // most recently used first
+    std::unordered_map<uint64_t, std::list<CachedTranscript>::iterator> index_;
+    uint64_t hits_ = 0;
+    uint64_t misses_ = 0;
+
+    std::mutex db_mu_;  // writes go out after mu_ is released
+    HistoryDb db_;
+    bool persistent_ = false;
+};
@@ -0,0 +1,395 @@
+// sa-loadgen: synthetic users for capacity planning. Each user is a
+// speak-anywhere daemon replaying WAV files instead of a microphone
+// (speak-anywhere --replay), driven through start/stop cycles over its
+// socket like `sa` would. The daemons transcribe with whatever backend their
+// config names, so N users put N people's worth of load on a shared server.
+
+#include "metrics.hpp"
+#include "platform/linux/unix_socket_client.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <expected>
+#include <filesystem>
+#include <format>
+#include <map>
+#include <nlohmann/json.hpp>
+#include <print>
+#include <random>
+#include <string>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+using json = nlohmann::json;
+namespace fs = std::filesystem;
+
+namespace {
+
+// Seconds, drawn uniformly from [min, max] for each cycle.
+struct Range {
+    double min = 0;
+    double max = 0;
+
+    double pick(std::mt19937& rng) const {
+        return min < max ? std::uniform_real_distribution<double>(min, max)(rng) : min;
+    }
+};
+
+struct Options {
+    int users = 4;
+    int cycles = 10;               // per user
+    Range duration{3, 10};         // speaking, start to stop
+    Range pause{1, 5};             // between a result and the next start
+    std::string replay;            // --replay for the daemons started here
+    std::string config;            // their --config
+    std::string daemon;            // the speak-anywhere binary
+    std::vector<std::string> sockets;  // daemons already running: one user each
+    uint32_t seed = 1;
+    int timeout_s = 300;           // for a transcription
+    bool json = false;
+};
+
+// One start/stop cycle as a user saw it.
+struct Cycle {
+    bool started = false;
+    bool ok = false;
+    std::string error;
+    double audio_s = 0;   // what the daemon transcribed
+    double result_s = 0;  // stop sent until the result arrived
+    json timings;         // the daemon's stages
+};
+
+std::atomic<bool> interrupted{false};
+
+void usage(const char* prog) {
+    std::println(stderr, "Usage: {} --replay PATH [options]", prog);
+    std::println(stderr, "       {} --socket PATH... [options]", prog);
+    std::println(stderr, "Options:");
+    std::println(stderr, "  --replay PATH       WAV file or directory the daemons record from");
+    std::println(stderr, "  --users N           Synthetic users, one daemon each (default 4)");
+    std::println(stderr, "  --cycles N          Recordings per user (default 10)");
+    std::println(stderr, "  --duration S[-S]    Seconds each recording lasts (default 3-10)");
+    std::println(stderr, "  --pause S[-S]       Seconds between recordings (default 1-5)");
+    std::println(stderr, "  --config PATH       Config file for the daemons (default: the usual one)");
+    std::println(stderr, "  --daemon PATH       speak-anywhere binary (default: next to this one)");
+    std::println(stderr, "  --socket PATH       Drive a daemon already running with --replay instead");
+    std::println(stderr, "                      (repeat for more users; --users is ignored)");
+    std::println(stderr, "  --seed N            Seed for durations and pauses (default 1)");
+    std::println(stderr, "  --timeout S         Seconds to wait for a transcription (default 300)");
+    std::println(stderr, "  --json              Print the report as JSON");
+}
+
+std::expected<Range, std::string> parse_range(const std::string& s) {
+    char* end = nullptr;
+    Range r;
+    r.min = r.max = std::strtod(s.c_str(), &end);
+    if (*end == '-') r.max = std::strtod(end + 1, &end);
+    if (*end != '\0' || r.min < 0 || r.max < r.min) return std::unexpected("bad range: " + s);
+    return r;
+}
+
+// Sleeps in short steps so Ctrl+C is not held up by a long pause.
+void sleep_for(double seconds) {
+    using Clock = std::chrono::steady_clock;
+    auto until = Clock::now() + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(seconds));
+    while (!interrupted.load() && Clock::now() < until) {
+        std::this_thread::sleep_for(std::min<Clock::duration>(until - Clock::now(), std::chrono::milliseconds(100)));
+    }
+}
+
+std::string default_daemon() {
+    std::error_code ec;
+    auto self = fs::read_symlink("/proc/self/exe", ec);
+    if (!ec) {
+        auto sibling = self.parent_path() / "speak-anywhere";
+        if (fs::exists(sibling, ec)) return sibling.string();
+    }
+    return "speak-anywhere";  // from PATH
+}
+
+struct Daemon {
+    pid_t pid = -1;
+    std::string socket;
+};
+
+// Starts daemon i with its own socket and data directory under dir (so its
+// history stays out of the real one), and waits until it takes connections.
+std::expected<Daemon, std::string> spawn(const Options& opts, const fs::path& dir, int i) {
+    auto home = dir / std::format("user{}", i);
+    fs::create_directories(home);
+    Daemon d{.socket = (home / "speak-anywhere.sock").string()};
+
+    std::vector<std::string> args = {opts.daemon, "--foreground", "--replay", opts.replay};
+    if (!opts.config.empty()) {
+        args.push_back("--config");
+        args.push_back(opts.config);
+    }
+    d.pid = ::fork();
+    if (d.pid < 0) return std::unexpected(std::string("fork() failed: ") + std::strerror(errno));
+    if (d.pid == 0) {
+        // Out of our process group: Ctrl+C stops the users, who then stop
+        // their recordings, before the daemons are told to exit.
+        ::setpgid(0, 0);
+        ::setenv("SPEAK_ANYWHERE_SOCKET", d.socket.c_str(), 1);
+        ::setenv("XDG_DATA_HOME", home.c_str(), 1);
+        std::vector<char*> argv;
+        for (auto& a : args) argv.push_back(a.data());
+        argv.push_back(nullptr);
+        ::execvp(argv[0], argv.data());
+        ::_exit(127);
+    }
+
+    for (int attempt = 0; attempt < 100; ++attempt) {
+        UnixSocketClient probe;
+        if (probe.connect(d.socket)) return d;
+        int status;
+        if (::waitpid(d.pid, &status, WNOHANG) == d.pid) {
+            return std::unexpected(std::format("{} exited with code {}", opts.daemon,
+                                               WIFEXITED(status) ? WEXITSTATUS(status) : -1));
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+    ::kill(d.pid, SIGTERM);
+    ::waitpid(d.pid, nullptr, 0);
+    return std::unexpected("daemon did not open its socket");
+}
+
+// One synthetic user: cycles of pause, start, speak, stop, wait for the text.
+std::vector<Cycle> run_user(const Options& opts, const std::string& socket, uint32_t seed) {
+    std::vector<Cycle> cycles;
+    std::mt19937 rng(seed);
+    UnixSocketClient client(ipc::Encoding::Cbor);
+    if (!client.connect(socket)) {
+        cycles.emplace_back().error = "connect failed: " + socket;
+        return cycles;
+    }
+
+    for (int n = 0; n < opts.cycles && !interrupted.load(); ++n) {
+        sleep_for(opts.pause.pick(rng));
+        if (interrupted.load()) break;
+
+        Cycle& c = cycles.emplace_back();
+        json response;
+        // Nothing typed or copied: the text only comes back here.
+        if (!client.send({{"cmd", "start"}, {"output", "none"}}) || !client.recv(response)) {
+            c.error = "daemon went away";
+            break;
+        }
+        if (response.value("status", "") != "ok") {
+            c.error = "start: " + response.value("message", "refused");
+            continue;
+        }
+        c.started = true;
+
+        sleep_for(opts.duration.pick(rng));
+        auto stopped = std::chrono::steady_clock::now();
+        if (!client.send({{"cmd", "stop"}}) || !client.recv(response)) {
+            c.error = "daemon went away";
+            break;
+        }
+        // "transcribing", then the result on the same connection.
+        if (response.value("status", "") == "transcribing" && !client.recv(response, opts.timeout_s * 1000)) {
+            c.error = "timed out";
+            continue;
+        }
+        c.result_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - stopped).count();
+        if (response.value("status", "") != "ok") {
+            c.error = response.value("message", "failed");
+            continue;
+        }
+        c.ok = true;
+        c.audio_s = response.value("duration", 0.0);
+        c.timings = response.value("timings", json::object());
+    }
+    return cycles;
+}
+
+json stage_json(const LatencyHistogram& h) {
+    return {
+        {"count", h.count()},
+        {"mean", h.mean()},
+        {"p50", h.percentile(0.50)},
+        {"p95", h.percentile(0.95)},
+        {"p99", h.percentile(0.99)},
+        {"max", h.max()},
+    };
+}
+
+json report(const std::vector<std::vector<Cycle>>& users, double wall_s) {
+    std::map<std::string, LatencyHistogram> stages;
+    LatencyHistogram result;
+    std::map<std::string, int> errors;
+    int attempts = 0, started = 0, transcribed = 0, failed = 0;
+    double audio_s = 0;
+
+    for (auto& cycles : users) {
+        for (auto& c : cycles) {
+            ++attempts;
+            if (!c.error.empty()) ++errors[c.error];
+            if (!c.started) continue;
+            ++started;
+            if (!c.ok) {
+                ++failed;
+                continue;
+            }
+            ++transcribed;
+            audio_s += c.audio_s;
+            result.add(c.result_s);
+            for (auto& stage : STAGES) {
+                if (auto it = c.timings.find(stage.name); it != c.timings.end() && it->is_number()) {
+                    stages[stage.name].add(it->get<double>());
+                }
+            }
+        }
+    }
+
+    json out = {
+        {"users", users.size()},
+        {"wall_seconds", wall_s},
+        {"cycles", attempts},
+        {"recordings", started},
+        {"transcribed", transcribed},
+        {"failed", failed},
+        // Recordings that reached the backend and came back without text.
+        {"error_rate", started > 0 ? static_cast<double>(failed) / started : 0.0},
+        {"per_minute", wall_s > 0 ? transcribed * 60.0 / wall_s : 0.0},
+        {"audio_seconds", audio_s},
+        {"real_time_factor", wall_s > 0 ? audio_s / wall_s : 0.0},
+        {"stages", json::object()},
+        {"errors", json::object()},
+    };
+    // In pipeline order, then as the client saw it.
+    for (auto& stage : STAGES) {
+        if (auto it = stages.find(stage.name); it != stages.end()) out["stages"][stage.name] = stage_json(it->second);
+    }
+    if (result.count() > 0) out["stages"]["client"] = stage_json(result);
+    for (auto& [message, count] : errors) out["errors"][message] = count;
+    return out;
+}
+
+void print_report(const json& r) {
+    std::println("Users: {}, {:.1f} min", r["users"].get<size_t>(), r["wall_seconds"].get<double>() / 60);
+    std::println("Recordings: {} of {} started, {} transcribed, {} failed ({:.1f}% error rate)",
+                 r["recordings"].get<int>(), r["cycles"].get<int>(), r["transcribed"].get<int>(),
+                 r["failed"].get<int>(), r["error_rate"].get<double>() * 100);
+    std::println("Throughput: {:.1f} transcriptions/min, {:.0f} s of audio ({:.2f}x real time)",
+                 r["per_minute"].get<double>(), r["audio_seconds"].get<double>(),
+                 r["real_time_factor"].get<double>());
+    std::println("{:<10} {:>6} {:>9} {:>9} {:>9} {:>9}", "stage", "count", "p50 ms", "p95 ms", "p99 ms",
+                 "max ms");
+    for (auto& [name, s] : r["stages"].items()) {
+        std::println("{:<10} {:>6} {:>9.1f} {:>9.1f} {:>9.1f} {:>9.1f}", name, s.value("count", 0),
+                     s.value("p50", 0.0) * 1000, s.value("p95", 0.0) * 1000, s.value("p99", 0.0) * 1000,
+                     s.value("max", 0.0) * 1000);
+    }
+    for (auto& [message, count] : r["errors"].items()) {
+        std::println("{:>5}x {}", count.get<int>(), message);
+    }
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    Options opts;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--replay" && has_value) {
+            opts.replay = argv[++i];
+        } else if (arg == "--users" && has_value) {
+            opts.users = std::atoi(argv[++i]);
+        } else if (arg == "--cycles" && has_value) {
+            opts.cycles = std::atoi(argv[++i]);
+        } else if ((arg == "--duration" || arg == "--pause") && has_value) {
+            auto range = parse_range(argv[++i]);
+            if (!range) {
+                std::println(stderr, "{}: {}", arg, range.error());
+                return 1;
+            }
+            (arg == "--duration" ? opts.duration : opts.pause) = *range;
+        } else if (arg == "--config" && has_value) {
+            opts.config = fs::absolute(argv[++i]).string();
+        } else if (arg == "--daemon" && has_value) {
+            opts.daemon = argv[++i];
+        } else if (arg == "--socket" && has_value) {
+            opts.sockets.push_back(argv[++i]);
+        } else if (arg == "--seed" && has_value) {
+            opts.seed = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "--timeout" && has_value) {
+            opts.timeout_s = std::atoi(argv[++i]);
+        } else if (arg == "--json") {
+            opts.json = true;
+        } else {
+            usage(argv[0]);
+            return arg == "--help" || arg == "-h" ? 0 : 1;
+        }
+    }
+    if (opts.sockets.empty() && (opts.replay.empty() || opts.users < 1)) {
+        usage(argv[0]);
+        return 1;
+    }
+    if (opts.daemon.empty()) opts.daemon = default_daemon();
+    if (!opts.replay.empty()) opts.replay = fs::absolute(opts.replay).string();
+
+    std::signal(SIGINT, [](int) { interrupted.store(true); });
+    std::signal(SIGTERM, [](int) { interrupted.store(true); });
+
+    std::vector<Daemon> daemons;
+    fs::path dir;
+    auto cleanup = [&daemons, &dir] {
+        for (auto& d : daemons) ::kill(d.pid, SIGTERM);
+        for (auto& d : daemons) ::waitpid(d.pid, nullptr, 0);
+        std::error_code ec;
+        if (!dir.empty()) fs::remove_all(dir, ec);
+    };
+
+    std::vector<std::string> sockets = opts.sockets;
+    if (sockets.empty()) {
+        std::string tmpl = (fs::temp_directory_path() / "sa-loadgen-XXXXXX").string();
+        if (!::mkdtemp(tmpl.data())) {
+            std::println(stderr, "Cannot create a directory for the daemons");
+            return 1;
+        }
+        dir = tmpl;
+        for (int i = 0; i < opts.users; ++i) {
+            auto d = spawn(opts, dir, i);
+            if (!d) {
+                std::println(stderr, "Daemon {}: {}", i, d.error());
+                cleanup();
+                return 1;
+            }
+            daemons.push_back(*d);
+            sockets.push_back(d->socket);
+        }
+    }
+
+    if (!opts.json) {
+        std::println(stderr, "{} users, {} recordings each...", sockets.size(), opts.cycles);
+    }
+    auto began = std::chrono::steady_clock::now();
+    std::vector<std::vector<Cycle>> users(sockets.size());
+    {
+        std::vector<std::jthread> threads;
+        for (size_t i = 0; i < sockets.size(); ++i) {
+            threads.emplace_back([&, i] { users[i] = run_user(opts, sockets[i], opts.seed + i); });
+        }
+    }
+    double wall_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - began).count();
+    cleanup();
+
+    auto r = report(users, wall_s);
+    if (opts.json) {
+        std::println("{}", r.dump(2));
+    } else {
+        print_report(r);
+    }
+    return r["transcribed"].get<int>() > 0 ? 0 : 1;
+}
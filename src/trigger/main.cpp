@@ -0,0 +1,143 @@
+// sa-trigger: the hotkey end of `sa`. It writes one prebuilt CBOR frame to
+// the daemon's socket and exits, without waiting for the recording to start
+// or the transcription to finish unless --wait asks it to. No JSON library,
+// no iostreams: the binary is linked statically and starts in well under a
+// millisecond.
+
+#include "platform/platform_paths.hpp"
+#include "trigger_frame.hpp"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <poll.h>
+#include <string>
+#include <string_view>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+
+// How long --wait waits for the reply, as `sa` does.
+constexpr int REPLY_TIMEOUT_MS = 30000;
+
+void usage(const char* prog) {
+    std::fprintf(stderr,
+                 "Usage: %s [start|stop|toggle|cancel] [--output clipboard|type|none] [--auto-stop] [--wait]\n"
+                 "Sends the command (toggle if none is given) and exits at once.\n"
+                 "  --wait  Wait for the reply and print it, like sa does\n",
+                 prog);
+}
+
+int connect_daemon(const std::string& path) {
+    sockaddr_un addr{};
+    if (path.size() >= sizeof(addr.sun_path)) return -1;
+    int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) return -1;
+    addr.sun_family = AF_UNIX;
+    path.copy(addr.sun_path, sizeof(addr.sun_path) - 1);
+    if (::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+bool write_all(int fd, std::span<const char> data) {
+    while (!data.empty()) {
+        ssize_t n = ::send(fd, data.data(), data.size(), MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        data = data.subspan(static_cast<size_t>(n));
+    }
+    return true;
+}
+
+// Reads until one whole frame is in buf. Returns its size, 0 on failure.
+size_t read_reply(int fd, std::string& buf) {
+    while (true) {
+        auto size = trigger::frame_size(buf);
+        if (!size) return 0;
+        if (*size > 0) return *size;
+
+        pollfd pfd{.fd = fd, .events = POLLIN, .revents = 0};
+        int ret = ::poll(&pfd, 1, REPLY_TIMEOUT_MS);
+        if (ret < 0 && errno == EINTR) continue;
+        if (ret <= 0) return 0;
+
+        char chunk[4096];
+        ssize_t n = ::recv(fd, chunk, sizeof(chunk), 0);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return 0;
+        buf.append(chunk, static_cast<size_t>(n));
+    }
+}
+
+void print_line(FILE* out, std::string_view s) {
+    std::fwrite(s.data(), 1, s.size(), out);
+    std::fputc('\n', out);
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    trigger::Command command;
+    bool wait = false;
+    for (int i = 1; i < argc; ++i) {
+        std::string_view arg = argv[i];
+        if (arg == "--output" && i + 1 < argc) {
+            command.output = argv[++i];
+        } else if (arg == "--auto-stop") {
+            command.auto_stop = true;
+        } else if (arg == "--wait") {
+            wait = true;
+        } else if (arg == "start" || arg == "stop" || arg == "toggle" || arg == "cancel") {
+            command.cmd = arg;
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    auto frame = trigger::encode(command);
+    if (!frame) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    auto path = platform::ipc_endpoint();
+    int fd = connect_daemon(path);
+    if (fd < 0) {
+        std::fprintf(stderr, "Failed to connect to daemon at %s\nIs speak-anywhere running?\n", path.c_str());
+        return 1;
+    }
+    if (!write_all(fd, frame->data())) {
+        std::fputs("Failed to send command\n", stderr);
+        ::close(fd);
+        return 1;
+    }
+    // The daemon still runs a command that arrives just before the hangup.
+    if (!wait) {
+        ::close(fd);
+        return 0;
+    }
+
+    std::string buf;
+    size_t size = read_reply(fd, buf);
+    ::close(fd);
+    auto reply = size ? trigger::parse_reply(std::span<const char>(buf).first(size)) : std::nullopt;
+    if (!reply) {
+        std::fputs("No response from daemon (timeout)\n", stderr);
+        return 1;
+    }
+    if (reply->status == "error") {
+        std::fputs("Error: ", stderr);
+        print_line(stderr, reply->message.empty() ? "unknown error" : reply->message);
+        return 1;
+    }
+    print_line(stdout, !reply->text.empty() ? reply->text
+                       : !reply->message.empty() ? reply->message
+                       : "OK");
+    return 0;
+}
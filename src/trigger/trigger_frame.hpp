@@ -0,0 +1,178 @@
+#pragma once
+
+#include "ipc_frame.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string_view>
+
+// The little CBOR that sa-trigger needs, written and read by hand so the
+// binary doesn't carry nlohmann::json. Commands are maps of short strings and
+// booleans; of a reply only the top-level strings status, text and message
+// are read, and everything else is skipped.
+namespace trigger {
+
+struct Command {
+    std::string_view cmd = "toggle";  // start, stop, toggle or cancel
+    std::string_view output;          // empty: the daemon's default
+    bool auto_stop = false;
+};
+
+// The header, a map of three entries and strings of up to 23 bytes.
+constexpr size_t MAX_COMMAND_FRAME = 64;
+
+struct Frame {
+    std::array<char, MAX_COMMAND_FRAME> bytes{};
+    size_t size = 0;
+
+    std::span<const char> data() const { return {bytes.data(), size}; }
+};
+
+// Empty if a string is too long for CBOR's one-byte length form.
+constexpr std::optional<Frame> encode(const Command& command) {
+    constexpr size_t MAX_SHORT = 23;
+    if (command.cmd.size() > MAX_SHORT || command.output.size() > MAX_SHORT) return std::nullopt;
+
+    Frame f;
+    f.size = ipc::FRAME_HEADER;
+    auto put = [&f](uint8_t b) { f.bytes[f.size++] = static_cast<char>(b); };
+    auto put_text = [&f, &put](std::string_view s) {
+        put(static_cast<uint8_t>(0x60 + s.size()));
+        for (char c : s) f.bytes[f.size++] = c;
+    };
+
+    put(static_cast<uint8_t>(0xA0 + 1 + !command.output.empty() + command.auto_stop));
+    put_text("cmd");
+    put_text(command.cmd);
+    if (!command.output.empty()) {
+        put_text("output");
+        put_text(command.output);
+    }
+    if (command.auto_stop) {
+        put_text("auto_stop");
+        put(0xF5);  // true
+    }
+
+    auto len = static_cast<uint32_t>(f.size - ipc::FRAME_HEADER);
+    f.bytes[0] = static_cast<char>(ipc::FRAME_MAGIC);
+    f.bytes[1] = 'C';
+    for (int i = 0; i < 4; ++i) f.bytes[2 + i] = static_cast<char>((len >> (8 * i)) & 0xFF);
+    return f;
+}
+
+struct Reply {
+    std::string_view status;
+    std::string_view text;
+    std::string_view message;
+};
+
+// Bytes of the first frame in buf, 0 while it is incomplete. Empty if buf
+// doesn't start with a CBOR frame.
+constexpr std::optional<size_t> frame_size(std::span<const char> buf) {
+    if (buf.empty()) return 0;
+    if (static_cast<uint8_t>(buf[0]) != ipc::FRAME_MAGIC || (buf.size() > 1 && buf[1] != 'C')) {
+        return std::nullopt;
+    }
+    if (buf.size() < ipc::FRAME_HEADER) return 0;
+    uint32_t len = 0;
+    for (int i = 0; i < 4; ++i) len |= uint32_t{static_cast<uint8_t>(buf[2 + i])} << (8 * i);
+    if (len > ipc::MAX_FRAME) return std::nullopt;
+    return buf.size() < ipc::FRAME_HEADER + len ? 0 : ipc::FRAME_HEADER + len;
+}
+
+namespace detail {
+
+// Reads the head of a CBOR item: its major type and argument. False if it
+// runs past the end or has an indefinite length, which the daemon never sends.
+constexpr bool read_head(std::span<const char> buf, size_t& pos, uint8_t& major, uint64_t& arg) {
+    if (pos >= buf.size()) return false;
+    auto b = static_cast<uint8_t>(buf[pos++]);
+    major = b >> 5;
+    uint8_t info = b & 0x1F;
+    if (info < 24) {
+        arg = info;
+        return true;
+    }
+    if (info > 27) return false;
+    size_t n = size_t{1} << (info - 24);
+    if (buf.size() - pos < n) return false;
+    arg = 0;
+    for (size_t i = 0; i < n; ++i) arg = arg << 8 | static_cast<uint8_t>(buf[pos++]);
+    return true;
+}
+
+// Steps over one item, and whatever it contains.
+constexpr bool skip(std::span<const char> buf, size_t& pos) {
+    uint64_t left = 1;
+    while (left > 0) {
+        --left;
+        uint8_t major;
+        uint64_t arg;
+        if (!read_head(buf, pos, major, arg)) return false;
+        // Each item takes at least a byte, which bounds the counts below.
+        uint64_t rest = buf.size() - pos;
+        switch (major) {
+            case 2:
+            case 3:
+                if (arg > rest) return false;
+                pos += arg;
+                break;
+            case 4:
+                if (arg > rest) return false;
+                left += arg;
+                break;
+            case 5:
+                if (arg > rest / 2) return false;
+                left += 2 * arg;
+                break;
+            case 6:
+                ++left;  // a tag applies to the item after it
+                break;
+            default:
+                break;  // integers, floats and simple values: the head is all
+        }
+    }
+    return true;
+}
+
+} // namespace detail
+
+// Reads a whole frame as frame_size() measured it. Empty if it isn't a map.
+constexpr std::optional<Reply> parse_reply(std::span<const char> frame) {
+    auto payload = frame.subspan(ipc::FRAME_HEADER);
+    size_t pos = 0;
+    uint8_t major;
+    uint64_t entries;
+    if (!detail::read_head(payload, pos, major, entries) || major != 5) return std::nullopt;
+
+    Reply reply;
+    for (uint64_t i = 0; i < entries; ++i) {
+        uint64_t key_len;
+        if (!detail::read_head(payload, pos, major, key_len) || major != 3 || key_len > payload.size() - pos) {
+            return std::nullopt;
+        }
+        std::string_view key(payload.data() + pos, key_len);
+        pos += key_len;
+
+        std::string_view* field = key == "status" ? &reply.status
+                                : key == "text" ? &reply.text
+                                : key == "message" ? &reply.message
+                                : nullptr;
+        size_t value_at = pos;
+        uint64_t value_len;
+        if (field && detail::read_head(payload, pos, major, value_len) && major == 3 &&
+            value_len <= payload.size() - pos) {
+            *field = std::string_view(payload.data() + pos, value_len);
+            pos += value_len;
+            continue;
+        }
+        pos = value_at;
+        if (!detail::skip(payload, pos)) return std::nullopt;
+    }
+    return reply;
+}
+
+} // namespace trigger
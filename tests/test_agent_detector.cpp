@@ -2,9 +2,36 @@
 
 #include "platform/linux/procfs_detector.hpp"
 
+#include <chrono>
+#include <csignal>
 #include <sys/wait.h>
+#include <thread>
 #include <unistd.h>
 
+namespace {
+
+// Forks a child that runs `sleep`, for an agent that appears after the fact.
+pid_t spawn_sleep() {
+    pid_t child = fork();
+    if (child == 0) {
+        execlp("sleep", "sleep", "10", nullptr);
+        _exit(127);
+    }
+    usleep(50000);  // let exec replace the comm
+    return child;
+}
+
+// Polls detect() until it reports agent, for up to a second.
+bool eventually_detects(const ProcfsDetector& detector, int pid, const std::string& agent) {
+    for (int i = 0; i < 100; ++i) {
+        if (detector.detect(pid).agent == agent) return true;
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return false;
+}
+
+} // namespace
+
 TEST_CASE("ProcfsDetector", "[agent]") {
 
     SECTION("DetectSelf") {
@@ -86,4 +113,55 @@ TEST_CASE("ProcfsDetector", "[agent]") {
         auto r2 = detector.detect(-1);
         REQUIRE(r2.agent.empty());
     }
+
+    SECTION("CacheHitSchedulesRefresh") {
+        ProcfsDetector detector({"sleep"});
+        REQUIRE(detector.detect(getpid()).agent.empty());
+
+        pid_t child = spawn_sleep();
+        REQUIRE(child > 0);
+        // The first lookup may still answer from the cache, but it sends the
+        // background thread to look again.
+        REQUIRE(eventually_detects(detector, getpid(), "sleep"));
+        REQUIRE(detector.scan(getpid()).agent == "sleep");
+
+        kill(child, SIGTERM);
+        waitpid(child, nullptr, 0);
+    }
+
+    SECTION("PrefetchFillsCache") {
+        pid_t child = spawn_sleep();
+        REQUIRE(child > 0);
+
+        ProcfsDetector detector({"sleep"});
+        detector.prefetch(getpid());
+        REQUIRE(eventually_detects(detector, getpid(), "sleep"));
+
+        kill(child, SIGTERM);
+        waitpid(child, nullptr, 0);
+    }
+
+    SECTION("SetAgentsDropsCachedResults") {
+        pid_t child = spawn_sleep();
+        REQUIRE(child > 0);
+
+        ProcfsDetector detector({"sleep"});
+        REQUIRE(detector.detect(getpid()).agent == "sleep");
+        detector.set_agents({"definitely_not_a_real_process_name_xyz"});
+        // Straight away: the cached "sleep" is gone with the list.
+        REQUIRE(detector.detect(getpid()).agent.empty());
+
+        kill(child, SIGTERM);
+        waitpid(child, nullptr, 0);
+    }
+
+    SECTION("VanishedProcessReturnsEmpty") {
+        pid_t child = spawn_sleep();
+        REQUIRE(child > 0);
+        ProcfsDetector detector({"anything"});
+        kill(child, SIGKILL);
+        waitpid(child, nullptr, 0);
+
+        REQUIRE(detector.detect(child).agent.empty());
+    }
 }
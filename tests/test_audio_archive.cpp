@@ -0,0 +1,139 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "platform/linux/mmap_audio_archive.hpp"
+
+#include <filesystem>
+#include <fstream>
+#include <numeric>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+struct TmpDir {
+    std::string path;
+
+    TmpDir() {
+        path = fs::temp_directory_path() / ("sa_test_archive_" + std::to_string(getpid()));
+        fs::remove_all(path);
+    }
+
+    ~TmpDir() { fs::remove_all(path); }
+};
+
+std::vector<int16_t> ramp(size_t n, int16_t start) {
+    std::vector<int16_t> v(n);
+    std::iota(v.begin(), v.end(), start);
+    return v;
+}
+
+std::vector<int16_t> read(MmapAudioArchive& archive, uint64_t id) {
+    auto clip = archive.clip(id);
+    if (!clip) return {};
+    return {clip->samples.begin(), clip->samples.end()};
+}
+
+} // namespace
+
+TEST_CASE("MmapAudioArchive", "[archive]") {
+    TmpDir tmp;
+    MmapAudioArchive::Options options{.dir = tmp.path, .max_bytes = 1 << 20, .segment_bytes = 16 << 10};
+
+    SECTION("ClipsReadBackInPlace") {
+        MmapAudioArchive archive;
+        REQUIRE(archive.open(options));
+
+        // Odd sizes, so clips start at unaligned offsets.
+        auto a = ramp(1001, 0);
+        auto b = ramp(3333, 5000);
+        uint64_t id_a = archive.append(a, 16000);
+        uint64_t id_b = archive.append(b, 8000);
+        REQUIRE(id_a != 0);
+        REQUIRE(id_b > id_a);
+
+        auto clip = archive.clip(id_b);
+        REQUIRE(clip.has_value());
+        REQUIRE(clip->sample_rate == 8000);
+        REQUIRE(std::vector<int16_t>(clip->samples.begin(), clip->samples.end()) == b);
+        REQUIRE(read(archive, id_a) == a);
+        REQUIRE_FALSE(archive.clip(id_b + 1));
+        REQUIRE(archive.append({}, 16000) == 0);
+    }
+
+    SECTION("SurvivesReopen") {
+        auto a = ramp(2000, 7);
+        uint64_t id = 0;
+        {
+            MmapAudioArchive archive;
+            REQUIRE(archive.open(options));
+            id = archive.append(a, 16000);
+        }
+
+        MmapAudioArchive archive;
+        REQUIRE(archive.open(options));
+        REQUIRE(read(archive, id) == a);
+
+        // Appends continue after the loaded clips with larger ids.
+        auto b = ramp(10, 1);
+        uint64_t next = archive.append(b, 16000);
+        REQUIRE(next > id);
+        REQUIRE(read(archive, next) == b);
+        REQUIRE(read(archive, id) == a);
+    }
+
+    SECTION("RetentionDropsOldestSegments") {
+        options.max_bytes = 48 << 10;
+        MmapAudioArchive archive;
+        REQUIRE(archive.open(options));
+
+        // 12 KiB clips: one per 16 KiB segment.
+        std::vector<uint64_t> ids;
+        for (int i = 0; i < 8; ++i) {
+            ids.push_back(archive.append(ramp(6144, static_cast<int16_t>(i)), 16000));
+        }
+        REQUIRE(archive.segment_count() == 4);
+        REQUIRE(archive.size_bytes() <= options.max_bytes);
+        REQUIRE_FALSE(archive.clip(ids[0]));
+        REQUIRE(read(archive, ids[7]) == ramp(6144, 7));
+    }
+
+    SECTION("MappedClipOutlivesRetention") {
+        options.max_bytes = 16 << 10;
+        MmapAudioArchive archive;
+        REQUIRE(archive.open(options));
+
+        auto a = ramp(6144, 3);
+        auto clip = archive.clip(archive.append(a, 16000));
+        REQUIRE(clip.has_value());
+        archive.append(ramp(6144, 0), 16000);
+        archive.append(ramp(6144, 0), 16000);
+        REQUIRE(std::vector<int16_t>(clip->samples.begin(), clip->samples.end()) == a);
+    }
+
+    SECTION("TornIndexRecordIgnored") {
+        uint64_t id = 0;
+        {
+            MmapAudioArchive archive;
+            REQUIRE(archive.open(options));
+            id = archive.append(ramp(100, 0), 16000);
+        }
+        // Half a record, as after a crash mid-write.
+        {
+            std::ofstream idx(tmp.path + "/00000001.idx", std::ios::binary | std::ios::app);
+            idx.write("0123456789abcdef", 16);
+        }
+
+        MmapAudioArchive archive;
+        REQUIRE(archive.open(options));
+        REQUIRE(read(archive, id) == ramp(100, 0));
+        uint64_t next = archive.append(ramp(50, 9), 16000);
+        REQUIRE(read(archive, next) == ramp(50, 9));
+
+        MmapAudioArchive reopened;
+        REQUIRE(reopened.open(options));
+        REQUIRE(read(reopened, next) == ramp(50, 9));
+    }
+}
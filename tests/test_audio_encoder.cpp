@@ -0,0 +1,218 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "audio_encoder.hpp"
+#include "flac_encoder.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace {
+
+class BitReader {
+public:
+    explicit BitReader(const std::vector<uint8_t>& data, size_t pos = 0)
+        : data_(data), bit_(pos * 8) {}
+
+    uint64_t get(unsigned bits) {
+        uint64_t v = 0;
+        for (unsigned i = 0; i < bits; ++i, ++bit_) {
+            v = (v << 1) | ((data_.at(bit_ / 8) >> (7 - bit_ % 8)) & 1);
+        }
+        return v;
+    }
+    int32_t get_signed(unsigned bits) {
+        auto v = static_cast<int64_t>(get(bits));
+        if (v & (int64_t{1} << (bits - 1))) v -= int64_t{1} << bits;
+        return static_cast<int32_t>(v);
+    }
+    void align() { bit_ = (bit_ + 7) / 8 * 8; }
+    size_t byte_pos() const { return bit_ / 8; }
+    bool at_end() const { return bit_ / 8 >= data_.size(); }
+
+private:
+    const std::vector<uint8_t>& data_;
+    size_t bit_;
+};
+
+uint16_t crc16(const std::vector<uint8_t>& data, size_t begin, size_t end) {
+    uint16_t crc = 0;
+    for (size_t i = begin; i < end; ++i) {
+        crc ^= static_cast<uint16_t>(data[i]) << 8;
+        for (int b = 0; b < 8; ++b)
+            crc = (crc & 0x8000) ? static_cast<uint16_t>((crc << 1) ^ 0x8005) : static_cast<uint16_t>(crc << 1);
+    }
+    return crc;
+}
+
+struct Decoded {
+    uint32_t sample_rate = 0;
+    uint64_t total_samples = 0;
+    std::vector<int16_t> samples;
+    bool crc_ok = true;
+};
+
+// Decoder for the subset FlacEncoder writes: one STREAMINFO block, mono
+// 16-bit, CONSTANT / VERBATIM / FIXED subframes with Rice partitions.
+Decoded decode_flac(const std::vector<uint8_t>& file) {
+    Decoded d;
+    BitReader br(file, 8);
+    br.get(16 + 16 + 24 + 24);  // block sizes, frame sizes
+    d.sample_rate = static_cast<uint32_t>(br.get(20));
+    br.get(3 + 5);
+    d.total_samples = br.get(36);
+    br.get(128);
+
+    while (!br.at_end()) {
+        size_t frame_start = br.byte_pos();
+        REQUIRE(br.get(14) == 0x3FFE);
+        br.get(2);
+        uint32_t bs_code = static_cast<uint32_t>(br.get(4));
+        br.get(4 + 4 + 3 + 1);
+        // UTF-8 coded frame number
+        uint64_t lead = br.get(8);
+        int extra = 0;
+        while (lead & (0x80 >> extra)) ++extra;
+        for (int i = 1; i < extra; ++i) br.get(8);
+        size_t n = bs_code == 12 ? 4096 : bs_code == 7 ? br.get(16) + 1 : 0;
+        REQUIRE(n > 0);
+        br.get(8);  // CRC-8
+
+        br.get(1);
+        uint32_t type = static_cast<uint32_t>(br.get(6));
+        br.get(1);
+        std::vector<int32_t> s;
+        if (type == 0) {
+            s.assign(n, br.get_signed(16));
+        } else if (type == 1) {
+            for (size_t i = 0; i < n; ++i) s.push_back(br.get_signed(16));
+        } else {
+            REQUIRE((type & 0b111000) == 0b001000);
+            uint32_t order = type & 7;
+            for (uint32_t i = 0; i < order; ++i) s.push_back(br.get_signed(16));
+            REQUIRE(br.get(2) == 0);
+            uint32_t porder = static_cast<uint32_t>(br.get(4));
+            for (size_t p = 0; p < (size_t{1} << porder); ++p) {
+                unsigned k = static_cast<unsigned>(br.get(4));
+                size_t len = (n >> porder) - (p == 0 ? order : 0);
+                for (size_t i = 0; i < len; ++i) {
+                    uint32_t q = 0;
+                    while (br.get(1) == 0) ++q;
+                    uint32_t u = (q << k) | static_cast<uint32_t>(br.get(k));
+                    int32_t r = static_cast<int32_t>(u >> 1) ^ -static_cast<int32_t>(u & 1);
+                    size_t j = s.size();
+                    int32_t pred = 0;
+                    switch (order) {
+                    case 1: pred = s[j - 1]; break;
+                    case 2: pred = 2 * s[j - 1] - s[j - 2]; break;
+                    case 3: pred = 3 * s[j - 1] - 3 * s[j - 2] + s[j - 3]; break;
+                    case 4: pred = 4 * s[j - 1] - 6 * s[j - 2] + 4 * s[j - 3] - s[j - 4]; break;
+                    }
+                    s.push_back(pred + r);
+                }
+            }
+        }
+        br.align();
+        uint16_t crc = static_cast<uint16_t>(br.get(16));
+        if (crc != crc16(file, frame_start, br.byte_pos() - 2)) d.crc_ok = false;
+        for (int32_t v : s) d.samples.push_back(static_cast<int16_t>(v));
+    }
+    return d;
+}
+
+std::vector<int16_t> speech_like(size_t n) {
+    std::vector<int16_t> out(n);
+    uint32_t noise = 12345;
+    for (size_t i = 0; i < n; ++i) {
+        noise = noise * 1103515245 + 12345;
+        double t = static_cast<double>(i) / 16000.0;
+        double v = 6000 * std::sin(2 * M_PI * 220 * t) + 2000 * std::sin(2 * M_PI * 1250 * t)
+                 + static_cast<double>(static_cast<int16_t>(noise >> 16)) / 64;
+        out[i] = static_cast<int16_t>(v);
+    }
+    return out;
+}
+
+} // namespace
+
+TEST_CASE("FlacEncoder", "[encoder]") {
+    constexpr uint32_t rate = 16000;
+
+    SECTION("RoundTripIsLossless") {
+        auto samples = speech_like(3 * 4096 + 1000);
+        FlacEncoder enc(rate);
+        // Uneven chunks, like capture ticks
+        for (size_t pos = 0; pos < samples.size(); pos += 1600) {
+            size_t len = std::min<size_t>(1600, samples.size() - pos);
+            enc.append(std::span<const int16_t>(samples).subspan(pos, len));
+        }
+        auto file = enc.finish();
+
+        REQUIRE(std::string(file.begin(), file.begin() + 4) == "fLaC");
+        auto d = decode_flac(file);
+        CHECK(d.crc_ok);
+        CHECK(d.sample_rate == rate);
+        CHECK(d.total_samples == samples.size());
+        REQUIRE(d.samples == samples);
+    }
+
+    SECTION("SmallerThanWav") {
+        auto samples = speech_like(rate * 2);
+        FlacEncoder enc(rate);
+        enc.append(samples);
+        auto file = enc.finish();
+        CHECK(file.size() < samples.size() * sizeof(int16_t) * 3 / 4);
+    }
+
+    SECTION("SilenceIsTiny") {
+        std::vector<int16_t> silence(rate * 2, 0);
+        FlacEncoder enc(rate);
+        enc.append(silence);
+        auto file = enc.finish();
+        CHECK(file.size() < 200);
+        REQUIRE(decode_flac(file).samples == silence);
+    }
+
+    SECTION("ExtremeValuesRoundTrip") {
+        std::vector<int16_t> samples;
+        for (int i = 0; i < 5000; ++i) samples.push_back(i % 2 ? 32767 : -32768);
+        FlacEncoder enc(rate);
+        enc.append(samples);
+        auto d = decode_flac(enc.finish());
+        CHECK(d.crc_ok);
+        REQUIRE(d.samples == samples);
+    }
+}
+
+TEST_CASE("make_audio_encoder", "[encoder]") {
+    SECTION("KnownFormats") {
+        auto wav = make_audio_encoder("wav", 16000);
+        REQUIRE(wav);
+        CHECK(std::string(wav->mime_type()) == "audio/wav");
+
+        auto flac = make_audio_encoder("flac", 16000);
+        REQUIRE(flac);
+        CHECK(std::string(flac->file_name()) == "audio.flac");
+    }
+
+    SECTION("UnknownFormat") {
+        REQUIRE_FALSE(make_audio_encoder("mp3", 16000));
+    }
+}
+
+TEST_CASE("BackgroundEncoder", "[encoder]") {
+    auto samples = speech_like(20000);
+    BackgroundEncoder bg(make_audio_encoder("flac", 16000), 16000);
+    for (size_t pos = 0; pos < samples.size(); pos += 1600) {
+        size_t len = std::min<size_t>(1600, samples.size() - pos);
+        bg.push(std::span<const int16_t>(samples).subspan(pos, len));
+    }
+    REQUIRE(bg.samples_pushed() == samples.size());
+
+    auto out = bg.finish();
+    CHECK(out.mime_type == "audio/flac");
+    CHECK(out.duration_s == 1.25);
+    REQUIRE(decode_flac(out.data).samples == samples);
+}
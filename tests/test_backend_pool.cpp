@@ -0,0 +1,262 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "whisper/backend_pool.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using namespace std::chrono_literals;
+
+// Answers with its name after `delay`, reporting `delay` as processing time.
+// Honours cancellation, like LanBackend does through libcurl.
+class FakeBackend : public WhisperBackend {
+public:
+    FakeBackend(std::string name, std::chrono::milliseconds delay, bool fail = false)
+        : name_(std::move(name)), delay_(delay), fail_(fail) {}
+
+    std::expected<TranscriptResult, std::string>
+    transcribe(std::span<const int16_t> audio, uint32_t sample_rate) override {
+        return transcribe(audio, sample_rate, std::stop_token{});
+    }
+
+    std::expected<TranscriptResult, std::string>
+    transcribe(std::span<const int16_t> audio, uint32_t sample_rate,
+               std::stop_token stop, std::string_view prompt = {}) override {
+        ++calls;
+        last_prompt = prompt;
+        auto deadline = std::chrono::steady_clock::now() + delay_;
+        while (std::chrono::steady_clock::now() < deadline) {
+            if (stop.stop_requested()) {
+                ++cancelled;
+                return std::unexpected("cancelled");
+            }
+            std::this_thread::sleep_for(1ms);
+        }
+        if (fail_) return std::unexpected("down");
+        return TranscriptResult{
+            .text = name_,
+            .duration_s = static_cast<double>(audio.size()) / sample_rate,
+            .processing_s = std::chrono::duration<double>(delay_).count(),
+        };
+    }
+
+    std::vector<EndpointHealth> health() const override {
+        return {{.name = name_, .state = fail_ ? "open" : "closed"}};
+    }
+
+    std::atomic<int> calls{0};
+    std::atomic<int> cancelled{0};
+    std::string last_prompt;  // failover only: race calls come from other threads
+
+private:
+    std::string name_;
+    std::chrono::milliseconds delay_;
+    bool fail_;
+};
+
+struct Fixture {
+    explicit Fixture(BackendPool::Mode mode) : pool(mode) {}
+
+    FakeBackend& add(const std::string& name, std::chrono::milliseconds delay, bool fail = false) {
+        auto b = std::make_unique<FakeBackend>(name, delay, fail);
+        auto& ref = *b;
+        pool.add(name, std::move(b));
+        return ref;
+    }
+
+    FakeBackend& add_fallback(const std::string& name) {
+        auto b = std::make_unique<FakeBackend>(name, 0ms);
+        auto& ref = *b;
+        pool.add_fallback(name, std::move(b));
+        return ref;
+    }
+
+    std::string run() {
+        auto r = pool.transcribe(audio, 16000);
+        return r ? r->text : "error: " + r.error();
+    }
+
+    BackendPool pool;
+    std::vector<int16_t> audio = std::vector<int16_t>(16000, 1);
+};
+
+} // namespace
+
+TEST_CASE("BackendPool modes", "[backend_pool]") {
+    SECTION("ParseMode") {
+        REQUIRE(BackendPool::parse_mode("race") == BackendPool::Mode::Race);
+        REQUIRE(BackendPool::parse_mode("latency") == BackendPool::Mode::Latency);
+        REQUIRE(BackendPool::parse_mode("failover") == BackendPool::Mode::Failover);
+        REQUIRE_FALSE(BackendPool::parse_mode("random"));
+    }
+
+    SECTION("EmptyPoolFails") {
+        BackendPool pool(BackendPool::Mode::Latency);
+        std::vector<int16_t> audio(160, 1);
+        REQUIRE_FALSE(pool.transcribe(audio, 16000));
+    }
+
+    SECTION("FailoverUsesNextEndpoint") {
+        Fixture f(BackendPool::Mode::Failover);
+        auto& a = f.add("a", 0ms, true);
+        auto& b = f.add("b", 0ms);
+        REQUIRE(f.run() == "b");
+        CHECK(a.calls == 1);
+        CHECK(b.calls == 1);
+
+        auto stats = f.pool.stats();
+        CHECK(stats[0].failures == 1);
+        CHECK(stats[1].successes == 1);
+    }
+
+    SECTION("AllFailReportsEveryError") {
+        Fixture f(BackendPool::Mode::Failover);
+        f.add("a", 0ms, true);
+        f.add("b", 0ms, true);
+        auto r = f.run();
+        CHECK(r.find("a: down") != std::string::npos);
+        CHECK(r.find("b: down") != std::string::npos);
+    }
+
+    SECTION("LatencyPrefersFasterEndpoint") {
+        Fixture f(BackendPool::Mode::Latency);
+        auto& slow = f.add("slow", 40ms);
+        auto& fast = f.add("fast", 5ms);
+
+        // Both unmeasured: configured order, then each gets measured once.
+        REQUIRE(f.run() == "slow");
+        f.pool.transcribe(f.audio, 16000);  // fast is now the only unmeasured one
+        CHECK(fast.calls == 1);
+
+        for (int i = 0; i < 3; ++i) REQUIRE(f.run() == "fast");
+        CHECK(slow.calls == 1);
+
+        auto stats = f.pool.stats();
+        CHECK(stats[1].seconds_per_audio_second < stats[0].seconds_per_audio_second);
+    }
+
+    SECTION("LatencyMovesAwayFromFailingEndpoint") {
+        Fixture f(BackendPool::Mode::Latency);
+        f.add("broken", 0ms, true);
+        f.add("ok", 20ms);
+
+        REQUIRE(f.run() == "ok");
+        // broken now carries the failure penalty and ranks last.
+        REQUIRE(f.run() == "ok");
+        CHECK(f.pool.stats()[0].failures == 1);
+    }
+
+    SECTION("LatencySpreadsConcurrentRequests") {
+        Fixture f(BackendPool::Mode::Latency);
+        auto& a = f.add("a", 100ms);
+        auto& b = f.add("b", 100ms);
+
+        std::jthread first([&f] { f.pool.transcribe(f.audio, 16000); });
+        for (int i = 0; i < 500 && a.calls == 0; ++i) std::this_thread::sleep_for(1ms);
+        // a is busy with the first request, so the second goes to b.
+        REQUIRE(f.run() == "b");
+        first.join();
+        CHECK(a.calls == 1);
+        CHECK(b.calls == 1);
+        CHECK(f.pool.stats()[0].in_flight == 0);
+    }
+
+    SECTION("RaceTakesFirstSuccessAndCancelsLoser") {
+        Fixture f(BackendPool::Mode::Race);
+        auto& slow = f.add("slow", 2000ms);
+        auto& fast = f.add("fast", 10ms);
+
+        auto start = std::chrono::steady_clock::now();
+        REQUIRE(f.run() == "fast");
+        CHECK(std::chrono::steady_clock::now() - start < 1000ms);
+        CHECK(fast.calls == 1);
+
+        // The loser is aborted rather than left to run to completion.
+        for (int i = 0; i < 200 && slow.cancelled == 0; ++i) std::this_thread::sleep_for(5ms);
+        CHECK(slow.cancelled == 1);
+        // Cancellation isn't counted against it.
+        CHECK(f.pool.stats()[0].failures == 0);
+    }
+
+    SECTION("RaceFallsBackWhenBothFail") {
+        Fixture f(BackendPool::Mode::Race);
+        f.add("a", 0ms, true);
+        f.add("b", 0ms, true);
+        auto& c = f.add("c", 0ms);
+        REQUIRE(f.run() == "c");
+        CHECK(c.calls == 1);
+    }
+
+    SECTION("PromptReachesEndpoint") {
+        Fixture f(BackendPool::Mode::Failover);
+        auto& a = f.add("a", 0ms, true);
+        auto& b = f.add("b", 0ms);
+        REQUIRE(f.pool.transcribe(f.audio, 16000, std::stop_token{}, "kubectl, DaemonCore")->text == "b");
+        CHECK(a.last_prompt == "kubectl, DaemonCore");
+        CHECK(b.last_prompt == "kubectl, DaemonCore");
+    }
+
+    SECTION("RaceWithOneEndpoint") {
+        Fixture f(BackendPool::Mode::Race);
+        f.add("only", 0ms);
+        REQUIRE(f.run() == "only");
+    }
+
+    SECTION("FallbackOnlyWhenEveryEndpointFails") {
+        for (auto mode : {BackendPool::Mode::Failover, BackendPool::Mode::Latency, BackendPool::Mode::Race}) {
+            // Added first, tried last.
+            Fixture up(mode);
+            auto& unused = up.add_fallback("local");
+            up.add("a", 0ms);
+            REQUIRE(up.run() == "a");
+            CHECK(unused.calls == 0);
+
+            Fixture down(mode);
+            down.add_fallback("local");
+            down.add("a", 0ms, true);
+            down.add("b", 0ms, true);
+            REQUIRE(down.run() == "local");
+        }
+    }
+
+    SECTION("RaceLeavesTheFallbackOut") {
+        Fixture f(BackendPool::Mode::Race);
+        f.add("only", 5ms);
+        auto& local = f.add_fallback("local");
+        REQUIRE(f.run() == "only");
+        CHECK(local.calls == 0);
+    }
+
+    SECTION("HealthOfEveryMember") {
+        Fixture f(BackendPool::Mode::Latency);
+        f.add("http://gpu:8080", 0ms);
+        f.add("http://nas:8080", 0ms, true);
+        auto health = f.pool.health();
+        REQUIRE(health.size() == 2);
+        CHECK(health[0].name == "http://gpu:8080");
+        CHECK(health[0].state == "closed");
+        CHECK(health[1].state == "open");
+    }
+
+    SECTION("OuterStopCancelsRace") {
+        Fixture f(BackendPool::Mode::Race);
+        f.add("a", 2000ms);
+        f.add("b", 2000ms);
+
+        std::stop_source stop;
+        std::jthread canceller([&stop] {
+            std::this_thread::sleep_for(20ms);
+            stop.request_stop();
+        });
+        auto start = std::chrono::steady_clock::now();
+        auto r = f.pool.transcribe(f.audio, 16000, stop.get_token());
+        REQUIRE_FALSE(r);
+        CHECK(std::chrono::steady_clock::now() - start < 1000ms);
+    }
+}
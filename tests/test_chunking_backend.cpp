@@ -0,0 +1,215 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "whisper/chunking_backend.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <memory>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using namespace std::chrono_literals;
+
+constexpr uint32_t RATE = 16000;
+
+// "Speech": a 440 Hz tone with a 60 ms gap every two seconds, too short to
+// cut at but enough to keep the VAD from taking the tone for background. The
+// given ranges (in seconds) are left silent.
+std::vector<int16_t> tone(size_t seconds, std::vector<std::pair<double, double>> pauses = {}) {
+    std::vector<int16_t> audio(seconds * RATE);
+    for (size_t i = 0; i < audio.size(); ++i) {
+        if (i % (2 * RATE) < RATE * 60 / 1000) continue;
+        audio[i] = static_cast<int16_t>(8000 * std::sin(2 * M_PI * 440 * static_cast<double>(i) / RATE));
+    }
+    for (auto [from, to] : pauses) {
+        std::fill(audio.begin() + static_cast<ptrdiff_t>(from * RATE),
+                  audio.begin() + static_cast<ptrdiff_t>(to * RATE), 0);
+    }
+    return audio;
+}
+
+// "Transcribes" a chunk of `clip` as one word per second that starts in it,
+// so chunks that overlap by a second repeat a word.
+class ClockBackend : public WhisperBackend {
+public:
+    explicit ClockBackend(const std::vector<int16_t>& clip) : clip_(clip) {}
+
+    std::expected<TranscriptResult, std::string>
+    transcribe(std::span<const int16_t> audio, uint32_t sample_rate) override {
+        return transcribe(audio, sample_rate, std::stop_token{});
+    }
+
+    std::expected<TranscriptResult, std::string>
+    transcribe(std::span<const int16_t> audio, uint32_t sample_rate, std::stop_token stop,
+               std::string_view = {}) override {
+        int now = ++running;
+        for (int peak = max_running; now > peak && !max_running.compare_exchange_weak(peak, now);) {}
+        ++calls;
+
+        auto begin = static_cast<size_t>(audio.data() - clip_.data());
+        size_t first = (begin + sample_rate - 1) / sample_rate;
+        size_t last = (begin + audio.size() + sample_rate - 1) / sample_rate;
+
+        std::this_thread::sleep_for(delay);
+        --running;
+        if (stop.stop_requested()) return std::unexpected("cancelled");
+        if (fail_at && begin <= *fail_at * sample_rate && *fail_at * sample_rate < begin + audio.size()) {
+            return std::unexpected("down");
+        }
+
+        std::string text;
+        for (size_t s = first; s < last; ++s) text += (text.empty() ? "W" : " w") + std::to_string(s);
+        text += '.';
+        return TranscriptResult{.text = text, .duration_s = static_cast<double>(audio.size()) / sample_rate};
+    }
+
+    std::chrono::milliseconds delay{20};
+    std::optional<size_t> fail_at;  // second whose chunk fails
+    std::atomic<int> calls{0};
+    std::atomic<int> running{0};
+    std::atomic<int> max_running{0};
+
+private:
+    const std::vector<int16_t>& clip_;
+};
+
+std::string expected_words(size_t seconds) {
+    std::string text;
+    for (size_t s = 0; s < seconds; ++s) text += (text.empty() ? "W" : " w") + std::to_string(s);
+    return text;
+}
+
+} // namespace
+
+TEST_CASE("chunking::plan", "[chunking]") {
+    chunking::Options opts{.max_chunk_seconds = 30, .overlap_ms = 1000, .min_chunk_seconds = 10};
+
+    SECTION("ShortClipIsOneChunk") {
+        auto spans = chunking::plan(tone(30), RATE, opts);
+        REQUIRE(spans.size() == 1);
+        REQUIRE(spans[0].end == 30 * RATE);
+    }
+
+    SECTION("CutsInTheLastPause") {
+        // Pauses at 12s and 25s: the first chunk ends in the later one.
+        auto audio = tone(70, {{12.0, 12.6}, {25.0, 25.6}, {50.0, 50.6}});
+        auto spans = chunking::plan(audio, RATE, opts);
+        REQUIRE(spans.size() == 3);
+        REQUIRE(spans[0].begin == 0);
+        REQUIRE(spans[0].end > 25 * RATE);
+        REQUIRE(spans[0].end < 25.6 * RATE);
+        REQUIRE(spans[1].begin == spans[0].end);
+        REQUIRE(spans[1].end > 50 * RATE);
+        REQUIRE(spans[1].end < 50.6 * RATE);
+        REQUIRE(spans[2].end == audio.size());
+        for (auto& s : spans) {
+            REQUIRE_FALSE(s.overlaps);
+            REQUIRE(s.end - s.begin <= 30 * RATE);
+        }
+    }
+
+    SECTION("PauseTooEarlyIsIgnored") {
+        auto audio = tone(40, {{3.0, 3.6}});
+        auto spans = chunking::plan(audio, RATE, opts);
+        REQUIRE(spans.size() == 2);
+        REQUIRE(spans[0].end == 30 * RATE);
+        REQUIRE(spans[1].overlaps);
+    }
+
+    SECTION("NoPauseOverlapsTheCut") {
+        auto spans = chunking::plan(tone(75), RATE, opts);
+        REQUIRE(spans.size() == 3);
+        REQUIRE(spans[0].end == 30 * RATE);
+        REQUIRE(spans[1].begin == 29 * RATE);
+        REQUIRE(spans[1].overlaps);
+        REQUIRE(spans[1].end == 59 * RATE);
+        REQUIRE(spans[2].begin == 58 * RATE);
+        REQUIRE(spans[2].end == 75 * RATE);
+    }
+}
+
+TEST_CASE("chunking::merge", "[chunking]") {
+    using chunking::merge;
+    REQUIRE(merge("the quick brown fox.", "Brown fox jumps") == "the quick brown fox. jumps");
+    REQUIRE(merge("a b", "c d") == "a b c d");
+    REQUIRE(merge("", " c ") == "c");
+    REQUIRE(merge("a b ", "") == "a b");
+    // The longest repeat wins.
+    REQUIRE(merge("x a b a b", "a b a b y") == "x a b a b y");
+    REQUIRE(merge("a b", "b c", 0) == "a b b c");
+}
+
+TEST_CASE("ChunkingBackend", "[chunking]") {
+    chunking::Options opts{.max_chunk_seconds = 10, .concurrency = 3, .overlap_ms = 1000,
+                           .min_chunk_seconds = 4};
+
+    SECTION("ShortClipPassesThrough") {
+        auto audio = tone(8);
+        auto inner = std::make_unique<ClockBackend>(audio);
+        auto& clock = *inner;
+        ChunkingBackend backend(std::move(inner), opts);
+        auto r = backend.transcribe(audio, RATE, std::stop_token{});
+        REQUIRE(r);
+        REQUIRE(r->text == expected_words(8) + ".");
+        REQUIRE(r->chunks.empty());
+        REQUIRE(clock.calls == 1);
+    }
+
+    SECTION("ChunksRunSideBySideAndJoinInOrder") {
+        auto audio = tone(65);
+        auto inner = std::make_unique<ClockBackend>(audio);
+        auto& clock = *inner;
+        ChunkingBackend backend(std::move(inner), opts);
+        auto r = backend.transcribe(audio, RATE, std::stop_token{});
+        REQUIRE(r);
+        REQUIRE(clock.calls == 8);
+        REQUIRE(r->chunks.size() == 8);
+        REQUIRE(clock.max_running <= 3);
+        REQUIRE(clock.max_running > 1);
+        REQUIRE(r->duration_s == 65.0);
+        REQUIRE(r->chunks[1].start_s == 9.0);
+        REQUIRE(r->chunks[1].duration_s == 10.0);
+        REQUIRE(r->timings.inference_s);
+
+        // Every cut repeated a second, merged away again; only the periods
+        // that ended each chunk mark where the cuts were.
+        std::string text = r->text;
+        std::erase(text, '.');
+        REQUIRE(text == expected_words(65));
+    }
+
+    SECTION("OneFailedChunkFailsTheClip") {
+        auto audio = tone(40);
+        auto inner = std::make_unique<ClockBackend>(audio);
+        inner->fail_at = 15;
+        ChunkingBackend backend(std::move(inner), opts);
+        auto r = backend.transcribe(audio, RATE, std::stop_token{});
+        REQUIRE_FALSE(r);
+        REQUIRE(r.error() == "chunk 2 of 5: down");
+    }
+
+    SECTION("StopCancels") {
+        auto audio = tone(65);
+        auto inner = std::make_unique<ClockBackend>(audio);
+        inner->delay = 50ms;
+        auto& clock = *inner;
+        ChunkingBackend backend(std::move(inner), opts);
+
+        std::stop_source stop;
+        std::jthread canceller([&stop] {
+            std::this_thread::sleep_for(20ms);
+            stop.request_stop();
+        });
+        auto r = backend.transcribe(audio, RATE, stop.get_token());
+        REQUIRE_FALSE(r);
+        REQUIRE(r.error() == "cancelled");
+        // The first three were under way; the rest never went out.
+        REQUIRE(clock.calls == 3);
+    }
+}
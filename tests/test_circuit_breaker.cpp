@@ -0,0 +1,91 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "whisper/circuit_breaker.hpp"
+
+#include <chrono>
+
+namespace {
+
+using namespace std::chrono_literals;
+using State = CircuitBreaker::State;
+
+} // namespace
+
+TEST_CASE("CircuitBreaker", "[circuit_breaker]") {
+    CircuitBreaker breaker({.failures = 2, .retry = 30s});
+    auto t0 = CircuitBreaker::Clock::now();
+
+    SECTION("OpensAfterFailuresInARow") {
+        REQUIRE(breaker.allow(t0));
+        breaker.failure("connection refused", t0);
+        REQUIRE(breaker.closed());
+        breaker.success();
+        breaker.failure("connection refused", t0);
+        REQUIRE(breaker.closed());  // the success in between reset the count
+        breaker.failure("connection refused", t0);
+        REQUIRE_FALSE(breaker.closed());
+
+        auto s = breaker.snapshot();
+        REQUIRE(s.state == State::Open);
+        REQUIRE(s.consecutive_failures == 2);
+        REQUIRE(s.last_error == "connection refused");
+    }
+
+    SECTION("FailsFastWhileOpen") {
+        breaker.failure("timeout", t0);
+        breaker.failure("timeout", t0);
+        REQUIRE_FALSE(breaker.allow(t0 + 1s));
+        REQUIRE_FALSE(breaker.allow(t0 + 29s));
+        REQUIRE(breaker.snapshot().rejected == 2);
+    }
+
+    // Opened at t0, then the trial let through at t0 + 30s.
+    auto start_trial = [&] {
+        breaker.failure("timeout", t0);
+        breaker.failure("timeout", t0);
+        REQUIRE(breaker.allow(t0 + 30s));
+        REQUIRE(breaker.snapshot().state == State::HalfOpen);
+        REQUIRE_FALSE(breaker.allow(t0 + 31s));  // the trial is still out
+    };
+
+    SECTION("TrialSucceeds") {
+        start_trial();
+        breaker.success();
+        REQUIRE(breaker.closed());
+        REQUIRE(breaker.allow(t0 + 31s));
+    }
+
+    SECTION("TrialFails") {
+        start_trial();
+        breaker.failure("timeout", t0 + 32s);
+        REQUIRE(breaker.snapshot().state == State::Open);
+        REQUIRE_FALSE(breaker.allow(t0 + 61s));
+        REQUIRE(breaker.allow(t0 + 62s));
+    }
+
+    SECTION("TrialThatNeverReportsIsGivenUpOn") {
+        start_trial();
+        REQUIRE(breaker.allow(t0 + 60s));
+    }
+
+    SECTION("ProbeSuccessCloses") {
+        breaker.failure("timeout", t0);
+        breaker.failure("timeout", t0);
+        breaker.success();
+        REQUIRE(breaker.allow(t0 + 1s));
+        REQUIRE(breaker.snapshot().consecutive_failures == 0);
+    }
+
+    SECTION("ProbeFailuresDontPushTheRetryBack") {
+        breaker.failure("timeout", t0);
+        breaker.failure("timeout", t0);
+        breaker.failure("probe: timeout", t0 + 20s);
+        REQUIRE(breaker.allow(t0 + 30s));
+    }
+
+    SECTION("Names") {
+        REQUIRE(std::string(CircuitBreaker::name(State::Closed)) == "closed");
+        REQUIRE(std::string(CircuitBreaker::name(State::Open)) == "open");
+        REQUIRE(std::string(CircuitBreaker::name(State::HalfOpen)) == "half-open");
+    }
+}
@@ -40,10 +40,20 @@ TEST_CASE("Config", "[config]") {
         REQUIRE(cfg.backend.api_format == "whisper.cpp");
         REQUIRE(cfg.backend.language == "en");
         REQUIRE(cfg.output.default_method == "clipboard");
+        REQUIRE(cfg.output.native_wayland);
+        REQUIRE_FALSE(cfg.output.incremental);
+        REQUIRE(cfg.output.apps.empty());
+        REQUIRE(cfg.output.fallback == "paste");
         REQUIRE(cfg.audio.sample_rate == 16000);
         REQUIRE(cfg.audio.max_seconds == 120);
         REQUIRE(cfg.audio.ring_buffer_bytes() == 120 * 16000 * sizeof(int16_t));
+        REQUIRE(cfg.audio.quantum == 0);
+        REQUIRE_FALSE(cfg.audio.lock_memory);
+        REQUIRE(cfg.audio.cpus.empty());
         REQUIRE(cfg.agents.size() == 4);
+        REQUIRE_FALSE(cfg.streaming.enabled);
+        REQUIRE_FALSE(cfg.archive.enabled);
+        REQUIRE_FALSE(cfg.prompt.enabled);
     }
 
     SECTION("LoadFullConfig") {
@@ -52,9 +62,12 @@ TEST_CASE("Config", "[config]") {
                 "type": "remote",
                 "url": "http://10.0.0.1:9090",
                 "api_format": "openai",
-                "language": "de"
+                "language": "de",
+                "http2": true,
+                "audio_format": "flac",
+                "opus_bitrate": 16000
             },
-            "output": { "default": "type" },
+            "output": { "default": "type", "native_wayland": false, "incremental": true },
             "audio": { "sample_rate": 48000, "max_seconds": 60 },
             "agents": ["nvim", "emacs"]
         })");
@@ -64,7 +77,12 @@ TEST_CASE("Config", "[config]") {
         REQUIRE(cfg.backend.url == "http://10.0.0.1:9090");
         REQUIRE(cfg.backend.api_format == "openai");
         REQUIRE(cfg.backend.language == "de");
+        REQUIRE(cfg.backend.http2);
+        REQUIRE(cfg.backend.audio_format == "flac");
+        REQUIRE(cfg.backend.opus_bitrate == 16000);
         REQUIRE(cfg.output.default_method == "type");
+        REQUIRE_FALSE(cfg.output.native_wayland);
+        REQUIRE(cfg.output.incremental);
         REQUIRE(cfg.audio.sample_rate == 48000);
         REQUIRE(cfg.audio.max_seconds == 60);
         REQUIRE(cfg.agents == std::vector<std::string>{"nvim", "emacs"});
@@ -82,6 +100,143 @@ TEST_CASE("Config", "[config]") {
         REQUIRE(cfg.audio.sample_rate == 16000);
     }
 
+    SECTION("LoadAudioPipelineConfig") {
+        TmpFile f(R"({
+            "audio": { "chunk_ms": 50, "quantum": 256, "native_format": true,
+                       "lock_memory": true, "hugepages": true, "cpus": [2, 3] },
+            "streaming": { "enabled": true, "segment_seconds": 6 },
+            "preview": { "enabled": true, "interval_ms": 500, "window_seconds": 8 },
+            "vad": { "enabled": true, "threshold_db": -50.5, "silence_ms": 700, "min_segment_seconds": 3 },
+            "trim": { "enabled": true, "threshold_db": -40, "padding_ms": 50 },
+            "cleanup": { "denoise": true, "suppression_db": 12, "agc": true, "target_db": -18, "max_gain_db": 30 },
+            "queue": { "max_jobs": 2, "cancel_on_start": true },
+            "archive": { "enabled": true, "max_mb": 256, "segment_mb": 16 },
+            "chunking": { "enabled": true, "max_chunk_seconds": 20, "concurrency": 3, "overlap_ms": 500 },
+            "daemon": { "idle_exit_minutes": 15, "multi_user": true, "socket_group": "dictation" }
+        })");
+
+        auto cfg = Config::load(f.path);
+        REQUIRE(cfg.audio.chunk_ms == 50);
+        REQUIRE(cfg.audio.quantum == 256);
+        REQUIRE(cfg.audio.native_format);
+        REQUIRE(cfg.audio.lock_memory);
+        REQUIRE(cfg.audio.hugepages);
+        REQUIRE(cfg.audio.cpus == std::vector<int>{2, 3});
+        REQUIRE(cfg.streaming.enabled);
+        REQUIRE(cfg.streaming.segment_seconds == 6);
+        REQUIRE(cfg.preview.enabled);
+        REQUIRE(cfg.preview.interval_ms == 500);
+        REQUIRE(cfg.preview.window_seconds == 8);
+        REQUIRE(cfg.vad.enabled);
+        REQUIRE(cfg.vad.threshold_db == -50.5);
+        REQUIRE(cfg.vad.silence_ms == 700);
+        REQUIRE(cfg.vad.min_segment_seconds == 3);
+        REQUIRE(cfg.trim.enabled);
+        REQUIRE(cfg.trim.threshold_db == -40.0);
+        REQUIRE(cfg.trim.padding_ms == 50);
+        REQUIRE(cfg.cleanup.denoise);
+        REQUIRE(cfg.cleanup.suppression_db == 12.0);
+        REQUIRE(cfg.cleanup.agc);
+        REQUIRE(cfg.cleanup.target_db == -18.0);
+        REQUIRE(cfg.cleanup.max_gain_db == 30.0);
+        REQUIRE(cfg.queue.max_jobs == 2);
+        REQUIRE(cfg.queue.cancel_on_start);
+        REQUIRE(cfg.archive.enabled);
+        REQUIRE(cfg.archive.max_mb == 256);
+        REQUIRE(cfg.archive.segment_mb == 16);
+        REQUIRE(cfg.chunking.enabled);
+        REQUIRE(cfg.chunking.max_chunk_seconds == 20);
+        REQUIRE(cfg.chunking.concurrency == 3);
+        REQUIRE(cfg.chunking.overlap_ms == 500);
+        REQUIRE(cfg.daemon.idle_exit_minutes == 15);
+        REQUIRE(cfg.daemon.multi_user);
+        REQUIRE(cfg.daemon.socket_group == "dictation");
+    }
+
+    SECTION("LoadBackendPool") {
+        TmpFile f(R"({
+            "backend": {
+                "api_format": "openai",
+                "endpoints": ["http://gpu:8080", { "url": "http://nas:8080", "api_format": "whisper.cpp" }],
+                "pool_mode": "race",
+                "health": { "probe_seconds": 5, "failures": 3, "retry_seconds": 60 },
+                "local_fallback": true
+            }
+        })");
+
+        auto cfg = Config::load(f.path);
+        REQUIRE(cfg.backend.endpoints.size() == 2);
+        REQUIRE(cfg.backend.endpoints[0].url == "http://gpu:8080");
+        REQUIRE(cfg.backend.endpoints[0].api_format.empty());
+        REQUIRE(cfg.backend.endpoints[1].url == "http://nas:8080");
+        REQUIRE(cfg.backend.endpoints[1].api_format == "whisper.cpp");
+        REQUIRE(cfg.backend.pool_mode == "race");
+        REQUIRE(cfg.backend.health.probe_seconds == 5);
+        REQUIRE(cfg.backend.health.failures == 3);
+        REQUIRE(cfg.backend.health.retry_seconds == 60);
+        REQUIRE(cfg.backend.local_fallback);
+    }
+
+    SECTION("LoadLocalBackend") {
+        TmpFile f(R"({
+            "backend": {
+                "type": "local",
+                "local": { "model_path": "/models/ggml-base.en.bin", "threads": 6, "use_gpu": false, "lazy_load": true }
+            }
+        })");
+
+        auto cfg = Config::load(f.path);
+        REQUIRE(cfg.backend.type == "local");
+        REQUIRE(cfg.backend.local.model_path == "/models/ggml-base.en.bin");
+        REQUIRE(cfg.backend.local.threads == 6);
+        REQUIRE_FALSE(cfg.backend.local.use_gpu);
+        REQUIRE(cfg.backend.local.lazy_load);
+    }
+
+    SECTION("LoadPostProcess") {
+        TmpFile f(R"({
+            "postprocess": {
+                "voice_commands": true,
+                "replace": { "speak anywhere": "speak-anywhere" },
+                "apps": [
+                    { "agent": "claude", "replace": { "cube control": "kubectl" } },
+                    { "app_id": "firefox" }
+                ]
+            }
+        })");
+
+        auto cfg = Config::load(f.path);
+        REQUIRE(cfg.postprocess.voice_commands);
+        REQUIRE(cfg.postprocess.replace.size() == 1);
+        REQUIRE(cfg.postprocess.replace[0].second == "speak-anywhere");
+        REQUIRE(cfg.postprocess.apps.size() == 2);
+        REQUIRE(cfg.postprocess.apps[0].agent == "claude");
+        REQUIRE(cfg.postprocess.apps[0].replace[0].first == "cube control");
+        REQUIRE(cfg.postprocess.apps[1].app_id == "firefox");
+        REQUIRE(cfg.postprocess.apps[1].replace.empty());
+    }
+
+    SECTION("LoadOutputRules") {
+        TmpFile f(R"({
+            "output": {
+                "apps": [
+                    { "app_id": "Emacs", "method": "type" },
+                    { "app_id": "ghostty", "paste_keys": "ctrl+shift+v" }
+                ],
+                "fallback": "auto"
+            }
+        })");
+
+        auto cfg = Config::load(f.path);
+        REQUIRE(cfg.output.apps.size() == 2);
+        REQUIRE(cfg.output.apps[0].app_id == "Emacs");
+        REQUIRE(cfg.output.apps[0].method == "type");
+        REQUIRE(cfg.output.apps[0].paste_keys == "ctrl+v");
+        REQUIRE(cfg.output.apps[1].method == "paste");
+        REQUIRE(cfg.output.apps[1].paste_keys == "ctrl+shift+v");
+        REQUIRE(cfg.output.fallback == "auto");
+    }
+
     SECTION("LoadInvalidJson") {
         TmpFile f("not json {{{");
 
@@ -91,6 +246,21 @@ TEST_CASE("Config", "[config]") {
         REQUIRE(cfg.audio.sample_rate == 16000);
     }
 
+    SECTION("ReadReportsWhatLoadPapersOver") {
+        TmpFile good(R"({ "backend": { "url": "http://10.0.0.2:8080" }, "agents": ["aider"] })");
+        auto cfg = Config::read(good.path);
+        REQUIRE(cfg.has_value());
+        REQUIRE(cfg->backend.url == "http://10.0.0.2:8080");
+        REQUIRE(*cfg == Config::load(good.path));
+        REQUIRE(*cfg != Config{});
+
+        TmpFile bad(R"({ "backend": { "url": "http://10.0.0.2:8080" )");
+        auto broken = Config::read(bad.path);
+        REQUIRE_FALSE(broken.has_value());
+        REQUIRE(broken.error().starts_with("parse error"));
+        REQUIRE_FALSE(Config::read("/tmp/sa_test_nonexistent_config_file.json").has_value());
+    }
+
     SECTION("LoadMissingFile") {
         auto cfg = Config::load("/tmp/sa_test_nonexistent_config_file.json");
         REQUIRE(cfg.backend.type == "lan");
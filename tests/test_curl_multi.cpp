@@ -0,0 +1,182 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "whisper/curl_multi.hpp"
+#include "whisper/lan_backend.hpp"
+
+#include <arpa/inet.h>
+#include <atomic>
+#include <chrono>
+#include <netinet/in.h>
+#include <optional>
+#include <poll.h>
+#include <string>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+using namespace std::chrono_literals;
+using Result = std::expected<TranscriptResult, std::string>;
+
+// Just enough HTTP/1.1 for a whisper.cpp /inference upload: reads the request
+// (answering Expect: 100-continue), waits `delay`, replies and hangs up.
+class FakeServer {
+public:
+    explicit FakeServer(std::chrono::milliseconds delay = 0ms) : delay_(delay) {
+        listen_fd_ = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        sockaddr_in addr{.sin_family = AF_INET, .sin_port = 0, .sin_addr = {htonl(INADDR_LOOPBACK)}};
+        ::bind(listen_fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+        ::listen(listen_fd_, 8);
+        socklen_t len = sizeof(addr);
+        ::getsockname(listen_fd_, reinterpret_cast<sockaddr*>(&addr), &len);
+        port_ = ntohs(addr.sin_port);
+
+        acceptor_ = std::jthread([this](std::stop_token stop) {
+            while (!stop.stop_requested()) {
+                pollfd p{.fd = listen_fd_, .events = POLLIN, .revents = 0};
+                if (::poll(&p, 1, 20) <= 0) continue;
+                int fd = ::accept4(listen_fd_, nullptr, nullptr, SOCK_CLOEXEC);
+                if (fd >= 0) handlers_.emplace_back([this, fd] { serve(fd); });
+            }
+        });
+    }
+
+    ~FakeServer() {
+        acceptor_.request_stop();
+        acceptor_.join();
+        handlers_.clear();
+        ::close(listen_fd_);
+    }
+
+    std::string url() const { return "http://127.0.0.1:" + std::to_string(port_); }
+    std::atomic<int> requests{0};
+
+private:
+    void serve(int fd) {
+        std::string in;
+        char buf[4096];
+        size_t header_end = std::string::npos;
+        while ((header_end = in.find("\r\n\r\n")) == std::string::npos) {
+            ssize_t n = ::read(fd, buf, sizeof(buf));
+            if (n <= 0) return void(::close(fd));
+            in.append(buf, static_cast<size_t>(n));
+        }
+        std::string headers = in.substr(0, header_end);
+        size_t length = 0;
+        if (auto at = headers.find("Content-Length: "); at != std::string::npos) {
+            length = std::stoul(headers.substr(at + 16));
+        }
+        if (headers.find("Expect: 100-continue") != std::string::npos) {
+            std::string cont = "HTTP/1.1 100 Continue\r\n\r\n";
+            ::write(fd, cont.data(), cont.size());
+        }
+        size_t body = in.size() - header_end - 4;
+        while (body < length) {
+            ssize_t n = ::read(fd, buf, sizeof(buf));
+            if (n <= 0) return void(::close(fd));
+            body += static_cast<size_t>(n);
+        }
+        ++requests;
+
+        std::this_thread::sleep_for(delay_);
+        std::string reply = R"({"text":" hello "})";
+        std::string out = "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\nContent-Length: " +
+                          std::to_string(reply.size()) + "\r\nConnection: close\r\n\r\n" + reply;
+        ::write(fd, out.data(), out.size());
+        ::close(fd);
+    }
+
+    std::chrono::milliseconds delay_;
+    int listen_fd_ = -1;
+    uint16_t port_ = 0;
+    std::vector<std::jthread> handlers_;  // joined before acceptor_ goes
+    std::jthread acceptor_;
+};
+
+} // namespace
+
+TEST_CASE("CurlMulti", "[curl_multi]") {
+    std::vector<int16_t> audio(16000, 100);
+
+    SECTION("TranscribesWithoutAThread") {
+        FakeServer server;
+        LanBackend backend(server.url());
+        std::vector<std::pair<int, uint32_t>> watched;
+        CurlMulti transfers([&watched](int fd, uint32_t events) { watched.emplace_back(fd, events); },
+                            [](long) {});
+
+        std::optional<Result> result;
+        uint64_t id = backend.start_transcribe(transfers, audio, 16000, "",
+                                               [&result](Result r) { result = std::move(r); });
+        REQUIRE(id != 0);
+        REQUIRE_FALSE(result);
+        transfers.run_until_idle();
+
+        REQUIRE(result);
+        REQUIRE(result->has_value());
+        REQUIRE((*result)->text == "hello");
+        REQUIRE((*result)->duration_s == 1.0);
+        REQUIRE(server.requests == 1);
+        // The socket was handed to the loop and taken back.
+        REQUIRE_FALSE(watched.empty());
+        REQUIRE(watched.back().second == 0);
+        REQUIRE_FALSE(transfers.watches(watched.back().first));
+    }
+
+    SECTION("CancelReportsCancelled") {
+        FakeServer server(2000ms);
+        LanBackend backend(server.url());
+        CurlMulti transfers([](int, uint32_t) {}, [](long) {});
+
+        std::optional<Result> result;
+        uint64_t id = backend.start_transcribe(transfers, audio, 16000, "",
+                                               [&result](Result r) { result = std::move(r); });
+        REQUIRE(id != 0);
+        transfers.cancel(id);
+        // Deferred to the loop, never from under the caller.
+        REQUIRE_FALSE(result);
+
+        auto start = std::chrono::steady_clock::now();
+        transfers.run_until_idle();
+        REQUIRE(std::chrono::steady_clock::now() - start < 1s);
+        REQUIRE(result);
+        REQUIRE_FALSE(result->has_value());
+        REQUIRE(result->error() == "cancelled");
+        transfers.cancel(id);  // already gone: ignored
+    }
+
+    SECTION("TransfersOverlap") {
+        FakeServer server(300ms);
+        LanBackend backend(server.url());
+        CurlMulti transfers([](int, uint32_t) {}, [](long) {});
+
+        std::vector<Result> results;
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < 2; ++i) {
+            REQUIRE(backend.start_transcribe(transfers, audio, 16000, "",
+                                             [&results](Result r) { results.push_back(std::move(r)); }));
+        }
+        REQUIRE(transfers.active() == 2);
+        transfers.run_until_idle();
+
+        REQUIRE(results.size() == 2);
+        for (auto& r : results) REQUIRE(r.has_value());
+        REQUIRE(server.requests == 2);
+        // Side by side: well under two server delays.
+        REQUIRE(std::chrono::steady_clock::now() - start < 550ms);
+    }
+
+    SECTION("OtherUploadsKeepTheirThread") {
+        CurlMulti transfers([](int, uint32_t) {}, [](long) {});
+        auto never = [](Result) { FAIL("called"); };
+        LanBackend flac("http://127.0.0.1:9", "whisper.cpp", "en", false, "flac");
+        if (flac.upload_format() == "flac") {
+            REQUIRE(flac.start_transcribe(transfers, audio, 16000, "", never) == 0);
+        }
+        LanBackend wav("http://127.0.0.1:9");
+        REQUIRE(wav.start_transcribe(transfers, std::span<const int16_t>{}, 16000, "", never) == 0);
+        REQUIRE(transfers.active() == 0);
+    }
+}
@@ -0,0 +1,104 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "audio/file_capture.hpp"
+#include "wav_encoder.hpp"
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+struct TmpDir {
+    fs::path path;
+
+    TmpDir() {
+        path = fs::temp_directory_path() / ("sa_test_replay_" + std::to_string(getpid()));
+        fs::create_directories(path);
+    }
+    ~TmpDir() { fs::remove_all(path); }
+
+    fs::path write(const std::string& name, std::span<const int16_t> samples, uint32_t rate) {
+        auto file = wav::encode(samples, rate);
+        std::ofstream(path / name, std::ios::binary).write(reinterpret_cast<const char*>(file.data()),
+                                                           static_cast<std::streamsize>(file.size()));
+        return path / name;
+    }
+};
+
+// Waits until the buffer holds at least bytes, or a second has gone by.
+bool wait_for(const RingBuffer& rb, size_t bytes) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+    while (rb.available() < bytes) {
+        if (std::chrono::steady_clock::now() > deadline) return false;
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    return true;
+}
+
+} // namespace
+
+TEST_CASE("FileAudioCapture", "[file_capture]") {
+    TmpDir dir;
+    RingBuffer rb(1 << 20);
+    FileAudioCapture capture(rb, 16000);
+    // 0.1 s each, told apart by their value.
+    std::vector<int16_t> a(1600, 100), b(1600, 200);
+
+    SECTION("PlaysClipsInTurnThenSilence") {
+        dir.write("b.wav", b, 16000);
+        dir.write("a.wav", a, 16000);
+        dir.write("notes.txt", {}, 16000);
+        auto clips = capture.open(dir.path.string());
+        REQUIRE(clips.has_value());
+        REQUIRE(*clips == 2);
+        REQUIRE(capture.clip_seconds() == std::vector<double>{0.1, 0.1});
+
+        for (int16_t expected : {100, 200, 100}) {
+            REQUIRE(capture.start());
+            REQUIRE(capture.is_capturing());
+            REQUIRE(wait_for(rb, 2000 * sizeof(int16_t)));
+            capture.stop();
+            REQUIRE_FALSE(capture.is_capturing());
+
+            auto samples = rb.drain_all();
+            REQUIRE(samples.size() >= 2000);
+            REQUIRE(samples[0] == expected);
+            REQUIRE(samples[1599] == expected);
+            REQUIRE(samples[1600] == 0);
+        }
+        REQUIRE(capture.stats().bytes >= 6000 * sizeof(int16_t));
+        REQUIRE(capture.stats().quantum == 320);
+    }
+
+    SECTION("ConvertsToMonoAtTheCaptureRate") {
+        std::vector<int16_t> stereo(4800 * 2, 1000);
+        auto path = dir.write("stereo.wav", stereo, 48000);
+        auto file = wav::encode(stereo, 48000);
+        // Rewrite as 2 channels at 48 kHz: 4800 frames, 0.1 s.
+        file[22] = 2;
+        std::ofstream(path, std::ios::binary).write(reinterpret_cast<const char*>(file.data()),
+                                                    static_cast<std::streamsize>(file.size()));
+        REQUIRE(capture.open(path.string()).has_value());
+        auto seconds = capture.clip_seconds();
+        REQUIRE(seconds.size() == 1);
+        REQUIRE(seconds[0] > 0.09);
+        REQUIRE(seconds[0] <= 0.1);
+    }
+
+    SECTION("Errors") {
+        REQUIRE_FALSE(capture.start());
+        REQUIRE_FALSE(capture.open((dir.path / "missing.wav").string()).has_value());
+        REQUIRE_FALSE(capture.open(dir.path.string()).has_value());
+        std::ofstream(dir.path / "bad.wav") << "not a wav";
+        auto res = capture.open(dir.path.string());
+        REQUIRE_FALSE(res.has_value());
+        REQUIRE(res.error().find("not a WAV file") != std::string::npos);
+    }
+}
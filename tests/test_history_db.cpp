@@ -5,8 +5,11 @@
 
 #include <cstdlib>
 #include <filesystem>
+#include <sqlite3.h>
 #include <string>
+#include <thread>
 #include <unistd.h>
+#include <vector>
 
 namespace {
 
@@ -21,6 +24,23 @@ struct TmpDb {
     ~TmpDb() { std::filesystem::remove(path); }
 };
 
+// A database as version 2 wrote it, the context strings in every row.
+void write_version2(const std::string& path) {
+    sqlite3* raw = nullptr;
+    REQUIRE(sqlite3_open(path.c_str(), &raw) == SQLITE_OK);
+    REQUIRE(sqlite3_exec(raw,
+                         "CREATE TABLE transcriptions (id INTEGER PRIMARY KEY AUTOINCREMENT, "
+                         "timestamp TEXT NOT NULL DEFAULT (strftime('%Y-%m-%dT%H:%M:%f','now')), "
+                         "text TEXT NOT NULL, audio_duration REAL, processing_time REAL, "
+                         "app_context TEXT, app_id TEXT, window_class TEXT, window_title TEXT, "
+                         "agent TEXT, working_dir TEXT, backend TEXT);"
+                         "INSERT INTO transcriptions (text, window_title, working_dir) VALUES "
+                         "('one', 'vim', '/src'), ('two', 'vim', '/src'), ('three', 'shell', NULL);"
+                         "PRAGMA user_version = 2;",
+                         nullptr, nullptr, nullptr) == SQLITE_OK);
+    sqlite3_close(raw);
+}
+
 } // namespace
 
 TEST_CASE("HistoryDb", "[history]") {
@@ -124,4 +144,458 @@ TEST_CASE("HistoryDb", "[history]") {
         REQUIRE(entries.size() == 1);
         REQUIRE_FALSE(entries[0].timestamp.empty());
     }
+
+    SECTION("StageTimingsRoundTrip") {
+        TmpDb tmp;
+        HistoryDb db;
+        REQUIRE(db.open(tmp.path));
+
+        StageTimings t{.upload_s = 0.25, .inference_s = 1.5, .total_s = 2.0};
+        REQUIRE(db.insert("timed", 3.0, 1.8, WindowInfo{}, "lan", t));
+
+        auto entries = db.recent(1);
+        REQUIRE(entries.size() == 1);
+        REQUIRE(entries[0].timings.upload_s == 0.25);
+        REQUIRE(entries[0].timings.inference_s == 1.5);
+        REQUIRE(entries[0].timings.total_s == 2.0);
+        // Stages that didn't run come back unset rather than as 0.
+        REQUIRE_FALSE(entries[0].timings.connect_s);
+        REQUIRE_FALSE(entries[0].timings.history_s);
+    }
+}
+
+TEST_CASE("HistoryDb search", "[history][search]") {
+    TmpDb tmp;
+    HistoryDb db;
+    REQUIRE(db.open(tmp.path));
+
+    WindowInfo kitty{.app_id = "kitty", .agent = "claude", .working_dir = "/home/u/proj"};
+    WindowInfo firefox{.app_id = "firefox"};
+
+    SECTION("MatchesWordsWithSnippet") {
+        REQUIRE(db.insert("refactor the parser before lunch", 1.0, 0.1, kitty, "lan"));
+        REQUIRE(db.insert("book a table for dinner", 1.0, 0.1, firefox, "lan"));
+
+        auto page = db.search("parser");
+        REQUIRE(page.has_value());
+        REQUIRE(page->hits.size() == 1);
+        REQUIRE(page->hits[0].entry.text == "refactor the parser before lunch");
+        REQUIRE(page->hits[0].snippet == "refactor the [parser] before lunch");
+        REQUIRE_FALSE(page->next);
+
+        // Every word has to match; punctuation is taken literally.
+        REQUIRE(db.search("parser dinner")->hits.empty());
+        REQUIRE(db.search("\"parser AND (")->hits.empty());
+        REQUIRE(db.search("pars*")->hits.size() == 1);
+    }
+
+    SECTION("RanksBetterMatchesFirst") {
+        REQUIRE(db.insert("deploy once, mention nothing else at all here", 1.0, 0.1, kitty, "lan"));
+        REQUIRE(db.insert("deploy deploy deploy", 1.0, 0.1, kitty, "lan"));
+
+        auto page = db.search("deploy");
+        REQUIRE(page->hits.size() == 2);
+        REQUIRE(page->hits[0].entry.text == "deploy deploy deploy");
+        REQUIRE(page->hits[0].rank < page->hits[1].rank);
+    }
+
+    SECTION("PagesWithCursor") {
+        for (int i = 0; i < 5; ++i) {
+            REQUIRE(db.insert("note number " + std::to_string(i), 1.0, 0.1, kitty, "lan"));
+        }
+
+        std::vector<std::string> seen;
+        std::optional<SearchCursor> after;
+        int pages = 0;
+        do {
+            auto page = db.search("note", {}, after, 2);
+            REQUIRE(page.has_value());
+            for (auto& hit : page->hits) seen.push_back(hit.entry.text);
+            after = page->next;
+            ++pages;
+        } while (after);
+
+        REQUIRE(pages == 3);
+        // Equal ranks fall back to newest first.
+        REQUIRE(seen == std::vector<std::string>{"note number 4", "note number 3", "note number 2",
+                                                 "note number 1", "note number 0"});
+    }
+
+    SECTION("CursorRoundTrips") {
+        SearchCursor c{.rank = -1.2345678901234567e-6, .id = 42};
+        auto parsed = SearchCursor::parse(c.encode());
+        REQUIRE(parsed.has_value());
+        REQUIRE(parsed->rank == c.rank);
+        REQUIRE(parsed->id == 42);
+        REQUIRE_FALSE(SearchCursor::parse("garbage"));
+        REQUIRE_FALSE(SearchCursor::parse("1.0,x"));
+    }
+
+    SECTION("Filters") {
+        REQUIRE(db.insert("status update one", 1.0, 0.1, kitty, "lan"));
+        REQUIRE(db.insert("status update two", 1.0, 0.1, firefox, "lan"));
+        WindowInfo nested = kitty;
+        nested.working_dir = "/home/u/proj/sub";
+        REQUIRE(db.insert("status update three", 1.0, 0.1, nested, "lan"));
+        WindowInfo sibling = kitty;
+        sibling.working_dir = "/home/u/project";
+        REQUIRE(db.insert("status update four", 1.0, 0.1, sibling, "lan"));
+
+        REQUIRE(db.search("status", {.app_id = "firefox"})->hits.size() == 1);
+        REQUIRE(db.search("status", {.agent = "claude"})->hits.size() == 3);
+        // A directory matches itself and below, not names sharing its prefix.
+        REQUIRE(db.search("status", {.working_dir = "/home/u/proj"})->hits.size() == 2);
+        REQUIRE(db.search("status", {.since = "2000-01-01", .before = "2000-01-02"})->hits.empty());
+        REQUIRE(db.search("status", {.since = "2000-01-01"})->hits.size() == 4);
+
+        // Without words, filters alone list entries newest first.
+        auto page = db.search("", {.app_id = "kitty"});
+        REQUIRE(page->hits.size() == 3);
+        REQUIRE(page->hits[0].entry.text == "status update four");
+    }
+
+    SECTION("PagedSearchSeesLaterWrites") {
+        for (int i = 0; i < 3; ++i) REQUIRE(db.insert("standup notes", 1.0, 0.1, kitty, "lan"));
+        auto page = db.search("standup", {}, std::nullopt, 2);
+        REQUIRE(page->next);
+
+        // The writer thread has a connection of its own.
+        HistoryDb writer;
+        REQUIRE(writer.open(tmp.path));
+        REQUIRE(writer.insert("standup moved to ten", 1.0, 0.1, kitty, "lan"));
+        REQUIRE(db.recent(10).size() == 4);
+        REQUIRE(db.search("moved")->hits.size() == 1);
+    }
+}
+
+TEST_CASE("HistoryDb search indexes existing rows", "[history][search]") {
+    TmpDb tmp;
+    {
+        // A database written before the search index existed.
+        sqlite3* raw = nullptr;
+        REQUIRE(sqlite3_open(tmp.path.c_str(), &raw) == SQLITE_OK);
+        REQUIRE(sqlite3_exec(raw,
+                             "CREATE TABLE transcriptions (id INTEGER PRIMARY KEY AUTOINCREMENT, "
+                             "timestamp TEXT NOT NULL DEFAULT (strftime('%Y-%m-%dT%H:%M:%f','now')), "
+                             "text TEXT NOT NULL, audio_duration REAL, processing_time REAL);"
+                             "INSERT INTO transcriptions (text) VALUES ('an old dictation');",
+                             nullptr, nullptr, nullptr) == SQLITE_OK);
+        sqlite3_close(raw);
+    }
+
+    HistoryDb db;
+    REQUIRE(db.open(tmp.path));
+    REQUIRE(db.search("old")->hits.size() == 1);
+
+    REQUIRE(db.insert("a new dictation", 1.0, 0.1, WindowInfo{}, "lan"));
+    REQUIRE(db.search("dictation")->hits.size() == 2);
+}
+
+TEST_CASE("HistoryDb schema version", "[history]") {
+    TmpDb tmp;
+    auto user_version = [&tmp] {
+        sqlite3* raw = nullptr;
+        sqlite3_open(tmp.path.c_str(), &raw);
+        sqlite3_stmt* stmt = nullptr;
+        sqlite3_prepare_v2(raw, "PRAGMA user_version", -1, &stmt, nullptr);
+        sqlite3_step(stmt);
+        int version = sqlite3_column_int(stmt, 0);
+        sqlite3_finalize(stmt);
+        sqlite3_close(raw);
+        return version;
+    };
+
+    {
+        // Written before audio_id and the stage timings existed.
+        sqlite3* raw = nullptr;
+        REQUIRE(sqlite3_open(tmp.path.c_str(), &raw) == SQLITE_OK);
+        REQUIRE(sqlite3_exec(raw,
+                             "CREATE TABLE transcriptions (id INTEGER PRIMARY KEY AUTOINCREMENT, "
+                             "timestamp TEXT NOT NULL DEFAULT (strftime('%Y-%m-%dT%H:%M:%f','now')), "
+                             "text TEXT NOT NULL, audio_duration REAL, processing_time REAL);",
+                             nullptr, nullptr, nullptr) == SQLITE_OK);
+        sqlite3_close(raw);
+    }
+    REQUIRE(user_version() == 0);
+
+    {
+        HistoryDb db;
+        REQUIRE(db.open(tmp.path));
+        HistoryRecord record{.text = "migrated", .audio_id = 7};
+        REQUIRE(db.insert(record));
+    }
+    REQUIRE(user_version() == HistoryDb::SCHEMA_VERSION);
+
+    // Current: opened without touching the schema.
+    HistoryDb db;
+    REQUIRE(db.open(tmp.path));
+    auto entries = db.recent(1);
+    REQUIRE(entries.size() == 1);
+    REQUIRE(entries[0].audio_id == 7);
+}
+
+TEST_CASE("HistoryDb context strings", "[history]") {
+    TmpDb tmp;
+    auto query_int = [&tmp](const char* sql) {
+        sqlite3* raw = nullptr;
+        sqlite3_open(tmp.path.c_str(), &raw);
+        sqlite3_stmt* stmt = nullptr;
+        int value = -1;
+        if (sqlite3_prepare_v2(raw, sql, -1, &stmt, nullptr) == SQLITE_OK && sqlite3_step(stmt) == SQLITE_ROW) {
+            value = sqlite3_column_int(stmt, 0);
+        }
+        sqlite3_finalize(stmt);
+        sqlite3_close(raw);
+        return value;
+    };
+
+    SECTION("StoredOnce") {
+        HistoryDb db;
+        REQUIRE(db.open(tmp.path));
+        WindowInfo ctx{.app_id = "kitty", .title = "vim notes.md", .working_dir = "/home/u/proj"};
+        for (int i = 0; i < 3; ++i) REQUIRE(db.insert("line " + std::to_string(i), 1.0, 0.1, ctx, "lan"));
+        ctx.context = "notes.md:12";
+        REQUIRE(db.insert("line 3", 1.0, 0.1, ctx, "lan"));
+
+        REQUIRE(query_int("SELECT COUNT(*) FROM context_strings") == 3);
+        auto entries = db.recent(4);
+        REQUIRE(entries[0].app_context == "notes.md:12");
+        REQUIRE(entries[3].app_context.empty());
+        REQUIRE(entries[3].window_title == "vim notes.md");
+        REQUIRE(entries[3].working_dir == "/home/u/proj");
+    }
+
+    SECTION("MigratedFromVersion2") {
+        write_version2(tmp.path);
+
+        HistoryDb db;
+        REQUIRE(db.open(tmp.path));
+        auto entries = db.after(0, 10);
+        REQUIRE(entries.size() == 3);
+        REQUIRE(entries[1].window_title == "vim");
+        REQUIRE(entries[1].working_dir == "/src");
+        REQUIRE(entries[2].window_title == "shell");
+        REQUIRE(entries[2].working_dir.empty());
+        REQUIRE(db.search("", {.working_dir = "/src"})->hits.size() == 2);
+
+        REQUIRE(query_int("SELECT COUNT(*) FROM context_strings") == 3);
+        REQUIRE(query_int("SELECT COUNT(*) FROM pragma_table_info('transcriptions') "
+                          "WHERE name IN ('app_context', 'window_title', 'working_dir')") == 0);
+        REQUIRE(query_int("PRAGMA auto_vacuum") == 2);  // incremental
+    }
+
+    SECTION("MigratedOnceWhenOpenedTogether") {
+        // The daemon's history and its transcript cache open the same file.
+        write_version2(tmp.path);
+        HistoryDb first, second;
+        bool first_open = false;
+        std::thread other([&] { first_open = first.open(tmp.path); });
+        bool second_open = second.open(tmp.path);
+        other.join();
+        REQUIRE(first_open);
+        REQUIRE(second_open);
+
+        for (HistoryDb* db : {&first, &second}) {
+            auto entries = db->after(0, 10);
+            REQUIRE(entries.size() == 3);
+            REQUIRE(entries[0].window_title == "vim");
+            REQUIRE(entries[0].working_dir == "/src");
+            REQUIRE(entries[2].window_title == "shell");
+        }
+        REQUIRE(query_int("SELECT COUNT(*) FROM context_strings") == 3);
+        REQUIRE(query_int("SELECT COUNT(*) FROM transcriptions WHERE window_title_id IS NULL") == 0);
+    }
+
+    SECTION("LookupsLeaveNoSnapshotBehind") {
+        // The writer's connection finds the strings it has stored before;
+        // another connection (an import) writes between its batches.
+        HistoryDb writer, other;
+        REQUIRE(writer.open(tmp.path));
+        REQUIRE(other.open(tmp.path));
+        WindowInfo ctx{.app_id = "kitty", .title = "vim", .working_dir = "/src"};
+        REQUIRE(writer.insert("first", 1.0, 0.1, ctx, "lan"));
+        REQUIRE(writer.insert("second", 1.0, 0.1, ctx, "lan"));
+        REQUIRE(other.insert("imported", 1.0, 0.1, WindowInfo{}, "lan"));
+
+        std::vector<HistoryRecord> batch(2, HistoryRecord{.text = "later", .context = ctx});
+        REQUIRE(writer.insert_batch(batch));
+        REQUIRE(other.recent(10).size() == 5);
+    }
+}
+
+TEST_CASE("HistoryDb maintain", "[history]") {
+    TmpDb tmp;
+    HistoryDb db;
+    REQUIRE(db.open(tmp.path));
+
+    std::vector<HistoryRecord> records(400, HistoryRecord{.text = std::string(2000, 'x')});
+    REQUIRE(db.import(records));
+    db.checkpoint();
+    auto full = std::filesystem::file_size(tmp.path);
+
+    sqlite3* raw = nullptr;
+    REQUIRE(sqlite3_open(tmp.path.c_str(), &raw) == SQLITE_OK);
+    REQUIRE(sqlite3_exec(raw, "DELETE FROM transcriptions WHERE id > 10", nullptr, nullptr, nullptr) ==
+            SQLITE_OK);
+    sqlite3_close(raw);
+
+    db.maintain();
+    REQUIRE(std::filesystem::file_size(tmp.path) < full / 4);
+    REQUIRE(std::filesystem::file_size(tmp.path + "-wal") == 0);
+    REQUIRE(db.recent(20).size() == 10);
+}
+
+TEST_CASE("HistoryDb get", "[history]") {
+    TmpDb tmp;
+    HistoryDb db;
+    REQUIRE(db.open(tmp.path));
+
+    REQUIRE(db.insert(HistoryRecord{.text = "kept", .backend = "lan", .audio_id = 1234}));
+    REQUIRE(db.insert("not kept", 1.0, 0.1, WindowInfo{}, "lan"));
+
+    auto entries = db.recent(2);
+    auto kept = db.get(entries[1].id);
+    REQUIRE(kept.has_value());
+    REQUIRE(kept->text == "kept");
+    REQUIRE(kept->audio_id == 1234);
+    REQUIRE(db.get(entries[0].id)->audio_id == 0);
+    REQUIRE_FALSE(db.get(entries[0].id + 1));
+
+    // Retranscribing reads an entry; later writes still show up.
+    REQUIRE(db.get(entries[1].id));
+    HistoryDb writer;
+    REQUIRE(writer.open(tmp.path));
+    REQUIRE(writer.insert("written later", 1.0, 0.1, WindowInfo{}, "lan"));
+    REQUIRE(db.recent(1)[0].text == "written later");
+}
+
+TEST_CASE("HistoryDb pages and imports", "[history]") {
+    TmpDb tmp;
+    HistoryDb db;
+    REQUIRE(db.open(tmp.path));
+
+    SECTION("AfterPagesOldestFirst") {
+        for (int i = 0; i < 5; ++i) REQUIRE(db.insert(HistoryRecord{.text = std::to_string(i)}));
+        auto first = db.after(0, 2);
+        REQUIRE(first.size() == 2);
+        REQUIRE(first[0].text == "0");
+        REQUIRE(first[1].text == "1");
+        auto rest = db.after(first.back().id, 10);
+        REQUIRE(rest.size() == 3);
+        REQUIRE(rest.back().text == "4");
+        REQUIRE(db.after(rest.back().id, 10).empty());
+    }
+
+    SECTION("ImportKeepsTimestamps") {
+        std::vector<HistoryRecord> records = {
+            {.text = "old one", .backend = "lan", .timestamp = "2025-01-02T03:04:05.000"},
+            {.text = "no time"},
+        };
+        REQUIRE(db.import(records));
+        auto entries = db.after(0, 10);
+        REQUIRE(entries.size() == 2);
+        REQUIRE(entries[0].timestamp == "2025-01-02T03:04:05.000");
+        REQUIRE(entries[0].backend == "lan");
+        REQUIRE(entries[1].timestamp.size() >= 19);
+        REQUIRE(db.search("old")->hits.size() == 1);
+    }
+
+    SECTION("FailedImportAddsNothing") {
+        REQUIRE(db.insert(HistoryRecord{.text = "before"}));
+        // A trigger fails the second row, after the first went in.
+        sqlite3* raw = nullptr;
+        REQUIRE(sqlite3_open(tmp.path.c_str(), &raw) == SQLITE_OK);
+        REQUIRE(sqlite3_exec(raw,
+                             "CREATE TRIGGER no_bad BEFORE INSERT ON transcriptions WHEN new.text = 'bad' "
+                             "BEGIN SELECT RAISE(ABORT, 'bad row'); END;",
+                             nullptr, nullptr, nullptr) == SQLITE_OK);
+        sqlite3_close(raw);
+
+        std::vector<HistoryRecord> records = {{.text = "fine"}, {.text = "bad"}, {.text = "also fine"}};
+        REQUIRE_FALSE(db.import(records));
+        auto entries = db.after(0, 10);
+        REQUIRE(entries.size() == 1);
+        REQUIRE(entries[0].text == "before");
+    }
+}
+
+TEST_CASE("HistoryDb stats", "[history][stats]") {
+    TmpDb tmp;
+    HistoryDb db;
+    REQUIRE(db.open(tmp.path));
+
+    auto record = [](std::string text, std::string day, std::string app, std::string backend,
+                     double audio, double processing) {
+        return HistoryRecord{.text = std::move(text), .audio_duration = audio, .processing_time = processing,
+                             .context = {.app_id = std::move(app)}, .backend = std::move(backend),
+                             .timestamp = day + "T12:00:00.000"};
+    };
+    std::vector<HistoryRecord> records = {
+        record("one two three", "2026-03-01", "kitty", "lan", 2.0, 0.5),
+        record("  four  ", "2026-03-01", "kitty", "lan", 1.0, 0.5),
+        record("five six", "2026-03-01", "firefox", "local", 4.0, 4.0),
+        record("seven", "2026-03-02", "kitty", "lan", 1.0, 0.25),
+    };
+    REQUIRE(db.import(records));
+
+    SECTION("RollsUpByDayAppAndAgent") {
+        auto stats = db.stats();
+        REQUIRE(stats.has_value());
+        REQUIRE(stats->days.size() == 3);
+        auto& kitty = stats->days[0];
+        REQUIRE(kitty.day == "2026-03-01");
+        REQUIRE(kitty.app == "kitty");
+        REQUIRE(kitty.entries == 2);
+        REQUIRE(kitty.words == 4);
+        REQUIRE(kitty.audio_seconds == 3.0);
+        REQUIRE(stats->days[2].day == "2026-03-02");
+
+        REQUIRE(stats->backends.size() == 2);
+        REQUIRE(stats->backends[0].backend == "lan");
+        REQUIRE(stats->backends[0].entries == 3);
+        REQUIRE(stats->backends[0].real_time_factor() == 0.3125);
+        REQUIRE(stats->backends[1].real_time_factor() == 1.0);
+    }
+
+    SECTION("BoundsAreDays") {
+        auto stats = db.stats("2026-03-02", "");
+        REQUIRE(stats->days.size() == 1);
+        REQUIRE(stats->backends.size() == 1);
+        REQUIRE(db.stats("", "2026-03-02")->days.size() == 2);
+        REQUIRE(db.stats("2027-01-01", "")->days.empty());
+    }
+
+    SECTION("InsertAndDeleteKeepThemCurrent") {
+        REQUIRE(db.insert(record("eight nine", "2026-03-02", "kitty", "lan", 1.0, 0.25)));
+        REQUIRE(db.stats("2026-03-02", "")->days[0].words == 3);
+
+        // Deleted through any connection, e.g. the sqlite3 shell.
+        sqlite3* raw = nullptr;
+        REQUIRE(sqlite3_open(tmp.path.c_str(), &raw) == SQLITE_OK);
+        REQUIRE(sqlite3_exec(raw, "DELETE FROM transcriptions WHERE timestamp < '2026-03-02'", nullptr,
+                             nullptr, nullptr) == SQLITE_OK);
+        sqlite3_close(raw);
+        auto stats = db.stats();
+        REQUIRE(stats->days.size() == 1);
+        REQUIRE(stats->days[0].entries == 2);
+        REQUIRE(stats->backends.size() == 1);
+    }
+
+    SECTION("BackfilledForOlderDatabases") {
+        db.close();
+        sqlite3* raw = nullptr;
+        REQUIRE(sqlite3_open(tmp.path.c_str(), &raw) == SQLITE_OK);
+        REQUIRE(sqlite3_exec(raw,
+                             "DROP TABLE daily_usage; DROP TABLE daily_backend;"
+                             "DROP TRIGGER transcriptions_rollup_insert; DROP TRIGGER transcriptions_rollup_delete;"
+                             "PRAGMA user_version = 1;",
+                             nullptr, nullptr, nullptr) == SQLITE_OK);
+        sqlite3_close(raw);
+
+        REQUIRE(db.open(tmp.path));
+        auto stats = db.stats();
+        REQUIRE(stats->days.size() == 3);
+        REQUIRE(stats->days[0].words == 4);
+        REQUIRE(stats->backends[0].entries == 3);
+    }
 }
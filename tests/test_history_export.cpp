@@ -0,0 +1,122 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "storage/history_export.hpp"
+
+#include <filesystem>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+struct TmpDb {
+    std::string path = std::filesystem::temp_directory_path() /
+                       ("sa_test_export_" + std::to_string(getpid()) + ".sqlite");
+    ~TmpDb() { std::filesystem::remove(path); }
+};
+
+HistoryRecord tricky() {
+    return HistoryRecord{
+        .text = "says \"hi\", then\nnew line",
+        .audio_duration = 2.5,
+        .processing_time = 0.25,
+        .context = {.app_id = "kitty", .title = "a, b", .agent = "claude",
+                    .working_dir = "/home/u/src", .context = "claude on kitty"},
+        .backend = "lan",
+        .timings = {.upload_s = 0.125, .total_s = 0.5},
+    };
+}
+
+std::string export_all(HistoryDb& db, history_io::Format format, int page_rows) {
+    HistoryExport ex(db, format, page_rows);
+    std::string out;
+    for (std::string page; !(page = ex.next()).empty();) out += page;
+    return out;
+}
+
+} // namespace
+
+TEST_CASE("History export", "[history][export]") {
+    TmpDb tmp;
+    HistoryDb db;
+    REQUIRE(db.open(tmp.path));
+
+    SECTION("ParseFormat") {
+        REQUIRE(history_io::parse_format("ndjson") == history_io::Format::Ndjson);
+        REQUIRE(history_io::parse_format("csv") == history_io::Format::Csv);
+        REQUIRE_FALSE(history_io::parse_format("xml"));
+    }
+
+    SECTION("PagesCoverEveryRowOnce") {
+        for (int i = 0; i < 7; ++i) REQUIRE(db.insert(HistoryRecord{.text = "row " + std::to_string(i)}));
+        HistoryExport ex(db, history_io::Format::Ndjson, 3);
+        std::vector<std::string> pages;
+        for (std::string page; !(page = ex.next()).empty();) pages.push_back(page);
+        REQUIRE(pages.size() == 3);
+        REQUIRE(ex.rows() == 7);
+        REQUIRE(pages[0].starts_with("{\"agent\""));
+        REQUIRE(pages[0].find("row 0") != std::string::npos);
+        REQUIRE(pages[2].find("row 6") != std::string::npos);
+        REQUIRE(ex.next().empty());
+    }
+
+    SECTION("EmptyHistory") {
+        REQUIRE(export_all(db, history_io::Format::Ndjson, 10).empty());
+        REQUIRE(export_all(db, history_io::Format::Csv, 10) == history_io::header(history_io::Format::Csv));
+    }
+
+    auto round_trip = [&db](history_io::Format format) {
+        REQUIRE(db.insert(tricky()));
+        REQUIRE(db.insert(HistoryRecord{.text = "plain"}));
+        auto text = export_all(db, format, 1);
+
+        auto records = history_io::parse(text, format);
+        REQUIRE(records.has_value());
+        REQUIRE(records->size() == 2);
+        auto& r = records->front();
+        REQUIRE(r.text == tricky().text);
+        REQUIRE(r.audio_duration == 2.5);
+        REQUIRE(r.context.title == "a, b");
+        REQUIRE(r.context.context == "claude on kitty");
+        REQUIRE(r.timings.upload_s == 0.125);
+        REQUIRE_FALSE(r.timings.drain_s);
+        REQUIRE(r.timestamp == db.after(0, 1)[0].timestamp);
+        REQUIRE(records->back().text == "plain");
+
+        // Into a second database, the same rows come out again.
+        TmpDb other;
+        other.path += ".2";
+        HistoryDb copy;
+        REQUIRE(copy.open(other.path));
+        REQUIRE(copy.import(*records));
+        REQUIRE(export_all(copy, format, 5) == text);
+    };
+
+    SECTION("RoundTripNdjson") { round_trip(history_io::Format::Ndjson); }
+    SECTION("RoundTripCsv") { round_trip(history_io::Format::Csv); }
+
+    SECTION("BadRowsNameTheirLine") {
+        auto nd = history_io::parse("{\"text\":\"a\"}\n\n{\"text\":\"\"}\n", history_io::Format::Ndjson);
+        REQUIRE_FALSE(nd);
+        REQUIRE(nd.error() == "line 3: no text");
+        REQUIRE(history_io::parse("not json\n", history_io::Format::Ndjson).error() ==
+                "line 1: not a JSON object");
+
+        auto csv = history_io::parse("text,audio_duration\n\"two\nlines\",1\nthree,abc\n",
+                                     history_io::Format::Csv);
+        REQUIRE_FALSE(csv);
+        REQUIRE(csv.error() == "line 4: bad audio_duration");
+        REQUIRE(history_io::parse("text\n\"open\n", history_io::Format::Csv).error() ==
+                "line 2: unterminated quote");
+        REQUIRE(history_io::parse("id,words\n1,x\n", history_io::Format::Csv).error() ==
+                "line 1: no text column");
+    }
+
+    SECTION("CsvColumnsByName") {
+        auto records = history_io::parse("backend,text\r\nlan,hello\r\n", history_io::Format::Csv);
+        REQUIRE(records.has_value());
+        REQUIRE(records->size() == 1);
+        REQUIRE((*records)[0].text == "hello");
+        REQUIRE((*records)[0].backend == "lan");
+    }
+}
@@ -0,0 +1,86 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "storage/history_writer.hpp"
+
+#include <filesystem>
+#include <string>
+#include <unistd.h>
+
+namespace {
+
+struct TmpDb {
+    std::string path;
+
+    TmpDb() {
+        path = std::filesystem::temp_directory_path() /
+               ("sa_test_writer_" + std::to_string(getpid()) + ".sqlite");
+    }
+
+    ~TmpDb() {
+        std::filesystem::remove(path);
+        std::filesystem::remove(path + "-wal");
+        std::filesystem::remove(path + "-shm");
+    }
+};
+
+HistoryRecord record(const std::string& text) {
+    return HistoryRecord{.text = text, .audio_duration = 1.0, .processing_time = 0.1, .backend = "lan"};
+}
+
+} // namespace
+
+TEST_CASE("HistoryWriter", "[history]") {
+    TmpDb tmp;
+    HistoryDb reader;
+    REQUIRE(reader.open(tmp.path));
+
+    SECTION("FlushMakesRowsVisible") {
+        HistoryWriter writer;
+        REQUIRE(writer.open(tmp.path));
+        REQUIRE(writer.submit(record("first")));
+        REQUIRE(writer.submit(record("second")));
+        writer.flush();
+
+        auto entries = reader.recent(10);
+        REQUIRE(entries.size() == 2);
+        REQUIRE(entries[0].text == "second");
+        REQUIRE(entries[1].text == "first");
+    }
+
+    SECTION("CloseWritesEverythingQueued") {
+        HistoryWriter writer;
+        REQUIRE(writer.open(tmp.path));
+        // More than fit in the queue, so submit() has to wait for batches.
+        constexpr int rows = HistoryWriter::MAX_QUEUED * 2 + 3;
+        for (int i = 0; i < rows; ++i) {
+            REQUIRE(writer.submit(record("row " + std::to_string(i))));
+        }
+        writer.close();
+        REQUIRE_FALSE(writer.active());
+
+        auto entries = reader.recent(rows + 1);
+        REQUIRE(entries.size() == rows);
+        REQUIRE(entries[0].text == "row " + std::to_string(rows - 1));
+        // Rows written by the batch are searchable like any other.
+        REQUIRE(reader.search("row")->hits.size() == 20);
+    }
+
+    SECTION("SubmitWithoutOpenFails") {
+        HistoryWriter writer;
+        REQUIRE_FALSE(writer.submit(record("lost")));
+        writer.flush();  // returns at once
+    }
+}
+
+TEST_CASE("HistoryDb insert_batch", "[history]") {
+    TmpDb tmp;
+    HistoryDb db;
+    REQUIRE(db.open(tmp.path));
+
+    std::vector<HistoryRecord> batch{record("a"), record("b"), record("c")};
+    REQUIRE(db.insert_batch(batch));
+    auto entries = db.recent(10);
+    REQUIRE(entries.size() == 3);
+    REQUIRE(entries[0].text == "c");
+    REQUIRE(entries[0].backend == "lan");
+}
@@ -0,0 +1,134 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "audio/input_cleanup.hpp"
+#include "audio/vad.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace {
+
+constexpr uint32_t RATE = 16000;
+
+std::vector<int16_t> tone(size_t n, double amplitude, double offset = 0.0) {
+    std::vector<int16_t> v(n);
+    for (size_t i = 0; i < n; ++i) {
+        v[i] = static_cast<int16_t>(offset + amplitude * std::sin(2.0 * M_PI * 440.0 * i / RATE));
+    }
+    return v;
+}
+
+// White noise, a fan or a busy room.
+std::vector<int16_t> noise(size_t n, int amplitude) {
+    std::vector<int16_t> v(n);
+    uint32_t state = 12345;
+    for (auto& s : v) {
+        state = state * 1664525u + 1013904223u;
+        s = static_cast<int16_t>(static_cast<int>(state >> 16) % (2 * amplitude + 1) - amplitude);
+    }
+    return v;
+}
+
+std::vector<int16_t> join(std::vector<int16_t> a, const std::vector<int16_t>& b) {
+    a.insert(a.end(), b.begin(), b.end());
+    return a;
+}
+
+double level_db(std::span<const int16_t> samples) { return Vad::frame_level_db(samples); }
+
+} // namespace
+
+TEST_CASE("InputCleanup", "[input_cleanup]") {
+    const InputCleanup::Options denoise{.denoise = true};
+
+    SECTION("BackgroundIsPulledDown") {
+        InputCleanup cleanup(RATE, denoise);
+        auto audio = noise(2 * RATE, 600);
+        auto before = level_db(std::span(audio).last(RATE / 2));
+        cleanup.process(audio);
+        auto after = level_db(std::span(audio).last(RATE / 2));
+        REQUIRE(after < before - 12.0);
+        REQUIRE(cleanup.gain_db() < -12.0);
+        REQUIRE(cleanup.noise_floor_db() > -45.0);
+        REQUIRE(cleanup.samples() == 2 * RATE);
+    }
+
+    SECTION("SpeechPassesThrough") {
+        InputCleanup cleanup(RATE, denoise);
+        auto audio = join(noise(RATE, 600), tone(RATE / 2, 8000));
+        auto speech = std::span(audio).subspan(RATE + RATE / 20);
+        auto before = level_db(speech);
+        cleanup.process(audio);
+        REQUIRE(std::abs(level_db(speech) - before) < 0.5);
+        REQUIRE(cleanup.gain_db() == 0.0);
+    }
+
+    SECTION("DcIsRemoved") {
+        InputCleanup cleanup(RATE, denoise);
+        auto audio = tone(RATE, 4000, 6000);
+        cleanup.process(audio);
+        double sum = 0;
+        for (auto s : std::span(audio).last(RATE / 2)) sum += s;
+        REQUIRE(std::abs(sum / (RATE / 2)) < 20.0);
+    }
+
+    SECTION("AgcBringsQuietSpeechUp") {
+        InputCleanup cleanup(RATE, {.agc = true, .target_db = -20.0});
+        auto audio = tone(2 * RATE, 500);
+        cleanup.process(audio);
+        REQUIRE(std::abs(level_db(std::span(audio).last(RATE / 2)) + 20.0) < 1.0);
+        REQUIRE(std::ranges::max(audio) < 32767);
+    }
+
+    SECTION("AgcGainIsCapped") {
+        InputCleanup cleanup(RATE, {.agc = true, .target_db = -20.0, .max_gain_db = 6.0});
+        auto audio = tone(2 * RATE, 500);
+        auto before = level_db(std::span(audio).last(RATE / 2));
+        cleanup.process(audio);
+        REQUIRE(std::abs(level_db(std::span(audio).last(RATE / 2)) - before - 6.0) < 0.5);
+    }
+
+    SECTION("SilenceIsLeftAlone") {
+        InputCleanup cleanup(RATE, {.agc = true});
+        std::vector<int16_t> audio(RATE, 0);
+        cleanup.process(audio);
+        REQUIRE(std::ranges::all_of(audio, [](int16_t s) { return s == 0; }));
+        REQUIRE(cleanup.gain_db() == 0.0);
+    }
+
+    SECTION("ChunkingDoesNotMatter") {
+        const InputCleanup::Options both{.denoise = true, .agc = true};
+        auto source = join(join(noise(RATE / 2, 400), tone(RATE / 2, 1500)), noise(RATE / 2, 400));
+        auto whole = source;
+        InputCleanup(RATE, both).process(whole);
+
+        auto chunked = source;
+        InputCleanup cleanup(RATE, both);
+        size_t sizes[] = {1, 7, 160, 333, 959, 2};
+        for (size_t i = 0, at = 0; at < chunked.size(); ++i) {
+            size_t n = std::min(sizes[i % std::size(sizes)], chunked.size() - at);
+            cleanup.process(std::span(chunked).subspan(at, n));
+            at += n;
+        }
+        REQUIRE(chunked == whole);
+        REQUIRE(cleanup.samples() == source.size());
+    }
+
+    SECTION("ResetStartsOver") {
+        InputCleanup cleanup(RATE, denoise);
+        auto audio = noise(RATE, 600);
+        cleanup.process(audio);
+        cleanup.reset();
+        REQUIRE(cleanup.samples() == 0);
+        REQUIRE(cleanup.gain_db() == 0.0);
+
+        auto first = noise(RATE / 4, 600);
+        auto again = first;
+        InputCleanup(RATE, denoise).process(first);
+        cleanup.process(again);
+        REQUIRE(again == first);
+    }
+}
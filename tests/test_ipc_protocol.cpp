@@ -1,12 +1,16 @@
 #include <catch2/catch_test_macros.hpp>
 
+#include "ipc_protocol.hpp"
 #include "platform/linux/unix_socket_client.hpp"
 #include "platform/linux/unix_socket_server.hpp"
 
+#include <atomic>
+#include <cstdlib>
 #include <filesystem>
 #include <nlohmann/json.hpp>
 #include <string>
 #include <sys/socket.h>
+#include <sys/un.h>
 #include <thread>
 #include <unistd.h>
 
@@ -18,6 +22,19 @@ std::string tmp_socket_path() {
     return "/tmp/sa_test_ipc_" + std::to_string(getpid()) + ".sock";
 }
 
+// A client socket without UnixSocketClient's framing, to write arbitrary bytes.
+int raw_connect(const std::string& path) {
+    int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    path.copy(addr.sun_path, sizeof(addr.sun_path) - 1);
+    if (::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+
 } // namespace
 
 TEST_CASE("IPC protocol", "[ipc]") {
@@ -33,6 +50,63 @@ TEST_CASE("IPC protocol", "[ipc]") {
         }
     }
 
+    SECTION("TakesSocketFromSystemd") {
+        // What systemd hands over: a bound, listening, blocking socket as fd 3.
+        int listener = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        sockaddr_un addr{};
+        addr.sun_family = AF_UNIX;
+        sock_path.copy(addr.sun_path, sizeof(addr.sun_path) - 1);
+        ::unlink(sock_path.c_str());
+        REQUIRE(::bind(listener, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0);
+        REQUIRE(::listen(listener, 4) == 0);
+
+        // A client queued before the daemon was up.
+        UnixSocketClient early;
+        REQUIRE(early.connect(sock_path));
+
+        // (fd 3 may have been free, and so taken by the listener already.)
+        int saved = -1;
+        if (listener != 3) {
+            saved = ::dup(3);
+            REQUIRE(::dup2(listener, 3) == 3);
+            ::close(listener);
+        }
+        ::setenv("LISTEN_PID", std::to_string(getpid()).c_str(), 1);
+        ::setenv("LISTEN_FDS", "1", 1);
+
+        {
+            UnixSocketServer server;
+            REQUIRE(server.start(sock_path));
+            REQUIRE(server.socket_activated());
+            REQUIRE(server.server_fd() == 3);
+            REQUIRE(std::getenv("LISTEN_FDS") == nullptr);
+
+            int client_fd = server.accept_client();
+            REQUIRE(client_fd >= 0);
+            server.close_client(client_fd);
+            // No one waiting: non-blocking, so no hang.
+            REQUIRE(server.accept_client() < 0);
+        }
+        // systemd's socket stays for the next activation.
+        REQUIRE(std::filesystem::exists(sock_path));
+        ::unlink(sock_path.c_str());
+
+        if (saved >= 0) {
+            ::dup2(saved, 3);
+            ::close(saved);
+        }
+    }
+
+    SECTION("IgnoresSocketsForOtherProcesses") {
+        ::setenv("LISTEN_PID", "1", 1);
+        ::setenv("LISTEN_FDS", "1", 1);
+        UnixSocketServer server;
+        REQUIRE(server.start(sock_path));
+        REQUIRE_FALSE(server.socket_activated());
+        REQUIRE(std::getenv("LISTEN_PID") == nullptr);
+        server.stop();
+    }
+
     SECTION("ClientConnects") {
         UnixSocketServer server;
         REQUIRE(server.start(sock_path));
@@ -123,6 +197,256 @@ TEST_CASE("IPC protocol", "[ipc]") {
         server.stop();
     }
 
+    SECTION("PipelinedCommands") {
+        UnixSocketServer server;
+        REQUIRE(server.start(sock_path));
+
+        int raw = raw_connect(sock_path);
+        REQUIRE(raw >= 0);
+        int client_fd = server.accept_client();
+        REQUIRE(client_fd >= 0);
+
+        // Two commands and half of a third in one write, as a script would.
+        std::string third = ipc::encode({{"cmd", "metrics"}}, ipc::Encoding::Cbor);
+        std::string wire = ipc::encode({{"cmd", "start"}}, ipc::Encoding::JsonLines) +
+                           ipc::encode({{"cmd", "status"}}, ipc::Encoding::Cbor) +
+                           third.substr(0, 4);
+        REQUIRE(::send(raw, wire.data(), wire.size(), 0) == static_cast<ssize_t>(wire.size()));
+
+        std::vector<json> cmds;
+        for (int i = 0; i < 50 && cmds.size() < 2; ++i) {
+            REQUIRE(server.read_commands(client_fd, cmds));
+            if (cmds.size() < 2) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        REQUIRE(cmds.size() == 2);
+        REQUIRE(cmds[0]["cmd"] == "start");
+        REQUIRE(cmds[1]["cmd"] == "status");
+
+        // The rest of the third completes it.
+        REQUIRE(::send(raw, third.data() + 4, third.size() - 4, 0) == static_cast<ssize_t>(third.size() - 4));
+        cmds.clear();
+        for (int i = 0; i < 50 && cmds.empty(); ++i) {
+            REQUIRE(server.read_commands(client_fd, cmds));
+            if (cmds.empty()) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        REQUIRE(cmds.size() == 1);
+        REQUIRE(cmds[0]["cmd"] == "metrics");
+
+        // A hangup still hands over what came before it.
+        std::string stop = ipc::encode({{"cmd", "stop"}}, ipc::Encoding::JsonLines);
+        REQUIRE(::send(raw, stop.data(), stop.size(), 0) == static_cast<ssize_t>(stop.size()));
+        ::close(raw);
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        cmds.clear();
+        REQUIRE_FALSE(server.read_commands(client_fd, cmds));
+        REQUIRE(cmds.size() == 1);
+
+        server.close_client(client_fd);
+        server.stop();
+    }
+
+    SECTION("BinaryFrames") {
+        UnixSocketServer server;
+        REQUIRE(server.start(sock_path));
+
+        for (auto enc : {ipc::Encoding::Cbor, ipc::Encoding::MsgPack}) {
+            UnixSocketClient client(enc);
+            REQUIRE(client.connect(sock_path));
+            int client_fd = server.accept_client();
+            REQUIRE(client_fd >= 0);
+
+            REQUIRE(client.send({{"cmd", "toggle"}, {"output", "type"}}));
+            json received;
+            bool got = false;
+            for (int i = 0; i < 50 && !got; ++i) {
+                got = server.read_command(client_fd, received);
+                if (!got) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+            REQUIRE(got);
+            REQUIRE(received["output"] == "type");
+
+            // Answered in the encoding the command came in.
+            REQUIRE(server.send_response(client_fd, {{"status", "ok"}, {"seq", 7}}));
+            json resp;
+            REQUIRE(client.recv(resp, 1000));
+            REQUIRE(resp["seq"] == 7);
+
+            server.close_client(client_fd);
+        }
+        server.stop();
+    }
+
+    SECTION("FrameDecoding") {
+        json msg = {{"cmd", "status"}, {"text", std::string(300, 'x')}};
+        auto frame = ipc::encode(msg, ipc::Encoding::Cbor);
+        REQUIRE(static_cast<uint8_t>(frame[0]) == ipc::FRAME_MAGIC);
+
+        json out;
+        for (size_t n = 0; n < frame.size(); ++n) {
+            REQUIRE(ipc::decode(std::span(frame).first(n), out).status == ipc::DecodeStatus::Incomplete);
+        }
+        auto both = frame + ipc::encode(msg, ipc::Encoding::JsonLines);
+        auto d = ipc::decode(both, out);
+        REQUIRE(d.status == ipc::DecodeStatus::Ok);
+        REQUIRE(d.consumed == frame.size());
+        REQUIRE(d.encoding == ipc::Encoding::Cbor);
+        REQUIRE(out == msg);
+
+        d = ipc::decode(std::span(both).subspan(d.consumed), out);
+        REQUIRE(d.status == ipc::DecodeStatus::Ok);
+        REQUIRE(d.encoding == ipc::Encoding::JsonLines);
+        REQUIRE(out == msg);
+
+        frame[1] = 'X';
+        REQUIRE(ipc::decode(frame, out).status == ipc::DecodeStatus::Invalid);
+        REQUIRE(ipc::decode(std::string("not json\n"), out).status == ipc::DecodeStatus::Invalid);
+    }
+
+    SECTION("SubscribersGetPublishedEvents") {
+        UnixSocketServer server;
+        REQUIRE(server.start(sock_path));
+
+        UnixSocketClient subscriber, other;
+        REQUIRE(subscriber.connect(sock_path));
+        int sub_fd = server.accept_client();
+        REQUIRE(other.connect(sock_path));
+        int other_fd = server.accept_client();
+
+        server.subscribe(sub_fd);
+        server.subscribe(sub_fd);
+        REQUIRE(server.subscriber_count() == 1);
+
+        // Sent back to back; the client splits them again.
+        server.publish({{"event", "partial"}, {"seq", 1}});
+        server.publish({{"event", "partial"}, {"seq", 2}});
+
+        json event;
+        REQUIRE(subscriber.recv(event, 1000));
+        REQUIRE(event["seq"] == 1);
+        REQUIRE(subscriber.recv(event, 1000));
+        REQUIRE(event["seq"] == 2);
+        REQUIRE_FALSE(other.recv(event, 20));
+
+        server.close_client(sub_fd);
+        REQUIRE(server.subscriber_count() == 0);
+        server.close_client(other_fd);
+        server.stop();
+    }
+
+    SECTION("EventsForOneUid") {
+        UnixSocketServer server;
+        REQUIRE(server.start(sock_path));
+
+        UnixSocketClient subscriber;
+        REQUIRE(subscriber.connect(sock_path));
+        int sub_fd = server.accept_client();
+        REQUIRE(server.peer_uid(sub_fd) == ::getuid());
+        server.subscribe(sub_fd);
+
+        // Someone else's result is not for this subscriber; its own is.
+        server.publish({{"event", "result"}, {"seq", 1}}, ::getuid() + 1);
+        server.publish({{"event", "result"}, {"seq", 2}}, ::getuid());
+
+        json event;
+        REQUIRE(subscriber.recv(event, 1000));
+        REQUIRE(event["seq"] == 2);
+        REQUIRE_FALSE(subscriber.recv(event, 20));
+
+        server.close_client(sub_fd);
+        server.stop();
+    }
+
+    SECTION("SendSomeStopsWhenFull") {
+        UnixSocketServer server;
+        REQUIRE(server.start(sock_path));
+        UnixSocketClient client;
+        REQUIRE(client.connect(sock_path));
+        int client_fd = server.accept_client();
+        REQUIRE(client_fd >= 0);
+
+        REQUIRE(server.send_response(client_fd, {{"status", "ok"}}));
+        // Far more than the socket buffers: it takes part and then nothing.
+        std::string rows(8 << 20, 'x');
+        long first = server.send_some(client_fd, rows);
+        REQUIRE(first > 0);
+        REQUIRE(first < static_cast<long>(rows.size()));
+        REQUIRE(server.send_some(client_fd, std::string_view(rows).substr(static_cast<size_t>(first))) == 0);
+
+        // The response, then the raw bytes behind it.
+        json resp;
+        REQUIRE(client.recv(resp, 1000));
+        REQUIRE(resp["status"] == "ok");
+        size_t received = 0;
+        std::string chunk;
+        while (received < static_cast<size_t>(first) && client.recv_bytes(chunk, 1000)) {
+            REQUIRE(chunk.find_first_not_of('x') == std::string::npos);
+            received += chunk.size();
+        }
+        REQUIRE(received == static_cast<size_t>(first));
+
+        // Once the client is gone the write fails instead of blocking.
+        client.close();
+        REQUIRE(server.send_some(client_fd, "x") == -1);
+        server.close_client(client_fd);
+    }
+
+    SECTION("SlowClientGetsWholeResponses") {
+        UnixSocketServer server;
+        REQUIRE(server.start(sock_path));
+        UnixSocketClient client;
+        REQUIRE(client.connect(sock_path));
+        int client_fd = server.accept_client();
+        REQUIRE(client_fd >= 0);
+
+        // More than the socket buffers, while the client reads nothing.
+        json big = {{"status", "ok"}, {"text", std::string(1 << 20, 'a')}};
+        REQUIRE(server.send_response(client_fd, big));
+        REQUIRE(server.send_response(client_fd, {{"status", "second"}}));
+        REQUIRE(server.queued(client_fd) > 0);
+        // Raw bytes wait behind the queue.
+        REQUIRE(server.send_some(client_fd, "raw") == 0);
+
+        // The loop would flush on EPOLLOUT; here, whenever the client has read some.
+        std::atomic<bool> flushed{true};
+        std::jthread flusher([&server, &flushed, client_fd](std::stop_token stop) {
+            while (!stop.stop_requested() && server.queued(client_fd) > 0) {
+                if (!server.flush(client_fd)) flushed = false;
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        });
+        json resp;
+        REQUIRE(client.recv(resp, 2000));
+        REQUIRE(resp["text"].get<std::string>().size() == 1u << 20);
+        REQUIRE(client.recv(resp, 2000));
+        REQUIRE(resp["status"] == "second");
+        flusher.join();
+        REQUIRE(flushed);
+        REQUIRE(server.queued(client_fd) == 0);
+        server.close_client(client_fd);
+    }
+
+    SECTION("ClientTooFarBehindIsCutOff") {
+        UnixSocketServer server;
+        REQUIRE(server.start(sock_path));
+        UnixSocketClient client;
+        REQUIRE(client.connect(sock_path));
+        int client_fd = server.accept_client();
+        REQUIRE(client_fd >= 0);
+        server.subscribe(client_fd);
+
+        json event = {{"event", "level"}, {"pad", std::string(64 << 10, 'x')}};
+        size_t published = 0;
+        while (server.subscriber_count() > 0 && published < 1000) {
+            server.publish(event);
+            ++published;
+        }
+        REQUIRE(server.subscriber_count() == 0);
+        REQUIRE(published * (64 << 10) > UnixSocketServer::MAX_QUEUED_BYTES);
+        REQUIRE(server.queued(client_fd) == 0);
+        REQUIRE_FALSE(server.send_response(client_fd, {{"status", "ok"}}));
+        server.close_client(client_fd);
+    }
+
     SECTION("ClientDisconnect") {
         UnixSocketServer server;
         REQUIRE(server.start(sock_path));
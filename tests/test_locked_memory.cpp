@@ -0,0 +1,71 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "platform/cpu_affinity.hpp"
+#include "platform/linux/locked_memory.hpp"
+#include "ring_buffer.hpp"
+
+#include <cstdint>
+#include <sched.h>
+#include <vector>
+
+TEST_CASE("LockedMemory", "[locked_memory]") {
+    SECTION("NothingAskedForNothingMapped") {
+        LockedMemory none(0, true);
+        REQUIRE(none.data().empty());
+        REQUIRE_FALSE(none.locked());
+        REQUIRE_FALSE(none.hugepages());
+    }
+
+    SECTION("MapsAtLeastWhatWasAsked") {
+        LockedMemory memory(10000, false);
+        REQUIRE(memory.data().size() >= 10000);
+        // Locked, or else faulted in: readable and writable either way.
+        REQUIRE((memory.locked() || !memory.error().empty()));
+        REQUIRE(memory.data()[9999] == 0);
+        memory.data()[9999] = 0x5a;
+        REQUIRE(memory.data()[9999] == 0x5a);
+    }
+
+    SECTION("HugepagesAreAligned") {
+        LockedMemory memory(3 << 20, true);
+        REQUIRE(memory.data().size() == 2 * LockedMemory::HUGEPAGE_BYTES);
+        REQUIRE(reinterpret_cast<uintptr_t>(memory.data().data()) % LockedMemory::HUGEPAGE_BYTES == 0);
+    }
+
+    SECTION("HoldsARingBuffer") {
+        LockedMemory memory(RingBuffer::storage_bytes(4096, 256), false);
+        RingBuffer rb(4096, 256, memory.data());
+        REQUIRE(rb.preallocated());
+        std::vector<uint8_t> data(4096, 0x33), out(4096);
+        REQUIRE(rb.write(data.data(), data.size()) == 4096);
+        REQUIRE(rb.read(out.data(), out.size()) == 4096);
+        REQUIRE(out == data);
+    }
+}
+
+TEST_CASE("Pinning threads", "[locked_memory]") {
+    cpu_set_t before;
+    REQUIRE(sched_getaffinity(0, sizeof(before), &before) == 0);
+
+    SECTION("NoCpusNothingToDo") {
+        REQUIRE(platform::pin_current_thread({}).has_value());
+    }
+
+    SECTION("BadCpuIsAnError") {
+        REQUIRE_FALSE(platform::pin_current_thread({-1}).has_value());
+        REQUIRE_FALSE(platform::pin_current_thread({CPU_SETSIZE}).has_value());
+    }
+
+    SECTION("PinsToACpuWeMayUse") {
+        int cpu = 0;
+        while (!CPU_ISSET(cpu, &before)) ++cpu;
+        REQUIRE(platform::pin_current_thread({cpu}).has_value());
+
+        cpu_set_t now;
+        REQUIRE(sched_getaffinity(0, sizeof(now), &now) == 0);
+        REQUIRE(CPU_COUNT(&now) == 1);
+        REQUIRE(CPU_ISSET(cpu, &now));
+    }
+
+    sched_setaffinity(0, sizeof(before), &before);
+}
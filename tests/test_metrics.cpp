@@ -0,0 +1,98 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "metrics.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <thread>
+
+namespace {
+
+// Percentiles come from log buckets about 9% wide.
+bool near(double actual, double expected) {
+    return std::abs(actual - expected) <= expected * 0.05;
+}
+
+} // namespace
+
+TEST_CASE("LatencyHistogram", "[metrics]") {
+    SECTION("EmptyIsZero") {
+        LatencyHistogram h;
+        REQUIRE(h.count() == 0);
+        REQUIRE(h.percentile(0.5) == 0.0);
+        REQUIRE(h.mean() == 0.0);
+    }
+
+    SECTION("SingleValueIsExact") {
+        LatencyHistogram h;
+        h.add(0.42);
+        // Clamped to the observed range, so one sample reads back as itself.
+        REQUIRE(h.percentile(0.5) == 0.42);
+        REQUIRE(h.percentile(0.99) == 0.42);
+        REQUIRE(h.max() == 0.42);
+    }
+
+    SECTION("Percentiles") {
+        LatencyHistogram h;
+        // 1ms .. 1000ms in 1ms steps
+        for (int i = 1; i <= 1000; ++i) h.add(i / 1000.0);
+
+        REQUIRE(h.count() == 1000);
+        CHECK(near(h.percentile(0.50), 0.500));
+        CHECK(near(h.percentile(0.95), 0.950));
+        CHECK(near(h.percentile(0.99), 0.990));
+        CHECK(near(h.percentile(1.0), 1.0));
+        CHECK(near(h.mean(), 0.5005));
+    }
+
+    SECTION("TailDominatesHighPercentiles") {
+        LatencyHistogram h;
+        for (int i = 0; i < 98; ++i) h.add(0.1);
+        h.add(5.0);
+        h.add(5.0);
+        CHECK(near(h.percentile(0.50), 0.1));
+        CHECK(near(h.percentile(0.99), 5.0));
+    }
+
+    SECTION("OutOfRangeValuesAreClamped") {
+        LatencyHistogram h;
+        h.add(0.0);
+        h.add(-1.0);
+        h.add(1e6);
+        REQUIRE(h.count() == 3);
+        CHECK(h.percentile(0.0) < LatencyHistogram::MIN_S * 2);
+        CHECK(h.percentile(1.0) == 1e6);
+    }
+}
+
+TEST_CASE("Metrics", "[metrics]") {
+    SECTION("UnsetStagesNotCounted") {
+        Metrics m;
+        m.record(StageTimings{.upload_s = 0.2, .total_s = 1.0});
+        m.record(StageTimings{.connect_s = 0.0, .upload_s = 0.4, .total_s = 2.0});
+
+        REQUIRE(m.transcriptions() == 2);
+        for (size_t i = 0; i < STAGES.size(); ++i) {
+            std::string name = STAGES[i].name;
+            if (name == "upload" || name == "total") {
+                CHECK(m.stage(i).count() == 2);
+            } else if (name == "connect") {
+                // A reused connection is a real 0, not a missing stage.
+                CHECK(m.stage(i).count() == 1);
+            } else {
+                CHECK(m.stage(i).count() == 0);
+            }
+        }
+    }
+
+    SECTION("StageSpanWritesOnScopeExit") {
+        std::optional<double> out;
+        {
+            StageSpan span(out);
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+            REQUIRE_FALSE(out);
+        }
+        REQUIRE(out);
+        CHECK(*out >= 0.005);
+    }
+}
@@ -0,0 +1,127 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "output/output_router.hpp"
+
+#include <string>
+#include <vector>
+
+namespace {
+
+struct NullOutput : OutputMethod {
+    std::expected<void, std::string> deliver(const std::string&) override { return {}; }
+};
+
+WindowInfo app(std::string app_id) {
+    return {.app_id = std::move(app_id)};
+}
+
+} // namespace
+
+TEST_CASE("OutputRouter", "[output_router]") {
+    Config::Output config;
+    std::vector<OutputStrategy> made;
+    auto factory = [&made](const OutputStrategy& s) {
+        made.push_back(s);
+        return std::make_unique<NullOutput>();
+    };
+    const OutputStrategy paste{.delivery = Delivery::Paste};
+    const OutputStrategy shift_paste{.delivery = Delivery::Paste, .shift = true};
+    const OutputStrategy type{.delivery = Delivery::Type};
+    const OutputStrategy clipboard{.delivery = Delivery::Clipboard};
+
+    SECTION("TerminalsPasteWithShift") {
+        OutputRouter router(config, factory);
+        REQUIRE(router.choose("type", app("kitty")) == shift_paste);
+        REQUIRE(router.choose("type", app("org.codeberg.dnkl.Foot")) == shift_paste);
+        REQUIRE(router.choose("type", {.window_class = "Alacritty"}) == shift_paste);
+        REQUIRE(router.choose("type", app("firefox")) == paste);
+        REQUIRE(router.choose("type", {}) == paste);
+        // Asked for the clipboard, that is what it gets, terminal or not.
+        REQUIRE(router.choose("clipboard", app("kitty")) == clipboard);
+        REQUIRE(router.choose("none", app("kitty")).delivery == Delivery::None);
+    }
+
+    SECTION("ConfiguredRulesComeFirst") {
+        config.apps = {
+            {.app_id = "Emacs", .method = "type"},
+            {.app_id = "kitty", .method = "clipboard"},
+            {.app_id = "ghostty", .paste_keys = "Ctrl+Shift+V"},
+        };
+        config.fallback = "clipboard";
+        OutputRouter router(config, factory);
+        REQUIRE(router.choose("type", app("emacs")) == type);
+        REQUIRE(router.choose("type", app("kitty")) == clipboard);
+        REQUIRE(router.choose("type", app("com.mitchellh.ghostty")) == shift_paste);
+        REQUIRE(router.choose("type", app("alacritty")) == shift_paste);
+        REQUIRE(router.choose("type", app("firefox")) == clipboard);
+    }
+
+    SECTION("ConfigureReplacesTheRules") {
+        OutputRouter router(config, factory);
+        auto* output = router.output(paste);
+        router.record(app("emacs"), paste, 0.010, true);
+        REQUIRE(router.choose("type", app("emacs")) == paste);
+
+        config.apps = {{.app_id = "emacs", .method = "type"}};
+        router.configure(config);
+        REQUIRE(router.choose("type", app("emacs")) == type);
+        REQUIRE(router.stats(app("emacs"), Delivery::Paste).deliveries == 0);
+        REQUIRE(router.output(paste) == output);
+    }
+
+    SECTION("OutputsAreMadeOncePerStrategy") {
+        OutputRouter router(config, factory);
+        auto* first = router.output(paste);
+        REQUIRE(first != nullptr);
+        REQUIRE(router.output(paste) == first);
+        REQUIRE(router.output(shift_paste) != first);
+        router.output(shift_paste);
+        router.output(clipboard);
+        REQUIRE(made == std::vector<OutputStrategy>{paste, shift_paste, clipboard});
+
+        REQUIRE(router.output({.delivery = Delivery::None}) == nullptr);
+        REQUIRE(made.size() == 3);
+
+        OutputRouter none(config, {});
+        REQUIRE(none.output(paste) == nullptr);
+    }
+
+    SECTION("AutoTriesEachThenPicksTheFastest") {
+        config.fallback = "auto";
+        OutputRouter router(config, factory);
+        auto editor = app("gedit");
+
+        REQUIRE(router.choose("type", editor) == paste);
+        router.record(editor, paste, 0.050, true);
+        REQUIRE(router.choose("type", editor) == type);
+        router.record(editor, type, 0.020, true);
+        REQUIRE(router.choose("type", editor) == type);
+        REQUIRE(router.stats(editor, Delivery::Type).latency_s == 0.020);
+
+        // Typing slows down (long texts): the average follows, pasting wins.
+        for (int i = 0; i < 8; ++i) router.record(editor, type, 0.200, true);
+        REQUIRE(router.stats(editor, Delivery::Type).latency_s > 0.050);
+        REQUIRE(router.choose("type", editor) == paste);
+        REQUIRE(router.stats(editor, Delivery::Type).deliveries == 9);
+
+        // Other apps learn on their own; terminals keep their rule.
+        REQUIRE(router.choose("type", app("gimp")) == paste);
+        REQUIRE(router.choose("type", app("kitty")) == shift_paste);
+    }
+
+    SECTION("AutoSkipsWhatFails") {
+        config.fallback = "auto";
+        OutputRouter router(config, factory);
+        auto editor = app("gedit");
+
+        router.record(editor, paste, 0.010, true);
+        router.record(editor, type, 0.100, false);
+        REQUIRE_FALSE(router.stats(editor, Delivery::Type).reliable());
+        REQUIRE(router.choose("type", editor) == paste);
+
+        router.record(editor, paste, 0.010, false);
+        REQUIRE_FALSE(router.stats(editor, Delivery::Paste).reliable());
+        // Nothing works reliably: back to pasting.
+        REQUIRE(router.choose("type", editor) == paste);
+    }
+}
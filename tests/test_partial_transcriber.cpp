@@ -0,0 +1,116 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "whisper/partial_transcriber.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// Answers with the next scripted text, taking `delay` to do so.
+class ScriptedBackend : public WhisperBackend {
+public:
+    explicit ScriptedBackend(std::vector<std::string> texts) : texts(std::move(texts)) {}
+
+    std::expected<TranscriptResult, std::string>
+    transcribe(std::span<const int16_t> audio, uint32_t sample_rate) override {
+        std::this_thread::sleep_for(delay);
+        sizes.push_back(audio.size());
+        return TranscriptResult{
+            .text = texts.at(std::min(calls++, texts.size() - 1)),
+            .duration_s = static_cast<double>(audio.size()) / sample_rate,
+            .processing_s = std::chrono::duration<double>(delay).count(),
+        };
+    }
+
+    std::vector<std::string> texts;
+    std::vector<size_t> sizes;
+    size_t calls = 0;
+    std::chrono::milliseconds delay{0};
+};
+
+std::optional<PartialTranscriber::Hypothesis> wait_for(PartialTranscriber& pt) {
+    for (int i = 0; i < 500 && pt.busy(); ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return pt.take();
+}
+
+} // namespace
+
+TEST_CASE("PartialTranscriber", "[partial]") {
+    std::vector<int16_t> audio(16000, 100);
+
+    SECTION("StablePrefixIsWhatTwoHypothesesAgreeOn") {
+        ScriptedBackend backend({"open the", "open the door", "open a door please"});
+        PartialTranscriber pt(backend, 16000, 0);
+
+        pt.start(audio, "");
+        auto h = wait_for(pt);
+        REQUIRE(h);
+        REQUIRE(h->text == "open the");
+        REQUIRE(h->stable.empty());
+        REQUIRE(h->audio_s == 1.0);
+
+        pt.start(audio, "");
+        h = wait_for(pt);
+        REQUIRE(h->text == "open the door");
+        REQUIRE(h->stable == "open the");
+
+        pt.start(audio, "");
+        h = wait_for(pt);
+        REQUIRE(h->stable == "open");
+    }
+
+    SECTION("PrefixIsPrepended") {
+        ScriptedBackend backend({"world"});
+        PartialTranscriber pt(backend, 16000, 0);
+        pt.start(audio, "hello");
+        auto h = wait_for(pt);
+        REQUIRE(h->text == "hello world");
+    }
+
+    SECTION("NotDueWhileBusyOrBeforeInterval") {
+        ScriptedBackend backend({"a"});
+        backend.delay = std::chrono::milliseconds(20);
+        PartialTranscriber pt(backend, 16000, 10'000);
+        auto now = std::chrono::steady_clock::now();
+        REQUIRE(pt.due(now));
+
+        pt.start(audio, "");
+        REQUIRE_FALSE(pt.due(std::chrono::steady_clock::now()));
+        REQUIRE(wait_for(pt));
+        REQUIRE_FALSE(pt.due(std::chrono::steady_clock::now()));
+        REQUIRE(pt.due(std::chrono::steady_clock::now() + std::chrono::seconds(10)));
+    }
+
+    SECTION("SlowBackendStretchesInterval") {
+        ScriptedBackend backend({"a"});
+        backend.delay = std::chrono::milliseconds(30);
+        PartialTranscriber pt(backend, 16000, 10);
+        pt.start(audio, "");
+        REQUIRE(wait_for(pt));
+        REQUIRE(pt.interval() >= std::chrono::milliseconds(60));
+    }
+
+    SECTION("CancelledResultIsDropped") {
+        ScriptedBackend backend({"too late"});
+        backend.delay = std::chrono::milliseconds(20);
+        PartialTranscriber pt(backend, 16000, 0);
+        pt.start(audio, "");
+        pt.cancel();
+        REQUIRE_FALSE(wait_for(pt));
+    }
+
+    SECTION("CommonPrefix") {
+        using partial::common_prefix;
+        using partial::split_words;
+        REQUIRE(split_words("  a  b c ") == std::vector<std::string>{"a", "b", "c"});
+        REQUIRE(common_prefix(split_words("a b c"), split_words("a b d")) == "a b");
+        REQUIRE(common_prefix(split_words("a b"), split_words("x")).empty());
+        REQUIRE(common_prefix({}, split_words("a")).empty());
+    }
+}
@@ -0,0 +1,75 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "platform/linux/proc_event_tracker.hpp"
+#include "platform/linux/procfs_detector.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <csignal>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+
+namespace {
+
+// Applies events until pred holds, for up to a second.
+template <typename Pred>
+bool wait_for(ProcEventTracker& tracker, Pred pred) {
+    for (int i = 0; i < 100; ++i) {
+        tracker.read_events();
+        if (pred()) return true;
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return false;
+}
+
+bool has_child(const ProcEventTracker& tracker, int parent, int child) {
+    auto* children = tracker.children(parent);
+    return children && std::ranges::find(*children, child) != children->end();
+}
+
+} // namespace
+
+TEST_CASE("ProcEventTracker", "[agent]") {
+    ProcEventTracker tracker;
+    if (!tracker.start()) {
+        SKIP("proc connector needs CAP_NET_ADMIN");
+    }
+
+    SECTION("InitialScanIndexesSelf") {
+        REQUIRE(tracker.process_count() > 1);
+        REQUIRE(has_child(tracker, getppid(), getpid()));
+        REQUIRE_FALSE(tracker.comm(getpid()).empty());
+    }
+
+    SECTION("FollowsForkExecExit") {
+        pid_t child = fork();
+        REQUIRE(child >= 0);
+        if (child == 0) {
+            execlp("sleep", "sleep", "10", nullptr);
+            _exit(127);
+        }
+
+        REQUIRE(wait_for(tracker, [&] {
+            return has_child(tracker, getpid(), child) && tracker.comm(child) == "sleep";
+        }));
+
+        ProcfsDetector detector({"sleep"});
+        detector.use_tracker(&tracker);
+        REQUIRE(detector.detect(getpid()).agent == "sleep");
+
+        kill(child, SIGKILL);
+        waitpid(child, nullptr, 0);
+        REQUIRE(wait_for(tracker, [&] { return !has_child(tracker, getpid(), child); }));
+        REQUIRE(tracker.children(child) == nullptr);
+        REQUIRE(detector.detect(getpid()).agent.empty());
+    }
+
+    SECTION("ThreadsAreNotProcesses") {
+        std::jthread worker([] { std::this_thread::sleep_for(std::chrono::milliseconds(50)); });
+        tracker.read_events();
+        auto* children = tracker.children(getpid());
+        REQUIRE(children != nullptr);
+        REQUIRE(children->empty());
+    }
+}
@@ -0,0 +1,118 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "text/prompt_builder.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// A small project tree, removed again at the end.
+struct TmpProject {
+    fs::path root = fs::temp_directory_path() / ("sa_test_prompt_" + std::to_string(getpid()));
+
+    TmpProject() {
+        fs::remove_all(root);
+        fs::create_directories(root / "src");
+        fs::create_directories(root / "node_modules" / "leftpad");
+        write("src/daemon_core.cpp", "void DaemonCore::handle_start() { ring_buf_.clear(); }\n");
+        write("src/session.cpp", "Session::Session() { DaemonCore* core; ring_buf_ = nullptr; }\n");
+        write("node_modules/leftpad/index.js", "function leftPadString() {}\n");
+        write("notes.txt", "someIdentifier in a text file\n");
+    }
+
+    ~TmpProject() { fs::remove_all(root); }
+
+    void write(const std::string& name, const std::string& content) {
+        std::ofstream(root / name) << content;
+    }
+
+    std::string dir() const { return root.string(); }
+};
+
+bool contains(const std::vector<std::string>& terms, const std::string& term) {
+    return std::ranges::find(terms, term) != terms.end();
+}
+
+} // namespace
+
+TEST_CASE("PromptBuilder", "[prompt]") {
+    TmpProject project;
+    PromptBuilder::Options options;
+
+    SECTION("ScanFindsIdentifiersAndNames") {
+        PromptBuilder::Fingerprint seen;
+        auto terms = PromptBuilder::scan(project.dir(), options, seen);
+        REQUIRE(contains(terms, "DaemonCore"));
+        REQUIRE(contains(terms, "ring_buf_"));
+        REQUIRE(contains(terms, "handle_start"));
+        REQUIRE(contains(terms, "daemon_core"));  // file name
+        // In two files, so ahead of what is only in one.
+        auto rank = [&](const std::string& t) { return std::ranges::find(terms, t) - terms.begin(); };
+        REQUIRE(rank("DaemonCore") < rank("handle_start"));
+
+        REQUIRE_FALSE(contains(terms, "leftPadString"));   // skipped directory
+        REQUIRE_FALSE(contains(terms, "someIdentifier"));  // not source
+        REQUIRE_FALSE(contains(terms, "void"));            // plain word
+        REQUIRE_FALSE(seen.empty());
+    }
+
+    SECTION("MaxTerms") {
+        options.max_terms = 2;
+        PromptBuilder::Fingerprint seen;
+        REQUIRE(PromptBuilder::scan(project.dir(), options, seen).size() == 2);
+    }
+
+    SECTION("FingerprintNoticesChanges") {
+        PromptBuilder::Fingerprint seen;
+        PromptBuilder::scan(project.dir(), options, seen);
+        REQUIRE(PromptBuilder::unchanged(seen));
+
+        fs::last_write_time(project.root / "src" / "session.cpp",
+                            fs::file_time_type::clock::now() + std::chrono::seconds(5));
+        REQUIRE_FALSE(PromptBuilder::unchanged(seen));
+    }
+
+    SECTION("MissingDirectory") {
+        PromptBuilder::Fingerprint seen;
+        REQUIRE(PromptBuilder::scan(project.dir() + "/nope", options, seen).empty());
+        REQUIRE(seen.empty());
+    }
+
+    SECTION("PrefetchFillsCacheInBackground") {
+        PromptBuilder builder(options);
+        REQUIRE(builder.prompt(project.dir()).empty());
+
+        builder.prefetch(project.dir());
+        std::string prompt;
+        for (int i = 0; i < 500 && prompt.empty(); ++i) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+            prompt = builder.prompt(project.dir());
+        }
+        REQUIRE(prompt.starts_with("Glossary: "));
+        REQUIRE(prompt.find("DaemonCore") != std::string::npos);
+        REQUIRE(prompt.size() <= PromptBuilder::MAX_PROMPT_CHARS);
+    }
+
+    SECTION("RememberedTranscriptComesLast") {
+        PromptBuilder builder(options);
+        builder.remember(project.dir(), "restart the daemon");
+        REQUIRE(builder.prompt(project.dir()) == "restart the daemon");
+        REQUIRE(builder.prompt("/elsewhere").empty());
+        REQUIRE(builder.prompt("").empty());
+
+        std::string long_text;
+        for (int i = 0; i < 100; ++i) long_text += "word" + std::to_string(i) + " ";
+        builder.remember(project.dir(), long_text);
+        auto prompt = builder.prompt(project.dir());
+        REQUIRE(prompt.size() <= PromptBuilder::MAX_HISTORY_CHARS);
+        REQUIRE(prompt.starts_with("word"));
+    }
+}
@@ -0,0 +1,128 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "text/post_processor.hpp"
+#include "text/replacer.hpp"
+
+#include <format>
+#include <string>
+#include <vector>
+
+TEST_CASE("Replacer", "[postprocess]") {
+    using Rules = std::vector<Replacer::Rule>;
+
+    SECTION("WholeWordsOnly") {
+        Rules rules{{"cube control", "kubectl"}, {"get", "GET"}};
+        Replacer r(rules);
+        REQUIRE(r.apply("run cube control get pods") == "run kubectl GET pods");
+        REQUIRE(r.apply("cube controls target") == "cube controls target");
+        REQUIRE(r.apply("forget it") == "forget it");
+        REQUIRE(r.apply("get") == "GET");
+    }
+
+    SECTION("CaseInsensitive") {
+        Rules rules{{"Cube Control", "kubectl"}};
+        Replacer r(rules);
+        REQUIRE(r.apply("CUBE control, then") == "kubectl, then");
+    }
+
+    SECTION("LeftmostThenLongest") {
+        Rules rules{{"new", "N"}, {"new york", "NY"}, {"york city", "YC"}};
+        Replacer r(rules);
+        REQUIRE(r.apply("new york city") == "NY city");
+        REQUIRE(r.apply("a new car") == "a N car");
+    }
+
+    SECTION("OverlappingSuffixes") {
+        // "she" and "he" end at the same byte; "he" alone is not a word there.
+        Rules rules{{"she", "SHE"}, {"he", "HE"}, {"hers", "HERS"}};
+        Replacer r(rules);
+        REQUIRE(r.apply("she said he has hers") == "SHE said HE has HERS");
+    }
+
+    SECTION("LaterRuleOverrides") {
+        Rules rules{{"foo", "a"}, {"FOO", "b"}};
+        Replacer r(rules);
+        REQUIRE(r.rule_count() == 1);
+        REQUIRE(r.apply("foo") == "b");
+    }
+
+    SECTION("PunctuationAttaches") {
+        Replacer r(voice_command_rules());
+        REQUIRE(r.apply("hello comma world full stop") == "hello, world.");
+        REQUIRE(r.apply("first new line second") == "first\nsecond");
+        REQUIRE(r.apply("really question mark") == "really?");
+    }
+
+    SECTION("NonAsciiIsPartOfWords") {
+        Rules rules{{"cafe", "CAFE"}};
+        Replacer r(rules);
+        REQUIRE(r.apply("cafe café cafés") == "CAFE café cafés");
+    }
+
+    SECTION("EmptyAndUnmatched") {
+        Replacer none;
+        REQUIRE(none.empty());
+        REQUIRE(none.apply("text") == "text");
+
+        Rules rules{{"  ", "x"}, {"abc", "x"}};
+        Replacer r(rules);
+        REQUIRE(r.rule_count() == 1);
+        REQUIRE(r.apply("") == "");
+        REQUIRE(r.apply("nothing here") == "nothing here");
+    }
+
+    SECTION("ThousandsOfRules") {
+        Rules rules;
+        for (int i = 0; i < 5000; ++i) rules.push_back({std::format("word{}", i), std::format("W{}", i)});
+        Replacer r(rules);
+        REQUIRE(r.apply("say word42 and word4999 not word50000") ==
+                "say W42 and W4999 not word50000");
+    }
+
+    SECTION("PiecesJoinLikeTheWhole") {
+        // Streamed segments go out one at a time: "comma" starts one and
+        // "new line" ends the one before it.
+        Replacer r(voice_command_rules());
+        std::vector<std::string> segments = {"dear team", "comma new line", "the build is green new line",
+                                             "ship it full stop"};
+        std::string whole, shown;
+        for (auto& segment : segments) {
+            std::string piece = whole.empty() ? segment : " " + segment;
+            whole += piece;
+            shown += r.apply_next(shown, piece);
+        }
+        REQUIRE(shown == r.apply(whole));
+        REQUIRE(shown == "dear team,\nthe build is green\nship it.");
+    }
+}
+
+TEST_CASE("PostProcessor", "[postprocess]") {
+    Config::PostProcess config;
+    config.replace = {{"speak anywhere", "speak-anywhere"}};
+    config.apps = {
+        {.app_id = "", .agent = "claude", .replace = {{"cube control", "kubectl"}}},
+        {.app_id = "Firefox", .agent = "", .replace = {{"speak anywhere", "Speak Anywhere"}}},
+    };
+    PostProcessor post(config);
+    std::string text = "speak anywhere cube control";
+
+    SECTION("GlobalRulesEverywhere") {
+        REQUIRE(post.apply(text, WindowInfo{.app_id = "kitty"}) == "speak-anywhere cube control");
+    }
+
+    SECTION("SetSelectedByAgent") {
+        REQUIRE(post.apply(text, WindowInfo{.app_id = "kitty", .agent = "claude"}) ==
+                "speak-anywhere kubectl");
+    }
+
+    SECTION("SetOverridesGlobalByClass") {
+        REQUIRE(post.apply(text, WindowInfo{.window_class = "firefox"}) ==
+                "Speak Anywhere cube control");
+    }
+
+    SECTION("VoiceCommandsAreOptIn") {
+        REQUIRE(post.apply("a comma b", WindowInfo{}) == "a comma b");
+        config.voice_commands = true;
+        REQUIRE(PostProcessor(config).apply("a comma b", WindowInfo{}) == "a, b");
+    }
+}
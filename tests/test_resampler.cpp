@@ -0,0 +1,144 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "audio/resampler.hpp"
+#include "audio/simd.hpp"
+
+#include <cmath>
+#include <cstdint>
+#include <numbers>
+#include <vector>
+
+namespace {
+
+// Interleaved frames with the same tone on every channel.
+std::vector<float> tone(uint32_t rate, uint32_t channels, double hz, double seconds, float amp = 0.5f) {
+    size_t frames = static_cast<size_t>(rate * seconds);
+    std::vector<float> v(frames * channels);
+    for (size_t f = 0; f < frames; ++f) {
+        float s = amp * static_cast<float>(std::sin(2 * std::numbers::pi * hz * static_cast<double>(f) / rate));
+        for (uint32_t c = 0; c < channels; ++c) v[f * channels + c] = s;
+    }
+    return v;
+}
+
+// RMS past the filter's start-up.
+double rms(const std::vector<float>& v, size_t skip = 200) {
+    double sum = 0;
+    for (size_t i = skip; i < v.size(); ++i) sum += static_cast<double>(v[i]) * v[i];
+    return std::sqrt(sum / static_cast<double>(v.size() - skip));
+}
+
+} // namespace
+
+TEST_CASE("Resampler", "[resampler]") {
+
+    SECTION("OutputLengthFollowsRatio") {
+        for (uint32_t rate : {48000u, 44100u, 32000u, 16000u}) {
+            Resampler r(rate, 16000, 2);
+            std::vector<float> out;
+            r.process(tone(rate, 2, 440, 1.0), out);
+            CHECK(out.size() > 16000 - Resampler::DEFAULT_TAPS);
+            CHECK(out.size() <= 16000);
+        }
+    }
+
+    SECTION("PassesSpeechBand") {
+        Resampler r(48000, 16000, 2);
+        std::vector<float> out;
+        r.process(tone(48000, 2, 1000, 0.5), out);
+        double level = rms(out) / (0.5 / std::sqrt(2.0));
+        CHECK(level > 0.97);
+        CHECK(level < 1.03);
+    }
+
+    SECTION("RejectsAboveOutputNyquist") {
+        // 12 kHz would alias to 4 kHz at 16 kHz without the low-pass.
+        Resampler r(48000, 16000, 1);
+        std::vector<float> out;
+        r.process(tone(48000, 1, 12000, 0.5), out);
+        CHECK(rms(out) < 0.5 * 0.01);  // below -40 dB
+    }
+
+    SECTION("ChunkingDoesNotChangeOutput") {
+        auto in = tone(44100, 2, 700, 0.3);
+        Resampler whole(44100, 16000, 2);
+        Resampler pieces(44100, 16000, 2);
+        std::vector<float> a, b;
+        whole.process(in, a);
+        for (size_t i = 0; i < in.size();) {
+            size_t n = std::min<size_t>(2 * 37, in.size() - i);  // 37 frames
+            pieces.process(std::span<const float>(in).subspan(i, n), b);
+            i += n;
+        }
+        REQUIRE(a == b);
+    }
+
+    SECTION("DownmixCancelsOppositeChannels") {
+        auto in = tone(48000, 2, 1000, 0.2);
+        for (size_t i = 1; i < in.size(); i += 2) in[i] = -in[i];
+        Resampler r(48000, 16000, 2);
+        std::vector<int16_t> out;
+        r.process(in, out);
+        REQUIRE_FALSE(out.empty());
+        for (int16_t s : out) REQUIRE(s == 0);
+    }
+
+    SECTION("Int16OutputSaturates") {
+        Resampler r(16000, 16000, 1);
+        std::vector<float> in(2000, 2.0f);
+        std::vector<int16_t> out;
+        r.process(in, out);
+        CHECK(out.back() == 32767);
+    }
+}
+
+TEST_CASE("SIMD float kernels", "[simd]") {
+
+    SECTION("DotMatchesScalar") {
+        std::vector<float> a(103), b(103);
+        double expected = 0;
+        for (size_t i = 0; i < a.size(); ++i) {
+            a[i] = static_cast<float>(i % 7) - 3;
+            b[i] = static_cast<float>(i % 5) * 0.5f;
+            expected += static_cast<double>(a[i]) * b[i];
+        }
+        REQUIRE(audio::dot(a.data(), b.data(), a.size()) == static_cast<float>(expected));
+    }
+
+    SECTION("DownmixAveragesChannels") {
+        std::vector<float> in;
+        for (int f = 0; f < 11; ++f) {
+            in.push_back(static_cast<float>(f));
+            in.push_back(static_cast<float>(f) + 1);
+        }
+        std::vector<float> out(11);
+        audio::downmix(in, 2, out.data());
+        for (int f = 0; f < 11; ++f) REQUIRE(out[f] == static_cast<float>(f) + 0.5f);
+
+        std::vector<float> three = {1, 2, 3, 4, 5, 6};
+        audio::downmix(three, 3, out.data());
+        REQUIRE(out[0] == 2);
+        REQUIRE(out[1] == 5);
+    }
+
+    SECTION("ToInt16RoundsAndClamps") {
+        std::vector<float> in = {0.0f, 0.5f, -0.5f, 1.0f, -1.0f, 1.5f, -1.5f, 1.0f / 32768, 0.25f, -2.0f};
+        std::vector<int16_t> out(in.size());
+        audio::to_int16(in.data(), in.size(), out.data());
+        REQUIRE(out == std::vector<int16_t>{0, 16384, -16384, 32767, -32768, 32767, -32768, 1, 8192, -32768});
+    }
+
+    SECTION("ToFloatRoundTrips") {
+        std::vector<int16_t> in(1001);
+        for (size_t i = 0; i < in.size(); ++i) in[i] = static_cast<int16_t>((i * 7919) % 65536 - 32768);
+        std::vector<float> pcm;
+        audio::append_float(pcm, std::span<const int16_t>(in).first(500));
+        audio::append_float(pcm, std::span<const int16_t>(in).subspan(500));
+        REQUIRE(pcm.size() == in.size());
+        REQUIRE(pcm[0] == static_cast<float>(in[0]) / 32768.0f);
+
+        std::vector<int16_t> back(in.size());
+        audio::to_int16(pcm.data(), pcm.size(), back.data());
+        REQUIRE(back == in);
+    }
+}
@@ -5,6 +5,7 @@
 #include <algorithm>
 #include <cstdint>
 #include <numeric>
+#include <thread>
 #include <vector>
 
 TEST_CASE("RingBuffer", "[ring_buffer]") {
@@ -114,3 +115,173 @@ TEST_CASE("RingBuffer", "[ring_buffer]") {
         REQUIRE(rb.available() == 0);
     }
 }
+
+TEST_CASE("RingBuffer readable spans", "[ring_buffer]") {
+    RingBuffer rb(16);
+
+    SECTION("ContiguousSpan") {
+        uint8_t data[5] = {1, 2, 3, 4, 5};
+        rb.write(data, sizeof(data));
+
+        auto spans = rb.readable_spans();
+        REQUIRE(spans.size() == 1);
+        REQUIRE(spans[0].size() == 5);
+        REQUIRE(spans[0][4] == 5);
+        // Peeking does not consume
+        REQUIRE(rb.available() == 5);
+
+        rb.consume(5);
+        REQUIRE(rb.available() == 0);
+    }
+
+    SECTION("WrappedSpans") {
+        std::vector<uint8_t> fill(12, 0);
+        rb.write(fill.data(), fill.size());
+        uint8_t sink[12];
+        rb.read(sink, sizeof(sink));
+
+        std::vector<uint8_t> data(8);
+        std::iota(data.begin(), data.end(), uint8_t(10));
+        rb.write(data.data(), data.size());
+
+        // The capacity is a single chunk, so the data continues in a second.
+        auto spans = rb.readable_spans();
+        REQUIRE(spans.size() == 2);
+        REQUIRE(spans[0].size() == 4);
+        REQUIRE(spans[1].size() == 4);
+
+        std::vector<uint8_t> joined(spans[0].begin(), spans[0].end());
+        joined.insert(joined.end(), spans[1].begin(), spans[1].end());
+        REQUIRE(joined == data);
+    }
+
+    SECTION("PartialConsume") {
+        uint8_t data[6] = {1, 2, 3, 4, 5, 6};
+        rb.write(data, sizeof(data));
+        rb.consume(4);
+
+        auto spans = rb.readable_spans();
+        REQUIRE(spans[0].size() == 2);
+        REQUIRE(spans[0][0] == 5);
+    }
+}
+
+TEST_CASE("RingBuffer chunks", "[ring_buffer]") {
+    constexpr size_t chunk = 64;
+
+    SECTION("AllocatesOnDemand") {
+        RingBuffer rb(1 << 20, chunk);
+        REQUIRE(rb.allocated_bytes() == chunk);
+
+        std::vector<uint8_t> data(1000);
+        std::iota(data.begin(), data.end(), uint8_t(0));
+        REQUIRE(rb.write(data.data(), data.size()) == 1000);
+        REQUIRE(rb.allocated_bytes() == 16 * chunk);  // ceil(1000 / 64)
+        REQUIRE(rb.readable_spans().size() == 16);
+
+        std::vector<uint8_t> out(1000);
+        REQUIRE(rb.read(out.data(), out.size()) == 1000);
+        REQUIRE(out == data);
+    }
+
+    SECTION("PreallocatedFromStorage") {
+        size_t bytes = RingBuffer::storage_bytes(1000, chunk);
+        REQUIRE(bytes == (1000 / chunk + 2) * chunk);
+        std::vector<uint8_t> storage(bytes);
+        RingBuffer rb(1000, chunk, storage);
+        REQUIRE(rb.preallocated());
+        REQUIRE(rb.allocated_bytes() == bytes);
+
+        std::vector<uint8_t> data(1000), out(1000);
+        for (int round = 0; round < 10; ++round) {
+            std::iota(data.begin(), data.end(), static_cast<uint8_t>(round));
+            REQUIRE(rb.write(data.data(), data.size()) == 1000);
+            // The audio is in the caller's storage, nowhere else.
+            for (auto piece : rb.readable_spans()) {
+                REQUIRE(piece.data() >= storage.data());
+                REQUIRE(piece.data() + piece.size() <= storage.data() + storage.size());
+            }
+            REQUIRE(rb.read(out.data(), out.size()) == 1000);
+            REQUIRE(out == data);
+        }
+        REQUIRE(rb.allocated_bytes() == bytes);
+    }
+
+    SECTION("StorageTooSmallIsNotUsed") {
+        std::vector<uint8_t> storage(RingBuffer::storage_bytes(1000, chunk) - 1);
+        RingBuffer rb(1000, chunk, storage);
+        REQUIRE_FALSE(rb.preallocated());
+        REQUIRE(rb.allocated_bytes() == chunk);
+    }
+
+    SECTION("ChunksAreReused") {
+        RingBuffer rb(1 << 20, chunk);
+        std::vector<uint8_t> data(150, 0x11), out(150);
+        for (int round = 0; round < 100; ++round) {
+            REQUIRE(rb.write(data.data(), data.size()) == 150);
+            REQUIRE(rb.read(out.data(), out.size()) == 150);
+        }
+        // Never more than four chunks hold 150 unread bytes.
+        REQUIRE(rb.allocated_bytes() <= 4 * chunk);
+    }
+
+    SECTION("OverflowCounted") {
+        RingBuffer rb(200, chunk);
+        std::vector<uint8_t> data(150, 0x22);
+        REQUIRE(rb.write(data.data(), data.size()) == 150);
+        REQUIRE(rb.overflows() == 0);
+
+        REQUIRE(rb.write(data.data(), data.size()) == 50);
+        REQUIRE(rb.write(data.data(), data.size()) == 0);
+        REQUIRE(rb.overflows() == 2);
+        REQUIRE(rb.overflow_bytes() == 250);
+        REQUIRE(rb.available() == 200);
+    }
+
+    SECTION("VisitDoesNotConsume") {
+        RingBuffer rb(1024, chunk);
+        std::vector<uint8_t> data(100);
+        std::iota(data.begin(), data.end(), uint8_t(0));
+        rb.write(data.data(), data.size());
+
+        std::vector<uint8_t> seen;
+        size_t n = rb.visit_readable(70, [&seen](std::span<const uint8_t> piece) {
+            seen.insert(seen.end(), piece.begin(), piece.end());
+        });
+        REQUIRE(n == 70);
+        REQUIRE(seen == std::vector<uint8_t>(data.begin(), data.begin() + 70));
+        REQUIRE(rb.available() == 100);
+    }
+
+    SECTION("ConcurrentProducer") {
+        // Small chunks and a small cap, so the producer keeps crossing chunk
+        // boundaries and running into the consumer.
+        RingBuffer rb(256, 16);
+        constexpr uint32_t total = 200000;
+
+        std::jthread producer([&rb] {
+            uint32_t next = 0;
+            while (next < total) {
+                uint8_t buf[24];
+                size_t n = std::min<size_t>(sizeof(buf), total - next);
+                for (size_t i = 0; i < n; ++i) buf[i] = static_cast<uint8_t>(next + i);
+                size_t written = rb.write(buf, n);
+                next += static_cast<uint32_t>(written);
+                if (written < n) std::this_thread::yield();
+            }
+        });
+
+        uint32_t received = 0;
+        bool in_order = true;
+        while (received < total) {
+            uint8_t buf[40];
+            size_t n = rb.read(buf, sizeof(buf));
+            for (size_t i = 0; i < n; ++i) {
+                in_order = in_order && buf[i] == static_cast<uint8_t>(received + i);
+            }
+            received += static_cast<uint32_t>(n);
+        }
+        REQUIRE(in_order);
+        REQUIRE(rb.allocated_bytes() <= 18 * 16);
+    }
+}
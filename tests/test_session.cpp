@@ -43,3 +43,107 @@ TEST_CASE("Session state machine", "[session]") {
         REQUIRE(session.recording_duration() == 0.0);
     }
 }
+
+TEST_CASE("Session pump", "[session]") {
+    RingBuffer ring(1024);
+    MockAudioCapture capture;
+
+    SECTION("PumpWhenIdleReturnsEmpty") {
+        Session session(ring, capture, 16000);
+        std::vector<int16_t> data = {1, 2, 3};
+        ring.write(data.data(), data.size() * sizeof(int16_t));
+        REQUIRE(session.pump().empty());
+    }
+
+    SECTION("PumpAccumulatesRecording") {
+        Session session(ring, capture, 16000);
+        REQUIRE(session.start_recording({}));
+
+        std::vector<int16_t> first = {1, 2, 3};
+        ring.write(first.data(), first.size() * sizeof(int16_t));
+        auto chunk = session.pump();
+        REQUIRE(std::vector<int16_t>(chunk.begin(), chunk.end()) == first);
+
+        std::vector<int16_t> second = {4, 5};
+        ring.write(second.data(), second.size() * sizeof(int16_t));
+        chunk = session.pump();
+        REQUIRE(std::vector<int16_t>(chunk.begin(), chunk.end()) == second);
+
+        auto all = session.stop_recording();
+        REQUIRE(all == std::vector<int16_t>{1, 2, 3, 4, 5});
+        REQUIRE(session.state() == SessionState::Transcribing);
+    }
+
+    SECTION("StopIncludesUnpumpedTail") {
+        Session session(ring, capture, 16000);
+        REQUIRE(session.start_recording({}));
+
+        std::vector<int16_t> data = {7, 8};
+        ring.write(data.data(), data.size() * sizeof(int16_t));
+        REQUIRE(session.stop_recording() == data);
+    }
+
+    SECTION("MaxSecondsCapsRecording") {
+        // 1 second at 4 Hz = 4 samples
+        Session session(ring, capture, 4, 1);
+        REQUIRE(session.start_recording({}));
+
+        std::vector<int16_t> data = {1, 2, 3, 4, 5, 6};
+        ring.write(data.data(), data.size() * sizeof(int16_t));
+        REQUIRE(session.pump().size() == 4);
+        REQUIRE(session.stop_recording() == std::vector<int16_t>{1, 2, 3, 4});
+    }
+}
+
+TEST_CASE("Session armed capture", "[session]") {
+    RingBuffer ring(4096);
+    MockAudioCapture capture;
+    // 1000 Hz so 1 ms of pre-roll is one sample.
+    Session session(ring, capture, 1000);
+
+    auto write = [&ring](std::vector<int16_t> data) {
+        ring.write(data.data(), data.size() * sizeof(int16_t));
+    };
+
+    SECTION("ArmStartsCaptureOnce") {
+        REQUIRE(session.arm(3));
+        REQUIRE(session.armed());
+        REQUIRE(capture.is_capturing());
+    }
+
+    SECTION("StartKeepsOnlyPreroll") {
+        REQUIRE(session.arm(3));
+        write({1, 2, 3, 4, 5, 6});
+        REQUIRE(session.start_recording({}));
+        write({7, 8});
+        auto samples = session.stop_recording();
+        REQUIRE(samples == std::vector<int16_t>{4, 5, 6, 7, 8});
+    }
+
+    SECTION("StopLeavesCaptureRunning") {
+        REQUIRE(session.arm(2));
+        REQUIRE(session.start_recording({}));
+        session.stop_recording();
+        REQUIRE(capture.is_capturing());
+    }
+
+    SECTION("DiscardStaleBetweenRecordings") {
+        REQUIRE(session.arm(2));
+        write({1, 2, 3, 4});
+        session.discard_stale();
+        REQUIRE(ring.available() == 2 * sizeof(int16_t));
+
+        // Not while recording: that audio belongs to the recording.
+        REQUIRE(session.start_recording({}));
+        write({5, 6, 7});
+        session.discard_stale();
+        REQUIRE(session.stop_recording() == std::vector<int16_t>{3, 4, 5, 6, 7});
+    }
+
+    SECTION("RestartsCaptureIfItDied") {
+        REQUIRE(session.arm(2));
+        capture.stop();
+        REQUIRE(session.start_recording({}));
+        REQUIRE(capture.is_capturing());
+    }
+}
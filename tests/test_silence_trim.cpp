@@ -0,0 +1,101 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "audio/silence_trim.hpp"
+#include "audio/simd.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <numeric>
+#include <vector>
+
+namespace {
+
+constexpr uint32_t RATE = 16000;
+
+uint64_t scalar_sum_squares(const std::vector<int16_t>& v) {
+    uint64_t s = 0;
+    for (int16_t x : v) s += static_cast<uint64_t>(static_cast<int32_t>(x) * x);
+    return s;
+}
+
+} // namespace
+
+TEST_CASE("SIMD reductions", "[simd]") {
+
+    SECTION("SumSquaresMatchesScalar") {
+        std::vector<int16_t> v(1003);
+        for (size_t i = 0; i < v.size(); ++i) v[i] = static_cast<int16_t>((i * 7919) % 65536 - 32768);
+        REQUIRE(audio::sum_squares(v) == scalar_sum_squares(v));
+    }
+
+    SECTION("SumSquaresFullScaleDoesNotOverflow") {
+        std::vector<int16_t> v(64, -32768);
+        REQUIRE(audio::sum_squares(v) == 64ull * 32768 * 32768);
+    }
+
+    SECTION("PeakAbs") {
+        std::vector<int16_t> v(37, 5);
+        v[20] = -1200;
+        v[36] = 900;  // in the scalar tail
+        REQUIRE(audio::peak_abs(v) == 1200);
+        v[3] = -32768;
+        REQUIRE(audio::peak_abs(v) == 32768);
+    }
+
+    SECTION("CountClipped") {
+        std::vector<int16_t> v(1003);
+        for (size_t i = 0; i < v.size(); ++i) v[i] = static_cast<int16_t>((i * 7919) % 65536 - 32768);
+        v[5] = 32767;
+        v[6] = -32768;
+        v[1002] = 32000;  // in the scalar tail
+        auto scalar = [&v](int16_t limit) {
+            return static_cast<size_t>(std::ranges::count_if(v, [limit](int16_t x) { return x >= limit || x <= -limit; }));
+        };
+        REQUIRE(audio::count_clipped(v, 32000) == scalar(32000));
+        REQUIRE(audio::count_clipped(v, 32767) == scalar(32767));
+        REQUIRE(scalar(32767) >= 2);
+    }
+
+    SECTION("EmptyInput") {
+        REQUIRE(audio::sum_squares({}) == 0);
+        REQUIRE(audio::peak_abs({}) == 0);
+        REQUIRE(audio::count_clipped({}, 32767) == 0);
+    }
+}
+
+TEST_CASE("Silence trimming", "[trim]") {
+
+    SECTION("TrimsLeadingAndTrailingSilenceWithPadding") {
+        // 1s silence, 0.5s loud, 1s silence
+        std::vector<int16_t> v(RATE * 5 / 2, 0);
+        std::fill(v.begin() + RATE, v.begin() + RATE * 3 / 2, int16_t(4000));
+
+        auto r = audio::find_voiced_range(v, RATE, -50.0, 100);
+        REQUIRE(r.begin == RATE - RATE / 10);
+        REQUIRE(r.end == RATE * 3 / 2 + RATE / 10);
+        REQUIRE(r.trimmed(v.size()) == v.size() - (RATE / 2 + RATE / 5));
+    }
+
+    SECTION("PaddingClampedToBounds") {
+        std::vector<int16_t> v(RATE, int16_t(4000));
+        auto r = audio::find_voiced_range(v, RATE, -50.0, 500);
+        REQUIRE(r.begin == 0);
+        REQUIRE(r.end == v.size());
+        REQUIRE(r.trimmed(v.size()) == 0);
+    }
+
+    SECTION("AllSilentKeepsEverything") {
+        std::vector<int16_t> v(RATE, 3);
+        auto r = audio::find_voiced_range(v, RATE, -50.0, 100);
+        REQUIRE(r.begin == 0);
+        REQUIRE(r.end == v.size());
+    }
+
+    SECTION("OddLengthTail") {
+        std::vector<int16_t> v(RATE + 37, 0);
+        v.back() = 20000;
+        auto r = audio::find_voiced_range(v, RATE, -50.0, 0);
+        REQUIRE(r.end == v.size());
+        REQUIRE(r.begin == (v.size() - 1) / 160 * 160);
+    }
+}
@@ -0,0 +1,282 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "whisper/streaming_transcriber.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <numeric>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// Returns the first sample of each request as its text, so tests can check
+// segment boundaries and ordering.
+class MockBackend : public WhisperBackend {
+public:
+    std::expected<TranscriptResult, std::string>
+    transcribe(std::span<const int16_t> audio, uint32_t sample_rate) override {
+        std::lock_guard lock(mu_);
+        sizes.push_back(audio.size());
+        if (fail) return std::unexpected("backend down");
+        return TranscriptResult{
+            .text = std::to_string(audio.front()),
+            .duration_s = static_cast<double>(audio.size()) / sample_rate,
+        };
+    }
+
+    std::vector<size_t> sizes;
+    bool fail = false;
+
+private:
+    std::mutex mu_;
+};
+
+std::vector<int16_t> ramp(size_t n, int16_t start = 0) {
+    std::vector<int16_t> v(n);
+    std::iota(v.begin(), v.end(), start);
+    return v;
+}
+
+// Constant-level "speech" tagged by its amplitude (marker * 1000).
+std::vector<int16_t> speech(size_t n, int16_t marker) {
+    return std::vector<int16_t>(n, static_cast<int16_t>(marker * 1000));
+}
+
+// Reports the loudest marker in each request.
+class MarkerBackend : public WhisperBackend {
+public:
+    std::expected<TranscriptResult, std::string>
+    transcribe(std::span<const int16_t> audio, uint32_t) override {
+        std::lock_guard lock(mu_);
+        sizes.push_back(audio.size());
+        return TranscriptResult{.text = std::to_string(*std::ranges::max_element(audio) / 1000)};
+    }
+
+    std::vector<size_t> sizes;
+
+private:
+    std::mutex mu_;
+};
+
+// Hangs like a stuck server until the request is cancelled.
+class StallingBackend : public WhisperBackend {
+public:
+    std::expected<TranscriptResult, std::string>
+    transcribe(std::span<const int16_t> audio, uint32_t sample_rate) override {
+        return transcribe(audio, sample_rate, std::stop_token{});
+    }
+
+    std::expected<TranscriptResult, std::string>
+    transcribe(std::span<const int16_t>, uint32_t, std::stop_token stop,
+               std::string_view = {}) override {
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (std::chrono::steady_clock::now() < deadline) {
+            if (stop.stop_requested()) {
+                ++cancelled;
+                return std::unexpected("cancelled");
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return TranscriptResult{.text = "late"};
+    }
+
+    std::atomic<int> cancelled{0};
+};
+
+// Fails the first segment at once and stalls on the others.
+class FailFirstBackend : public StallingBackend {
+public:
+    using StallingBackend::transcribe;
+
+    std::expected<TranscriptResult, std::string>
+    transcribe(std::span<const int16_t> audio, uint32_t sample_rate, std::stop_token stop,
+               std::string_view prompt = {}) override {
+        if (audio.front() == 0) return std::unexpected("backend down");
+        return StallingBackend::transcribe(audio, sample_rate, stop, prompt);
+    }
+};
+
+} // namespace
+
+TEST_CASE("StreamingTranscriber", "[streaming]") {
+    MockBackend backend;
+
+    SECTION("ShortRecordingOnlyTail") {
+        StreamingTranscriber st(backend, 10, 1);
+        auto audio = ramp(5);
+        st.feed(audio);
+        REQUIRE(st.segments_dispatched() == 0);
+
+        auto res = st.finish();
+        REQUIRE(res.has_value());
+        REQUIRE(res->text == "0");
+        REQUIRE(res->duration_s == 0.5);
+        REQUIRE(backend.sizes == std::vector<size_t>{5});
+    }
+
+    SECTION("FullSegmentsDispatchedWhileFeeding") {
+        StreamingTranscriber st(backend, 10, 1);
+        auto audio = ramp(25);
+        // Feed in uneven chunks that straddle segment boundaries
+        st.feed(std::span<const int16_t>(audio).subspan(0, 7));
+        st.feed(std::span<const int16_t>(audio).subspan(7, 11));
+        REQUIRE(st.segments_dispatched() == 1);
+        st.feed(std::span<const int16_t>(audio).subspan(18));
+        REQUIRE(st.segments_dispatched() == 2);
+        REQUIRE(st.samples_fed() == 25);
+
+        auto res = st.finish();
+        REQUIRE(res.has_value());
+        REQUIRE(res->text == "0 10 20");
+        REQUIRE(res->duration_s == 2.5);
+        REQUIRE(backend.sizes.size() == 3);
+    }
+
+    SECTION("ExactSegmentHasNoTail") {
+        StreamingTranscriber st(backend, 10, 1);
+        auto audio = ramp(20);
+        st.feed(audio);
+
+        auto res = st.finish();
+        REQUIRE(res.has_value());
+        REQUIRE(res->text == "0 10");
+        REQUIRE(backend.sizes.size() == 2);
+    }
+
+    SECTION("SegmentFailurePropagates") {
+        backend.fail = true;
+        StreamingTranscriber st(backend, 10, 1);
+        auto audio = ramp(15);
+        st.feed(audio);
+
+        auto res = st.finish();
+        REQUIRE_FALSE(res.has_value());
+        REQUIRE(res.error() == "backend down");
+    }
+
+    SECTION("FinishedSegmentsTakenInOrder") {
+        std::atomic<int> callbacks{0};
+        StreamingTranscriber st(backend, 10, 1, std::nullopt, [&] { ++callbacks; });
+        auto audio = ramp(25);
+        st.feed(audio);
+
+        auto res = st.finish();
+        REQUIRE(res.has_value());
+        REQUIRE(callbacks == 2);
+        // The tail is only part of the result, not a segment.
+        REQUIRE(st.take_finished() == std::vector<std::string>{"0", "10"});
+        REQUIRE(st.take_finished().empty());
+    }
+}
+
+TEST_CASE("StreamingTranscriber VAD segmentation", "[streaming][vad]") {
+    constexpr uint32_t rate = 16000;
+    MarkerBackend backend;
+    StreamingTranscriber::VadCuts cuts{.threshold_db = -45.0, .silence_ms = 300, .min_segment_seconds = 1};
+
+    auto append = [](std::vector<int16_t>& dst, const std::vector<int16_t>& src) {
+        dst.insert(dst.end(), src.begin(), src.end());
+    };
+
+    SECTION("CutsAtPauses") {
+        StreamingTranscriber st(backend, rate, 30, cuts);
+
+        std::vector<int16_t> audio;
+        append(audio, speech(rate * 3 / 2, 1));
+        append(audio, std::vector<int16_t>(rate / 2, 0));
+        append(audio, speech(rate * 3 / 2, 2));
+        append(audio, std::vector<int16_t>(rate / 2, 0));
+        append(audio, speech(rate, 3));
+
+        for (size_t i = 0; i < audio.size(); i += 1600) {
+            st.feed(std::span<const int16_t>(audio).subspan(i, std::min<size_t>(1600, audio.size() - i)));
+        }
+        REQUIRE(st.segments_dispatched() == 2);
+
+        auto res = st.finish();
+        REQUIRE(res.has_value());
+        REQUIRE(res->text == "1 2 3");
+        REQUIRE(backend.sizes.size() == 3);
+    }
+
+    SECTION("ShortUtteranceNotSplit") {
+        StreamingTranscriber st(backend, rate, 30, cuts);
+
+        std::vector<int16_t> audio;
+        append(audio, speech(rate / 2, 1));
+        append(audio, std::vector<int16_t>(rate / 2, 0));
+        append(audio, speech(rate / 2, 2));
+        st.feed(audio);
+        REQUIRE(st.segments_dispatched() == 0);
+
+        auto res = st.finish();
+        REQUIRE(res.has_value());
+        REQUIRE(backend.sizes == std::vector<size_t>{audio.size()});
+    }
+
+    SECTION("SilentTailSkipped") {
+        StreamingTranscriber st(backend, rate, 30, cuts);
+
+        std::vector<int16_t> audio;
+        append(audio, speech(rate * 2, 1));
+        append(audio, std::vector<int16_t>(rate * 2, 0));
+        st.feed(audio);
+        REQUIRE(st.segments_dispatched() == 1);
+
+        auto res = st.finish();
+        REQUIRE(res.has_value());
+        REQUIRE(res->text == "1");
+        REQUIRE(backend.sizes.size() == 1);
+    }
+
+    SECTION("MaxSegmentStillEnforced") {
+        StreamingTranscriber st(backend, rate, 2, cuts);
+        auto audio = speech(rate * 5, 1);
+        st.feed(audio);
+        REQUIRE(st.segments_dispatched() == 2);
+        REQUIRE(st.finish().has_value());
+    }
+}
+
+TEST_CASE("StreamingTranscriber cancellation", "[streaming]") {
+    StallingBackend backend;
+    auto start = std::chrono::steady_clock::now();
+    {
+        StreamingTranscriber st(backend, 10, 1);
+        auto audio = ramp(25);
+        st.feed(audio);  // two segments in flight, five samples of tail
+        REQUIRE(st.segments_dispatched() == 2);
+
+        std::stop_source stop;
+        std::jthread canceller([&stop] {
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            stop.request_stop();
+        });
+
+        auto res = st.finish(stop.get_token());
+        REQUIRE_FALSE(res.has_value());
+    }
+    CHECK(std::chrono::steady_clock::now() - start < std::chrono::seconds(2));
+    CHECK(backend.cancelled == 3);
+}
+
+TEST_CASE("StreamingTranscriber failed segment stops the rest", "[streaming]") {
+    FailFirstBackend backend;
+    auto start = std::chrono::steady_clock::now();
+    {
+        StreamingTranscriber st(backend, 10, 1);
+        auto audio = ramp(20);
+        st.feed(audio);  // two segments, no tail
+        REQUIRE(st.segments_dispatched() == 2);
+
+        auto res = st.finish();
+        REQUIRE_FALSE(res.has_value());
+        REQUIRE(res.error() == "backend down");
+        CHECK(backend.cancelled == 1);
+    }
+    CHECK(std::chrono::steady_clock::now() - start < std::chrono::seconds(2));
+}
@@ -0,0 +1,95 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "sway/focus_parser.hpp"
+
+namespace {
+
+// Trimmed-down GET_TREE reply: root -> output -> workspace -> windows, with
+// the keys in the order Sway writes them.
+constexpr const char* TREE = R"({
+  "id": 1, "type": "root", "focused": false, "name": "root",
+  "rect": {"x": 0, "y": 0, "width": 1920, "height": 1080},
+  "nodes": [{
+    "id": 3, "type": "output", "focused": false, "name": "eDP-1",
+    "nodes": [{
+      "id": 4, "type": "workspace", "focused": false, "name": "1",
+      "nodes": [
+        {"id": 5, "type": "con", "focused": false, "name": "vim",
+         "marks": ["a"], "nodes": [], "floating_nodes": [],
+         "pid": 100, "app_id": "foot"},
+        {"id": 6, "type": "con", "focused": true, "name": "~/src - claude",
+         "nodes": [], "floating_nodes": [], "pid": 200, "app_id": "kitty",
+         "idle_inhibitors": {"user": "none", "application": "none"}}
+      ],
+      "floating_nodes": []
+    }]
+  }]
+})";
+
+} // namespace
+
+TEST_CASE("Sway focus parser", "[window]") {
+
+    SECTION("TreeFindsFocusedWindow") {
+        auto info = sway::parse_focused_tree(TREE);
+        REQUIRE(info.app_id == "kitty");
+        REQUIRE(info.title == "~/src - claude");
+        REQUIRE(info.pid == 200);
+        REQUIRE(info.window_class.empty());
+    }
+
+    SECTION("TreeFindsFocusedFloatingXwaylandWindow") {
+        auto info = sway::parse_focused_tree(R"({
+          "type": "root", "focused": false, "nodes": [{
+            "type": "workspace", "focused": false, "name": "2", "nodes": [],
+            "floating_nodes": [{
+              "type": "floating_con", "focused": true, "name": "Mozilla Firefox",
+              "app_id": null, "pid": 300,
+              "window_properties": {"class": "firefox", "instance": "Navigator"}
+            }]
+          }]
+        })");
+        REQUIRE(info.app_id.empty());
+        REQUIRE(info.window_class == "firefox");
+        REQUIRE(info.title == "Mozilla Firefox");
+        REQUIRE(info.pid == 300);
+    }
+
+    SECTION("TreeWithoutFocusIsEmpty") {
+        REQUIRE(sway::parse_focused_tree(R"({"focused": false, "nodes": []})").empty());
+        REQUIRE(sway::parse_focused_tree("not json").empty());
+    }
+
+    SECTION("FocusEvent") {
+        auto info = sway::parse_focus_event(R"({
+          "change": "focus",
+          "container": {"id": 6, "name": "htop", "focused": true, "pid": 42,
+                        "app_id": "alacritty", "nodes": [], "marks": []}
+        })");
+        REQUIRE(info.has_value());
+        REQUIRE(info->app_id == "alacritty");
+        REQUIRE(info->title == "htop");
+        REQUIRE(info->pid == 42);
+    }
+
+    SECTION("FocusEventWithChangeLast") {
+        auto info = sway::parse_focus_event(
+            R"({"container": {"name": "x", "pid": 7, "app_id": "foot"}, "change": "focus"})");
+        REQUIRE(info.has_value());
+        REQUIRE(info->pid == 7);
+    }
+
+    SECTION("OtherChangesRejected") {
+        REQUIRE_FALSE(sway::parse_focus_event(
+            R"({"change": "title", "container": {"name": "x", "pid": 7}})").has_value());
+        REQUIRE_FALSE(sway::parse_focus_event(
+            R"({"container": {"name": "x", "pid": 7}, "change": "title"})").has_value());
+        // Rejected at "change": the broken container isn't looked at.
+        REQUIRE_FALSE(sway::parse_focus_event(R"({"change": "title", "container": {)").has_value());
+    }
+
+    SECTION("MalformedEventRejected") {
+        REQUIRE_FALSE(sway::parse_focus_event(R"({"change": "focus", "container": {"pid": )").has_value());
+        REQUIRE_FALSE(sway::parse_focus_event(R"({"change": "focus"})").has_value());
+    }
+}
@@ -0,0 +1,138 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "hash.hpp"
+#include "whisper/caching_backend.hpp"
+
+#include <filesystem>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+// Counts requests; answers with the request number.
+class CountingBackend : public WhisperBackend {
+public:
+    std::expected<TranscriptResult, std::string>
+    transcribe(std::span<const int16_t> audio, uint32_t sample_rate) override {
+        return transcribe(audio, sample_rate, std::stop_token{});
+    }
+
+    std::expected<TranscriptResult, std::string>
+    transcribe(std::span<const int16_t> audio, uint32_t sample_rate, std::stop_token,
+               std::string_view = {}) override {
+        ++calls;
+        if (fail) return std::unexpected("down");
+        return TranscriptResult{
+            .text = "text " + std::to_string(calls),
+            .duration_s = static_cast<double>(audio.size()) / sample_rate,
+            .processing_s = 0.5,
+        };
+    }
+
+    int calls = 0;
+    bool fail = false;
+};
+
+struct Fixture {
+    Fixture() {
+        auto b = std::make_unique<CountingBackend>();
+        inner = b.get();
+        backend = std::make_unique<CachingBackend>(std::move(b), std::make_unique<TranscriptCache>(8),
+                                                   "lan|whisper.cpp|en");
+    }
+
+    std::string run(const std::vector<int16_t>& audio, std::string_view prompt = {}) {
+        auto r = backend->transcribe(audio, 16000, std::stop_token{}, prompt);
+        return r ? r->text : "error: " + r.error();
+    }
+
+    CountingBackend* inner;
+    std::unique_ptr<CachingBackend> backend;
+};
+
+} // namespace
+
+TEST_CASE("Xxh64", "[cache]") {
+    // Reference values from the xxHash project.
+    REQUIRE(hash::xxh64("") == 0xEF46DB3751D8E999ULL);
+    REQUIRE(hash::xxh64("a") == 0xD24EC4F1A98C6E5BULL);
+    REQUIRE(hash::xxh64("abc") == 0x44BC2CF5AD770999ULL);
+    REQUIRE(hash::xxh64("Nobody inspects the spammish repetition") == 0xFBCEA83C8A378BF1ULL);
+    REQUIRE(hash::xxh64("abc", 1) != hash::xxh64("abc"));
+}
+
+TEST_CASE("TranscriptCache", "[cache]") {
+    SECTION("EvictsLeastRecentlyUsed") {
+        TranscriptCache cache(2);
+        cache.put(1, {.text = "one"});
+        cache.put(2, {.text = "two"});
+        REQUIRE(cache.get(1));  // 2 is now the oldest
+        cache.put(3, {.text = "three"});
+        REQUIRE(cache.size() == 2);
+        REQUIRE_FALSE(cache.get(2));
+        REQUIRE(cache.get(1)->text == "one");
+        REQUIRE(cache.get(3)->cached);
+        REQUIRE(cache.hits() == 3);
+        REQUIRE(cache.misses() == 1);
+    }
+
+    SECTION("PersistsAcrossOpens") {
+        auto path = std::filesystem::temp_directory_path() /
+                    ("sa_test_cache_" + std::to_string(getpid()) + ".db");
+        {
+            TranscriptCache cache(2);
+            REQUIRE(cache.open(path.string()));
+            cache.put(1, {.text = "one", .duration_s = 1.5});
+            cache.put(2, {.text = "two"});
+            cache.put(3, {.text = "three"});
+        }
+        {
+            TranscriptCache cache(2);
+            REQUIRE(cache.open(path.string()));
+            REQUIRE(cache.size() == 2);
+            REQUIRE_FALSE(cache.get(1));
+            auto three = cache.get(3);
+            REQUIRE(three);
+            REQUIRE(three->text == "three");
+        }
+        for (auto suffix : {"", "-wal", "-shm"}) std::filesystem::remove(path.string() + suffix);
+    }
+}
+
+TEST_CASE("CachingBackend", "[cache]") {
+    Fixture f;
+    std::vector<int16_t> audio(16000, 7);
+
+    SECTION("SameAudioAnsweredFromCache") {
+        REQUIRE(f.run(audio) == "text 1");
+        auto again = f.backend->transcribe(audio, 16000, std::stop_token{});
+        REQUIRE(again->text == "text 1");
+        REQUIRE(again->cached);
+        REQUIRE(again->duration_s == 1.0);
+        REQUIRE(f.inner->calls == 1);
+    }
+
+    SECTION("DifferentAudioOrPromptMisses") {
+        REQUIRE(f.run(audio) == "text 1");
+        audio[100] = 8;
+        REQUIRE(f.run(audio) == "text 2");
+        REQUIRE(f.run(audio, "kubectl") == "text 3");
+        REQUIRE(f.run(audio, "kubectl") == "text 3");
+        REQUIRE(f.inner->calls == 3);
+    }
+
+    SECTION("FailuresAreNotKept") {
+        f.inner->fail = true;
+        REQUIRE(f.run(audio) == "error: down");
+        f.inner->fail = false;
+        REQUIRE(f.run(audio) == "text 2");
+    }
+
+    SECTION("RefreshAsksAgainAndReplaces") {
+        REQUIRE(f.run(audio) == "text 1");
+        REQUIRE(f.backend->refresh(audio, 16000, std::stop_token{})->text == "text 2");
+        REQUIRE(f.run(audio) == "text 2");
+        REQUIRE(f.inner->calls == 2);
+    }
+}
@@ -0,0 +1,122 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "ipc_protocol.hpp"
+#include "platform/linux/unix_socket_server.hpp"
+#include "trigger_frame.hpp"
+
+#include <chrono>
+#include <nlohmann/json.hpp>
+#include <string>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+using json = nlohmann::json;
+
+namespace {
+
+json decode(std::span<const char> frame) {
+    json msg;
+    auto decoded = ipc::decode(frame, msg);
+    REQUIRE(decoded.status == ipc::DecodeStatus::Ok);
+    REQUIRE(decoded.consumed == frame.size());
+    REQUIRE(decoded.encoding == ipc::Encoding::Cbor);
+    return msg;
+}
+
+// Built when sa-trigger is compiled, not when it runs.
+constexpr auto TOGGLE = trigger::encode({});
+static_assert(TOGGLE && TOGGLE->size == ipc::FRAME_HEADER + 12);
+
+} // namespace
+
+TEST_CASE("Trigger frames", "[ipc][trigger]") {
+    SECTION("CommandsDecodeAsCbor") {
+        REQUIRE(decode(TOGGLE->data()) == json{{"cmd", "toggle"}});
+        auto start = trigger::encode({.cmd = "start", .output = "clipboard", .auto_stop = true});
+        REQUIRE(decode(start->data()) == json{{"cmd", "start"}, {"output", "clipboard"}, {"auto_stop", true}});
+        auto stop = trigger::encode({.cmd = "stop", .output = "none"});
+        REQUIRE(decode(stop->data()) == json{{"cmd", "stop"}, {"output", "none"}});
+    }
+
+    SECTION("LongStringsAreRefused") {
+        REQUIRE_FALSE(trigger::encode({.output = "a-very-long-output-method-name"}));
+    }
+
+    SECTION("ReplyFieldsAreFound") {
+        // What the daemon sends a waiting client: nested values to skip over,
+        // and strings long enough for the longer length forms.
+        std::string text(300, 'w');
+        json response = {
+            {"status", "ok"},
+            {"job_id", 123456789012},
+            {"duration", 2.5},
+            {"delta", -40},
+            {"cached", false},
+            {"chunks", json::array({{{"start_s", 0.0}, {"text", "inner"}}, nullptr})},
+            {"text", text},
+        };
+        // The reply's strings point into the frame.
+        auto frame = ipc::encode(response, ipc::Encoding::Cbor);
+        auto reply = trigger::parse_reply(frame);
+        REQUIRE(reply);
+        REQUIRE(reply->status == "ok");
+        REQUIRE(reply->text == text);
+        REQUIRE(reply->message.empty());
+
+        frame = ipc::encode({{"status", "error"}, {"message", "not recording"}}, ipc::Encoding::Cbor);
+        reply = trigger::parse_reply(frame);
+        REQUIRE(reply->status == "error");
+        REQUIRE(reply->message == "not recording");
+    }
+
+    SECTION("BadRepliesAreRejected") {
+        auto frame = ipc::encode({{"status", "ok"}, {"chunks", json::array({1, 2, 3})}}, ipc::Encoding::Cbor);
+        // Claims more items than the payload holds.
+        auto truncated = frame.substr(0, frame.size() - 2);
+        REQUIRE_FALSE(trigger::parse_reply(truncated));
+        REQUIRE_FALSE(trigger::parse_reply(ipc::encode(json::array({"ok"}), ipc::Encoding::Cbor)));
+    }
+
+    SECTION("FrameSize") {
+        auto frame = ipc::encode({{"status", "ok"}}, ipc::Encoding::Cbor);
+        REQUIRE(trigger::frame_size(frame) == frame.size());
+        REQUIRE(trigger::frame_size(std::span(frame).first(3)) == 0);
+        REQUIRE(trigger::frame_size(std::span(frame).first(frame.size() - 1)) == 0);
+        REQUIRE(trigger::frame_size(frame + "more") == frame.size());
+        REQUIRE_FALSE(trigger::frame_size(ipc::encode({{"status", "ok"}}, ipc::Encoding::JsonLines)));
+        REQUIRE_FALSE(trigger::frame_size(ipc::encode({{"status", "ok"}}, ipc::Encoding::MsgPack)));
+    }
+
+    SECTION("SentAndHungUp") {
+        // sa-trigger writes the frame and closes without reading the reply.
+        auto path = "/tmp/sa_test_trigger_" + std::to_string(getpid()) + ".sock";
+        UnixSocketServer server;
+        REQUIRE(server.start(path));
+
+        int raw = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        sockaddr_un addr{};
+        addr.sun_family = AF_UNIX;
+        path.copy(addr.sun_path, sizeof(addr.sun_path) - 1);
+        REQUIRE(::connect(raw, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0);
+        int client_fd = server.accept_client();
+        REQUIRE(client_fd >= 0);
+
+        auto frame = TOGGLE->data();
+        REQUIRE(::send(raw, frame.data(), frame.size(), 0) == static_cast<ssize_t>(frame.size()));
+        ::close(raw);
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+        std::vector<json> cmds;
+        REQUIRE_FALSE(server.read_commands(client_fd, cmds));
+        REQUIRE(cmds.size() == 1);
+        REQUIRE(cmds[0]["cmd"] == "toggle");
+        // The reply to a closed socket fails quietly.
+        REQUIRE_FALSE(server.send_response(client_fd, {{"status", "ok"}}));
+
+        server.close_client(client_fd);
+        server.stop();
+    }
+}
@@ -0,0 +1,168 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "audio/auto_stop.hpp"
+#include "audio/level_meter.hpp"
+#include "audio/vad.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+namespace {
+
+constexpr uint32_t RATE = 16000;
+
+std::vector<int16_t> tone(size_t n, double amplitude = 8000.0) {
+    std::vector<int16_t> v(n);
+    for (size_t i = 0; i < n; ++i) {
+        v[i] = static_cast<int16_t>(amplitude * std::sin(2.0 * M_PI * 440.0 * i / RATE));
+    }
+    return v;
+}
+
+std::vector<int16_t> silence(size_t n) { return std::vector<int16_t>(n, 0); }
+
+} // namespace
+
+TEST_CASE("Vad", "[vad]") {
+    Vad vad(RATE);  // 30ms frames = 480 samples
+
+    SECTION("SilenceIsNotSpeech") {
+        vad.process(silence(RATE));
+        REQUIRE_FALSE(vad.speech_detected());
+        REQUIRE(vad.trailing_silence_samples() == vad.samples_processed());
+    }
+
+    SECTION("ToneIsSpeech") {
+        vad.process(silence(RATE / 2));
+        vad.process(tone(RATE / 2));
+        REQUIRE(vad.speech_detected());
+        REQUIRE(vad.in_speech());
+        REQUIRE(vad.trailing_silence_samples() == 0);
+    }
+
+    SECTION("TrailingSilenceCounted") {
+        vad.process(tone(480 * 16));
+        vad.process(silence(4800));
+        REQUIRE(vad.speech_detected());
+        REQUIRE_FALSE(vad.in_speech());
+        REQUIRE(vad.trailing_silence_samples() == 4800);
+    }
+
+    SECTION("PartialFramesCarryOver") {
+        auto t = tone(1000);
+        vad.process(std::span<const int16_t>(t).first(300));
+        REQUIRE(vad.samples_processed() == 0);
+        vad.process(std::span<const int16_t>(t).subspan(300));
+        REQUIRE(vad.samples_processed() == 960);
+    }
+
+    SECTION("QuietSpeechBelowThreshold") {
+        vad.process(tone(RATE / 2, 50.0));  // about -56 dBFS
+        REQUIRE_FALSE(vad.speech_detected());
+    }
+
+    SECTION("ResetClearsState") {
+        vad.process(tone(RATE / 2));
+        vad.reset();
+        REQUIRE_FALSE(vad.speech_detected());
+        REQUIRE(vad.samples_processed() == 0);
+    }
+}
+
+TEST_CASE("AutoStop", "[vad]") {
+    auto feed = [](AutoStop& stop, const std::vector<int16_t>& audio) {
+        auto decision = AutoStop::Decision::Continue;
+        for (size_t i = 0; i < audio.size() && decision == AutoStop::Decision::Continue; i += 1600) {
+            decision = stop.feed(std::span<const int16_t>(audio).subspan(i, std::min<size_t>(1600, audio.size() - i)));
+        }
+        return decision;
+    };
+
+    SECTION("StopsAfterSilenceFollowingSpeech") {
+        AutoStop stop(RATE, -45.0, 800, 8000);
+        REQUIRE(feed(stop, tone(RATE)) == AutoStop::Decision::Continue);
+        REQUIRE(stop.heard());
+        REQUIRE(stop.ms_until_decision() == 800);
+
+        REQUIRE(feed(stop, silence(RATE / 2)) == AutoStop::Decision::Continue);
+        CHECK(stop.ms_until_decision() <= 330);
+        CHECK(stop.ms_until_decision() >= 270);
+        REQUIRE(feed(stop, silence(RATE / 2)) == AutoStop::Decision::Stop);
+    }
+
+    SECTION("PauseShorterThanLimitContinues") {
+        AutoStop stop(RATE, -45.0, 800, 8000);
+        feed(stop, tone(RATE / 2));
+        REQUIRE(feed(stop, silence(RATE / 2)) == AutoStop::Decision::Continue);
+        REQUIRE(feed(stop, tone(RATE / 2)) == AutoStop::Decision::Continue);
+        REQUIRE(stop.ms_until_decision() == 800);
+    }
+
+    SECTION("ClickDoesNotArm") {
+        AutoStop stop(RATE, -45.0, 800, 0);
+        auto audio = silence(RATE / 2);
+        auto click = tone(480);  // one 30 ms frame
+        audio.insert(audio.end(), click.begin(), click.end());
+        auto quiet = silence(RATE * 2);
+        audio.insert(audio.end(), quiet.begin(), quiet.end());
+        REQUIRE(feed(stop, audio) == AutoStop::Decision::Continue);
+        REQUIRE_FALSE(stop.heard());
+    }
+
+    SECTION("NoSpeechDiscards") {
+        AutoStop stop(RATE, -45.0, 800, 2000);
+        REQUIRE(feed(stop, silence(RATE)) == AutoStop::Decision::Continue);
+        CHECK(stop.ms_until_decision() == 1000);
+        REQUIRE(feed(stop, silence(RATE)) == AutoStop::Decision::Discard);
+    }
+}
+
+TEST_CASE("LevelMeter", "[vad]") {
+    auto feed = [](LevelMeter& meter, const std::vector<int16_t>& audio) {
+        for (size_t i = 0; i < audio.size(); i += 1600) {
+            meter.feed(std::span<const int16_t>(audio).subspan(i, std::min<size_t>(1600, audio.size() - i)));
+        }
+    };
+
+    SECTION("SilenceSitsAtTheFloor") {
+        LevelMeter meter(RATE / 4);
+        REQUIRE(meter.recent().rms_db == LevelMeter::FLOOR_DB);
+        feed(meter, silence(RATE));
+        REQUIRE(meter.recording().rms_db == LevelMeter::FLOOR_DB);
+        REQUIRE(meter.recording().peak_db == LevelMeter::FLOOR_DB);
+        REQUIRE(meter.recording().clipped_pct == 0.0);
+    }
+
+    SECTION("SineLevels") {
+        LevelMeter meter(RATE / 4);
+        feed(meter, tone(RATE));
+        // 8000 peak is -12.3 dBFS; a sine's RMS is 3 dB below its peak.
+        CHECK(std::abs(meter.recording().peak_db - -12.3) < 0.1);
+        CHECK(std::abs(meter.recording().rms_db - -15.3) < 0.1);
+        REQUIRE(meter.recording().clipped_pct == 0.0);
+        REQUIRE(meter.samples() == RATE);
+    }
+
+    SECTION("RecentFollowsTheLastWindow") {
+        LevelMeter meter(RATE / 4);
+        feed(meter, tone(RATE));
+        feed(meter, silence(RATE / 2));
+        REQUIRE(meter.recent().rms_db == LevelMeter::FLOOR_DB);
+        REQUIRE(meter.recording().rms_db > -20.0);
+    }
+
+    SECTION("CountsClipping") {
+        auto overdriven = silence(RATE);
+        std::fill(overdriven.begin(), overdriven.begin() + RATE / 10, int16_t{32767});
+        LevelMeter clipped(RATE / 4);
+        feed(clipped, overdriven);
+        CHECK(std::abs(clipped.recording().clipped_pct - 10.0) < 1e-9);
+        CHECK(clipped.recording().peak_db > -0.01);
+
+        clipped.reset();
+        REQUIRE(clipped.samples() == 0);
+        REQUIRE(clipped.recording().clipped_pct == 0.0);
+    }
+}
@@ -2,6 +2,7 @@
 
 #include "wav_encoder.hpp"
 
+#include <algorithm>
 #include <cstdint>
 #include <cstring>
 #include <string>
@@ -70,6 +71,12 @@ TEST_CASE("wav::encode", "[wav]") {
         REQUIRE(read_u32(wav.data() + 4) == 36 + data_size);
     }
 
+    SECTION("HeaderMatchesEncode") {
+        auto wav = wav::encode(samples, sample_rate);
+        auto hdr = wav::header(samples.size(), sample_rate);
+        REQUIRE(std::equal(hdr.begin(), hdr.end(), wav.begin()));
+    }
+
     SECTION("DataIntegrity") {
         auto wav = wav::encode(samples, sample_rate);
         auto* data_ptr = reinterpret_cast<const int16_t*>(wav.data() + 44);
@@ -85,3 +92,47 @@ TEST_CASE("wav::encode", "[wav]") {
         REQUIRE(read_u32(wav.data() + 40) == 0);
     }
 }
+
+TEST_CASE("WAV decoding", "[wav]") {
+    std::vector<int16_t> samples = {0, 1000, -1000, 32767, -32768, 42};
+
+    SECTION("RoundTrip") {
+        auto clip = wav::decode(wav::encode(samples, 16000));
+        REQUIRE(clip.has_value());
+        REQUIRE(clip->sample_rate == 16000);
+        REQUIRE(clip->channels == 1);
+        REQUIRE(clip->samples == samples);
+    }
+
+    SECTION("SkipsOtherChunksAndReadsChannels") {
+        auto file = wav::encode(samples, 48000);
+        file[22] = 2;  // stereo: three frames
+        // A LIST chunk between fmt and data, odd-sized and so padded.
+        std::vector<uint8_t> list = {'L', 'I', 'S', 'T', 3, 0, 0, 0, 'a', 'b', 'c', 0};
+        file.insert(file.begin() + 36, list.begin(), list.end());
+
+        auto clip = wav::decode(file);
+        REQUIRE(clip.has_value());
+        REQUIRE(clip->channels == 2);
+        REQUIRE(clip->sample_rate == 48000);
+        REQUIRE(clip->samples == samples);
+    }
+
+    SECTION("TruncatedDataTakesWhatIsThere") {
+        auto file = wav::encode(samples, 16000);
+        file.resize(file.size() - 5);
+        auto clip = wav::decode(file);
+        REQUIRE(clip.has_value());
+        REQUIRE(clip->samples == std::vector<int16_t>(samples.begin(), samples.begin() + 3));
+    }
+
+    SECTION("Rejects") {
+        REQUIRE_FALSE(wav::decode(std::vector<uint8_t>{'R', 'I', 'F', 'F'}).has_value());
+        auto file = wav::encode(samples, 16000);
+        file[34] = 8;  // 8-bit
+        REQUIRE(wav::decode(file).error() == "not 16-bit");
+        file = wav::encode(samples, 16000);
+        file[20] = 3;  // float
+        REQUIRE(wav::decode(file).error() == "not PCM");
+    }
+}